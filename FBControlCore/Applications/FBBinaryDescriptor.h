@@ -36,6 +36,7 @@ extern FBBinaryArchitecture const FBBinaryArchitectureArm64;
 
 /**
  Returns the FBBinaryDescriptor for the given binary path, by parsing the binary.
+ The binary is mapped into memory and the load commands of every architecture are read in a single pass.
 
  @param path the path to the binary.
  @param error an error out for any error that occurs.
@@ -68,10 +69,15 @@ extern FBBinaryArchitecture const FBBinaryArchitectureArm64;
 #pragma mark Public Methods
 
 /**
- Obtain the rpaths in the binary.
+ Obtain the rpaths in the binary, across all architectures.
  */
 - (nullable NSArray<NSString *> *)rpathsWithError:(NSError **)error;
 
+/**
+ Obtain the install names of the dynamic libraries that the binary links against, across all architectures.
+ */
+- (nullable NSArray<NSString *> *)linkedLibrariesWithError:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -11,15 +11,15 @@
 #import "FBCollectionInformation.h"
 #import "FBControlCoreGlobalConfiguration.h"
 
+#include <libkern/OSByteOrder.h>
 #include <mach/machine.h>
-#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
 
 #include <mach-o/fat.h>
 #include <mach-o/loader.h>
 #include <mach-o/swap.h>
 
-#import "FBControlCoreError.h"
-
 FBBinaryArchitecture const FBBinaryArchitecturei386 = @"i386";
 FBBinaryArchitecture const FBBinaryArchitecturex86_64 = @"x86_64";
 FBBinaryArchitecture const FBBinaryArchitectureArm = @"arm";
@@ -44,7 +44,9 @@ static inline NSString *MagicNameForMagic(uint32_t magic)
     @(MH_MAGIC_64) : @"MH_MAGIC_64",
     @(MH_CIGAM_64) : @"MH_CIGAM_64",
     @(FAT_MAGIC) : @"FAT_MAGIC",
-    @(FAT_CIGAM) : @"FAT_CIGAM"
+    @(FAT_CIGAM) : @"FAT_CIGAM",
+    @(FAT_MAGIC_64) : @"FAT_MAGIC_64",
+    @(FAT_CIGAM_64) : @"FAT_CIGAM_64",
   };
   return lookup[@(magic)];
 }
@@ -59,287 +61,265 @@ static inline BOOL IsMagic64(uint32_t magic)
   return magic == MH_MAGIC_64 || magic == MH_CIGAM_64;
 }
 
-static inline BOOL IsFatMagic(uint32_t magic)
+static inline BOOL IsFatMagic32(uint32_t magic)
 {
   return magic == FAT_MAGIC || magic == FAT_CIGAM;
 }
 
-static inline BOOL IsSwap(uint32_t magic)
+static inline BOOL IsFatMagic64(uint32_t magic)
 {
-  return magic == MH_CIGAM || magic == MH_CIGAM_64 || magic == FAT_CIGAM;
+  return magic == FAT_MAGIC_64 || magic == FAT_CIGAM_64;
 }
 
-static inline BOOL IsMagic(uint32_t magic)
+static inline BOOL IsFatMagic(uint32_t magic)
 {
-  return IsMagic32(magic) || IsMagic64(magic) || IsFatMagic(magic);
+  return IsFatMagic32(magic) || IsFatMagic64(magic);
 }
 
-static inline uint32_t GetMagic(FILE *file)
+static inline BOOL IsSwap(uint32_t magic)
 {
-  // Get then read from the current position.
-  long position = ftell(file);
-  uint32_t magic;
-  fread(&magic, sizeof(uint32_t), 1, file);
-
-  // Move back to the previous position now we know the magic.
-  fseek(file, position, SEEK_SET);
-  return magic;
+  return magic == MH_CIGAM || magic == MH_CIGAM_64;
 }
 
-static inline struct mach_header ReadHeader32(FILE *file, uint32_t magic)
+static inline BOOL IsMagic(uint32_t magic)
 {
-  // Read the header from the current location.
-  struct mach_header header;
-  fread(&header, sizeof(struct mach_header), 1, file);
-  if (IsSwap(magic)) {
-    swap_mach_header(&header, 0);
-  }
-  return header;
+  return IsMagic32(magic) || IsMagic64(magic) || IsFatMagic(magic);
 }
 
-static inline struct mach_header_64 ReadHeader64(FILE *file, uint32_t magic)
+static inline uint32_t ReadUInt32(const uint8_t *bytes, size_t offset, BOOL swap)
 {
-  // Read the header from the current location.
-  struct mach_header_64 header;
-  fread(&header, sizeof(header), 1, file);
-  if (IsSwap(magic)) {
-    swap_mach_header_64(&header, 0);
-  }
-  return header;
+  // Load commands are not guaranteed to be aligned, so copy rather than cast.
+  uint32_t value;
+  memcpy(&value, bytes + offset, sizeof(value));
+  return swap ? OSSwapInt32(value) : value;
 }
 
-static inline struct fat_header ReadFatHeader(FILE *file, uint32_t fatMagic)
+/**
+ The values extracted from the load commands of every architecture in a binary.
+ Paths are collected as NUL-terminated strings whilst parsing, and are only materialized as NSStrings when requested.
+ */
+@interface FBBinaryLoadCommands : NSObject
+
+@property (nonatomic, strong, readonly) NSMutableSet<FBBinaryArchitecture> *architectures;
+@property (nonatomic, strong, nullable, readwrite) NSUUID *uuid;
+@property (nonatomic, strong, readonly) NSMutableData *rpathStrings;
+@property (nonatomic, strong, readonly) NSMutableData *linkedLibraryStrings;
+
+@end
+
+@implementation FBBinaryLoadCommands
 {
-  // Get the Fat Header.
-  struct fat_header header;
-  fread(&header, sizeof(struct fat_header), 1, file);
-  if (IsSwap(fatMagic)) {
-    swap_fat_header(&header, 0);
-  }
-  return header;
+  NSArray<NSString *> *_rpaths;
+  NSArray<NSString *> *_linkedLibraries;
 }
 
-static inline id EnumerateFat(FILE *file, uint32_t fatMagic, id(^block)(struct fat_arch fatArch, uint32_t magic))
+- (instancetype)init
 {
-  // Get the Fat Header.
-  struct fat_header header = ReadFatHeader(file, fatMagic);
-
-  long fatArchPosition = sizeof(struct fat_header);
-  for (uint32_t index = 0; index < header.nfat_arch; index++) {
-    // Seek-to then get the Fat Arch info
-    fseek(file, fatArchPosition, SEEK_SET);
-    struct fat_arch fatArch;
-    fread(&fatArch, sizeof(struct fat_arch), 1, file);
-    if (IsSwap(fatMagic)) {
-      swap_fat_arch(&fatArch, 1, 0);
-    }
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
 
-    // Seek to the start position of the arch
-    fseek(file, fatArch.offset, SEEK_SET);
-    uint32_t magic = GetMagic(file);
-    if (!IsMagic(magic)){
-      return nil;
-    }
+  _architectures = [NSMutableSet set];
+  _rpathStrings = [NSMutableData data];
+  _linkedLibraryStrings = [NSMutableData data];
 
-    // Call the block
-    id value = block(fatArch, magic);
-    if (value) {
-      return value;
-    }
-    fatArchPosition += sizeof(struct fat_arch);
-  }
-  return nil;
+  return self;
 }
 
-static inline id EnumerateLoadCommands64(FILE *file, uint32_t magic, id (^block)(FILE *file, struct load_command command, uint32_t offset) )
++ (NSArray<NSString *> *)stringsFromBuffer:(NSData *)buffer
 {
-  struct mach_header_64 header = ReadHeader64(file, magic);
-  // Offset is relative to header length and position in file. In a fat binary it's not right equal to sizeof(header).
-  uint32_t offset = (uint32_t) ftell(file);
-  for (uint32_t i = 0; i < header.ncmds; i++) {
-    struct load_command command = {0x0, 0x0};
-    fseek(file, offset, SEEK_SET);
-    fread(&command, sizeof(command), 1, file);
-    fseek(file, offset, SEEK_SET);
-    id value = block(file, command, offset);
-    if (value) {
-      return value;
+  // The same path will usually be present in each architecture, only the first occurrence is kept.
+  NSMutableOrderedSet<NSString *> *strings = [NSMutableOrderedSet orderedSet];
+  const char *bytes = buffer.bytes;
+  size_t length = buffer.length;
+  size_t offset = 0;
+  while (offset < length) {
+    size_t stringLength = strnlen(bytes + offset, length - offset);
+    NSString *string = [[NSString alloc] initWithBytes:bytes + offset length:stringLength encoding:NSUTF8StringEncoding];
+    if (string) {
+      [strings addObject:string];
     }
-    offset += command.cmdsize;
+    offset += stringLength + 1;
   }
-  return nil;
+  return strings.array;
 }
 
-static inline id EnumerateLoadCommands32(FILE *file, uint32_t magic, id (^block)(FILE *file, struct load_command command, uint32_t offset) )
+- (NSArray<NSString *> *)rpaths
 {
-  struct mach_header header = ReadHeader32(file, magic);
-  // Offset is relative to header length and position in file. In a fat binary it's not right equal to sizeof(header).
-  uint32_t offset = (uint32_t) ftell(file);
-  for (uint32_t i = 0; i < header.ncmds; i++) {
-    struct load_command command = {0x0, 0x0};
-    fseek(file, offset, SEEK_SET);
-    fread(&command, sizeof(command), 1, file);
-    fseek(file, offset, SEEK_SET);
-    id value = block(file, command, offset);
-    if (value) {
-      return value;
+  @synchronized (self) {
+    if (!_rpaths) {
+      _rpaths = [FBBinaryLoadCommands stringsFromBuffer:self.rpathStrings];
     }
-    offset += command.cmdsize;
+    return _rpaths;
   }
-  return nil;
 }
 
-static inline NSArray<NSString *> *ReadRPathsSpecific(FILE *file, uint32_t magic, id(*Enumerator)(FILE *, uint32_t magic, id (^)(FILE *, struct load_command, uint32_t)))
+- (NSArray<NSString *> *)linkedLibraries
 {
-  NSMutableArray<NSString *> *rpaths = NSMutableArray.array;
-  Enumerator(file, magic, ^ id (FILE *_, struct load_command command, uint32_t offset) {
-    if (command.cmd != LC_RPATH) {
-      return nil;
+  @synchronized (self) {
+    if (!_linkedLibraries) {
+      _linkedLibraries = [FBBinaryLoadCommands stringsFromBuffer:self.linkedLibraryStrings];
     }
-    // Offset is calculated from the start of the command
-    struct rpath_command rpathCommand;
-    fseek(file, offset, SEEK_SET);
-    fread(&rpathCommand, sizeof(rpathCommand), 1, file);
-
-    // Calculate the offset and move back
-    const uint32_t pathOffset = offset + rpathCommand.path.offset;
-    const uint32_t pathLength = command.cmdsize;
-
-    // Extract the path
-    char *path = alloca(command.cmdsize);
-    fseek(file, pathOffset, SEEK_SET);
-    fread(path, pathLength, 1, file);
-
-    // Create an NSString for the rpaths
-    NSString *string = [[NSString alloc] initWithBytes:path length:strlen(path) encoding:NSASCIIStringEncoding];
-    [rpaths addObject:string];
-
-    return nil;
-  });
-  return rpaths;
-}
-
-static inline NSArray<NSString *> *ReadRPaths(FILE *file, uint32_t magic);
-
-static inline NSArray<NSString *> *ReadRPathsFat(FILE *file, uint32_t fatMagic)
-{
-  return EnumerateFat(file, fatMagic, ^id(struct fat_arch fatArch, uint32_t magic) {
-    return ReadRPaths(file, magic);
-  });
-}
-
-static inline NSUUID *ReadUUID(FILE *file, uint32_t magic);
-
-static id (^UUIDEnumerator)(FILE *, struct load_command, uint32_t) = ^id (FILE *file, struct load_command command, uint32_t offset){
-  if (command.cmd != LC_UUID) {
-    return nil;
+    return _linkedLibraries;
   }
-  struct uuid_command uuidCommand;
-  fread(&uuidCommand, sizeof(uuidCommand), 1, file);
-  NSUUID *uuid = [[NSUUID alloc] initWithUUIDBytes:uuidCommand.uuid];
-  return uuid;
-};
-
-static inline NSUUID *ReadUUID64(FILE *file, uint32_t magic)
-{
-  return EnumerateLoadCommands64(file, magic, UUIDEnumerator);
 }
 
-static inline NSUUID *ReadUUID32(FILE *file, uint32_t magic)
-{
-  return EnumerateLoadCommands32(file, magic, UUIDEnumerator);
-}
+@end
 
-static inline NSUUID *ReadUUIDFat(FILE *file, uint32_t fatMagic)
+static inline void AppendLoadCommandString(const uint8_t *command, uint32_t commandSize, BOOL swap, NSMutableData *strings)
 {
-  return EnumerateFat(file, fatMagic, ^ id (struct fat_arch fatArch, uint32_t magic) {
-    // Get the Arch
-    return ReadUUID(file, magic);
-  });
+  // Both rpath_command and dylib_command have the lc_str offset immediately after the load_command.
+  if (commandSize < sizeof(struct load_command) + sizeof(uint32_t)) {
+    return;
+  }
+  uint32_t stringOffset = ReadUInt32(command, sizeof(struct load_command), swap);
+  if (stringOffset >= commandSize) {
+    return;
+  }
+  const char *string = (const char *) command + stringOffset;
+  size_t stringLength = strnlen(string, commandSize - stringOffset);
+  [strings appendBytes:string length:stringLength];
+  [strings appendBytes:"\0" length:1];
 }
 
-static inline NSUUID *ReadUUID(FILE *file, uint32_t magic)
+static inline NSString *ParseSlice(const uint8_t *bytes, size_t length, FBBinaryLoadCommands *loadCommands)
 {
-  if (IsFatMagic(magic)) {
-    return ReadUUIDFat(file, magic);
+  if (length < sizeof(struct mach_header)) {
+    return @"Binary is too small to contain a mach header";
   }
-  if (IsMagic64(magic)) {
-    return ReadUUID64(file, magic);
+  uint32_t magic = ReadUInt32(bytes, 0, NO);
+  if (!IsMagic32(magic) && !IsMagic64(magic)) {
+    return [NSString stringWithFormat:@"Could not interpret magic '%d' of architecture", magic];
   }
-  if (IsMagic32(magic)) {
-    return ReadUUID32(file, magic);
+  BOOL swap = IsSwap(magic);
+  size_t headerSize = IsMagic64(magic) ? sizeof(struct mach_header_64) : sizeof(struct mach_header);
+  if (length < headerSize) {
+    return [NSString stringWithFormat:@"Binary is too small to contain a %@ header", MagicNameForMagic(magic)];
   }
-  return nil;
-}
-
-static inline FBBinaryArchitecture ReadArch32(FILE *file, uint32_t magic)
-{
-  struct mach_header header = ReadHeader32(file, magic);
-  return ArchitectureForCPUType(header.cputype);
-}
-
-static inline FBBinaryArchitecture ReadArch64(FILE *file, uint32_t magic)
-{
-  struct mach_header_64 header = ReadHeader64(file, magic);
-  return ArchitectureForCPUType(header.cputype);
-}
-
-static inline FBBinaryArchitecture ReadArch(FILE *file, uint32_t magic)
-{
-  if (IsMagic32(magic)) {
-    return ReadArch32(file, magic);
+  // The fields that are read are common to both the 32 and 64 bit headers.
+  struct mach_header header;
+  memcpy(&header, bytes, sizeof(header));
+  if (swap) {
+    swap_mach_header(&header, 0);
   }
-  if (IsMagic64(magic)) {
-    return ReadArch64(file, magic);
+  FBBinaryArchitecture architecture = ArchitectureForCPUType(header.cputype);
+  if (architecture) {
+    [loadCommands.architectures addObject:architecture];
+  }
+  if (header.sizeofcmds > length - headerSize) {
+    return [NSString stringWithFormat:@"Load commands of size %u exceed the size of the architecture %zu", header.sizeofcmds, length];
   }
-  return nil;
-}
 
-static inline NSArray<FBBinaryArchitecture> *ReadArchsFat(FILE *file, uint32_t fatMagic)
-{
-  NSMutableArray<FBBinaryArchitecture> *array = [NSMutableArray array];
-  EnumerateFat(file, fatMagic, ^id(struct fat_arch fatArch, uint32_t magic) {
-    // Get the Arch
-    NSString *arch = ReadArch(file, magic);
-    if (!arch) {
-      return nil;
+  size_t offset = headerSize;
+  size_t end = headerSize + header.sizeofcmds;
+  for (uint32_t index = 0; index < header.ncmds; index++) {
+    if (end - offset < sizeof(struct load_command)) {
+      return [NSString stringWithFormat:@"Load command %u is beyond the end of the load commands", index];
     }
-    [array addObject:arch];
-    return nil;
-  });
-  return array;
+    const uint8_t *command = bytes + offset;
+    uint32_t commandType = ReadUInt32(command, 0, swap);
+    uint32_t commandSize = ReadUInt32(command, sizeof(uint32_t), swap);
+    if (commandSize < sizeof(struct load_command) || commandSize > end - offset) {
+      return [NSString stringWithFormat:@"Load command %u has an invalid size %u", index, commandSize];
+    }
+    switch (commandType) {
+      case LC_UUID:
+        if (!loadCommands.uuid && commandSize >= sizeof(struct uuid_command)) {
+          loadCommands.uuid = [[NSUUID alloc] initWithUUIDBytes:command + offsetof(struct uuid_command, uuid)];
+        }
+        break;
+      case LC_RPATH:
+        AppendLoadCommandString(command, commandSize, swap, loadCommands.rpathStrings);
+        break;
+      case LC_LOAD_DYLIB:
+      case LC_LOAD_WEAK_DYLIB:
+      case LC_REEXPORT_DYLIB:
+      case LC_LAZY_LOAD_DYLIB:
+      case LC_LOAD_UPWARD_DYLIB:
+        AppendLoadCommandString(command, commandSize, swap, loadCommands.linkedLibraryStrings);
+        break;
+      default:
+        break;
+    }
+    offset += commandSize;
+  }
+  return nil;
 }
 
-static inline NSArray<FBBinaryArchitecture> *ReadArchs(FILE *file, uint32_t magic)
+static inline NSString *ParseFat(const uint8_t *bytes, size_t length, uint32_t fatMagic, FBBinaryLoadCommands *loadCommands)
 {
-  if (IsFatMagic(magic)) {
-    return ReadArchsFat(file, magic);
+  // Fat headers are always big-endian.
+  if (length < sizeof(struct fat_header)) {
+    return @"Binary is too small to contain a fat header";
   }
-  if (IsMagic32(magic)) {
-    FBBinaryArchitecture arch = ReadArch32(file, magic);
-    return arch ? @[arch] : @[];
+  uint32_t archCount = OSSwapBigToHostInt32(ReadUInt32(bytes, offsetof(struct fat_header, nfat_arch), NO));
+  BOOL is64 = IsFatMagic64(fatMagic);
+  size_t archSize = is64 ? sizeof(struct fat_arch_64) : sizeof(struct fat_arch);
+  if (archCount > (length - sizeof(struct fat_header)) / archSize) {
+    return [NSString stringWithFormat:@"Fat header with %u architectures exceeds the size of the binary", archCount];
   }
-  if (IsMagic64(magic)) {
-    FBBinaryArchitecture arch = ReadArch64(file, magic);
-    return arch ? @[arch] : @[];
+  for (uint32_t index = 0; index < archCount; index++) {
+    const uint8_t *arch = bytes + sizeof(struct fat_header) + (index * archSize);
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    if (is64) {
+      struct fat_arch_64 fatArch;
+      memcpy(&fatArch, arch, sizeof(fatArch));
+      offset = OSSwapBigToHostInt64(fatArch.offset);
+      size = OSSwapBigToHostInt64(fatArch.size);
+    } else {
+      struct fat_arch fatArch;
+      memcpy(&fatArch, arch, sizeof(fatArch));
+      offset = OSSwapBigToHostInt32(fatArch.offset);
+      size = OSSwapBigToHostInt32(fatArch.size);
+    }
+    if (offset > length || size > length - offset) {
+      return [NSString stringWithFormat:@"Architecture %u at offset %llu with size %llu exceeds the size of the binary", index, offset, size];
+    }
+    NSString *message = ParseSlice(bytes + offset, (size_t) size, loadCommands);
+    if (message) {
+      return message;
+    }
   }
-  return @[];
+  return nil;
 }
 
-static inline NSArray<NSString *> *ReadRPaths(FILE *file, uint32_t magic)
+static inline FBBinaryLoadCommands *ParseLoadCommands(NSString *path, NSError **error)
 {
-  if (IsFatMagic(magic)) {
-    return ReadRPathsFat(file, magic);
+  // The binary is mapped, so only the pages containing headers and load commands are read from disk.
+  NSError *innerError = nil;
+  NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:&innerError];
+  if (!data) {
+    return [[[FBControlCoreError
+      describeFormat:@"Could not map file at path %@", path]
+      causedBy:innerError]
+      fail:error];
   }
-  if (IsMagic64(magic)) {
-    return ReadRPathsSpecific(file, magic, EnumerateLoadCommands64);
+  const uint8_t *bytes = data.bytes;
+  size_t length = data.length;
+  if (length < sizeof(uint32_t)) {
+    return [[FBControlCoreError describeFormat:@"File at path %@ is too small to be a binary", path] fail:error];
   }
-  if (IsMagic32(magic)) {
-    return ReadRPathsSpecific(file, magic, EnumerateLoadCommands32);
+  uint32_t magic = ReadUInt32(bytes, 0, NO);
+  if (!IsMagic(magic)) {
+    return [[FBControlCoreError describeFormat:@"Could not interpret magic '%d' in file %@", magic, path] fail:error];
   }
-  return nil;
+
+  FBBinaryLoadCommands *loadCommands = [FBBinaryLoadCommands new];
+  NSString *message = IsFatMagic(magic) ? ParseFat(bytes, length, magic, loadCommands) : ParseSlice(bytes, length, loadCommands);
+  if (message) {
+    return [[FBControlCoreError describeFormat:@"%@ of magic %@ in file %@", message, MagicNameForMagic(magic), path] fail:error];
+  }
+  return loadCommands;
 }
 
+@interface FBBinaryDescriptor ()
+
+@property (nonatomic, strong, nullable, readwrite) FBBinaryLoadCommands *loadCommands;
+
+@end
+
 @implementation FBBinaryDescriptor
 
 - (instancetype)initWithName:(NSString *)name architectures:(NSSet<FBBinaryArchitecture> *)architectures uuid:(NSUUID *)uuid path:(NSString *)path
@@ -369,37 +349,18 @@ static inline NSArray<NSString *> *ReadRPaths(FILE *file, uint32_t magic)
       fail:error];
   }
 
-  FILE *file = fopen(binaryPath.UTF8String, "rb");
-  if (file == NULL) {
-    return [[FBControlCoreError describeFormat:@"Could not fopen file at path %@", binaryPath] fail:error];
-  }
-
-  // Seek to and read the magic.
-  rewind(file);
-  uint32_t magic = GetMagic(file);
-
-  if (!IsMagic(magic)) {
-    fclose(file);
-    return [[FBControlCoreError describeFormat:@"Could not interpret magic '%d' in file %@", magic, binaryPath] fail:error];
-  }
-
-  NSArray *archs = ReadArchs(file, magic);
-  if (!archs) {
-    fclose(file);
-    return [[FBControlCoreError describeFormat:@"Could not read architechtures of magic %@ in file %@", MagicNameForMagic(magic), binaryPath] fail:error];
+  FBBinaryLoadCommands *loadCommands = ParseLoadCommands(binaryPath, error);
+  if (!loadCommands) {
+    return nil;
   }
 
-  // Rewind to the start of the file
-  rewind(file);
-  NSUUID *uuid = ReadUUID(file, magic);
-
-  fclose(file);
-
-  return [[FBBinaryDescriptor alloc]
+  FBBinaryDescriptor *binary = [[FBBinaryDescriptor alloc]
     initWithName:[self binaryNameForBinaryPath:binaryPath]
-    architectures:[NSSet setWithArray:archs]
-    uuid:uuid
+    architectures:[loadCommands.architectures copy]
+    uuid:loadCommands.uuid
     path:binaryPath];
+  binary.loadCommands = loadCommands;
+  return binary;
 }
 
 #pragma mark NSCopying
@@ -441,28 +402,27 @@ static inline NSArray<NSString *> *ReadRPaths(FILE *file, uint32_t magic)
 
 - (NSArray<NSString *> *)rpathsWithError:(NSError **)error
 {
-  FILE *file = fopen(self.path.UTF8String, "rb");
-  if (file == NULL) {
-    return [[FBControlCoreError describeFormat:@"Could not fopen file at path %@", self.path] fail:error];
-  }
-
-  // Seek to and read the magic.
-  rewind(file);
-  uint32_t magic = GetMagic(file);
-
-  if (!IsMagic(magic)) {
-    fclose(file);
-    return [[FBControlCoreError describeFormat:@"Could not interpret magic '%d' in file %@", magic, self.path] fail:error];
-  }
-
-  NSArray<NSString *> *rpaths = ReadRPaths(file, magic);
-  fclose(file);
+  return [self loadCommandsWithError:error].rpaths;
+}
 
-  return rpaths;
+- (NSArray<NSString *> *)linkedLibrariesWithError:(NSError **)error
+{
+  return [self loadCommandsWithError:error].linkedLibraries;
 }
 
 #pragma mark Private
 
+- (FBBinaryLoadCommands *)loadCommandsWithError:(NSError **)error
+{
+  // Descriptors that are not created from a path are parsed on first use.
+  @synchronized (self) {
+    if (!self.loadCommands) {
+      self.loadCommands = ParseLoadCommands(self.path, error);
+    }
+    return self.loadCommands;
+  }
+}
+
 + (NSString *)binaryNameForBinaryPath:(NSString *)binaryPath
 {
   return binaryPath.lastPathComponent;
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBFuture.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A condition that Futures can wait upon.
+ The owner of some state signals the condition whenever that state may have changed, so that waiters re-evaluate as soon as it changes, instead of on an interval.
+ */
+@interface FBFutureCondition : NSObject
+
+/**
+ Re-evaluates every Future that is waiting on the condition, each on its own queue.
+ May be called from any thread.
+ */
+- (void)signal;
+
+@end
+
+/**
+ Constructors for Futures that resolve in response to events, instead of polling at a fixed interval.
+ */
+@interface FBFuture<T> (Events)
+
+/**
+ Constructs a Future that resolves when the resolveWhen block returns YES, polling with an exponential backoff.
+ The block is evaluated immediately, then after intervals that double from the initial interval up to the maximum interval.
+ This is for state that has no notification: a change soon after the wait starts is noticed sooner than with a fixed interval, and a long wait wakes up less often.
+
+ @param queue the queue to evaluate the block on.
+ @param resolveWhen a block determining when the future should resolve.
+ @param initialInterval the interval before the first re-evaluation.
+ @param maximumInterval the interval that the backoff stops growing at.
+ @return a new Future that resolves when the block returns YES.
+ */
++ (FBFuture<NSNull *> *)onQueue:(dispatch_queue_t)queue resolveWhen:(BOOL (^)(void))resolveWhen backoffFrom:(NSTimeInterval)initialInterval to:(NSTimeInterval)maximumInterval;
+
+/**
+ Constructs a Future that resolves when the resolveWhen block returns YES, re-evaluating it when the condition is signalled.
+ The block is evaluated immediately, then every time the condition is signalled.
+ The block is also evaluated with a slow exponential backoff, so that a change that is never signalled still resolves the Future.
+
+ @param queue the queue to evaluate the block on.
+ @param resolveWhen a block determining when the future should resolve.
+ @param condition the condition that is signalled when the state that the block evaluates changes.
+ @return a new Future that resolves when the block returns YES.
+ */
++ (FBFuture<NSNull *> *)onQueue:(dispatch_queue_t)queue resolveWhen:(BOOL (^)(void))resolveWhen signalledBy:(FBFutureCondition *)condition;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBFuture+Events.h"
+
+// A signalled waiter only polls in case a change is never signalled, so it can back off much further.
+static const NSTimeInterval SignalledFallbackInitialInterval = 0.25;
+static const NSTimeInterval SignalledFallbackMaximumInterval = 4;
+
+/**
+ Evaluates a predicate on a queue until it returns YES, resolving a Future when it does.
+ */
+@interface FBFutureWaiter : NSObject
+
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, copy, readonly) BOOL (^resolveWhen)(void);
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *future;
+@property (nonatomic, strong, readonly) dispatch_source_t timer;
+@property (nonatomic, assign, readwrite) NSTimeInterval interval;
+@property (nonatomic, assign, readonly) NSTimeInterval maximumInterval;
+
+@end
+
+@implementation FBFutureWaiter
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue resolveWhen:(BOOL (^)(void))resolveWhen initialInterval:(NSTimeInterval)initialInterval maximumInterval:(NSTimeInterval)maximumInterval
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _queue = queue;
+  _resolveWhen = resolveWhen;
+  _future = FBMutableFuture.future;
+  _interval = initialInterval;
+  _maximumInterval = MAX(initialInterval, maximumInterval);
+  _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+
+  return self;
+}
+
+- (void)start
+{
+  // The timer only references the waiter weakly. The waiter is retained by the completion handler of the future until the future completes.
+  __weak typeof(self) weakSelf = self;
+  dispatch_source_t timer = self.timer;
+  dispatch_source_set_event_handler(timer, ^{
+    FBFutureWaiter *waiter = weakSelf;
+    if (!waiter) {
+      dispatch_source_cancel(timer);
+      return;
+    }
+    [waiter backoff];
+  });
+  [self.future onQueue:self.queue notifyOfCompletion:^(FBFuture *_) {
+    dispatch_source_cancel(self.timer);
+  }];
+  [self scheduleTimer];
+  dispatch_resume(timer);
+  dispatch_async(self.queue, ^{
+    [self evaluate];
+  });
+}
+
+- (void)evaluate
+{
+  if (self.future.state != FBFutureStateRunning) {
+    return;
+  }
+  if (self.resolveWhen()) {
+    [self.future resolveWithResult:NSNull.null];
+  }
+}
+
+- (void)backoff
+{
+  [self evaluate];
+  self.interval = MIN(self.interval * 2, self.maximumInterval);
+  [self scheduleTimer];
+}
+
+- (void)scheduleTimer
+{
+  dispatch_source_set_timer(self.timer, FBCreateDispatchTimeFromDuration(self.interval), DISPATCH_TIME_FOREVER, (uint64_t) (self.interval * NSEC_PER_SEC / 10));
+}
+
+@end
+
+@interface FBFutureCondition ()
+
+@property (nonatomic, strong, readonly) NSHashTable<FBFutureWaiter *> *waiters;
+
+- (void)addWaiter:(FBFutureWaiter *)waiter;
+
+@end
+
+@implementation FBFutureCondition
+
+- (instancetype)init
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _waiters = [NSHashTable weakObjectsHashTable];
+
+  return self;
+}
+
+- (void)signal
+{
+  NSArray<FBFutureWaiter *> *waiters = nil;
+  @synchronized (self) {
+    waiters = self.waiters.allObjects;
+  }
+  for (FBFutureWaiter *waiter in waiters) {
+    dispatch_async(waiter.queue, ^{
+      [waiter evaluate];
+    });
+  }
+}
+
+#pragma mark Private
+
+- (void)addWaiter:(FBFutureWaiter *)waiter
+{
+  @synchronized (self) {
+    [self.waiters addObject:waiter];
+  }
+  [waiter.future onQueue:waiter.queue notifyOfCompletion:^(FBFuture *_) {
+    @synchronized (self) {
+      [self.waiters removeObject:waiter];
+    }
+  }];
+}
+
+@end
+
+@implementation FBFuture (Events)
+
++ (FBFuture<NSNull *> *)onQueue:(dispatch_queue_t)queue resolveWhen:(BOOL (^)(void))resolveWhen backoffFrom:(NSTimeInterval)initialInterval to:(NSTimeInterval)maximumInterval
+{
+  FBFutureWaiter *waiter = [[FBFutureWaiter alloc] initWithQueue:queue resolveWhen:resolveWhen initialInterval:initialInterval maximumInterval:maximumInterval];
+  [waiter start];
+  return waiter.future;
+}
+
++ (FBFuture<NSNull *> *)onQueue:(dispatch_queue_t)queue resolveWhen:(BOOL (^)(void))resolveWhen signalledBy:(FBFutureCondition *)condition
+{
+  FBFutureWaiter *waiter = [[FBFutureWaiter alloc] initWithQueue:queue resolveWhen:resolveWhen initialInterval:SignalledFallbackInitialInterval maximumInterval:SignalledFallbackMaximumInterval];
+  // The waiter is added before the first evaluation, so that a signal can't be missed between the two.
+  [condition addWaiter:waiter];
+  [waiter start];
+  return waiter.future;
+}
+
+@end
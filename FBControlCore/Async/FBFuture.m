@@ -7,6 +7,8 @@
 
 #import "FBFuture.h"
 
+#import <stdatomic.h>
+
 #import "FBCollectionOperations.h"
 #import "FBControlCore.h"
 
@@ -123,54 +125,138 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
     }];
 }
 
-@interface FBFuture_Handler : NSObject
-
-@property (nonatomic, strong, readonly) dispatch_queue_t queue;
-@property (nonatomic, strong, readonly) void (^handler)(FBFuture *);
+/**
+ The internal state of a Future that has been claimed by a resolution, but has not yet been published.
+ This is reported as running, as the result, error and handlers have not yet been published.
+ */
+static const FBFutureState FBFutureStateResolving = 0;
 
-@end
+/**
+ A node in the intrusive list of the completion handlers, or cancellation responders, of a Future.
+ The node owns a reference to the queue and the block, which are transferred out when the node is consumed.
+ */
+typedef struct FBFuture_Node {
+  struct FBFuture_Node *next;
+  void *queue;
+  void *block;
+} FBFuture_Node;
 
-@implementation FBFuture_Handler
+/**
+ The head of a list that has been consumed.
+ Once a list is closed, nothing more can be added to it, so whatever is added has to be handled by the caller.
+ */
+static FBFuture_Node FBFuture_NodeListClosedSentinel;
+#define FBFuture_NodeListClosed (&FBFuture_NodeListClosedSentinel)
 
-- (instancetype)initWithQueue:(dispatch_queue_t)queue handler:(void (^)(FBFuture *))handler
+/**
+ Adds to the head of a list, returning NO if the list has been closed.
+ */
+static BOOL FBFuture_NodeListPush(_Atomic(FBFuture_Node *) *list, dispatch_queue_t queue, id block)
 {
-  self = [super init];
-  if (!self) {
-    return nil;
+  FBFuture_Node *head = atomic_load_explicit(list, memory_order_acquire);
+  if (head == FBFuture_NodeListClosed) {
+    return NO;
   }
+  FBFuture_Node *node = malloc(sizeof(FBFuture_Node));
+  node->queue = (__bridge_retained void *) queue;
+  // The block may be on the stack, so must be copied before it is retained.
+  node->block = (__bridge_retained void *) [block copy];
+  do {
+    if (head == FBFuture_NodeListClosed) {
+      CFRelease(node->queue);
+      CFRelease(node->block);
+      free(node);
+      return NO;
+    }
+    node->next = head;
+  } while (!atomic_compare_exchange_weak_explicit(list, &head, node, memory_order_acq_rel, memory_order_acquire));
+  return YES;
+}
 
-  _queue = queue;
-  _handler = handler;
+/**
+ Closes a list, returning the nodes that were in it in the order that they were added.
+ */
+static FBFuture_Node *FBFuture_NodeListClose(_Atomic(FBFuture_Node *) *list)
+{
+  FBFuture_Node *head = atomic_exchange_explicit(list, FBFuture_NodeListClosed, memory_order_acq_rel);
+  if (head == FBFuture_NodeListClosed) {
+    return NULL;
+  }
+  // Nodes are pushed to the head, so reverse them to get the order in which they were added.
+  FBFuture_Node *ordered = NULL;
+  while (head) {
+    FBFuture_Node *next = head->next;
+    head->next = ordered;
+    ordered = head;
+    head = next;
+  }
+  return ordered;
+}
 
-  return self;
+/**
+ Consumes a node, transferring ownership of the queue and block to the caller, returning the next node.
+ */
+static FBFuture_Node *FBFuture_NodeConsume(FBFuture_Node *node, __strong dispatch_queue_t *queueOut, __strong id *blockOut)
+{
+  FBFuture_Node *next = node->next;
+  *queueOut = (__bridge_transfer dispatch_queue_t) node->queue;
+  *blockOut = (__bridge_transfer id) node->block;
+  free(node);
+  return next;
 }
 
-@end
+/**
+ Releases the nodes of a list without calling any of the blocks in it.
+ */
+static void FBFuture_NodeListDiscard(FBFuture_Node *node)
+{
+  if (node == FBFuture_NodeListClosed) {
+    return;
+  }
+  while (node) {
+    dispatch_queue_t queue = nil;
+    id block = nil;
+    node = FBFuture_NodeConsume(node, &queue, &block);
+  }
+}
 
-@interface FBFuture_Cancellation : NSObject
+// Handlers that are called in-line, instead of being dispatched, are bounded so that a long chain of Futures can't exhaust the stack.
+static const NSUInteger FBFutureMaximumInlineDepth = 16;
+static _Thread_local NSUInteger FBFutureInlineDepth = 0;
 
-@property (nonatomic, strong, readonly) dispatch_queue_t queue;
-@property (nonatomic, strong, readonly) FBFuture<NSNull *> *(^handler)(void);
+// The specific value for this key is the queue itself, for queues that completion handlers have been called on.
+static char FBFutureCurrentQueueKey;
 
-@end
+static BOOL FBFuture_IsGlobalQueue(dispatch_queue_t queue)
+{
+  return queue == dispatch_get_global_queue(dispatch_queue_get_qos_class(queue, NULL), 0);
+}
 
-@implementation FBFuture_Cancellation
+static void FBFuture_DispatchHandler(dispatch_queue_t queue, void (^handler)(FBFuture *), FBFuture *future)
+{
+  dispatch_async(queue, ^{
+    // Mark the queue, so that a Future resolved from this handler can call handlers for this queue in-line.
+    // Specifics can't be set on global queues, which are never called in-line.
+    if (dispatch_get_specific(&FBFutureCurrentQueueKey) != (__bridge void *) queue && !FBFuture_IsGlobalQueue(queue)) {
+      dispatch_queue_set_specific(queue, &FBFutureCurrentQueueKey, (__bridge void *) queue, NULL);
+    }
+    handler(future);
+  });
+}
 
-- (instancetype)initWithQueue:(dispatch_queue_t)queue handler:(FBFuture<NSNull *> *(^)(void))handler
+static void FBFuture_CallHandler(dispatch_queue_t queue, void (^handler)(FBFuture *), FBFuture *future)
 {
-  self = [super init];
-  if (!self) {
-    return nil;
+  // dispatch_get_specific reflects the queue that is executing, including within a dispatch_sync to another queue.
+  // A handler is only called in-line if it would have been dispatched to the queue that is already executing.
+  if (FBFutureInlineDepth < FBFutureMaximumInlineDepth && dispatch_get_specific(&FBFutureCurrentQueueKey) == (__bridge void *) queue) {
+    FBFutureInlineDepth++;
+    handler(future);
+    FBFutureInlineDepth--;
+    return;
   }
-
-  _queue = queue;
-  _handler = handler;
-
-  return self;
+  FBFuture_DispatchHandler(queue, handler, future);
 }
 
-@end
-
 @interface FBFutureContext_Teardown : NSObject
 
 @property (nonatomic, strong, readonly) FBFuture *future;
@@ -371,15 +457,20 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
 @interface FBFuture ()
 
 @property (atomic, copy, nullable, readwrite) NSString *name;
-@property (nonatomic, strong, readonly) NSMutableArray<FBFuture_Handler *> *handlers;
-@property (nonatomic, strong, nullable, readwrite) NSMutableArray<FBFuture_Cancellation *> *cancelResponders;
 @property (nonatomic, strong, nullable, readwrite) FBFuture<NSNull *> *resolvedCancellation;
 
 @end
 
 @implementation FBFuture
-
-@synthesize error = _error, result = _result, state = _state;
+{
+  // The state is claimed by a resolution with a compare-and-swap, so only one resolution can publish a result or error.
+  _Atomic(FBFutureState) _state;
+  // Retained references, published before the state.
+  _Atomic(void *) _result;
+  _Atomic(void *) _error;
+  _Atomic(FBFuture_Node *) _handlers;
+  _Atomic(FBFuture_Node *) _cancelResponders;
+}
 
 #pragma mark Initializers
 
@@ -524,10 +615,10 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
 
   FBMutableFuture *compositeFuture = FBMutableFuture.future;
   NSMutableArray *results = [[FBCollectionOperations arrayWithObject:NSNull.null count:futures.count] mutableCopy];
-  dispatch_queue_t queue = dispatch_queue_create("com.facebook.fbcontrolcore.future.composite", DISPATCH_QUEUE_SERIAL);
   __block NSUInteger remaining = futures.count;
 
-  // `futureCompleted` must be called on `queue`.
+  // Completions may be concurrent, so the results are guarded by a lock instead of a queue per composite.
+  // The composite is resolved outside of the lock, as resolving may call handlers in-line.
   void (^futureCompleted)(FBFuture *, NSUInteger) = ^(FBFuture *future, NSUInteger index) {
     if (compositeFuture.hasCompleted) {
       return;
@@ -535,13 +626,20 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
 
     FBFutureState state = future.state;
     switch (state) {
-      case FBFutureStateDone:
-        results[index] = future.result;
-        remaining--;
-        if (remaining == 0) {
-          [compositeFuture resolveWithResult:[results copy]];
+      case FBFutureStateDone: {
+        NSArray *completed = nil;
+        @synchronized (results) {
+          results[index] = future.result;
+          remaining--;
+          if (remaining == 0) {
+            completed = [results copy];
+          }
+        }
+        if (completed) {
+          [compositeFuture resolveWithResult:completed];
         }
         return;
+      }
       case FBFutureStateFailed:
         [compositeFuture resolveWithError:future.error];
         return;
@@ -560,16 +658,9 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
       // The reason that this is done in-line is to avoid work being
       // asynchronous when not necessary. For example a future-of-futures where
       // the input futures have resolved already should resolve immediately.
-      // The dispatch_sync ensures that in this case, the composed future is
-      // resolved before returning from the constructor.
-      // It's OK to use dispatch_sync here: queue is local; there is no dispatch
-      // calls within futureCompleted().
-      // @lint-ignore FBOBJCDISCOURAGEDFUNCTION
-      dispatch_sync(queue, ^{
-        futureCompleted(future, index);
-      });
+      futureCompleted(future, index);
     } else {
-      [future onQueue:queue notifyOfCompletion:^(FBFuture *innerFuture){
+      [future onQueue:FBFuture.internalQueue notifyOfCompletion:^(FBFuture *innerFuture){
         futureCompleted(innerFuture, index);
       }];
     }
@@ -582,8 +673,9 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
   NSParameterAssert(futures.count > 0);
 
   FBMutableFuture *compositeFuture = FBMutableFuture.future;
-  dispatch_queue_t queue = dispatch_queue_create("com.facebook.fbcontrolcore.future.race", DISPATCH_QUEUE_SERIAL);
   __block NSUInteger remainingCounter = futures.count;
+  // The array belongs to the caller, so it can't be used as the lock.
+  NSObject *counterLock = [NSObject new];
 
   void (^cancelAllFutures)(void) = ^{
     for (FBFuture *future in futures) {
@@ -591,9 +683,12 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
     }
   };
 
-  // `futureCompleted` must be called on `queue`.
+  // Completions may be concurrent. Only the first resolution of the composite takes effect, so only the count needs to be guarded.
   void (^futureCompleted)(FBFuture *future) = ^(FBFuture *future){
-    remainingCounter--;
+    NSUInteger remaining = 0;
+    @synchronized (counterLock) {
+      remaining = --remainingCounter;
+    }
     if (future.result) {
       [compositeFuture resolveWithResult:future.result];
       cancelAllFutures();
@@ -604,7 +699,7 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
       cancelAllFutures();
       return;
     }
-    if (remainingCounter == 0) {
+    if (remaining == 0) {
       [compositeFuture cancel];
     }
   };
@@ -614,16 +709,9 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
       // The reason that this is done in-line is to avoid work being
       // asynchronous when not necessary. For example a future-of-futures where
       // the input futures have resolved already should resolve immediately.
-      // The dispatch_sync ensures that in this case, the composed future is
-      // resolved before returning from the constructor.
-      // It's OK to use dispatch_sync here: queue is local; there is no dispatch
-      // calls within futureCompleted()
-      // @lint-ignore FBOBJCDISCOURAGEDFUNCTION
-      dispatch_sync(queue, ^{
-        futureCompleted(future);
-      });
+      futureCompleted(future);
     } else {
-      [future onQueue:queue notifyOfCompletion:futureCompleted];
+      [future onQueue:FBFuture.internalQueue notifyOfCompletion:futureCompleted];
     }
   }
   return compositeFuture;
@@ -647,15 +735,31 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
     return nil;
   }
 
-  _state = FBFutureStateRunning;
-  _handlers = [NSMutableArray array];
-  _cancelResponders = [NSMutableArray array];
+  atomic_init(&_state, FBFutureStateRunning);
+  atomic_init(&_result, NULL);
+  atomic_init(&_error, NULL);
+  atomic_init(&_handlers, NULL);
+  atomic_init(&_cancelResponders, NULL);
 
   _name = name;
 
   return self;
 }
 
+- (void)dealloc
+{
+  FBFuture_NodeListDiscard(atomic_load_explicit(&_handlers, memory_order_acquire));
+  FBFuture_NodeListDiscard(atomic_load_explicit(&_cancelResponders, memory_order_acquire));
+  void *result = atomic_load_explicit(&_result, memory_order_acquire);
+  if (result) {
+    CFRelease(result);
+  }
+  void *error = atomic_load_explicit(&_error, memory_order_acquire);
+  if (error) {
+    CFRelease(error);
+  }
+}
+
 #pragma mark NSObject
 
 - (NSString *)description
@@ -676,26 +780,29 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
     if (self.resolvedCancellation) {
       return self.resolvedCancellation;
     }
-    if (self.state != FBFutureStateRunning) {
-      return FBFuture.empty;
-    }
   }
-  NSArray<FBFuture_Cancellation *> *cancelResponders = [self resolveAsCancelled];
+  if (![self claimResolution]) {
+    return FBFuture.empty;
+  }
+  FBFuture_Node *cancelResponders = FBFuture_NodeListClose(&_cancelResponders);
+  [self publishState:FBFutureStateCancelled];
+  FBFuture<NSNull *> *resolvedCancellation = [FBFuture resolveCancellationResponders:cancelResponders forOriginalName:self.name];
   @synchronized (self) {
-    self.resolvedCancellation = [FBFuture resolveCancellationResponders:cancelResponders forOriginalName:self.name];
-    return self.resolvedCancellation;
+    self.resolvedCancellation = resolvedCancellation;
+    return resolvedCancellation;
   }
 }
 
 - (instancetype)shieldCancellation
 {
-  @synchronized (self) {
-    if (self.state != FBFutureStateRunning) {
+  FBFuture_Node *head = atomic_load_explicit(&_cancelResponders, memory_order_acquire);
+  do {
+    if (head == FBFuture_NodeListClosed) {
       return self;
     }
-    [self.cancelResponders removeAllObjects];
-    return self;
-  }
+  } while (!atomic_compare_exchange_weak_explicit(&_cancelResponders, &head, NULL, memory_order_acq_rel, memory_order_acquire));
+  FBFuture_NodeListDiscard(head);
+  return self;
 }
 
 - (instancetype)onQueue:(dispatch_queue_t)queue respondToCancellation:(FBFuture<NSNull *> *(^)(void))handler
@@ -703,10 +810,9 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
   NSParameterAssert(queue);
   NSParameterAssert(handler);
 
-  @synchronized(self) {
-    [self.cancelResponders addObject:[[FBFuture_Cancellation alloc] initWithQueue:queue handler:handler]];
-    return self;
-  }
+  // Responders added once the Future has resolved will never be called.
+  FBFuture_NodeListPush(&_cancelResponders, queue, handler);
+  return self;
 }
 
 #pragma mark Completion Notification
@@ -716,15 +822,9 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
   NSParameterAssert(queue);
   NSParameterAssert(handler);
 
-  @synchronized (self) {
-    if (self.state == FBFutureStateRunning) {
-      FBFuture_Handler *wrapper = [[FBFuture_Handler alloc] initWithQueue:queue handler:handler];
-      [self.handlers addObject:wrapper];
-    } else {
-      dispatch_async(queue, ^{
-        handler(self);
-      });
-    }
+  // A handler added to a Future that has already resolved is always dispatched, as the caller may not expect it to be called before this returns.
+  if (!FBFuture_NodeListPush(&_handlers, queue, handler)) {
+    FBFuture_DispatchHandler(queue, handler, self);
   }
   return self;
 }
@@ -925,66 +1025,45 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
 
 - (NSError *)error
 {
-  @synchronized (self) {
-    return self->_error;
-  }
+  return (__bridge NSError *) atomic_load_explicit(&_error, memory_order_acquire);
 }
 
 - (id)result
 {
-  @synchronized (self) {
-    return self->_result;
-  }
+  return (__bridge id) atomic_load_explicit(&_result, memory_order_acquire);
 }
 
 - (FBFutureState)state
 {
-  @synchronized (self) {
-    return _state;
-  }
-}
-
-- (void)setError:(NSError *)error
-{
-  _error = error;
-}
-
-- (void)setState:(FBFutureState)state
-{
-  _state = state;
-}
-
-- (void)setResult:(id)result
-{
-  _result = result;
+  FBFutureState state = atomic_load_explicit(&_state, memory_order_acquire);
+  return state == FBFutureStateResolving ? FBFutureStateRunning : state;
 }
 
 #pragma mark FBMutableFuture Implementation
 
 - (instancetype)resolveWithResult:(id)result
 {
-  @synchronized (self) {
-    if (self.state == FBFutureStateRunning) {
-      self.result = result;
-      self.state = FBFutureStateDone;
-      [self fireAllHandlers];
-      self.cancelResponders = nil;
-    }
+  if (![self claimResolution]) {
+    return self;
   }
-
+  [self willChangeValueForKey:@"result"];
+  atomic_store_explicit(&_result, (__bridge_retained void *) result, memory_order_release);
+  [self didChangeValueForKey:@"result"];
+  [self publishState:FBFutureStateDone];
+  FBFuture_NodeListDiscard(FBFuture_NodeListClose(&_cancelResponders));
   return self;
 }
 
 - (instancetype)resolveWithError:(NSError *)error
 {
-  @synchronized (self) {
-    if (self.state == FBFutureStateRunning) {
-      self.error = error;
-      self.state = FBFutureStateFailed;
-      [self fireAllHandlers];
-      self.cancelResponders = nil;
-    }
+  if (![self claimResolution]) {
+    return self;
   }
+  [self willChangeValueForKey:@"error"];
+  atomic_store_explicit(&_error, (__bridge_retained void *) error, memory_order_release);
+  [self didChangeValueForKey:@"error"];
+  [self publishState:FBFutureStateFailed];
+  FBFuture_NodeListDiscard(FBFuture_NodeListClose(&_cancelResponders));
   return self;
 }
 
@@ -1016,56 +1095,84 @@ static void final_resolveUntil(FBMutableFuture *final, dispatch_queue_t queue, F
 
 #pragma mark Private
 
-- (NSArray<FBFuture_Cancellation *> *)resolveAsCancelled
+- (BOOL)claimResolution
 {
-  @synchronized (self) {
-    if (self.state == FBFutureStateRunning) {
-      self.state = FBFutureStateCancelled;
-      [self fireAllHandlers];
-    }
-    NSArray<FBFuture_Cancellation *> *cancelResponders = self.cancelResponders;
-    self.cancelResponders = nil;
-    return cancelResponders;
-  }
+  FBFutureState expected = FBFutureStateRunning;
+  return atomic_compare_exchange_strong_explicit(&_state, &expected, FBFutureStateResolving, memory_order_acq_rel, memory_order_acquire);
+}
+
+- (void)publishState:(FBFutureState)state
+{
+  [self willChangeValueForKey:@"state"];
+  atomic_store_explicit(&_state, state, memory_order_release);
+  [self didChangeValueForKey:@"state"];
+  [self fireAllHandlers];
 }
 
 - (void)fireAllHandlers
 {
-  for (FBFuture_Handler *handler in self.handlers) {
-    dispatch_async(handler.queue, ^{
-      handler.handler(self);
-    });
+  FBFuture_Node *node = FBFuture_NodeListClose(&_handlers);
+  while (node) {
+    dispatch_queue_t queue = nil;
+    id handler = nil;
+    node = FBFuture_NodeConsume(node, &queue, &handler);
+    FBFuture_CallHandler(queue, handler, self);
   }
-  [self.handlers removeAllObjects];
 }
 
-+ (FBFuture<NSNull *> *)resolveCancellationResponders:(NSArray<FBFuture_Cancellation *> *)cancelResponders forOriginalName:(NSString *)originalName
++ (FBFuture<NSNull *> *)resolveCancellationResponders:(FBFuture_Node *)cancelResponders forOriginalName:(NSString *)originalName
 {
   NSString *name = [NSString stringWithFormat:@"Cancellation of %@", originalName];
-  if (cancelResponders.count == 0) {
+  NSMutableArray<FBFuture<NSNull *> *> *futures = [NSMutableArray array];
+  FBFuture_Node *node = cancelResponders;
+  while (node) {
+    dispatch_queue_t queue = nil;
+    id handler = nil;
+    node = FBFuture_NodeConsume(node, &queue, &handler);
+    [futures addObject:[FBFuture onQueue:queue resolve:handler]];
+  }
+  if (futures.count == 0) {
     return [FBFuture.empty named:name];
-  } else if (cancelResponders.count == 1) {
-    FBFuture_Cancellation *cancelResponder = cancelResponders[0];
-    return [[FBFuture onQueue:cancelResponder.queue resolve:cancelResponder.handler] named:name];
+  } else if (futures.count == 1) {
+    return [futures[0] named:name];
   } else {
-    NSMutableArray<FBFuture<NSNull *> *> *futures = [NSMutableArray array];
-    for (FBFuture_Cancellation *cancelResponder in cancelResponders) {
-      [futures addObject:[FBFuture onQueue:cancelResponder.queue resolve:cancelResponder.handler]];
-    }
     return [[[FBFuture futureWithFutures:futures] mapReplace:NSNull.null] named:name];
   }
 }
 
 + (dispatch_queue_t)internalQueue
 {
-  return dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
+  // A single concurrent queue is shared by all Futures, so that handlers for internal work can be called in-line.
+  static dispatch_queue_t queue;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    queue = dispatch_queue_create_with_target("com.facebook.fbcontrolcore.future.internal", DISPATCH_QUEUE_CONCURRENT, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
+    dispatch_queue_set_specific(queue, &FBFutureCurrentQueueKey, (__bridge void *) queue, NULL);
+  });
+  return queue;
 }
 
 #pragma mark KVO
 
++ (BOOL)automaticallyNotifiesObserversOfState
+{
+  // The state, result and error are published atomically, with notifications sent manually.
+  return NO;
+}
+
++ (BOOL)automaticallyNotifiesObserversOfResult
+{
+  return NO;
+}
+
++ (BOOL)automaticallyNotifiesObserversOfError
+{
+  return NO;
+}
+
 + (NSSet<NSString *> *)keyPathsForValuesAffectingHasCompleted
 {
-  return [NSSet setWithObjects:NSStringFromSelector(@selector(state)), nil];
+  return [NSSet setWithObjects:@"state", nil];
 }
 
 @end
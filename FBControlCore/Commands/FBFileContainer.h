@@ -72,6 +72,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FBFuture<NSArray<NSString *> *> *)contentsOfDirectory:(NSString *)path;
 
+@optional
+
+/**
+ Resolves a path within the container to the path on the host that backs it.
+ Only implemented by containers that are on the host's filesystem, so that items can be read in place rather than copied out first.
+
+ @param containerPath the sub-path within the container.
+ @return A future that resolves with the path on the host.
+ */
+- (FBFuture<NSString *> *)hostPathOfItemInContainer:(NSString *)containerPath;
+
 @end
 
 /**
@@ -18,6 +18,15 @@ extern FBVideoStreamEncoding const FBVideoStreamEncodingBGRA;
 extern FBVideoStreamEncoding const FBVideoStreamEncodingMJPEG;
 extern FBVideoStreamEncoding const FBVideoStreamEncodingMinicap;
 
+/**
+ Tiled encodings only send the regions of the screen that have changed since the previous frame, frames with no changes are not sent.
+ Each frame is a little-endian uint32 tile count, followed by each tile as little-endian uint32 x, y, width, height and payload length, followed by the payload.
+ The first frame, and the first frame after the screen changes size, is a single tile covering the whole screen.
+ For BGRATiles the payload is the rows of the tile, with no padding. For MJPEGTiles the payload is a JPEG of the tile.
+ */
+extern FBVideoStreamEncoding const FBVideoStreamEncodingBGRATiles;
+extern FBVideoStreamEncoding const FBVideoStreamEncodingMJPEGTiles;
+
 /**
  A Configuration Object for a Video Stream.
  */
@@ -15,6 +15,8 @@ FBVideoStreamEncoding const FBVideoStreamEncodingH264 = @"h264";
 FBVideoStreamEncoding const FBVideoStreamEncodingBGRA = @"bgra";
 FBVideoStreamEncoding const FBVideoStreamEncodingMJPEG = @"mjpeg";
 FBVideoStreamEncoding const FBVideoStreamEncodingMinicap = @"minicap";
+FBVideoStreamEncoding const FBVideoStreamEncodingBGRATiles = @"bgra-tiles";
+FBVideoStreamEncoding const FBVideoStreamEncodingMJPEGTiles = @"mjpeg-tiles";
 
 @implementation FBVideoStreamConfiguration
 
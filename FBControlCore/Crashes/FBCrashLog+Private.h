@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBCrashLog.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The attribute of a Crash Log that a FBCrashLogInfoPredicate matches on.
+ */
+typedef NS_ENUM(NSUInteger, FBCrashLogInfoPredicateKey) {
+  FBCrashLogInfoPredicateKeyName = 0, /** Matches the name of the Crash Log */
+  FBCrashLogInfoPredicateKeyIdentifier = 1, /** Matches the identifier of the Crash Log */
+  FBCrashLogInfoPredicateKeyProcessName = 2, /** Matches the name of the crashed process */
+  FBCrashLogInfoPredicateKeyProcessIdentifier = 3, /** Matches the process identifier of the crashed process */
+  FBCrashLogInfoPredicateKeyProcessType = 4, /** Matches any of the process types in the value */
+  FBCrashLogInfoPredicateKeyNewerThanDate = 5, /** Matches Crash Logs newer than the date in the value */
+  FBCrashLogInfoPredicateKeyExecutablePathContains = 6, /** Matches a substring of the executable path */
+};
+
+/**
+ The Predicate returned from the FBCrashLogInfo Predicate constructors.
+ Unlike a block predicate, the attribute and value can be inspected, so that a FBCrashLogStore can answer it from an index.
+ */
+@interface FBCrashLogInfoPredicate : NSPredicate
+
+/**
+ The Designated Initializer.
+
+ @param key the attribute to match.
+ @param value the value to match against.
+ @return a new Predicate.
+ */
+- (instancetype)initWithKey:(FBCrashLogInfoPredicateKey)key value:(id)value;
+
+/**
+ The attribute to match.
+ */
+@property (nonatomic, assign, readonly) FBCrashLogInfoPredicateKey key;
+
+/**
+ The value to match against.
+ */
+@property (nonatomic, strong, readonly) id value;
+
+@end
+
+/**
+ Private methods that should not be called by consumers.
+ */
+@interface FBCrashLogInfo (Private)
+
+/**
+ Constructs a Crash Log Info from previously extracted values.
+ */
+- (instancetype)initWithCrashPath:(NSString *)crashPath executablePath:(NSString *)executablePath identifier:(NSString *)identifier processName:(NSString *)processName processIdentifier:(pid_t)processIdentifer parentProcessName:(NSString *)parentProcessName parentProcessIdentifier:(pid_t)parentProcessIdentifier date:(NSDate *)date processType:(FBCrashLogInfoProcessType)processType;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -171,6 +171,22 @@ typedef NS_OPTIONS(NSUInteger, FBCrashLogInfoProcessType) {
  */
 + (NSPredicate *)predicateForName:(NSString *)name;
 
+/**
+ A Predicate for FBCrashLogInfo that matches the name of the crashed process.
+
+ @param processName the process name to use.
+ @return an NSPredicate
+ */
++ (NSPredicate *)predicateForProcessName:(NSString *)processName;
+
+/**
+ A Predicate for FBCrashLogInfo that matches any of the provided process types.
+
+ @param processType the process types to match.
+ @return an NSPredicate
+ */
++ (NSPredicate *)predicateForProcessType:(FBCrashLogInfoProcessType)processType;
+
 /**
  A Predicate that searches for a substring in the executable path.
 
@@ -6,6 +6,7 @@
  */
 
 #import "FBCrashLog.h"
+#import "FBCrashLog+Private.h"
 
 #import <stdio.h>
 
@@ -47,6 +48,67 @@
 
 @end
 
+@implementation FBCrashLogInfoPredicate
+
+#pragma mark Initializers
+
+- (instancetype)initWithKey:(FBCrashLogInfoPredicateKey)key value:(id)value
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _key = key;
+  _value = value;
+
+  return self;
+}
+
+#pragma mark NSPredicate
+
+- (BOOL)evaluateWithObject:(id)object
+{
+  return [self evaluateWithObject:object substitutionVariables:nil];
+}
+
+- (BOOL)evaluateWithObject:(FBCrashLogInfo *)crashLog substitutionVariables:(NSDictionary<NSString *, id> *)bindings
+{
+  switch (self.key) {
+    case FBCrashLogInfoPredicateKeyName:
+      return [self.value isEqualToString:crashLog.name];
+    case FBCrashLogInfoPredicateKeyIdentifier:
+      return [self.value isEqualToString:crashLog.identifier];
+    case FBCrashLogInfoPredicateKeyProcessName:
+      return [self.value isEqualToString:crashLog.processName];
+    case FBCrashLogInfoPredicateKeyProcessIdentifier:
+      return [self.value intValue] == crashLog.processIdentifier;
+    case FBCrashLogInfoPredicateKeyProcessType:
+      return ([self.value unsignedIntegerValue] & crashLog.processType) != 0;
+    case FBCrashLogInfoPredicateKeyNewerThanDate:
+      return [self.value compare:crashLog.date] == NSOrderedAscending;
+    case FBCrashLogInfoPredicateKeyExecutablePathContains:
+      return [crashLog.executablePath containsString:self.value];
+    default:
+      return NO;
+  }
+}
+
+- (NSString *)predicateFormat
+{
+  return [NSString stringWithFormat:@"FBCrashLogInfoPredicate(%lu, %@)", (unsigned long) self.key, self.value];
+}
+
+#pragma mark NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone
+{
+  // Is immutable
+  return self;
+}
+
+@end
+
 @implementation FBCrashLogInfo
 
 #pragma mark Initializers
@@ -212,16 +274,12 @@
 
 + (NSPredicate *)predicateForCrashLogsWithProcessID:(pid_t)processID
 {
-  return [NSPredicate predicateWithBlock:^ BOOL (FBCrashLogInfo *crashLog, id _) {
-    return crashLog.processIdentifier == processID;
-  }];
+  return [[FBCrashLogInfoPredicate alloc] initWithKey:FBCrashLogInfoPredicateKeyProcessIdentifier value:@(processID)];
 }
 
 + (NSPredicate *)predicateNewerThanDate:(NSDate *)date
 {
-  return [NSPredicate predicateWithBlock:^ BOOL (FBCrashLogInfo *crashLog, id _) {
-    return [date compare:crashLog.date] == NSOrderedAscending;
-  }];
+  return [[FBCrashLogInfoPredicate alloc] initWithKey:FBCrashLogInfoPredicateKeyNewerThanDate value:date];
 }
 
 + (NSPredicate *)predicateOlderThanDate:(NSDate *)date
@@ -231,23 +289,27 @@
 
 + (NSPredicate *)predicateForIdentifier:(NSString *)identifier
 {
-  return [NSPredicate predicateWithBlock:^ BOOL (FBCrashLogInfo *crashLog, id _) {
-    return [identifier isEqualToString:crashLog.identifier];
-  }];
+  return [[FBCrashLogInfoPredicate alloc] initWithKey:FBCrashLogInfoPredicateKeyIdentifier value:identifier];
 }
 
 + (NSPredicate *)predicateForName:(NSString *)name
 {
-  return [NSPredicate predicateWithBlock:^ BOOL (FBCrashLogInfo *crashLog, id _) {
-    return [name isEqualToString:crashLog.name];
-  }];
+  return [[FBCrashLogInfoPredicate alloc] initWithKey:FBCrashLogInfoPredicateKeyName value:name];
+}
+
++ (NSPredicate *)predicateForProcessName:(NSString *)processName
+{
+  return [[FBCrashLogInfoPredicate alloc] initWithKey:FBCrashLogInfoPredicateKeyProcessName value:processName];
+}
+
++ (NSPredicate *)predicateForProcessType:(FBCrashLogInfoProcessType)processType
+{
+  return [[FBCrashLogInfoPredicate alloc] initWithKey:FBCrashLogInfoPredicateKeyProcessType value:@(processType)];
 }
 
 + (NSPredicate *)predicateForExecutablePathContains:(NSString *)contains
 {
-  return [NSPredicate predicateWithBlock:^ BOOL (FBCrashLogInfo *crashLog, id _) {
-    return [crashLog.executablePath containsString:contains];
-  }];
+  return [[FBCrashLogInfoPredicate alloc] initWithKey:FBCrashLogInfoPredicateKeyExecutablePathContains value:contains];
 }
 
 #pragma mark Helpers
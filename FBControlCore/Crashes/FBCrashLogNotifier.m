@@ -149,7 +149,7 @@ static void EventStreamCallback(
     return nil;
   }
 
-  _store = [FBCrashLogStore storeForDirectories:FBCrashLogInfo.diagnosticReportsPaths logger:logger];
+  _store = [FBCrashLogStore storeForDirectories:FBCrashLogInfo.diagnosticReportsPaths indexPath:FBCrashLogNotifier.indexPath logger:logger];
 
 #if defined(__apple_build_version__)
   _fsEvents = [[FBCrashLogNotifier_FSEvents alloc] initWithDirectories:FBCrashLogInfo.diagnosticReportsPaths store:_store logger:logger];
@@ -170,6 +170,12 @@ static void EventStreamCallback(
   return notifier;
 }
 
++ (nullable NSString *)indexPath
+{
+  NSString *cachesDirectory = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+  return [cachesDirectory stringByAppendingPathComponent:@"com.facebook.fbcontrolcore/crash_log_index.plist"];
+}
+
 #pragma mark Public Methods
 
 - (instancetype)startListening:(BOOL)onlyNew
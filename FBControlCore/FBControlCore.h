@@ -12,6 +12,7 @@
 #import <FBControlCore/FBArchitecture.h>
 #import <FBControlCore/FBArchiveOperations.h>
 #import <FBControlCore/FBBinaryDescriptor.h>
+#import <FBControlCore/FBBoundedFrameDataConsumer.h>
 #import <FBControlCore/FBBundleDescriptor+Application.h>
 #import <FBControlCore/FBCodesignProvider.h>
 #import <FBControlCore/FBCollectionInformation.h>
@@ -39,9 +40,11 @@
 #import <FBControlCore/FBFileContainer.h>
 #import <FBControlCore/FBFileReader.h>
 #import <FBControlCore/FBFileWriter.h>
+#import <FBControlCore/FBFuture+Events.h>
 #import <FBControlCore/FBFuture+Sync.h>
 #import <FBControlCore/FBFuture.h>
 #import <FBControlCore/FBFutureContextManager.h>
+#import <FBControlCore/FBGzipStream.h>
 #import <FBControlCore/FBInstalledApplication.h>
 #import <FBControlCore/FBInstrumentsCommands.h>
 #import <FBControlCore/FBInstrumentsConfiguration.h>
@@ -55,6 +58,7 @@
 #import <FBControlCore/FBiOSTargetQuery.h>
 #import <FBControlCore/FBiOSTargetSet.h>
 #import <FBControlCore/FBLaunchedProcess.h>
+#import <FBControlCore/FBLineScanner.h>
 #import <FBControlCore/FBLocationCommands.h>
 #import <FBControlCore/FBLogCommands.h>
 #import <FBControlCore/FBLoggingWrapper.h>
@@ -74,6 +78,7 @@
 #import <FBControlCore/FBServiceManagement.h>
 #import <FBControlCore/FBSettingsCommands.h>
 #import <FBControlCore/FBSocketServer.h>
+#import <FBControlCore/FBTarStream.h>
 #import <FBControlCore/FBTask+Helpers.h>
 #import <FBControlCore/FBTask.h>
 #import <FBControlCore/FBTaskBuilder.h>
@@ -83,6 +88,7 @@
 #import <FBControlCore/FBVideoStream.h>
 #import <FBControlCore/FBVideoStreamCommands.h>
 #import <FBControlCore/FBVideoStreamConfiguration.h>
+#import <FBControlCore/FBVideoStreamRateController.h>
 #import <FBControlCore/FBWeakFramework+ApplePrivateFrameworks.h>
 #import <FBControlCore/FBWeakFrameworkLoader.h>
 #import <FBControlCore/FBXcodeConfiguration.h>
@@ -73,10 +73,11 @@
 
 - (FBFuture<NSNull *> *)onQueue:(dispatch_queue_t)queue waitForProcessIdentifierToDie:(pid_t)processIdentifier
 {
-  return [FBFuture onQueue:queue resolveWhen:^ BOOL {
-    FBProcessInfo *polledProcess = [self processInfoFor:processIdentifier];
-    return polledProcess == nil;
-  }];
+  return [[FBDispatchSourceNotifier
+    processTerminationFutureNotifierForProcessIdentifier:processIdentifier]
+    onQueue:queue map:^(id _) {
+      return NSNull.null;
+    }];
 }
 
 - (NSArray *)runningApplicationsForProcesses:(NSArray *)processes
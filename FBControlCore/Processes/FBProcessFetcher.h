@@ -13,10 +13,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  Queries for Processes running on the Host.
- Should not be called from multiple threads since buffers are re-used internally.
+ Buffers are re-used internally, so calls are serialized.
 
- Sharing a Query object and guaranteeing serialization of method calls
- can be an effective way to reduce the number of allocations that are required.
+ The arguments and environment of each process are cached by process identifier.
+ They are only re-read for processes that have not been seen before, or whose identifier has been re-used.
+ Sharing a Query object is an effective way to reduce the number of allocations and syscalls that are required.
  */
 @interface FBProcessFetcher : NSObject
 
@@ -64,6 +64,26 @@ static void IterateOpenFiles(pid_t *pidBuffer, size_t pidBufferSize, const char
   });
 }
 
+/**
+ The identity of a process, used to determine whether the arguments of a previously seen process identifier can be re-used.
+ The process start time disambiguates re-used process identifiers, the command name changes across an exec.
+ */
+typedef struct {
+  uint64_t startTime;
+  char name[MAXCOMLEN + 1];
+} FBProcessIdentity;
+
+static inline BOOL ProcessIdentityForProcessIdentifier(pid_t processIdentifier, FBProcessIdentity *identityOut)
+{
+  struct proc_bsdinfo info;
+  if (proc_pidinfo(processIdentifier, PROC_PIDTBSDINFO, 0, &info, PROC_PIDTBSDINFO_SIZE) != PROC_PIDTBSDINFO_SIZE) {
+    return NO;
+  }
+  identityOut->startTime = info.pbi_start_tvsec * USEC_PER_SEC + info.pbi_start_tvusec;
+  strlcpy(identityOut->name, info.pbi_comm, sizeof(identityOut->name));
+  return YES;
+}
+
 static inline FBProcessInfo *ProcessInfoForProcessIdentifier(pid_t processIdentifier, char *buffer, size_t bufferSize)
 {
   // Much of the layout information here comes from libtop.c in Apple's top(1) Open Source implementation.
@@ -79,7 +99,8 @@ static inline FBProcessInfo *ProcessInfoForProcessIdentifier(pid_t processIdenti
 
   // First Position is argc.
   const char *startPosition = buffer;
-  const int argc = *startPosition;
+  int argc = 0;
+  memcpy(&argc, startPosition, sizeof(argc));
 
   // If argc isn't 1 or more, something is wrong
   if (argc < 1) {
@@ -150,6 +171,23 @@ static BOOL ProcessNameForProcessIdentifier(pid_t processIdentifier, char *buffe
   return proc_name(processIdentifier, buffer, (uint32_t) bufferSize) > 1;
 }
 
+/**
+ A previously fetched process, along with the identity it was fetched for.
+ */
+@interface FBProcessFetcherCacheEntry : NSObject
+{
+  @public
+  FBProcessIdentity _identity;
+  FBProcessInfo *_process;
+  NSUInteger _generation;
+}
+
+@end
+
+@implementation FBProcessFetcherCacheEntry
+
+@end
+
 @interface FBProcessFetcher ()
 
 @property (nonatomic, assign, readonly) size_t argumentBufferSize;
@@ -158,6 +196,9 @@ static BOOL ProcessNameForProcessIdentifier(pid_t processIdentifier, char *buffe
 @property (nonatomic, assign, readonly) size_t pidBufferSize;
 @property (nonatomic, assign, readonly) pid_t *pidBuffer;
 
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSNumber *, FBProcessFetcherCacheEntry *> *cache;
+@property (nonatomic, assign, readwrite) NSUInteger generation;
+
 @end
 
 @implementation FBProcessFetcher
@@ -166,6 +207,7 @@ static BOOL ProcessNameForProcessIdentifier(pid_t processIdentifier, char *buffe
 
 static size_t MaxArgumentBufferSize = ARG_MAX; // A temporary value that is filled on load
 static size_t const MaxPidBufferSize = 5568 * 2 * sizeof(int);  // From 'ulimit -u', but twice as large, in ints.
+static NSUInteger const MaxCachedProcesses = 8192;
 
 + (void)load
 {
@@ -188,6 +230,8 @@ static size_t const MaxPidBufferSize = 5568 * 2 * sizeof(int);  // From 'ulimit
   _pidBufferSize = MaxPidBufferSize;
   _pidBuffer = malloc(_pidBufferSize);
 
+  _cache = [NSMutableDictionary dictionary];
+
   return self;
 }
 
@@ -201,102 +245,117 @@ static size_t const MaxPidBufferSize = 5568 * 2 * sizeof(int);  // From 'ulimit
 
 - (nullable FBProcessInfo *)processInfoFor:(pid_t)processIdentifier
 {
-  return ProcessInfoForProcessIdentifier(
-    processIdentifier,
-    self.argumentBuffer,
-    self.argumentBufferSize
-  );
+  @synchronized (self) {
+    FBProcessInfo *process = [self cachedProcessInfoFor:processIdentifier];
+    if (self.cache.count > MaxCachedProcesses) {
+      [self pruneCacheToSnapshot];
+    }
+    return process;
+  }
 }
 
 - (NSArray<FBProcessInfo *> *)subprocessesOf:(pid_t)parent
 {
-  NSMutableArray *subprocesses = [NSMutableArray array];
-
-  IterateSubprocessesOf(self.pidBuffer, self.pidBufferSize, parent, ^ BOOL (pid_t pid) {
-    FBProcessInfo *info = [self processInfoFor:pid];
-    if (info) {
-      [subprocesses addObject:info];
-    }
-    return YES;
-  });
+  @synchronized (self) {
+    NSMutableArray *subprocesses = [NSMutableArray array];
+
+    IterateSubprocessesOf(self.pidBuffer, self.pidBufferSize, parent, ^ BOOL (pid_t pid) {
+      FBProcessInfo *info = [self cachedProcessInfoFor:pid];
+      if (info) {
+        [subprocesses addObject:info];
+      }
+      return YES;
+    });
 
-  return [subprocesses copy];
+    return [subprocesses copy];
+  }
 }
 
 - (NSArray<FBProcessInfo *> *)processesWithLaunchPathSubstring:(NSString *)substring
 {
-  NSMutableArray *subprocesses = [NSMutableArray array];
-
-  IterateAllProcesses(self.pidBuffer, self.pidBufferSize, ^ BOOL (pid_t pid) {
-    FBProcessInfo *info = [self processInfoFor:pid];
-    if (!info) {
-      return YES;
-    }
-    if ([info.launchPath rangeOfString:substring].location == NSNotFound) {
+  @synchronized (self) {
+    NSMutableArray *subprocesses = [NSMutableArray array];
+    NSUInteger generation = ++self.generation;
+
+    IterateAllProcesses(self.pidBuffer, self.pidBufferSize, ^ BOOL (pid_t pid) {
+      FBProcessInfo *info = [self cachedProcessInfoFor:pid generation:generation];
+      if (!info) {
+        return YES;
+      }
+      if ([info.launchPath rangeOfString:substring].location == NSNotFound) {
+        return YES;
+      }
+      [subprocesses addObject:info];
       return YES;
-    }
-    [subprocesses addObject:info];
-    return YES;
-  });
+    });
+    // Every live process has been visited, so anything that was not is no longer running.
+    [self removeCacheEntriesOlderThan:generation];
 
-  return [subprocesses copy];
+    return [subprocesses copy];
+  }
 }
 
 - (NSArray<FBProcessInfo *> *)processesWithProcessName:(NSString *)processName
 {
-  NSMutableArray *subprocesses = [NSMutableArray array];
-  size_t bufferSize = self.argumentBufferSize;
-  char *buffer = self.argumentBuffer;
-  const char *needle = processName.UTF8String;
-
-  IterateAllProcesses(self.pidBuffer, self.pidBufferSize, ^ BOOL (pid_t pid) {
-    if (!ProcessNameForProcessIdentifier(pid, buffer, bufferSize)) {
-      return YES;
-    }
-    if (strcmp(needle, buffer) != 0) {
-      return YES;
-    }
-    FBProcessInfo *info = [self processInfoFor:pid];
-    if (!info) {
+  @synchronized (self) {
+    NSMutableArray *subprocesses = [NSMutableArray array];
+    size_t bufferSize = self.argumentBufferSize;
+    char *buffer = self.argumentBuffer;
+    const char *needle = processName.UTF8String;
+
+    IterateAllProcesses(self.pidBuffer, self.pidBufferSize, ^ BOOL (pid_t pid) {
+      if (!ProcessNameForProcessIdentifier(pid, buffer, bufferSize)) {
+        return YES;
+      }
+      if (strcmp(needle, buffer) != 0) {
+        return YES;
+      }
+      FBProcessInfo *info = [self cachedProcessInfoFor:pid];
+      if (!info) {
+        return YES;
+      }
+      [subprocesses addObject:info];
       return YES;
-    }
-    [subprocesses addObject:info];
-    return YES;
-  });
+    });
 
-  return [subprocesses copy];
+    return [subprocesses copy];
+  }
 }
 
 - (pid_t)subprocessOf:(pid_t)parent withName:(NSString *)needleString
 {
-  __block pid_t foundProcess = -1;
-  size_t argumentBufferSize = self.argumentBufferSize;
-  char *argumentBuffer = self.argumentBuffer;
-  const char *needle = needleString.UTF8String;
-
-  IterateSubprocessesOf(self.pidBuffer, self.pidBufferSize, parent, ^ BOOL (pid_t pid) {
-    if (proc_name(pid, argumentBuffer, (uint32_t) argumentBufferSize) == -1) {
-      return YES;
-    }
-    if (strstr(argumentBuffer, needle) == NULL) {
-      return YES;
-    }
-
-    foundProcess = pid;
-    return NO;
-  });
-
-  return foundProcess;
+  @synchronized (self) {
+    __block pid_t foundProcess = -1;
+    size_t argumentBufferSize = self.argumentBufferSize;
+    char *argumentBuffer = self.argumentBuffer;
+    const char *needle = needleString.UTF8String;
+
+    IterateSubprocessesOf(self.pidBuffer, self.pidBufferSize, parent, ^ BOOL (pid_t pid) {
+      if (proc_name(pid, argumentBuffer, (uint32_t) argumentBufferSize) == -1) {
+        return YES;
+      }
+      if (strstr(argumentBuffer, needle) == NULL) {
+        return YES;
+      }
+
+      foundProcess = pid;
+      return NO;
+    });
+
+    return foundProcess;
+  }
 }
 
 - (pid_t)processWithOpenFileTo:(const char *)filename
 {
-  __block pid_t processIdentifier = -1;
-  IterateOpenFiles(self.pidBuffer, self.pidBufferSize, filename, ^ BOOL (pid_t pid) {
-    processIdentifier = pid;
-    return NO;
-  });
-  return processIdentifier;
+  @synchronized (self) {
+    __block pid_t processIdentifier = -1;
+    IterateOpenFiles(self.pidBuffer, self.pidBufferSize, filename, ^ BOOL (pid_t pid) {
+      processIdentifier = pid;
+      return NO;
+    });
+    return processIdentifier;
+  }
 }
 
 - (pid_t)parentOf:(pid_t)child
@@ -308,4 +367,62 @@ static size_t const MaxPidBufferSize = 5568 * 2 * sizeof(int);  // From 'ulimit
   return proc.kp_eproc.e_ppid;
 }
 
+#pragma mark Private
+
+- (nullable FBProcessInfo *)cachedProcessInfoFor:(pid_t)processIdentifier
+{
+  return [self cachedProcessInfoFor:processIdentifier generation:self.generation];
+}
+
+- (nullable FBProcessInfo *)cachedProcessInfoFor:(pid_t)processIdentifier generation:(NSUInteger)generation
+{
+  // The arguments are only re-read for a process identifier that has not been seen, or has been re-used.
+  FBProcessIdentity identity;
+  if (!ProcessIdentityForProcessIdentifier(processIdentifier, &identity)) {
+    [self.cache removeObjectForKey:@(processIdentifier)];
+    return ProcessInfoForProcessIdentifier(processIdentifier, self.argumentBuffer, self.argumentBufferSize);
+  }
+  NSNumber *key = @(processIdentifier);
+  FBProcessFetcherCacheEntry *entry = self.cache[key];
+  if (entry && entry->_identity.startTime == identity.startTime && strcmp(entry->_identity.name, identity.name) == 0) {
+    entry->_generation = generation;
+    return entry->_process;
+  }
+  FBProcessInfo *process = ProcessInfoForProcessIdentifier(processIdentifier, self.argumentBuffer, self.argumentBufferSize);
+  if (!process) {
+    [self.cache removeObjectForKey:key];
+    return nil;
+  }
+  entry = [FBProcessFetcherCacheEntry new];
+  entry->_identity = identity;
+  entry->_process = process;
+  entry->_generation = generation;
+  self.cache[key] = entry;
+  return process;
+}
+
+- (void)pruneCacheToSnapshot
+{
+  NSUInteger generation = ++self.generation;
+  IterateAllProcesses(self.pidBuffer, self.pidBufferSize, ^ BOOL (pid_t pid) {
+    FBProcessFetcherCacheEntry *entry = self.cache[@(pid)];
+    if (entry) {
+      entry->_generation = generation;
+    }
+    return YES;
+  });
+  [self removeCacheEntriesOlderThan:generation];
+}
+
+- (void)removeCacheEntriesOlderThan:(NSUInteger)generation
+{
+  NSMutableArray<NSNumber *> *stale = [NSMutableArray array];
+  [self.cache enumerateKeysAndObjectsUsingBlock:^(NSNumber *key, FBProcessFetcherCacheEntry *entry, BOOL *_) {
+    if (entry->_generation < generation) {
+      [stale addObject:key];
+    }
+  }];
+  [self.cache removeObjectsForKeys:stale];
+}
+
 @end
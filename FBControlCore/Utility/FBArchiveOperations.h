@@ -7,6 +7,7 @@
 
 #import <Foundation/Foundation.h>
 
+#import <FBControlCore/FBDataConsumer.h>
 #import <FBControlCore/FBFuture.h>
 #import <FBControlCore/FBTask.h>
 
@@ -24,6 +25,7 @@ extern FBCompressionFormat const FBCompressionFormatZSTD;
 
 /**
  Operations of Zip/Tar Archives
+ Tar and gzip archives are read and written in-process, other formats are handled by launching bsdtar.
  */
 @interface FBArchiveOperations : NSObject
 
@@ -33,6 +35,7 @@ extern FBCompressionFormat const FBCompressionFormatZSTD;
  - An uncompressed tar.
  - A gzipped tar.
  - A zip.
+ Tars are extracted in-process.
 
  @param path the path to the archive.
  @param extractPath the extraction path.
@@ -49,6 +52,7 @@ extern FBCompressionFormat const FBCompressionFormatZSTD;
  - A gzipped tar.
  - A zstd compressed tar
  - A zip.
+ Uncompressed and gzipped tars are extracted in-process, as the stream is read.
 
  @param stream the stream of the archive.
  @param extractPath the extraction path
@@ -60,7 +64,7 @@ extern FBCompressionFormat const FBCompressionFormatZSTD;
 + (FBFuture<NSString *> *)extractArchiveFromStream:(FBProcessInput *)stream toPath:(NSString *)extractPath queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger compression:(FBCompressionFormat)compression;
 
 /**
- Extracts a gzip from a stream to a single file.
+ Extracts a gzip from a stream to a single file, in-process.
  A plain gzip wrapping a single file is preferred when there's only a single file to transfer.
 
  @param stream the stream of the gzip archive.
@@ -71,8 +75,33 @@ extern FBCompressionFormat const FBCompressionFormatZSTD;
  */
 + (FBFuture<NSString *> *)extractGzipFromStream:(FBProcessInput *)stream toPath:(NSString *)extractPath queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger;
 
+/**
+ Writes a gzip of a single file to a consumer, in-process.
+ The file is compressed on multiple threads.
+
+ @param path the path of the file to compress.
+ @param consumer the consumer to write the gzip to.
+ @param queue the queue to do work on
+ @param logger the logger to log to.
+ @return a Future that resolves when the gzip has been written and the consumer has been sent the end of file.
+ */
++ (FBFuture<NSNull *> *)writeGzipForPath:(NSString *)path toConsumer:(id<FBDataConsumer>)consumer queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger;
+
+/**
+ Writes a gzipped tar archive of a path to a consumer, in-process.
+ The archive is compressed on multiple threads.
+
+ @param path the path to archive.
+ @param consumer the consumer to write the archive to.
+ @param queue the queue to do work on
+ @param logger the logger to log to.
+ @return a Future that resolves when the archive has been written and the consumer has been sent the end of file.
+ */
++ (FBFuture<NSNull *> *)writeGzippedTarForPath:(NSString *)path toConsumer:(id<FBDataConsumer>)consumer queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger;
+
 /**
  Creates a gzips archive, returning an task that has an NSInputStream attached to stdout.
+ This launches gzip, -[FBArchiveOperations writeGzipForPath:toConsumer:queue:logger:] avoids the cost of a process.
  A plain gzip wrapping a single file is preferred when there's only a single file to transfer.
  Read the input stream to obtain all of the gzip output of the file.
 
@@ -86,6 +115,7 @@ extern FBCompressionFormat const FBCompressionFormatZSTD;
 /**
  Creates a gzipped tar archive, returning an task that has an NSInputStream attached to stdout.
  Read the input stream to obtain the gzipped tar output.
+ This launches bsdtar, -[FBArchiveOperations writeGzippedTarForPath:toConsumer:queue:logger:] avoids the cost of a process.
 
  @param path the path to archive.
  @param queue the queue to do work on
@@ -95,7 +125,7 @@ extern FBCompressionFormat const FBCompressionFormatZSTD;
 + (FBFuture<FBTask<NSNull *, NSInputStream *, id> *> *)createGzippedTarForPath:(NSString *)path queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger;
 
 /**
- Creates a gzipped tar archive, returning an the data of the tar.
+ Creates a gzipped tar archive in-process, returning an the data of the tar.
 
  @param path the path to archive.
  @param queue the queue to do work on
@@ -9,6 +9,11 @@
 
 #import "FBControlCoreError.h"
 #import "FBControlCoreLogger.h"
+#import "FBFileReader.h"
+#import "FBFileWriter.h"
+#import "FBGzipStream.h"
+#import "FBProcessStream.h"
+#import "FBTarStream.h"
 #import "FBTask.h"
 #import "FBTaskBuilder.h"
 
@@ -17,54 +22,200 @@ FBCompressionFormat const FBCompressionFormatZSTD = @"zstd";
 
 static NSString *const BSDTarPath = @"/usr/bin/bsdtar";
 
-@implementation FBArchiveOperations
+// Enough of the archive to recognise a tar header.
+static const NSUInteger ArchiveDetectionLength = 512;
 
-+ (FBFuture<NSString *> *)extractArchiveAtPath:(NSString *)path toPath:(NSString *)extractPath queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
+/**
+ Extracts an archive as it is consumed, deciding how to extract it from the first bytes of the archive.
+ Gzipped and uncompressed tars are extracted in-process, anything else (such as a zip) is extracted by bsdtar.
+ */
+@interface FBArchiveOperations_Extractor : NSObject <FBDataConsumer>
+
+@property (nonatomic, copy, readonly) NSString *extractPath;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, strong, readonly) id<FBControlCoreLogger> logger;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *completed;
+@property (nonatomic, strong, nullable, readwrite) NSMutableData *pending;
+@property (nonatomic, strong, nullable, readwrite) id<FBDataConsumer> destination;
+@property (nonatomic, assign, readwrite) BOOL detected;
+@property (nonatomic, assign, readwrite) BOOL endOfFile;
+
+@end
+
+@implementation FBArchiveOperations_Extractor
+
+- (instancetype)initWithExtractPath:(NSString *)extractPath queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _extractPath = extractPath;
+  _queue = queue;
+  _logger = logger;
+  _completed = FBMutableFuture.future;
+  _pending = [NSMutableData data];
+
+  return self;
+}
+
+#pragma mark FBDataConsumer
+
+- (void)consumeData:(NSData *)data
+{
+  @synchronized (self) {
+    if (self.destination) {
+      [self.destination consumeData:data];
+      return;
+    }
+    [self.pending appendData:data];
+    if (!self.detected && self.pending.length >= ArchiveDetectionLength) {
+      [self detectFormat];
+    }
+  }
+}
+
+- (void)consumeEndOfFile
+{
+  @synchronized (self) {
+    self.endOfFile = YES;
+    if (self.destination) {
+      [self.destination consumeEndOfFile];
+      return;
+    }
+    if (!self.detected) {
+      [self detectFormat];
+    }
+  }
+}
+
+#pragma mark Private
+
+- (void)detectFormat
 {
-  return [[[[[[[[FBTaskBuilder
+  self.detected = YES;
+  if ([FBGzipDecompressor isGzipData:self.pending] || [FBTarWriter isTarData:self.pending]) {
+    FBTarExtractor *extractor = [FBTarExtractor extractorWithDirectory:self.extractPath logger:self.logger];
+    [self.completed resolveFromFuture:extractor.finishedConsuming];
+    [self attachDestination:extractor];
+    return;
+  }
+
+  [self.logger logFormat:@"Archive is not a tar, extracting with %@", BSDTarPath];
+  FBProcessInput<id<FBDataConsumer>> *input = FBProcessInput.inputFromConsumer;
+  [[[[[[[[[FBTaskBuilder
     withLaunchPath:BSDTarPath]
-    withArguments:@[@"-zxp", @"-C", extractPath, @"-f", path]]
-    withStdErrToLoggerAndErrorMessage:logger.debug]
-    withStdOutToLogger:logger.debug]
+    withArguments:@[@"-xp", @"-C", self.extractPath, @"-f", @"-"]]
+    withStdIn:input]
+    withStdErrToLoggerAndErrorMessage:self.logger.debug]
+    withStdOutToLogger:self.logger.debug]
     withAcceptableExitCodes:[NSSet setWithObject:@0]]
-    withTaskLifecycleLoggingTo:logger]
-    runUntilCompletion]
+    withTaskLifecycleLoggingTo:self.logger]
+    start]
+    onQueue:self.queue notifyOfCompletion:^(FBFuture<FBTask *> *future) {
+      FBTask *task = future.result;
+      if (!task) {
+        [self.completed resolveWithError:future.error];
+        return;
+      }
+      // Data is buffered until the process has started, as the input is not attached until then.
+      @synchronized (self) {
+        [self attachDestination:input.contents];
+      }
+      [self.completed resolveFromFuture:[task.completed mapReplace:NSNull.null]];
+    }];
+}
+
+- (void)attachDestination:(id<FBDataConsumer>)destination
+{
+  self.destination = destination;
+  NSData *pending = self.pending;
+  self.pending = nil;
+  if (pending.length > 0) {
+    [destination consumeData:pending];
+  }
+  if (self.endOfFile) {
+    [destination consumeEndOfFile];
+  }
+}
+
+@end
+
+@implementation FBArchiveOperations
+
++ (FBFuture<NSString *> *)extractArchiveAtPath:(NSString *)path toPath:(NSString *)extractPath queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
+{
+  FBArchiveOperations_Extractor *extractor = [[FBArchiveOperations_Extractor alloc] initWithExtractPath:extractPath queue:queue logger:logger];
+  return [[[FBFileReader
+    readerWithFilePath:path consumer:extractor logger:logger]
+    onQueue:queue fmap:^(FBFileReader *reader) {
+      return [[reader
+        startReading]
+        onQueue:queue fmap:^(id _) {
+          return extractor.completed;
+        }];
+    }]
     mapReplace:extractPath];
 }
 
 + (FBFuture<NSString *> *)extractArchiveFromStream:(FBProcessInput *)stream toPath:(NSString *)extractPath queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger compression:(FBCompressionFormat)compression
 {
-  NSArray *extractCommand = @[@"-zxp", @"-C", extractPath, @"-f", @"-"];
-  if (compression == FBCompressionFormatZSTD) {
-    extractCommand = @[@"--use-compress-program", @"pzstd -d", @"-xp", @"-C", extractPath, @"-f", @"-"];
+  if ([compression isEqualToString:FBCompressionFormatZSTD]) {
+    // There is no zstd decoder available in-process, so this is extracted by bsdtar.
+    return [[[[[[[[[FBTaskBuilder
+      withLaunchPath:BSDTarPath]
+      withArguments:@[@"--use-compress-program", @"pzstd -d", @"-xp", @"-C", extractPath, @"-f", @"-"]]
+      withStdIn:stream]
+      withStdErrToLoggerAndErrorMessage:logger.debug]
+      withStdOutToLogger:logger.debug]
+      withAcceptableExitCodes:[NSSet setWithObject:@0]]
+      withTaskLifecycleLoggingTo:logger]
+      runUntilCompletion]
+      mapReplace:extractPath];
   }
-  
-  return [[[[[[[[[FBTaskBuilder
-    withLaunchPath:BSDTarPath]
-    withArguments:extractCommand]
-    withStdIn:stream]
-    withStdErrToLoggerAndErrorMessage:logger.debug]
-    withStdOutToLogger:logger.debug]
-    withAcceptableExitCodes:[NSSet setWithObject:@0]]
-    withTaskLifecycleLoggingTo:logger]
-    runUntilCompletion]
+
+  FBArchiveOperations_Extractor *extractor = [[FBArchiveOperations_Extractor alloc] initWithExtractPath:extractPath queue:queue logger:logger];
+  return [[self
+    readStream:stream toConsumer:extractor completed:extractor.completed queue:queue logger:logger]
     mapReplace:extractPath];
 }
 
 + (FBFuture<NSString *> *)extractGzipFromStream:(FBProcessInput *)stream toPath:(NSString *)extractPath queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
 {
-  return [[[[[[[[[FBTaskBuilder
-    withLaunchPath:@"/usr/bin/gunzip"]
-    withArguments:@[@"--to-stdout"]]
-    withStdIn:stream]
-    withStdErrToLoggerAndErrorMessage:logger.debug]
-    withStdOutPath:extractPath]
-    withAcceptableExitCodes:[NSSet setWithObject:@0]]
-    withTaskLifecycleLoggingTo:logger]
-    runUntilCompletion]
+  NSError *error = nil;
+  id<FBDataConsumer, FBDataConsumerLifecycle> writer = [FBFileWriter syncWriterForFilePath:extractPath error:&error];
+  if (!writer) {
+    return [FBFuture futureWithError:error];
+  }
+  FBGzipDecompressor *decompressor = [FBGzipDecompressor decompressorWithConsumer:writer];
+  return [[self
+    readStream:stream toConsumer:decompressor completed:decompressor.finishedConsuming queue:queue logger:logger]
     mapReplace:extractPath];
 }
 
++ (FBFuture<NSNull *> *)writeGzipForPath:(NSString *)path toConsumer:(id<FBDataConsumer>)consumer queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
+{
+  FBGzipCompressor *compressor = [FBGzipCompressor compressorWithConsumer:consumer];
+  return [[FBFileReader
+    readerWithFilePath:path consumer:compressor logger:logger]
+    onQueue:queue fmap:^(FBFileReader *reader) {
+      FBFuture<NSNull *> *read = [[reader
+        startReading]
+        onQueue:queue fmap:^(id _) {
+          return [reader finishedReading];
+        }];
+      return [self drainCompressor:compressor afterWriting:read queue:queue];
+    }];
+}
+
++ (FBFuture<NSNull *> *)writeGzippedTarForPath:(NSString *)path toConsumer:(id<FBDataConsumer>)consumer queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
+{
+  FBGzipCompressor *compressor = [FBGzipCompressor compressorWithConsumer:consumer];
+  FBFuture<NSNull *> *written = [FBTarWriter writeArchiveOfPath:path toConsumer:compressor queue:queue logger:logger];
+  return [self drainCompressor:compressor afterWriting:written queue:queue];
+}
+
 + (FBFuture<FBTask<NSNull *, NSInputStream *, id> *> *)createGzipForPath:(NSString *)path queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
 {
   return (FBFuture<FBTask<NSNull *, NSInputStream *, id> *> *) [[[[[[[FBTaskBuilder
@@ -91,20 +242,56 @@ static NSString *const BSDTarPath = @"/usr/bin/bsdtar";
 
 + (FBFuture<NSData *> *)createGzippedTarDataForPath:(NSString *)path queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
 {
-  NSError *error = nil;
-  FBTaskBuilder<NSNull *, NSData *, id> *builder = [self createGzippedTarTaskBuilderForPath:path queue:queue logger:logger error:&error];
-  if (!builder) {
-    return [FBFuture futureWithError:error];
-  }
-  return [[builder
-    runUntilCompletion]
-    onQueue:queue map:^(FBTask<NSNull *, NSData *, id<FBControlCoreLogger>> *result) {
-      return [result stdOut];
+  NSMutableData *data = NSMutableData.data;
+  id<FBDataConsumer> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *chunk) {
+    [data appendData:chunk];
+  }];
+  return [[self
+    writeGzippedTarForPath:path toConsumer:consumer queue:queue logger:logger]
+    onQueue:queue map:^(id _) {
+      return data;
     }];
 }
 
 #pragma mark Private
 
++ (FBFuture<NSNull *> *)readStream:(FBProcessInput *)stream toConsumer:(id<FBDataConsumer>)consumer completed:(FBFuture<NSNull *> *)completed queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
+{
+  // The stream is attached in the same way as it would be for the stdin of a process, then read in-process.
+  return [[stream
+    attach]
+    onQueue:queue fmap:^(FBProcessStreamAttachment *attachment) {
+      FBFileReader *reader = [FBFileReader readerWithFileDescriptor:attachment.fileDescriptor closeOnEndOfFile:NO consumer:consumer logger:logger];
+      return [[[reader
+        startReading]
+        onQueue:queue fmap:^(id _) {
+          return completed;
+        }]
+        onQueue:queue chain:^(FBFuture *future) {
+          // Reading must finish before the stream is detached, as detaching closes the file descriptor.
+          FBFuture *finishedReading = future.error ? [[reader stopReading] fallback:@0] : [reader finishedReading];
+          return [[[finishedReading
+            onQueue:queue chain:^(id _) {
+              return [stream detach];
+            }]
+            chainReplace:future]
+            mapReplace:NSNull.null];
+        }];
+    }];
+}
+
++ (FBFuture<NSNull *> *)drainCompressor:(FBGzipCompressor *)compressor afterWriting:(FBFuture<NSNull *> *)written queue:(dispatch_queue_t)queue
+{
+  return [written onQueue:queue chain:^(FBFuture<NSNull *> *future) {
+    // The compressor writes to the consumer from a queue of its own, so it must drain before any failure is reported and the consumer is released.
+    [compressor consumeEndOfFile];
+    return [compressor.finishedConsuming
+      onQueue:queue chain:^(FBFuture<NSNull *> *drained) {
+        return future.result ? drained : future;
+      }];
+  }];
+}
+
 + (FBTaskBuilder<NSNull *, NSData *, id> *)createGzippedTarTaskBuilderForPath:(NSString *)path queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger error:(NSError **)error
 {
   BOOL isDirectory;
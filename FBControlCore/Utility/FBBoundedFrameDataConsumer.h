@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBDataConsumer.h>
+#import <FBControlCore/FBVideoStreamConfiguration.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ What to drop when the queue of a FBBoundedFrameDataConsumer is full.
+ */
+typedef NS_ENUM(NSUInteger, FBFrameDropPolicy) {
+  FBFrameDropPolicyDropOldest = 0, /** The oldest queued frame is dropped to make room for a new frame. Suitable for encodings where every frame can be decoded on its own. */
+  FBFrameDropPolicyDropNonKeyframe = 1, /** Frames that are not keyframes are dropped until the next keyframe, which replaces everything that is queued. Suitable for encodings where frames depend on previous frames. */
+  FBFrameDropPolicyCoalesce = 2, /** Nothing is dropped, a new frame is appended to the most recently queued frame so that they are written together. Suitable for encodings where every frame is a delta that cannot be dropped. */
+};
+
+/**
+ A consumer of video frames that queues a bounded number of frames for a destination, so that a slow destination does not cause memory to grow without bound.
+ Frames are delimited by the producer with FBDataConsumerFrameDelimited, data for a frame is copied and accumulated until the end of the frame.
+ Each frame is written to the destination as a single call to `consumeData:`, followed by `consumeEndOfFrame` if the destination is also frame delimited.
+ The destination is written to from a private serial queue, so it may block without blocking the producer.
+
+ The encoding determines how keyframes are recognised:
+ - H264: A frame is a keyframe if it contains an IDR or SPS NAL Unit in the Annex-B stream.
+ - Minicap: Every frame is a keyframe, but the first frame contains the Minicap header so is never dropped.
+ - Otherwise: Every frame is a keyframe.
+ Tiled encodings depend upon every previous frame, so should only be passed through this consumer with FBFrameDropPolicyCoalesce.
+ */
+@interface FBBoundedFrameDataConsumer : NSObject <FBDataConsumer, FBDataConsumerStackConsuming, FBDataConsumerFrameDelimited, FBDataConsumerBacklog, FBDataConsumerLifecycle>
+
+#pragma mark Initializers
+
+/**
+ Constructs a Bounded Frame Consumer.
+
+ @param consumer the destination of the frames.
+ @param encoding the encoding of the frames.
+ @param maximumQueuedFrames the maximum number of frames that are queued, in addition to the frame that is being written.
+ @param dropPolicy the policy to apply when the queue is full.
+ @return a new Bounded Frame Consumer.
+ */
++ (instancetype)consumerWithConsumer:(id<FBDataConsumer>)consumer encoding:(FBVideoStreamEncoding)encoding maximumQueuedFrames:(NSUInteger)maximumQueuedFrames dropPolicy:(FBFrameDropPolicy)dropPolicy;
+
+#pragma mark Public Methods
+
+/**
+ Enqueues a complete frame.
+ This is equivalent to consuming the data of the frame followed by the end of the frame.
+
+ @param frame the data of the frame.
+ @return the number of frames that were dropped as a result of enqueuing the frame, including the frame itself.
+ */
+- (NSUInteger)consumeFrame:(NSData *)frame;
+
+/**
+ Returns YES if the frame is a keyframe in the provided encoding.
+
+ @param frame the data of the frame.
+ @param encoding the encoding of the frame.
+ @return YES if the frame can be decoded without any previous frame, NO otherwise.
+ */
++ (BOOL)isKeyframe:(NSData *)frame encoding:(FBVideoStreamEncoding)encoding;
+
+/**
+ Returns the policy that should be applied to frames of the provided encoding.
+
+ @param encoding the encoding of the frames.
+ @return the policy that drops as few frames as possible, without producing frames that cannot be decoded.
+ */
++ (FBFrameDropPolicy)dropPolicyForEncoding:(FBVideoStreamEncoding)encoding;
+
+#pragma mark Properties
+
+/**
+ The policy that is applied when the queue is full.
+ */
+@property (nonatomic, assign, readonly) FBFrameDropPolicy dropPolicy;
+
+/**
+ The number of frames that are queued and have not yet been written.
+ */
+@property (atomic, assign, readonly) NSUInteger queuedFrames;
+
+/**
+ The number of frames that have been written to the destination.
+ */
+@property (atomic, assign, readonly) NSUInteger framesWritten;
+
+/**
+ The number of frames that have been dropped.
+ */
+@property (atomic, assign, readonly) NSUInteger framesDropped;
+
+@end
+
+NS_ASSUME_NONNULL_END
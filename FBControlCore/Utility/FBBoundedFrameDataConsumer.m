@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBBoundedFrameDataConsumer.h"
+
+static const uint8_t FBAnnexBNALUnitTypeMask = 0x1f;
+static const uint8_t FBAnnexBNALUnitTypeIDR = 5;
+static const uint8_t FBAnnexBNALUnitTypeSPS = 7;
+
+static BOOL FBAnnexBFrameContainsKeyframe(const uint8_t *bytes, size_t length)
+{
+  // Every NAL Unit is preceeded by a start code of 0x000001, which may itself be preceeded by a zero byte.
+  for (size_t index = 0; index + 3 < length; index++) {
+    if (bytes[index] != 0x00 || bytes[index + 1] != 0x00 || bytes[index + 2] != 0x01) {
+      continue;
+    }
+    uint8_t type = bytes[index + 3] & FBAnnexBNALUnitTypeMask;
+    if (type == FBAnnexBNALUnitTypeIDR || type == FBAnnexBNALUnitTypeSPS) {
+      return YES;
+    }
+    index += 3;
+  }
+  return NO;
+}
+
+@interface FBBoundedFrameDataConsumer_Frame : NSObject
+
+@property (nonatomic, strong, readonly) NSData *data;
+@property (nonatomic, assign, readonly) BOOL keyframe;
+@property (nonatomic, assign, readonly) BOOL pinned;
+
+@end
+
+@implementation FBBoundedFrameDataConsumer_Frame
+
+- (instancetype)initWithData:(NSData *)data keyframe:(BOOL)keyframe pinned:(BOOL)pinned
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _data = data;
+  _keyframe = keyframe;
+  _pinned = pinned;
+
+  return self;
+}
+
+@end
+
+@interface FBBoundedFrameDataConsumer ()
+
+@property (nonatomic, strong, readonly) id<FBDataConsumer> consumer;
+@property (nonatomic, copy, readonly) FBVideoStreamEncoding encoding;
+@property (nonatomic, assign, readonly) NSUInteger maximumQueuedFrames;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, strong, readonly) NSMutableArray<FBBoundedFrameDataConsumer_Frame *> *frames;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *finishedConsumingFuture;
+@property (nonatomic, strong, readwrite) NSMutableData *currentFrame;
+@property (nonatomic, assign, readwrite) NSUInteger queuedBytes;
+@property (nonatomic, assign, readwrite) NSUInteger framesEnqueued;
+@property (nonatomic, assign, readwrite) BOOL awaitingKeyframe;
+@property (nonatomic, assign, readwrite) BOOL draining;
+@property (nonatomic, assign, readwrite) BOOL finishing;
+
+@end
+
+@implementation FBBoundedFrameDataConsumer
+
+@synthesize framesWritten = _framesWritten;
+@synthesize framesDropped = _framesDropped;
+
+#pragma mark Initializers
+
++ (instancetype)consumerWithConsumer:(id<FBDataConsumer>)consumer encoding:(FBVideoStreamEncoding)encoding maximumQueuedFrames:(NSUInteger)maximumQueuedFrames dropPolicy:(FBFrameDropPolicy)dropPolicy
+{
+  dispatch_queue_t queue = dispatch_queue_create("com.facebook.FBControlCore.BoundedFrameDataConsumer", DISPATCH_QUEUE_SERIAL);
+  return [[self alloc] initWithConsumer:consumer encoding:encoding maximumQueuedFrames:maximumQueuedFrames dropPolicy:dropPolicy queue:queue];
+}
+
+- (instancetype)initWithConsumer:(id<FBDataConsumer>)consumer encoding:(FBVideoStreamEncoding)encoding maximumQueuedFrames:(NSUInteger)maximumQueuedFrames dropPolicy:(FBFrameDropPolicy)dropPolicy queue:(dispatch_queue_t)queue
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _consumer = consumer;
+  _encoding = encoding;
+  _maximumQueuedFrames = MAX(maximumQueuedFrames, 1u);
+  _dropPolicy = dropPolicy;
+  _queue = queue;
+  _frames = [NSMutableArray array];
+  _finishedConsumingFuture = FBMutableFuture.future;
+  _currentFrame = NSMutableData.data;
+
+  return self;
+}
+
+#pragma mark Public Methods
+
++ (BOOL)isKeyframe:(NSData *)frame encoding:(FBVideoStreamEncoding)encoding
+{
+  if ([encoding isEqualToString:FBVideoStreamEncodingH264]) {
+    __block BOOL keyframe = NO;
+    [frame enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+      // The encoder emits each frame contiguously, so a start code is not split across regions.
+      keyframe = FBAnnexBFrameContainsKeyframe(bytes, byteRange.length);
+      *stop = keyframe;
+    }];
+    return keyframe;
+  }
+  return YES;
+}
+
++ (FBFrameDropPolicy)dropPolicyForEncoding:(FBVideoStreamEncoding)encoding
+{
+  // Tiles are deltas against every previous frame, so none of them can be dropped.
+  if ([encoding isEqualToString:FBVideoStreamEncodingBGRATiles] || [encoding isEqualToString:FBVideoStreamEncodingMJPEGTiles]) {
+    return FBFrameDropPolicyCoalesce;
+  }
+  // H264 frames depend upon the frames before them, so dropping any one of them means dropping until the next keyframe.
+  if ([encoding isEqualToString:FBVideoStreamEncodingH264]) {
+    return FBFrameDropPolicyDropNonKeyframe;
+  }
+  return FBFrameDropPolicyDropOldest;
+}
+
+- (NSUInteger)consumeFrame:(NSData *)data
+{
+  @synchronized (self) {
+    if (self.finishing) {
+      return 0;
+    }
+    // The first Minicap frame carries the header for the whole stream, so the stream cannot be decoded without it.
+    BOOL pinned = self.framesEnqueued == 0 && [self.encoding isEqualToString:FBVideoStreamEncodingMinicap];
+    self.framesEnqueued += 1;
+    FBBoundedFrameDataConsumer_Frame *frame = [[FBBoundedFrameDataConsumer_Frame alloc] initWithData:data keyframe:[FBBoundedFrameDataConsumer isKeyframe:data encoding:self.encoding] pinned:pinned];
+    NSUInteger dropped = 0;
+    BOOL enqueue = [self makeRoomForFrame:frame dropped:&dropped];
+    _framesDropped += dropped;
+    if (!enqueue) {
+      return dropped;
+    }
+    [self.frames addObject:frame];
+    self.queuedBytes += data.length;
+    // The drain is scheduled whilst holding the lock, so that it is always ordered before the end-of-file.
+    if (!self.draining) {
+      self.draining = YES;
+      dispatch_async(self.queue, ^{
+        [self drain];
+      });
+    }
+    return dropped;
+  }
+}
+
+#pragma mark FBDataConsumer
+
+- (void)consumeData:(NSData *)data
+{
+  @synchronized (self) {
+    [self.currentFrame appendData:data];
+  }
+}
+
+- (void)consumeEndOfFile
+{
+  @synchronized (self) {
+    if (self.finishing) {
+      return;
+    }
+    self.finishing = YES;
+    // Any frames that are queued are written before the end-of-file.
+    id<FBDataConsumer> consumer = self.consumer;
+    dispatch_async(self.queue, ^{
+      [consumer consumeEndOfFile];
+      [self.finishedConsumingFuture resolveWithResult:NSNull.null];
+    });
+  }
+}
+
+#pragma mark FBDataConsumerFrameDelimited
+
+- (void)consumeEndOfFrame
+{
+  NSData *frame = nil;
+  @synchronized (self) {
+    if (self.currentFrame.length == 0) {
+      return;
+    }
+    frame = self.currentFrame;
+    self.currentFrame = NSMutableData.data;
+  }
+  [self consumeFrame:frame];
+}
+
+#pragma mark FBDataConsumerBacklog
+
+- (NSUInteger)pendingBytes
+{
+  NSUInteger pendingBytes = 0;
+  @synchronized (self) {
+    pendingBytes = self.queuedBytes;
+  }
+  id<FBDataConsumer> consumer = self.consumer;
+  if ([consumer conformsToProtocol:@protocol(FBDataConsumerBacklog)]) {
+    pendingBytes += ((id<FBDataConsumerBacklog>) consumer).pendingBytes;
+  }
+  return pendingBytes;
+}
+
+#pragma mark FBDataConsumerLifecycle
+
+- (FBFuture<NSNull *> *)finishedConsuming
+{
+  return self.finishedConsumingFuture;
+}
+
+#pragma mark Properties
+
+- (NSUInteger)queuedFrames
+{
+  @synchronized (self) {
+    return self.frames.count;
+  }
+}
+
+- (NSUInteger)framesWritten
+{
+  @synchronized (self) {
+    return _framesWritten;
+  }
+}
+
+- (NSUInteger)framesDropped
+{
+  @synchronized (self) {
+    return _framesDropped;
+  }
+}
+
+#pragma mark Private
+
+// Must be called with the lock held. Drops frames according to the policy, returning NO if the incoming frame is itself dropped.
+- (BOOL)makeRoomForFrame:(FBBoundedFrameDataConsumer_Frame *)frame dropped:(NSUInteger *)droppedOut
+{
+  NSMutableArray<FBBoundedFrameDataConsumer_Frame *> *frames = self.frames;
+  if (self.dropPolicy == FBFrameDropPolicyCoalesce) {
+    if (frames.count < self.maximumQueuedFrames) {
+      return YES;
+    }
+    // The frames are written back-to-back, so the destination sees the same bytes in fewer writes.
+    FBBoundedFrameDataConsumer_Frame *last = frames.lastObject;
+    NSMutableData *data = [last.data mutableCopy];
+    [data appendData:frame.data];
+    frames[frames.count - 1] = [[FBBoundedFrameDataConsumer_Frame alloc] initWithData:data keyframe:last.keyframe pinned:last.pinned];
+    self.queuedBytes += frame.data.length;
+    *droppedOut = 0;
+    return NO;
+  }
+  if (self.dropPolicy == FBFrameDropPolicyDropNonKeyframe) {
+    if (!frame.keyframe) {
+      if (self.awaitingKeyframe || frames.count >= self.maximumQueuedFrames) {
+        // Every frame up to the next keyframe depends upon the dropped frame, so cannot be decoded either.
+        self.awaitingKeyframe = YES;
+        *droppedOut = 1;
+        return NO;
+      }
+      return YES;
+    }
+    self.awaitingKeyframe = NO;
+    if (frames.count < self.maximumQueuedFrames) {
+      return YES;
+    }
+    // Nothing before a keyframe is needed to decode it, so the keyframe replaces everything that is queued.
+    NSIndexSet *indexes = [frames indexesOfObjectsPassingTest:^ BOOL (FBBoundedFrameDataConsumer_Frame *queued, NSUInteger _, BOOL *__) {
+      return !queued.pinned;
+    }];
+    for (FBBoundedFrameDataConsumer_Frame *queued in [frames objectsAtIndexes:indexes]) {
+      self.queuedBytes -= queued.data.length;
+    }
+    [frames removeObjectsAtIndexes:indexes];
+    *droppedOut = indexes.count;
+    return YES;
+  }
+  NSUInteger dropped = 0;
+  while (frames.count >= self.maximumQueuedFrames) {
+    NSUInteger index = [frames indexOfObjectPassingTest:^ BOOL (FBBoundedFrameDataConsumer_Frame *queued, NSUInteger _, BOOL *__) {
+      return !queued.pinned;
+    }];
+    if (index == NSNotFound) {
+      break;
+    }
+    self.queuedBytes -= frames[index].data.length;
+    [frames removeObjectAtIndex:index];
+    dropped += 1;
+  }
+  *droppedOut = dropped;
+  return YES;
+}
+
+- (void)drain
+{
+  id<FBDataConsumer> consumer = self.consumer;
+  BOOL frameDelimited = [consumer conformsToProtocol:@protocol(FBDataConsumerFrameDelimited)];
+  while (YES) {
+    FBBoundedFrameDataConsumer_Frame *frame = nil;
+    @synchronized (self) {
+      frame = self.frames.firstObject;
+      if (!frame) {
+        self.draining = NO;
+        return;
+      }
+      [self.frames removeObjectAtIndex:0];
+      self.queuedBytes -= frame.data.length;
+    }
+    [consumer consumeData:frame.data];
+    if (frameDelimited) {
+      [(id<FBDataConsumerFrameDelimited>) consumer consumeEndOfFrame];
+    }
+    @synchronized (self) {
+      _framesWritten += 1;
+    }
+  }
+}
+
+@end
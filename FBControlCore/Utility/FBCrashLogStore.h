@@ -16,6 +16,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  Stores Device Crash logs on the host.
+ Ingested crash logs are indexed by identifier, process name, process identifier, process type and date.
+ Queries using predicates from the FBCrashLogInfo predicate constructors are answered from these indices.
  */
 @interface FBCrashLogStore : NSObject
 
@@ -30,6 +32,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (instancetype)storeForDirectories:(NSArray<NSString *> *)directories logger:(id<FBControlCoreLogger>)logger;
 
+/**
+ A store that persists the information extracted from crash logs to an index file.
+ Crash logs that are unchanged since they were recorded in the index are ingested from the index, without being parsed again.
+
+ @param directories the directories to store into.
+ @param indexPath the path of the index file. If nil, no index file is used.
+ @param logger the logger to use.
+ @return a store for the device.
+ */
++ (instancetype)storeForDirectories:(NSArray<NSString *> *)directories indexPath:(nullable NSString *)indexPath logger:(id<FBControlCoreLogger>)logger;
+
 #pragma mark Ingestion
 
 /**
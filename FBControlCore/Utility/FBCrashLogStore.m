@@ -7,20 +7,78 @@
 
 #import "FBCrashLogStore.h"
 
+#include <sys/stat.h>
+
 #import "FBCrashLog.h"
+#import "FBCrashLog+Private.h"
 #import "FBControlCoreLogger.h"
 
 typedef NSString *FBCrashLogNotificationName NS_STRING_ENUM;
 
 FBCrashLogNotificationName const FBCrashLogAppeared = @"FBCrashLogAppeared";
 
+static NSUInteger const IndexVersion = 1;
+static NSString *const IndexKeyVersion = @"version";
+static NSString *const IndexKeyRecords = @"records";
+static NSString *const RecordKeyExecutablePath = @"executable_path";
+static NSString *const RecordKeyIdentifier = @"identifier";
+static NSString *const RecordKeyProcessName = @"process_name";
+static NSString *const RecordKeyProcessIdentifier = @"pid";
+static NSString *const RecordKeyParentProcessName = @"parent_process_name";
+static NSString *const RecordKeyParentProcessIdentifier = @"ppid";
+static NSString *const RecordKeyDate = @"date";
+static NSString *const RecordKeyProcessType = @"process_type";
+static NSString *const RecordKeyFileSize = @"file_size";
+static NSString *const RecordKeyModificationTime = @"modification_time";
+static int64_t const IndexSaveDelay = 1 * NSEC_PER_SEC;
+
+static NSTimeInterval FBModificationInterval(struct stat *fileInfo)
+{
+  return fileInfo->st_mtimespec.tv_sec + fileInfo->st_mtimespec.tv_nsec / (double) NSEC_PER_SEC;
+}
+
+static void AddToIndex(NSMutableDictionary<id, NSMutableSet<FBCrashLogInfo *> *> *index, id key, FBCrashLogInfo *crashLog)
+{
+  if (!key) {
+    return;
+  }
+  NSMutableSet<FBCrashLogInfo *> *crashLogs = index[key];
+  if (!crashLogs) {
+    crashLogs = [NSMutableSet set];
+    index[key] = crashLogs;
+  }
+  [crashLogs addObject:crashLog];
+}
+
+static void RemoveFromIndex(NSMutableDictionary<id, NSMutableSet<FBCrashLogInfo *> *> *index, id key, FBCrashLogInfo *crashLog)
+{
+  if (!key) {
+    return;
+  }
+  NSMutableSet<FBCrashLogInfo *> *crashLogs = index[key];
+  [crashLogs removeObject:crashLog];
+  if (crashLogs.count == 0) {
+    [index removeObjectForKey:key];
+  }
+}
+
 @interface FBCrashLogStore ()
 
 @property (nonatomic, copy, readonly) NSArray<NSString *> *directories;
+@property (nonatomic, copy, nullable, readonly) NSString *indexPath;
 @property (nonatomic, strong, readonly) id<FBControlCoreLogger> logger;
-@property (nonatomic, strong, readonly) NSMutableDictionary<NSString *, FBCrashLogInfo *> *ingestedCrashLogs;
 @property (nonatomic, strong, readonly) dispatch_queue_t queue;
 
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSString *, FBCrashLogInfo *> *ingestedCrashLogs;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSString *, NSMutableSet<FBCrashLogInfo *> *> *identifierIndex;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSString *, NSMutableSet<FBCrashLogInfo *> *> *processNameIndex;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSNumber *, NSMutableSet<FBCrashLogInfo *> *> *processIdentifierIndex;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSNumber *, NSMutableSet<FBCrashLogInfo *> *> *processTypeIndex;
+@property (nonatomic, strong, readonly) NSMutableArray<FBCrashLogInfo *> *dateIndex;
+
+@property (nonatomic, strong, nullable, readwrite) NSMutableDictionary<NSString *, NSDictionary<NSString *, id> *> *persistedRecords;
+@property (nonatomic, assign, readwrite) BOOL indexSaveScheduled;
+
 @end
 
 @implementation FBCrashLogStore
@@ -29,10 +87,15 @@ FBCrashLogNotificationName const FBCrashLogAppeared = @"FBCrashLogAppeared";
 
 + (instancetype)storeForDirectories:(NSArray<NSString *> *)directories logger:(id<FBControlCoreLogger>)logger
 {
-  return [[self alloc] initWithDirectories:directories logger:logger];
+  return [[self alloc] initWithDirectories:directories indexPath:nil logger:logger];
+}
+
++ (instancetype)storeForDirectories:(NSArray<NSString *> *)directories indexPath:(nullable NSString *)indexPath logger:(id<FBControlCoreLogger>)logger
+{
+  return [[self alloc] initWithDirectories:directories indexPath:indexPath logger:logger];
 }
 
-- (instancetype)initWithDirectories:(NSArray<NSString *> *)directories logger:(id<FBControlCoreLogger>)logger
+- (instancetype)initWithDirectories:(NSArray<NSString *> *)directories indexPath:(nullable NSString *)indexPath logger:(id<FBControlCoreLogger>)logger
 {
   self = [super init];
   if (!self) {
@@ -40,10 +103,17 @@ FBCrashLogNotificationName const FBCrashLogAppeared = @"FBCrashLogAppeared";
   }
 
   _directories = directories;
+  _indexPath = indexPath;
   _logger = logger;
-  _ingestedCrashLogs = NSMutableDictionary.dictionary;
   _queue = dispatch_queue_create("com.facebook.fbcontrolcore.crash_store", DISPATCH_QUEUE_SERIAL);
 
+  _ingestedCrashLogs = NSMutableDictionary.dictionary;
+  _identifierIndex = NSMutableDictionary.dictionary;
+  _processNameIndex = NSMutableDictionary.dictionary;
+  _processIdentifierIndex = NSMutableDictionary.dictionary;
+  _processTypeIndex = NSMutableDictionary.dictionary;
+  _dateIndex = NSMutableArray.array;
+
   return self;
 }
 
@@ -65,13 +135,22 @@ FBCrashLogNotificationName const FBCrashLogAppeared = @"FBCrashLogAppeared";
   if ([self hasIngestedCrashLogWithName:path.lastPathComponent]) {
     return nil;
   }
-  NSError *error = nil;
-  FBCrashLogInfo *crashLog = [FBCrashLogInfo fromCrashLogAtPath:path error:&error];
+  // The header of a crash log that is unchanged since it was last indexed does not need to be parsed again.
+  struct stat fileInfo;
+  BOOL hasFileInfo = stat(path.fileSystemRepresentation, &fileInfo) == 0;
+  FBCrashLogInfo *crashLog = hasFileInfo ? [self persistedCrashLogAtPath:path fileInfo:&fileInfo] : nil;
   if (!crashLog) {
-    [self.logger logFormat:@"Could not obtain crash info %@", error];
-    return nil;
+    NSError *error = nil;
+    crashLog = [FBCrashLogInfo fromCrashLogAtPath:path error:&error];
+    if (!crashLog) {
+      [self.logger logFormat:@"Could not obtain crash info %@", error];
+      return nil;
+    }
+    if (hasFileInfo) {
+      [self persistCrashLog:crashLog fileInfo:&fileInfo];
+    }
   }
-  return  [self ingestCrashLog:crashLog];
+  return [self ingestCrashLog:crashLog];
 }
 
 - (nullable FBCrashLogInfo *)ingestCrashLogData:(NSData *)data name:(NSString *)name
@@ -100,25 +179,31 @@ FBCrashLogNotificationName const FBCrashLogAppeared = @"FBCrashLogAppeared";
 
 - (nullable FBCrashLogInfo *)removeCrashLogAtPath:(NSString *)path
 {
-  NSString *key = path.lastPathComponent;
-  FBCrashLogInfo *crashLog = [self ingestedCrashLogWithName:key];
-  if (!crashLog) {
-    return nil;
+  @synchronized (self) {
+    FBCrashLogInfo *crashLog = [self ingestedCrashLogWithName:path.lastPathComponent];
+    if (!crashLog) {
+      return nil;
+    }
+    [self removeCrashLog:crashLog];
+    [self forgetPersistedCrashLog:crashLog];
+    return crashLog;
   }
-  [self.ingestedCrashLogs removeObjectForKey:key];
-  return crashLog;
 }
 
 #pragma mark Fetching
 
 - (FBCrashLogInfo *)ingestedCrashLogWithName:(NSString *)name
 {
-  return self.ingestedCrashLogs[name];
+  @synchronized (self) {
+    return self.ingestedCrashLogs[name];
+  }
 }
 
 - (NSArray<FBCrashLogInfo *> *)allIngestedCrashLogs
 {
-  return self.ingestedCrashLogs.allValues;
+  @synchronized (self) {
+    return self.ingestedCrashLogs.allValues;
+  }
 }
 
 - (FBFuture<FBCrashLogInfo *> *)nextCrashLogForMatchingPredicate:(NSPredicate *)predicate
@@ -131,39 +216,303 @@ FBCrashLogNotificationName const FBCrashLogAppeared = @"FBCrashLogAppeared";
 
 - (NSArray<FBCrashLogInfo *> *)ingestedCrashLogsMatchingPredicate:(NSPredicate *)predicate
 {
-  return [self.ingestedCrashLogs.allValues filteredArrayUsingPredicate:predicate];
+  @synchronized (self) {
+    return [[self candidatesForPredicate:predicate] filteredArrayUsingPredicate:predicate];
+  }
 }
 
 - (NSArray<FBCrashLogInfo *> *)pruneCrashLogsMatchingPredicate:(NSPredicate *)predicate
 {
-  NSMutableArray<NSString *> *keys = NSMutableArray.array;
-  NSMutableArray<FBCrashLogInfo *> *crashLogs = NSMutableArray.array;
-  for (FBCrashLogInfo *crashLog in self.ingestedCrashLogs.allValues) {
-    if (![predicate evaluateWithObject:crashLog]) {
-      continue;
+  @synchronized (self) {
+    NSArray<FBCrashLogInfo *> *crashLogs = [[self candidatesForPredicate:predicate] filteredArrayUsingPredicate:predicate];
+    for (FBCrashLogInfo *crashLog in crashLogs) {
+      [self removeCrashLog:crashLog];
+      [self forgetPersistedCrashLog:crashLog];
     }
-    [keys addObject:crashLog.name];
-    [crashLogs addObject:crashLog];
+    return crashLogs;
   }
-  [self.ingestedCrashLogs removeObjectsForKeys:keys];
-  return crashLogs;
 }
 
 #pragma mark Private
 
 - (BOOL)hasIngestedCrashLogWithName:(NSString *)key
 {
-  return self.ingestedCrashLogs[key] != nil;
+  @synchronized (self) {
+    return self.ingestedCrashLogs[key] != nil;
+  }
 }
 
 - (FBCrashLogInfo *)ingestCrashLog:(FBCrashLogInfo *)crashLog
 {
   [self.logger logFormat:@"Ingesting Crash Log %@", crashLog];
-  self.ingestedCrashLogs[crashLog.name] = crashLog;
+  @synchronized (self) {
+    FBCrashLogInfo *existing = self.ingestedCrashLogs[crashLog.name];
+    if (existing) {
+      [self removeCrashLog:existing];
+    }
+    self.ingestedCrashLogs[crashLog.name] = crashLog;
+    AddToIndex(self.identifierIndex, crashLog.identifier, crashLog);
+    AddToIndex(self.processNameIndex, crashLog.processName, crashLog);
+    AddToIndex(self.processIdentifierIndex, @(crashLog.processIdentifier), crashLog);
+    AddToIndex(self.processTypeIndex, @(crashLog.processType), crashLog);
+    [self.dateIndex insertObject:crashLog atIndex:[self dateIndexPositionAfter:crashLog.date]];
+  }
   [NSNotificationCenter.defaultCenter postNotificationName:FBCrashLogAppeared object:crashLog];
   return crashLog;
 }
 
+- (void)removeCrashLog:(FBCrashLogInfo *)crashLog
+{
+  [self.ingestedCrashLogs removeObjectForKey:crashLog.name];
+  RemoveFromIndex(self.identifierIndex, crashLog.identifier, crashLog);
+  RemoveFromIndex(self.processNameIndex, crashLog.processName, crashLog);
+  RemoveFromIndex(self.processIdentifierIndex, @(crashLog.processIdentifier), crashLog);
+  RemoveFromIndex(self.processTypeIndex, @(crashLog.processType), crashLog);
+  NSUInteger lower = [self dateIndexPositionOf:crashLog.date inclusive:NO];
+  NSUInteger upper = [self dateIndexPositionOf:crashLog.date inclusive:YES];
+  NSUInteger position = [self.dateIndex indexOfObjectIdenticalTo:crashLog inRange:NSMakeRange(lower, upper - lower)];
+  if (position != NSNotFound) {
+    [self.dateIndex removeObjectAtIndex:position];
+  }
+}
+
+#pragma mark Querying
+
+- (NSArray<FBCrashLogInfo *> *)candidatesForPredicate:(NSPredicate *)predicate
+{
+  // Any predicate that can be answered from an index narrows the crash logs that are evaluated, otherwise all crash logs are.
+  NSArray<FBCrashLogInfo *> *candidates = [self indexedCandidatesForPredicate:predicate];
+  return candidates ?: self.ingestedCrashLogs.allValues;
+}
+
+- (nullable NSArray<FBCrashLogInfo *> *)indexedCandidatesForPredicate:(NSPredicate *)predicate
+{
+  if ([predicate isKindOfClass:FBCrashLogInfoPredicate.class]) {
+    return [self indexedCandidatesForCrashLogPredicate:(FBCrashLogInfoPredicate *)predicate];
+  }
+  if (![predicate isKindOfClass:NSCompoundPredicate.class]) {
+    return nil;
+  }
+  NSCompoundPredicate *compound = (NSCompoundPredicate *) predicate;
+  switch (compound.compoundPredicateType) {
+    case NSAndPredicateType: {
+      // Every subpredicate must pass, so the smallest set of candidates is sufficient.
+      NSArray<FBCrashLogInfo *> *smallest = nil;
+      for (NSPredicate *subpredicate in compound.subpredicates) {
+        NSArray<FBCrashLogInfo *> *candidates = [self indexedCandidatesForPredicate:subpredicate];
+        if (candidates && (!smallest || candidates.count < smallest.count)) {
+          smallest = candidates;
+        }
+      }
+      return smallest;
+    }
+    case NSOrPredicateType: {
+      NSMutableSet<FBCrashLogInfo *> *union_ = [NSMutableSet set];
+      for (NSPredicate *subpredicate in compound.subpredicates) {
+        NSArray<FBCrashLogInfo *> *candidates = [self indexedCandidatesForPredicate:subpredicate];
+        if (!candidates) {
+          return nil;
+        }
+        [union_ addObjectsFromArray:candidates];
+      }
+      return union_.allObjects;
+    }
+    case NSNotPredicateType: {
+      FBCrashLogInfoPredicate *subpredicate = compound.subpredicates.firstObject;
+      if (compound.subpredicates.count != 1 || ![subpredicate isKindOfClass:FBCrashLogInfoPredicate.class] || subpredicate.key != FBCrashLogInfoPredicateKeyNewerThanDate) {
+        return nil;
+      }
+      return [self.dateIndex subarrayWithRange:NSMakeRange(0, [self dateIndexPositionAfter:subpredicate.value])];
+    }
+    default:
+      return nil;
+  }
+}
+
+- (nullable NSArray<FBCrashLogInfo *> *)indexedCandidatesForCrashLogPredicate:(FBCrashLogInfoPredicate *)predicate
+{
+  switch (predicate.key) {
+    case FBCrashLogInfoPredicateKeyName: {
+      FBCrashLogInfo *crashLog = self.ingestedCrashLogs[predicate.value];
+      return crashLog ? @[crashLog] : @[];
+    }
+    case FBCrashLogInfoPredicateKeyIdentifier:
+      return self.identifierIndex[predicate.value].allObjects ?: @[];
+    case FBCrashLogInfoPredicateKeyProcessName:
+      return self.processNameIndex[predicate.value].allObjects ?: @[];
+    case FBCrashLogInfoPredicateKeyProcessIdentifier:
+      return self.processIdentifierIndex[predicate.value].allObjects ?: @[];
+    case FBCrashLogInfoPredicateKeyProcessType: {
+      NSUInteger processTypes = [predicate.value unsignedIntegerValue];
+      NSMutableArray<FBCrashLogInfo *> *candidates = [NSMutableArray array];
+      for (NSNumber *processType in self.processTypeIndex) {
+        if (processType.unsignedIntegerValue & processTypes) {
+          [candidates addObjectsFromArray:self.processTypeIndex[processType].allObjects];
+        }
+      }
+      return candidates;
+    }
+    case FBCrashLogInfoPredicateKeyNewerThanDate: {
+      NSUInteger position = [self dateIndexPositionAfter:predicate.value];
+      return [self.dateIndex subarrayWithRange:NSMakeRange(position, self.dateIndex.count - position)];
+    }
+    default:
+      return nil;
+  }
+}
+
+- (NSUInteger)dateIndexPositionAfter:(NSDate *)date
+{
+  return [self dateIndexPositionOf:date inclusive:YES];
+}
+
+- (NSUInteger)dateIndexPositionOf:(NSDate *)date inclusive:(BOOL)inclusive
+{
+  // The position of the first crash log with a date later than the provided date.
+  // If not inclusive, this is the position of the first crash log with a date equal to or later than the provided date.
+  NSTimeInterval interval = date.timeIntervalSinceReferenceDate;
+  NSUInteger lower = 0;
+  NSUInteger upper = self.dateIndex.count;
+  while (lower < upper) {
+    NSUInteger middle = lower + (upper - lower) / 2;
+    NSTimeInterval middleInterval = self.dateIndex[middle].date.timeIntervalSinceReferenceDate;
+    if (middleInterval < interval || (inclusive && middleInterval == interval)) {
+      lower = middle + 1;
+    } else {
+      upper = middle;
+    }
+  }
+  return lower;
+}
+
+#pragma mark Persisted Index
+
+- (NSMutableDictionary<NSString *, NSDictionary<NSString *, id> *> *)loadedPersistedRecords
+{
+  if (self.persistedRecords) {
+    return self.persistedRecords;
+  }
+  NSMutableDictionary<NSString *, NSDictionary<NSString *, id> *> *records = [NSMutableDictionary dictionary];
+  NSData *data = self.indexPath ? [NSData dataWithContentsOfFile:self.indexPath] : nil;
+  NSDictionary<NSString *, id> *index = data ? [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:nil error:nil] : nil;
+  if ([index isKindOfClass:NSDictionary.class] && [index[IndexKeyVersion] isEqual:@(IndexVersion)] && [index[IndexKeyRecords] isKindOfClass:NSDictionary.class]) {
+    [records addEntriesFromDictionary:index[IndexKeyRecords]];
+  }
+  // Crash logs that have been deleted since the index was saved would otherwise remain in it forever.
+  NSUInteger loadedCount = records.count;
+  for (NSString *path in records.allKeys) {
+    if (![NSFileManager.defaultManager fileExistsAtPath:path]) {
+      [records removeObjectForKey:path];
+    }
+  }
+  self.persistedRecords = records;
+  if (records.count != loadedCount) {
+    [self scheduleIndexSave];
+  }
+  return records;
+}
+
+- (nullable FBCrashLogInfo *)persistedCrashLogAtPath:(NSString *)path fileInfo:(struct stat *)fileInfo
+{
+  if (!self.indexPath) {
+    return nil;
+  }
+  NSDictionary<NSString *, id> *record = nil;
+  @synchronized (self) {
+    record = self.loadedPersistedRecords[path];
+  }
+  if (!record) {
+    return nil;
+  }
+  if ([record[RecordKeyFileSize] longLongValue] != fileInfo->st_size || [record[RecordKeyModificationTime] doubleValue] != FBModificationInterval(fileInfo)) {
+    return nil;
+  }
+  NSString *executablePath = record[RecordKeyExecutablePath];
+  NSString *identifier = record[RecordKeyIdentifier];
+  NSString *processName = record[RecordKeyProcessName];
+  NSString *parentProcessName = record[RecordKeyParentProcessName];
+  NSDate *date = record[RecordKeyDate];
+  if (![executablePath isKindOfClass:NSString.class] || ![identifier isKindOfClass:NSString.class] || ![processName isKindOfClass:NSString.class] || ![parentProcessName isKindOfClass:NSString.class] || ![date isKindOfClass:NSDate.class]) {
+    return nil;
+  }
+  return [[FBCrashLogInfo alloc]
+    initWithCrashPath:path
+    executablePath:executablePath
+    identifier:identifier
+    processName:processName
+    processIdentifier:[record[RecordKeyProcessIdentifier] intValue]
+    parentProcessName:parentProcessName
+    parentProcessIdentifier:[record[RecordKeyParentProcessIdentifier] intValue]
+    date:date
+    processType:[record[RecordKeyProcessType] unsignedIntegerValue]];
+}
+
+- (void)persistCrashLog:(FBCrashLogInfo *)crashLog fileInfo:(struct stat *)fileInfo
+{
+  if (!self.indexPath) {
+    return;
+  }
+  NSDictionary<NSString *, id> *record = @{
+    RecordKeyExecutablePath: crashLog.executablePath,
+    RecordKeyIdentifier: crashLog.identifier,
+    RecordKeyProcessName: crashLog.processName,
+    RecordKeyProcessIdentifier: @(crashLog.processIdentifier),
+    RecordKeyParentProcessName: crashLog.parentProcessName,
+    RecordKeyParentProcessIdentifier: @(crashLog.parentProcessIdentifier),
+    RecordKeyDate: crashLog.date,
+    RecordKeyProcessType: @(crashLog.processType),
+    RecordKeyFileSize: @(fileInfo->st_size),
+    RecordKeyModificationTime: @(FBModificationInterval(fileInfo)),
+  };
+  @synchronized (self) {
+    self.loadedPersistedRecords[crashLog.crashPath] = record;
+    [self scheduleIndexSave];
+  }
+}
+
+- (void)forgetPersistedCrashLog:(FBCrashLogInfo *)crashLog
+{
+  if (!self.indexPath || !self.loadedPersistedRecords[crashLog.crashPath]) {
+    return;
+  }
+  [self.loadedPersistedRecords removeObjectForKey:crashLog.crashPath];
+  [self scheduleIndexSave];
+}
+
+- (void)scheduleIndexSave
+{
+  // Saves are coalesced, so that ingesting many crash logs results in a single write.
+  if (self.indexSaveScheduled) {
+    return;
+  }
+  self.indexSaveScheduled = YES;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, IndexSaveDelay), self.queue, ^{
+    [self saveIndex];
+  });
+}
+
+- (void)saveIndex
+{
+  NSDictionary<NSString *, id> *index = nil;
+  @synchronized (self) {
+    self.indexSaveScheduled = NO;
+    index = @{
+      IndexKeyVersion: @(IndexVersion),
+      IndexKeyRecords: [self.persistedRecords copy] ?: @{},
+    };
+  }
+  NSError *error = nil;
+  NSData *data = [NSPropertyListSerialization dataWithPropertyList:index format:NSPropertyListBinaryFormat_v1_0 options:0 error:&error];
+  if (!data) {
+    [self.logger logFormat:@"Failed to serialize crash log index %@", error];
+    return;
+  }
+  [NSFileManager.defaultManager createDirectoryAtPath:self.indexPath.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:nil];
+  if (![data writeToFile:self.indexPath options:NSDataWritingAtomic error:&error]) {
+    [self.logger logFormat:@"Failed to write crash log index to %@ %@", self.indexPath, error];
+  }
+}
+
 + (FBFuture<FBCrashLogInfo *> *)oneshotCrashLogNotificationForPredicate:(NSPredicate *)predicate queue:(dispatch_queue_t)queue
 {
   __weak NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
@@ -8,6 +8,7 @@
 #import "FBDataBuffer.h"
 
 #import "FBControlCoreError.h"
+#import "FBLineScanner.h"
 
 @interface FBDataBuffer_Accumilating : NSObject <FBDataConsumer, FBAccumulatingBuffer>
 
@@ -206,8 +207,19 @@
 
 @end
 
-@interface FBDataBuffer_Consumable : FBDataBuffer_Accumilating <FBConsumableBuffer, FBNotifyingBuffer>
+/**
+ A Consumable Buffer, backed by a queue of the data segments that have been appended to it.
+ Consumption from the front of the buffer drops whole segments, or advances an offset into the first segment, so the remainder of the buffer is never moved.
+ A scan cursor is kept for the most recently searched-for terminal, so bytes that are known not to contain it are not scanned again.
+ */
+@interface FBDataBuffer_Consumable : NSObject <FBConsumableBuffer, FBNotifyingBuffer>
 
+@property (nonatomic, strong, readonly) NSMutableArray<NSData *> *segments;
+@property (nonatomic, assign, readwrite) NSUInteger headOffset;
+@property (nonatomic, assign, readwrite) NSUInteger length;
+@property (nonatomic, copy, nullable, readwrite) NSData *scanTerminal;
+@property (nonatomic, assign, readwrite) NSUInteger scanCursor;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *finishedConsumingFuture;
 @property (nonatomic, strong, nullable, readwrite) id<FBDataBuffer_Forwarder> forwarder;
 
 @end
@@ -223,6 +235,8 @@
     return nil;
   }
 
+  _segments = NSMutableArray.array;
+  _finishedConsumingFuture = FBMutableFuture.future;
   _forwarder = forwarder;
 
   return self;
@@ -233,17 +247,35 @@
 - (NSString *)description
 {
   @synchronized (self) {
-    return [NSString stringWithFormat:@"Consumable Buffer %lu Bytes", self.data.length];
+    return [NSString stringWithFormat:@"Consumable Buffer %lu Bytes", self.length];
+  }
+}
+
+#pragma mark FBAccumulatingBuffer
+
+- (NSData *)data
+{
+  @synchronized (self) {
+    return [self dataOfLength:self.length];
   }
 }
 
+- (NSArray<NSString *> *)lines
+{
+  NSString *output = [[NSString alloc] initWithData:self.data encoding:NSUTF8StringEncoding];
+  return [output componentsSeparatedByCharactersInSet:NSCharacterSet.newlineCharacterSet];
+}
+
 #pragma mark FBConsumableBuffer
 
 - (nullable NSData *)consumeCurrentData
 {
   @synchronized (self) {
-    NSData *data = self.data;
-    self.buffer.data = NSData.data;
+    NSData *data = [self dataOfLength:self.length];
+    [self.segments removeAllObjects];
+    self.headOffset = 0;
+    self.length = 0;
+    self.scanCursor = 0;
     return data;
   }
 }
@@ -257,15 +289,11 @@
 - (nullable NSData *)consumeLength:(NSUInteger)length
 {
   @synchronized (self) {
-    if (length > self.buffer.length) {
-      return nil;
-    }
-    NSRange range = NSMakeRange(0, length);
-    NSData *data = [self.buffer subdataWithRange:range];
-    if (!data) {
+    if (length > self.length) {
       return nil;
     }
-    [self.buffer replaceBytesInRange:range withBytes:"" length:0];
+    NSData *data = [self dataOfLength:length];
+    [self dropLength:length];
     return data;
   }
 }
@@ -273,15 +301,15 @@
 - (nullable NSData *)consumeUntil:(NSData *)terminal
 {
   @synchronized (self) {
-    if (self.buffer.length == 0) {
+    if (self.length == 0) {
       return nil;
     }
-    NSRange terminalRange = [self.buffer rangeOfData:terminal options:0 range:NSMakeRange(0, self.buffer.length)];
-    if (terminalRange.location == NSNotFound) {
+    NSUInteger location = [self locationOfTerminal:terminal];
+    if (location == NSNotFound) {
       return nil;
     }
-    NSData *data = [self.buffer subdataWithRange:NSMakeRange(0, terminalRange.location)];
-    [self.buffer replaceBytesInRange:NSMakeRange(0, terminalRange.location + terminal.length) withBytes:"" length:0];
+    NSData *data = [self dataOfLength:location];
+    [self dropLength:location + terminal.length];
     return data;
   }
 }
@@ -341,12 +369,33 @@
 
 - (void)consumeData:(NSData *)data
 {
-  [super consumeData:data];
   @synchronized (self) {
+    if (self.finishedConsumingFuture.hasCompleted || data.length == 0) {
+      return;
+    }
+    [self.segments addObject:[data copy]];
+    self.length += data.length;
     [self.forwarder run:self];
   }
 }
 
+- (void)consumeEndOfFile
+{
+  @synchronized (self) {
+    if (self.finishedConsumingFuture.hasCompleted) {
+      return;
+    }
+    [self.finishedConsumingFuture resolveWithResult:NSNull.null];
+  }
+}
+
+#pragma mark FBDataConsumerLifecycle
+
+- (FBFuture<NSNull *> *)finishedConsuming
+{
+  return self.finishedConsumingFuture;
+}
+
 #pragma mark Private
 
 - (BOOL)attachForwardingConsumer:(id<FBDataBuffer_Forwarder>)forwarder error:(NSError **)error
@@ -375,6 +424,123 @@
   return [self consume:consumer onQueue:nil untilTerminal:terminal error:error];
 }
 
+#pragma mark Segments
+
+// All of these must be called whilst synchronized.
+
+- (void)getBytes:(uint8_t *)buffer range:(NSRange)range
+{
+  NSUInteger position = 0;
+  NSUInteger remaining = range.length;
+  for (NSUInteger index = 0; index < self.segments.count && remaining > 0; index++) {
+    NSData *segment = self.segments[index];
+    NSUInteger offset = index == 0 ? self.headOffset : 0;
+    NSUInteger available = segment.length - offset;
+    if (position + available <= range.location) {
+      position += available;
+      continue;
+    }
+    NSUInteger begin = range.location > position ? range.location - position : 0;
+    NSUInteger count = MIN(available - begin, remaining);
+    memcpy(buffer, (const uint8_t *) segment.bytes + offset + begin, count);
+    buffer += count;
+    remaining -= count;
+    position += available;
+  }
+}
+
+- (NSData *)dataOfLength:(NSUInteger)length
+{
+  if (length == 0) {
+    return NSData.data;
+  }
+  // When the data is within the first segment, there's no need to assemble it from many.
+  NSData *first = self.segments.firstObject;
+  if (self.headOffset == 0 && first.length == length) {
+    return first;
+  }
+  if (first.length - self.headOffset >= length) {
+    return [first subdataWithRange:NSMakeRange(self.headOffset, length)];
+  }
+  NSMutableData *data = [NSMutableData dataWithLength:length];
+  [self getBytes:data.mutableBytes range:NSMakeRange(0, length)];
+  return data;
+}
+
+- (void)dropLength:(NSUInteger)length
+{
+  NSUInteger remaining = length;
+  while (remaining > 0) {
+    NSData *first = self.segments.firstObject;
+    NSUInteger available = first.length - self.headOffset;
+    if (remaining < available) {
+      self.headOffset += remaining;
+      break;
+    }
+    [self.segments removeObjectAtIndex:0];
+    self.headOffset = 0;
+    remaining -= available;
+  }
+  self.length -= length;
+  self.scanCursor = self.scanCursor > length ? self.scanCursor - length : 0;
+}
+
+- (BOOL)terminal:(NSData *)terminal matchesAtLocation:(NSUInteger)location
+{
+  NSUInteger terminalLength = terminal.length;
+  if (location + terminalLength > self.length) {
+    return NO;
+  }
+  if (terminalLength == 1) {
+    return YES;
+  }
+  NSMutableData *candidate = [NSMutableData dataWithLength:terminalLength];
+  [self getBytes:candidate.mutableBytes range:NSMakeRange(location, terminalLength)];
+  return [candidate isEqualToData:terminal];
+}
+
+- (NSUInteger)locationOfTerminal:(NSData *)terminal
+{
+  if (![terminal isEqualToData:self.scanTerminal]) {
+    self.scanTerminal = terminal;
+    self.scanCursor = 0;
+  }
+  NSUInteger terminalLength = terminal.length;
+  if (terminalLength == 0) {
+    return NSNotFound;
+  }
+  uint8_t firstByte = ((const uint8_t *) terminal.bytes)[0];
+  NSUInteger position = 0;
+  for (NSUInteger index = 0; index < self.segments.count; index++) {
+    NSData *segment = self.segments[index];
+    NSUInteger offset = index == 0 ? self.headOffset : 0;
+    NSUInteger available = segment.length - offset;
+    if (position + available <= self.scanCursor) {
+      position += available;
+      continue;
+    }
+    const uint8_t *bytes = (const uint8_t *) segment.bytes + offset;
+    const uint8_t *end = bytes + available;
+    const uint8_t *cursor = bytes + (self.scanCursor > position ? self.scanCursor - position : 0);
+    while (cursor < end) {
+      const uint8_t *candidate = FBLineScannerFindByte(cursor, (size_t) (end - cursor), firstByte);
+      if (!candidate) {
+        break;
+      }
+      NSUInteger location = position + (NSUInteger) (candidate - bytes);
+      if ([self terminal:terminal matchesAtLocation:location]) {
+        self.scanCursor = location;
+        return location;
+      }
+      cursor = candidate + 1;
+    }
+    position += available;
+  }
+  // The terminal may be partially present at the end of the buffer, so these bytes must be scanned again.
+  self.scanCursor = self.length >= terminalLength ? self.length - terminalLength + 1 : 0;
+  return NSNotFound;
+}
+
 @end
 
 @implementation FBDataBuffer
@@ -60,6 +60,32 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/**
+ Members of this protocol are informed of the boundaries between frames, when the data is a stream of video frames.
+ All of the data that is consumed between two calls to `consumeEndOfFrame` belongs to a single frame.
+ */
+@protocol FBDataConsumerFrameDelimited <NSObject>
+
+/**
+ Called when all of the data for the current frame has been consumed.
+ */
+- (void)consumeEndOfFrame;
+
+@end
+
+/**
+ Members of this protocol queue data that has been consumed, before it is written to its destination.
+ Producers can use this to observe back-pressure from a slow destination.
+ */
+@protocol FBDataConsumerBacklog <NSObject>
+
+/**
+ The number of bytes that have been consumed, but not yet written.
+ */
+@property (atomic, assign, readonly) NSUInteger pendingBytes;
+
+@end
+
 /**
  Observation of a Data Consumer's lifecycle
  */
@@ -128,6 +154,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (id<FBDataConsumer, FBDataConsumerLifecycle, FBDataConsumerStackConsuming>)synchronousLineConsumerWithBlock:(void (^)(NSString *))consumer;
 
+/**
+ Creates a Consumer of lines from a block, where each line is a range of bytes that is borrowed rather than copied into a new object.
+ The bytes do not include the terminating newline and are only valid for the duration of the block.
+ Lines will be delivered synchronously.
+
+ @param consumer the block to call when a line has been consumed.
+ @return a new consumer.
+ */
++ (id<FBDataConsumer, FBDataConsumerLifecycle, FBDataConsumerStackConsuming>)synchronousLineConsumerWithBytesBlock:(void (^)(const char *bytes, NSUInteger length))consumer;
+
 /**
  Creates a consumer that delivers data when available.
  Data will be delivered asynchronously to the provided queue.
@@ -176,6 +212,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (id<FBDataConsumer, FBDataConsumerLifecycle>)asynchronousLineConsumerWithQueue:(dispatch_queue_t)queue dataConsumer:(void (^)(NSData *))consumer;
 
+/**
+ Creates a Consumer of lines from a block, where each line is a range of bytes that is borrowed rather than copied into a new object.
+ The bytes do not include the terminating newline and are only valid for the duration of the block.
+ Lines will be delivered asynchronously to the given queue.
+
+ @param queue the queue to call the consumer from.
+ @param consumer the block to call when a line has been consumed.
+ @return a new consumer.
+ */
++ (id<FBDataConsumer, FBDataConsumerLifecycle>)asynchronousLineConsumerWithQueue:(dispatch_queue_t)queue bytesConsumer:(void (^)(const char *bytes, NSUInteger length))consumer;
+
 @end
 
 @protocol FBControlCoreLogger;
@@ -10,7 +10,7 @@
 #import "FBCollectionInformation.h"
 #import "FBControlCoreError.h"
 #import "FBControlCoreLogger.h"
-#import "FBDataBuffer.h"
+#import "FBLineScanner.h"
 
 @interface FBDataConsumerAdaptor ()
 
@@ -147,9 +147,11 @@
 @end
 
 typedef void (^dataBlock)(NSData *);
-static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString *)) {
-  return ^(NSData *data){
-    NSString *line = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+typedef void (^lineBytesBlock)(const char *, NSUInteger);
+
+static inline lineBytesBlock FBDataConsumerBytesToStringConsumer (void(^consumer)(NSString *)) {
+  return ^(const char *bytes, NSUInteger length){
+    NSString *line = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
     if (line == nil) {
       line = @"non-utf8";
     }
@@ -157,6 +159,39 @@ static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString
   };
 }
 
+static inline lineBytesBlock FBDataConsumerBytesToDataConsumer (void(^consumer)(NSData *)) {
+  return ^(const char *bytes, NSUInteger length){
+    consumer([NSData dataWithBytes:bytes length:length]);
+  };
+}
+
+static inline dataBlock FBDataConsumerToLineSplitter (lineBytesBlock consumer) {
+  // Only an incomplete line is carried between chunks, all other lines are passed as ranges of the chunk itself.
+  NSMutableData *partialLine = NSMutableData.data;
+  return ^(NSData *data){
+    @synchronized (partialLine) {
+      const uint8_t *bytes = data.bytes;
+      size_t length = data.length;
+      size_t offset = 0;
+      if (partialLine.length > 0) {
+        const uint8_t *newline = FBLineScannerFindByte(bytes, length, '\n');
+        if (!newline) {
+          [partialLine appendBytes:bytes length:length];
+          return;
+        }
+        [partialLine appendBytes:bytes length:(NSUInteger) (newline - bytes)];
+        consumer(partialLine.bytes, partialLine.length);
+        partialLine.length = 0;
+        offset = (size_t) (newline - bytes) + 1;
+      }
+      offset += FBLineScannerEnumerateLines(bytes + offset, length - offset, consumer);
+      if (offset < length) {
+        [partialLine appendBytes:bytes + offset length:length - offset];
+      }
+    }
+  };
+}
+
 @interface FBBlockDataConsumer_Dispatcher : NSObject <FBDataConsumer>
 
 @property (nonatomic, strong, nullable, readwrite) dispatch_queue_t queue;
@@ -225,11 +260,12 @@ static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString
 
 @end
 
-@interface FBBlockDataConsumer_Buffered : FBBlockDataConsumer
+@interface FBBlockDataConsumer_Lines : FBBlockDataConsumer
 
-@property (nonatomic, strong, readonly) id<FBConsumableBuffer> buffer;
+@property (nonatomic, assign, readonly) BOOL copiesData;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *finishedConsumingFuture;
 
-- (instancetype)initWithDispatcher:(FBBlockDataConsumer_Dispatcher *)dispatcher terminal:(NSData *)terminal;
+- (instancetype)initWithQueue:(nullable dispatch_queue_t)queue consumer:(lineBytesBlock)consumer;
 
 @end
 
@@ -251,8 +287,12 @@ static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString
 
 + (id<FBDataConsumer, FBDataConsumerLifecycle>)synchronousLineConsumerWithBlock:(void (^)(NSString *))consumer
 {
-  FBBlockDataConsumer_Dispatcher *dispatcher = [[FBBlockDataConsumer_Dispatcher alloc] initWithQueue:nil consumer:FBDataConsumerToStringConsumer(consumer)];
-  return [[FBBlockDataConsumer_Buffered alloc] initWithDispatcher:dispatcher terminal:FBDataBuffer.newlineTerminal];
+  return [[FBBlockDataConsumer_Lines alloc] initWithQueue:nil consumer:FBDataConsumerBytesToStringConsumer(consumer)];
+}
+
++ (id<FBDataConsumer, FBDataConsumerLifecycle>)synchronousLineConsumerWithBytesBlock:(void (^)(const char *, NSUInteger))consumer
+{
+  return [[FBBlockDataConsumer_Lines alloc] initWithQueue:nil consumer:consumer];
 }
 
 + (id<FBDataConsumer, FBDataConsumerLifecycle>)asynchronousDataConsumerOnQueue:(dispatch_queue_t)queue consumer:(void (^)(NSData *))consumer
@@ -270,20 +310,22 @@ static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString
 + (id<FBDataConsumer, FBDataConsumerLifecycle>)asynchronousLineConsumerWithBlock:(void (^)(NSString *))consumer
 {
   dispatch_queue_t queue = dispatch_queue_create("com.facebook.FBControlCore.BlockDataConsumer.lines", DISPATCH_QUEUE_SERIAL);
-  FBBlockDataConsumer_Dispatcher *dispatcher = [[FBBlockDataConsumer_Dispatcher alloc] initWithQueue:queue consumer:FBDataConsumerToStringConsumer(consumer)];
-  return [[FBBlockDataConsumer_Buffered alloc] initWithDispatcher:dispatcher terminal:FBDataBuffer.newlineTerminal];
+  return [[FBBlockDataConsumer_Lines alloc] initWithQueue:queue consumer:FBDataConsumerBytesToStringConsumer(consumer)];
 }
 
 + (id<FBDataConsumer, FBDataConsumerLifecycle>)asynchronousLineConsumerWithQueue:(dispatch_queue_t)queue consumer:(void (^)(NSString *))consumer
 {
-  FBBlockDataConsumer_Dispatcher *dispatcher = [[FBBlockDataConsumer_Dispatcher alloc] initWithQueue:queue consumer:FBDataConsumerToStringConsumer(consumer)];
-  return [[FBBlockDataConsumer_Buffered alloc] initWithDispatcher:dispatcher terminal:FBDataBuffer.newlineTerminal];
+  return [[FBBlockDataConsumer_Lines alloc] initWithQueue:queue consumer:FBDataConsumerBytesToStringConsumer(consumer)];
 }
 
 + (id<FBDataConsumer, FBDataConsumerLifecycle>)asynchronousLineConsumerWithQueue:(dispatch_queue_t)queue dataConsumer:(void (^)(NSData *))consumer
 {
-  FBBlockDataConsumer_Dispatcher *dispatcher = [[FBBlockDataConsumer_Dispatcher alloc] initWithQueue:queue consumer:consumer];
-  return [[FBBlockDataConsumer_Buffered alloc] initWithDispatcher:dispatcher terminal:FBDataBuffer.newlineTerminal];
+  return [[FBBlockDataConsumer_Lines alloc] initWithQueue:queue consumer:FBDataConsumerBytesToDataConsumer(consumer)];
+}
+
++ (id<FBDataConsumer, FBDataConsumerLifecycle>)asynchronousLineConsumerWithQueue:(dispatch_queue_t)queue bytesConsumer:(void (^)(const char *, NSUInteger))consumer
+{
+  return [[FBBlockDataConsumer_Lines alloc] initWithQueue:queue consumer:consumer];
 }
 
 - (instancetype)initWithDispatcher:(FBBlockDataConsumer_Dispatcher *)dispatcher
@@ -320,18 +362,21 @@ static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString
 
 @end
 
-@implementation FBBlockDataConsumer_Buffered
+@implementation FBBlockDataConsumer_Lines
 
 #pragma mark Initializers
 
-- (instancetype)initWithDispatcher:(FBBlockDataConsumer_Dispatcher *)dispatcher terminal:(NSData *)terminal
+- (instancetype)initWithQueue:(dispatch_queue_t)queue consumer:(lineBytesBlock)consumer
 {
+  FBBlockDataConsumer_Dispatcher *dispatcher = [[FBBlockDataConsumer_Dispatcher alloc] initWithQueue:queue consumer:FBDataConsumerToLineSplitter(consumer)];
   self = [super initWithDispatcher:dispatcher];
   if (!self) {
     return nil;
   }
 
-  _buffer = [FBDataBuffer consumableBufferForwardingToConsumer:dispatcher onQueue:nil terminal:terminal];
+  // Lines are split on the queue, so the data must outlive the call to -consumeData:
+  _copiesData = queue != nil;
+  _finishedConsumingFuture = FBMutableFuture.future;
 
   return self;
 }
@@ -341,14 +386,17 @@ static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString
 - (void)consumeData:(NSData *)data
 {
   @synchronized (self) {
-    [self.buffer consumeData:data];
+    if (self.finishedConsumingFuture.hasCompleted || data.length == 0) {
+      return;
+    }
+    [self.dispatcher consumeData:(self.copiesData ? [data copy] : data)];
   }
 }
 
 - (void)consumeEndOfFile
 {
   @synchronized (self) {
-    [self.buffer consumeEndOfFile];
+    [self.finishedConsumingFuture resolveWithResult:NSNull.null];
   }
 }
 
@@ -356,7 +404,7 @@ static inline dataBlock FBDataConsumerToStringConsumer (void(^consumer)(NSString
 
 - (FBFuture<NSNull *> *)finishedConsuming
 {
-  return self.buffer.finishedConsuming;
+  return self.finishedConsumingFuture;
 }
 
 @end
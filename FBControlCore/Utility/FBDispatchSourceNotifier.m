@@ -31,6 +31,11 @@
     dispatch_source_cancel(source);
   });
   dispatch_resume(source);
+  // A process that exits before the source is registered will not deliver an event.
+  if (kill(processIdentifier, 0) != 0 && errno == ESRCH) {
+    [future resolveWithResult:@(processIdentifier)];
+    dispatch_source_cancel(source);
+  }
 
   return future;
 }
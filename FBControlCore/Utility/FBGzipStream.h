@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBDataConsumer.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A consumer that gzip compresses the data that it consumes, writing a single gzip member to a destination consumer.
+ The input is divided into blocks that are deflated concurrently. Each block is primed with the end of the previous block, so the compression ratio is close to that of a serial compressor.
+ Compressed blocks are written to the destination in order, from a private serial queue.
+ The number of blocks in flight is bounded, so `consumeData:` will block the producer when the destination cannot keep up.
+ */
+@interface FBGzipCompressor : NSObject <FBDataConsumer, FBDataConsumerLifecycle>
+
+#pragma mark Initializers
+
+/**
+ Constructs a Gzip Compressor.
+
+ @param consumer the consumer to write the compressed data to.
+ @param level the zlib compression level, from 1 to 9.
+ @param concurrency the maximum number of blocks that are compressed at the same time.
+ @return a new Gzip Compressor.
+ */
++ (instancetype)compressorWithConsumer:(id<FBDataConsumer>)consumer level:(int)level concurrency:(NSUInteger)concurrency;
+
+/**
+ Constructs a Gzip Compressor with the default compression level, using every active processor.
+
+ @param consumer the consumer to write the compressed data to.
+ @return a new Gzip Compressor.
+ */
++ (instancetype)compressorWithConsumer:(id<FBDataConsumer>)consumer;
+
+#pragma mark Properties
+
+/**
+ The number of uncompressed bytes that have been consumed.
+ */
+@property (atomic, assign, readonly) unsigned long long bytesConsumed;
+
+/**
+ The number of compressed bytes that have been written to the destination.
+ */
+@property (atomic, assign, readonly) unsigned long long bytesWritten;
+
+@end
+
+/**
+ A consumer that decompresses gzip data, writing the decompressed data to a destination consumer.
+ Concatenated gzip members are decompressed in sequence, as they are by gunzip.
+ Data must be consumed serially. Decompression happens on the calling thread.
+ `finishedConsuming` fails if the data is not a valid gzip stream.
+ */
+@interface FBGzipDecompressor : NSObject <FBDataConsumer, FBDataConsumerLifecycle>
+
+#pragma mark Initializers
+
+/**
+ Constructs a Gzip Decompressor.
+
+ @param consumer the consumer to write the decompressed data to.
+ @return a new Gzip Decompressor.
+ */
++ (instancetype)decompressorWithConsumer:(id<FBDataConsumer>)consumer;
+
+#pragma mark Public Methods
+
+/**
+ Returns YES if the data begins with the gzip magic number.
+
+ @param data the data to check.
+ @return YES if the data looks like gzip data, NO otherwise.
+ */
++ (BOOL)isGzipData:(NSData *)data;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBGzipStream.h"
+
+#import <zlib.h>
+
+#import "FBControlCoreError.h"
+
+static const NSUInteger FBGzipBlockSize = 1024 * 1024;
+static const NSUInteger FBGzipDictionarySize = 32 * 1024;
+static const NSUInteger FBGzipOutputChunkSize = 256 * 1024;
+static const int FBGzipDefaultLevel = 6;
+
+static void FBGzipAppendLittleEndian32(NSMutableData *data, uint32_t value)
+{
+  uint8_t bytes[4] = {
+    (uint8_t) (value & 0xff),
+    (uint8_t) ((value >> 8) & 0xff),
+    (uint8_t) ((value >> 16) & 0xff),
+    (uint8_t) ((value >> 24) & 0xff),
+  };
+  [data appendBytes:bytes length:sizeof(bytes)];
+}
+
+// Deflates a block as raw deflate data.
+// Blocks other than the last end with a sync flush, so that they are byte aligned and can be concatenated with the following block.
+static NSData *FBGzipDeflateBlock(NSData *input, NSData *dictionary, int level, BOOL last, NSError **error)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  int status = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  if (status != Z_OK) {
+    return [[FBControlCoreError
+      describeFormat:@"Failed to initialize deflate: %d", status]
+      fail:error];
+  }
+  if (dictionary.length > 0) {
+    deflateSetDictionary(&stream, dictionary.bytes, (uInt) dictionary.length);
+  }
+  NSMutableData *output = [NSMutableData dataWithLength:deflateBound(&stream, input.length) + 64];
+  stream.next_in = (Bytef *) input.bytes;
+  stream.avail_in = (uInt) input.length;
+  int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+  while (YES) {
+    if (stream.total_out == output.length) {
+      [output increaseLengthBy:FBGzipOutputChunkSize];
+    }
+    stream.next_out = (Bytef *) output.mutableBytes + stream.total_out;
+    stream.avail_out = (uInt) (output.length - stream.total_out);
+    status = deflate(&stream, flush);
+    if (status == Z_STREAM_END) {
+      break;
+    }
+    if (status != Z_OK && status != Z_BUF_ERROR) {
+      deflateEnd(&stream);
+      return [[FBControlCoreError
+        describeFormat:@"Failed to deflate block: %d", status]
+        fail:error];
+    }
+    if (flush == Z_SYNC_FLUSH && stream.avail_out != 0) {
+      break;
+    }
+  }
+  output.length = stream.total_out;
+  deflateEnd(&stream);
+  return output;
+}
+
+@interface FBGzipCompressor_Block : NSObject
+
+@property (nonatomic, strong, readwrite) NSData *input;
+@property (nonatomic, strong, nullable, readwrite) NSData *output;
+@property (nonatomic, strong, nullable, readwrite) NSError *error;
+@property (nonatomic, assign, readwrite) uLong crc;
+
+@end
+
+@implementation FBGzipCompressor_Block
+
+@end
+
+@interface FBGzipCompressor ()
+
+@property (nonatomic, strong, readonly) id<FBDataConsumer> consumer;
+@property (nonatomic, assign, readonly) int level;
+@property (nonatomic, copy, readonly) NSArray<dispatch_queue_t> *compressionQueues;
+@property (nonatomic, strong, readonly) dispatch_queue_t writeQueue;
+@property (nonatomic, strong, readonly) dispatch_semaphore_t blocksInFlight;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *finishedConsumingFuture;
+@property (nonatomic, strong, readonly) NSMutableData *pending;
+@property (nonatomic, strong, nullable, readwrite) NSData *dictionary;
+@property (nonatomic, assign, readwrite) NSUInteger blockCount;
+@property (nonatomic, assign, readwrite) BOOL finished;
+@property (atomic, assign, readwrite) unsigned long long bytesConsumed;
+@property (atomic, assign, readwrite) unsigned long long bytesWritten;
+
+// Only accessed on the write queue.
+@property (nonatomic, assign, readwrite) uLong crc;
+@property (nonatomic, strong, nullable, readwrite) NSError *error;
+
+@end
+
+@implementation FBGzipCompressor
+
+#pragma mark Initializers
+
++ (instancetype)compressorWithConsumer:(id<FBDataConsumer>)consumer level:(int)level concurrency:(NSUInteger)concurrency
+{
+  return [[self alloc] initWithConsumer:consumer level:level concurrency:MAX(concurrency, 1u)];
+}
+
++ (instancetype)compressorWithConsumer:(id<FBDataConsumer>)consumer
+{
+  return [self compressorWithConsumer:consumer level:FBGzipDefaultLevel concurrency:NSProcessInfo.processInfo.activeProcessorCount];
+}
+
+- (instancetype)initWithConsumer:(id<FBDataConsumer>)consumer level:(int)level concurrency:(NSUInteger)concurrency
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  // Blocks are assigned to serial queues in turn, which bounds the number of blocks that are compressed at once without blocking any threads.
+  NSMutableArray<dispatch_queue_t> *compressionQueues = [NSMutableArray array];
+  for (NSUInteger index = 0; index < concurrency; index++) {
+    [compressionQueues addObject:dispatch_queue_create("com.facebook.fbcontrolcore.gzip.compress", DISPATCH_QUEUE_SERIAL)];
+  }
+
+  _consumer = consumer;
+  _level = level;
+  _compressionQueues = compressionQueues;
+  _writeQueue = dispatch_queue_create("com.facebook.fbcontrolcore.gzip.write", DISPATCH_QUEUE_SERIAL);
+  _blocksInFlight = dispatch_semaphore_create((long) concurrency * 2);
+  _finishedConsumingFuture = FBMutableFuture.future;
+  _pending = [NSMutableData dataWithCapacity:FBGzipBlockSize];
+  _crc = crc32(0, Z_NULL, 0);
+
+  return self;
+}
+
+#pragma mark FBDataConsumer
+
+- (void)consumeData:(NSData *)data
+{
+  @synchronized (self) {
+    if (self.finished) {
+      return;
+    }
+    self.bytesConsumed += data.length;
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+      NSUInteger offset = 0;
+      while (offset < byteRange.length) {
+        NSUInteger length = MIN(byteRange.length - offset, FBGzipBlockSize - self.pending.length);
+        [self.pending appendBytes:(const uint8_t *) bytes + offset length:length];
+        offset += length;
+        if (self.pending.length == FBGzipBlockSize) {
+          [self submitBlockLast:NO];
+        }
+      }
+    }];
+  }
+}
+
+- (void)consumeEndOfFile
+{
+  @synchronized (self) {
+    if (self.finished) {
+      return;
+    }
+    self.finished = YES;
+    [self submitBlockLast:YES];
+  }
+  dispatch_async(self.writeQueue, ^{
+    if (!self.error) {
+      NSMutableData *trailer = [NSMutableData dataWithCapacity:8];
+      FBGzipAppendLittleEndian32(trailer, (uint32_t) self.crc);
+      FBGzipAppendLittleEndian32(trailer, (uint32_t) (self.bytesConsumed & 0xffffffff));
+      [self writeData:trailer];
+    }
+    [self.consumer consumeEndOfFile];
+    if (self.error) {
+      [self.finishedConsumingFuture resolveWithError:self.error];
+    } else {
+      [self.finishedConsumingFuture resolveWithResult:NSNull.null];
+    }
+  });
+}
+
+#pragma mark FBDataConsumerLifecycle
+
+- (FBFuture<NSNull *> *)finishedConsuming
+{
+  return self.finishedConsumingFuture;
+}
+
+#pragma mark Private
+
+- (void)submitBlockLast:(BOOL)last
+{
+  // Wait for a slot, this applies back-pressure to the producer.
+  dispatch_semaphore_wait(self.blocksInFlight, DISPATCH_TIME_FOREVER);
+
+  FBGzipCompressor_Block *block = [[FBGzipCompressor_Block alloc] init];
+  block.input = [self.pending copy];
+  [self.pending setLength:0];
+  NSData *dictionary = self.dictionary;
+  if (block.input.length >= FBGzipDictionarySize) {
+    self.dictionary = [block.input subdataWithRange:NSMakeRange(block.input.length - FBGzipDictionarySize, FBGzipDictionarySize)];
+  }
+  BOOL first = self.blockCount == 0;
+  dispatch_queue_t compressionQueue = self.compressionQueues[self.blockCount % self.compressionQueues.count];
+  self.blockCount++;
+
+  int level = self.level;
+  dispatch_block_t compress = dispatch_block_create(0, ^{
+    NSError *error = nil;
+    block.output = FBGzipDeflateBlock(block.input, dictionary, level, last, &error);
+    block.error = error;
+    block.crc = crc32(crc32(0, Z_NULL, 0), block.input.bytes, (uInt) block.input.length);
+  });
+  dispatch_async(compressionQueue, compress);
+
+  // The write queue is serial, so blocks are written in the order that they were submitted.
+  dispatch_async(self.writeQueue, ^{
+    dispatch_block_wait(compress, DISPATCH_TIME_FOREVER);
+    if (first) {
+      // Magic, Deflate, No Flags, No Modification Time, No Extra Flags, Unix.
+      static const uint8_t header[10] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03};
+      [self writeData:[NSData dataWithBytes:header length:sizeof(header)]];
+    }
+    if (block.error && !self.error) {
+      self.error = block.error;
+    }
+    if (!self.error) {
+      self.crc = crc32_combine(self.crc, block.crc, (z_off_t) block.input.length);
+      [self writeData:block.output];
+    }
+    dispatch_semaphore_signal(self.blocksInFlight);
+  });
+}
+
+- (void)writeData:(NSData *)data
+{
+  if (data.length == 0) {
+    return;
+  }
+  [self.consumer consumeData:data];
+  self.bytesWritten += data.length;
+}
+
+@end
+
+@interface FBGzipDecompressor ()
+
+@property (nonatomic, strong, readonly) id<FBDataConsumer> consumer;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *finishedConsumingFuture;
+@property (nonatomic, assign, readwrite) BOOL memberEnded;
+@property (nonatomic, assign, readwrite) BOOL trailingData;
+@property (nonatomic, assign, readwrite) BOOL receivedData;
+@property (nonatomic, assign, readwrite) BOOL finished;
+@property (nonatomic, strong, nullable, readwrite) NSError *error;
+
+@end
+
+@implementation FBGzipDecompressor
+{
+  z_stream _stream;
+  BOOL _streamInitialized;
+}
+
+#pragma mark Initializers
+
++ (instancetype)decompressorWithConsumer:(id<FBDataConsumer>)consumer
+{
+  return [[self alloc] initWithConsumer:consumer];
+}
+
+- (instancetype)initWithConsumer:(id<FBDataConsumer>)consumer
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _consumer = consumer;
+  _finishedConsumingFuture = FBMutableFuture.future;
+  memset(&_stream, 0, sizeof(_stream));
+
+  return self;
+}
+
+- (void)dealloc
+{
+  if (_streamInitialized) {
+    inflateEnd(&_stream);
+  }
+}
+
+#pragma mark Public Methods
+
++ (BOOL)isGzipData:(NSData *)data
+{
+  if (data.length < 2) {
+    return NO;
+  }
+  const uint8_t *bytes = data.bytes;
+  return bytes[0] == 0x1f && bytes[1] == 0x8b;
+}
+
+#pragma mark FBDataConsumer
+
+- (void)consumeData:(NSData *)data
+{
+  if (self.finished || self.error || self.trailingData) {
+    return;
+  }
+  [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+    if (![self inflateBytes:bytes length:byteRange.length]) {
+      *stop = YES;
+    }
+  }];
+}
+
+- (void)consumeEndOfFile
+{
+  if (self.finished) {
+    return;
+  }
+  self.finished = YES;
+  if (!self.error && (!self.receivedData || !self.memberEnded)) {
+    self.error = [[FBControlCoreError
+      describe:@"Unexpected end of gzip stream"]
+      build];
+  }
+  [self.consumer consumeEndOfFile];
+  if (self.error) {
+    [self.finishedConsumingFuture resolveWithError:self.error];
+  } else {
+    [self.finishedConsumingFuture resolveWithResult:NSNull.null];
+  }
+}
+
+#pragma mark FBDataConsumerLifecycle
+
+- (FBFuture<NSNull *> *)finishedConsuming
+{
+  return self.finishedConsumingFuture;
+}
+
+#pragma mark Private
+
+- (BOOL)inflateBytes:(const void *)bytes length:(NSUInteger)length
+{
+  if (length == 0) {
+    return YES;
+  }
+  if (self.memberEnded) {
+    // Another member may follow, anything else is trailing garbage that gunzip would ignore.
+    if (((const uint8_t *) bytes)[0] != 0x1f) {
+      self.trailingData = YES;
+      return NO;
+    }
+    inflateReset(&_stream);
+    self.memberEnded = NO;
+  }
+  if (!_streamInitialized) {
+    int status = inflateInit2(&_stream, 16 + MAX_WBITS);
+    if (status != Z_OK) {
+      return [self failWithStatus:status];
+    }
+    _streamInitialized = YES;
+  }
+  self.receivedData = YES;
+  _stream.next_in = (Bytef *) bytes;
+  _stream.avail_in = (uInt) length;
+  while (_stream.avail_in > 0) {
+    NSMutableData *output = [NSMutableData dataWithLength:FBGzipOutputChunkSize];
+    _stream.next_out = output.mutableBytes;
+    _stream.avail_out = (uInt) output.length;
+    int status = inflate(&_stream, Z_NO_FLUSH);
+    if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+      return [self failWithStatus:status];
+    }
+    output.length = output.length - _stream.avail_out;
+    if (output.length > 0) {
+      [self.consumer consumeData:output];
+    }
+    if (status == Z_STREAM_END) {
+      self.memberEnded = YES;
+      NSUInteger remaining = _stream.avail_in;
+      if (remaining > 0) {
+        return [self inflateBytes:_stream.next_in length:remaining];
+      }
+      return YES;
+    }
+    if (status == Z_BUF_ERROR && _stream.avail_out != 0) {
+      // No progress is possible until more input arrives.
+      break;
+    }
+  }
+  return YES;
+}
+
+- (BOOL)failWithStatus:(int)status
+{
+  self.error = [[FBControlCoreError
+    describeFormat:@"Failed to inflate gzip stream: %d %s", status, _stream.msg ?: ""]
+    build];
+  [self.finishedConsumingFuture resolveWithError:self.error];
+  return NO;
+}
+
+@end
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Finds the first occurrence of a byte within a range of bytes.
+ Compares 16 bytes at a time with SSE2 or NEON where they are available, otherwise falls back to memchr.
+
+ @param bytes the bytes to scan.
+ @param length the number of bytes to scan.
+ @param byte the byte to find.
+ @return a pointer to the first occurrence of the byte, or NULL if it is not present.
+ */
+extern const uint8_t *_Nullable FBLineScannerFindByte(const uint8_t *bytes, size_t length, uint8_t byte);
+
+/**
+ Enumerates the newline terminated lines within a range of bytes, without copying them.
+ Each line is passed to the handler without its terminating newline, the pointer is into the provided range.
+
+ @param bytes the bytes to scan.
+ @param length the number of bytes to scan.
+ @param handler the handler to call for each complete line.
+ @return the number of bytes that were consumed. This is the offset of the byte after the last newline, any bytes after it are an incomplete line.
+ */
+extern size_t FBLineScannerEnumerateLines(const uint8_t *bytes, size_t length, void (^handler)(const char *line, NSUInteger lineLength));
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBLineScanner.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static const size_t FBLineScannerVectorWidth = 16;
+
+const uint8_t *FBLineScannerFindByte(const uint8_t *bytes, size_t length, uint8_t byte)
+{
+  const uint8_t *cursor = bytes;
+  const uint8_t *end = bytes + length;
+#if defined(__SSE2__)
+  __m128i needle = _mm_set1_epi8((char) byte);
+  for (; (size_t) (end - cursor) >= FBLineScannerVectorWidth; cursor += FBLineScannerVectorWidth) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *) cursor);
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    if (mask != 0) {
+      return cursor + __builtin_ctz((unsigned int) mask);
+    }
+  }
+#elif defined(__ARM_NEON)
+  uint8x16_t needle = vdupq_n_u8(byte);
+  for (; (size_t) (end - cursor) >= FBLineScannerVectorWidth; cursor += FBLineScannerVectorWidth) {
+    uint8x16_t matches = vceqq_u8(vld1q_u8(cursor), needle);
+    // NEON has no movemask, narrowing each 16-bit lane by 4 bits packs the comparison into a 64-bit value with a nibble per byte.
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+    if (mask != 0) {
+      return cursor + (__builtin_ctzll(mask) >> 2);
+    }
+  }
+#endif
+  if (cursor == end) {
+    return NULL;
+  }
+  return memchr(cursor, byte, (size_t) (end - cursor));
+}
+
+size_t FBLineScannerEnumerateLines(const uint8_t *bytes, size_t length, void (^handler)(const char *line, NSUInteger lineLength))
+{
+  size_t offset = 0;
+  while (offset < length) {
+    const uint8_t *newline = FBLineScannerFindByte(bytes + offset, length - offset, '\n');
+    if (!newline) {
+      break;
+    }
+    size_t lineEnd = (size_t) (newline - bytes);
+    handler((const char *) bytes + offset, lineEnd - offset);
+    offset = lineEnd + 1;
+  }
+  return offset;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBDataConsumer.h>
+#import <FBControlCore/FBFuture.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@protocol FBControlCoreLogger;
+
+/**
+ Writes a tar archive of a path on the filesystem to a consumer, without launching a tar process.
+ Entries are written in the ustar format. A pax extended header is written first for any path, link target or size that ustar cannot represent.
+ Regular files, directories and symbolic links are archived. Other types of file are skipped.
+ */
+@interface FBTarWriter : NSObject
+
+/**
+ Writes a tar archive of a path to a consumer.
+ A directory is archived as its contents, with each entry prefixed by './', as with `tar -C path .`.
+ A file is archived as a single entry named after the file, as with `tar -C dirname basename`.
+ The archive is produced on a private queue. `consumeEndOfFile` is called on the consumer once the archive is complete, or once it has failed.
+
+ @param path the path to archive.
+ @param consumer the consumer to write the archive to.
+ @param queue the queue to resolve the future on.
+ @param logger the logger to log to.
+ @return a Future that resolves when the archive has been written.
+ */
++ (FBFuture<NSNull *> *)writeArchiveOfPath:(NSString *)path toConsumer:(id<FBDataConsumer>)consumer queue:(dispatch_queue_t)queue logger:(nullable id<FBControlCoreLogger>)logger;
+
+/**
+ Returns YES if the data begins with a ustar, pax or GNU tar header.
+
+ @param data the data to check. At least 512 bytes are required.
+ @return YES if the data looks like a tar archive, NO otherwise.
+ */
++ (BOOL)isTarData:(NSData *)data;
+
+@end
+
+/**
+ Called with each regular file once it has been extracted.
+ Returning NO stops the extraction, failing `finishedConsuming` with the error.
+
+ @param relativePath the path of the file, relative to the directory that is extracted into.
+ @param path the path of the file on disk.
+ @param error an error out for any error that occurs.
+ @return YES if extraction should continue, NO otherwise.
+ */
+typedef BOOL (^FBTarExtractorEntryHandler)(NSString *relativePath, NSString *path, NSError **error);
+
+/**
+ A consumer that extracts a tar archive into a directory as it is consumed, without launching a tar process.
+ A gzip compressed archive is recognised from its first bytes and decompressed in-process.
+ Regular files, directories, symbolic and hard links are extracted from ustar, pax and GNU archives. Permissions and modification times are preserved.
+ Entries that would be extracted outside of the directory are rejected. AppleDouble entries, which carry metadata rather than contents, are skipped.
+ The modes of directories are applied once the archive has been extracted, so that read-only directories can be populated.
+ Data must be consumed serially. `finishedConsuming` resolves once the archive has been extracted, or fails as soon as the archive is found to be invalid.
+ */
+@interface FBTarExtractor : NSObject <FBDataConsumer, FBDataConsumerLifecycle>
+
+#pragma mark Initializers
+
+/**
+ Constructs a Tar Extractor.
+
+ @param directory the directory to extract into. It is created if it does not exist.
+ @param logger the logger to log to.
+ @return a new Tar Extractor.
+ */
++ (instancetype)extractorWithDirectory:(NSString *)directory logger:(nullable id<FBControlCoreLogger>)logger;
+
+/**
+ Constructs a Tar Extractor that inspects files as they are extracted.
+ This allows an archive to be validated from its first entries, rather than once it has been extracted in full.
+
+ @param directory the directory to extract into. It is created if it does not exist.
+ @param entryHandler called on the consuming thread with each regular file once it has been extracted.
+ @param logger the logger to log to.
+ @return a new Tar Extractor.
+ */
++ (instancetype)extractorWithDirectory:(NSString *)directory entryHandler:(nullable FBTarExtractorEntryHandler)entryHandler logger:(nullable id<FBControlCoreLogger>)logger;
+
+#pragma mark Properties
+
+/**
+ The directory that is extracted into.
+ */
+@property (nonatomic, copy, readonly) NSString *directory;
+
+/**
+ The number of entries that have been extracted.
+ */
+@property (atomic, assign, readonly) NSUInteger entriesExtracted;
+
+@end
+
+NS_ASSUME_NONNULL_END
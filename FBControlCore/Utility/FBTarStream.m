@@ -0,0 +1,1096 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBTarStream.h"
+
+#import <fts.h>
+#import <sys/stat.h>
+#import <sys/time.h>
+
+#import "FBControlCoreError.h"
+#import "FBControlCoreLogger.h"
+#import "FBGzipStream.h"
+
+typedef struct {
+  char name[100];
+  char mode[8];
+  char uid[8];
+  char gid[8];
+  char size[12];
+  char mtime[12];
+  char checksum[8];
+  char typeflag;
+  char linkname[100];
+  char magic[6];
+  char version[2];
+  char uname[32];
+  char gname[32];
+  char devmajor[8];
+  char devminor[8];
+  char prefix[155];
+  char padding[12];
+} FBTarHeader;
+
+_Static_assert(sizeof(FBTarHeader) == 512, "A tar header occupies a single block");
+
+static const NSUInteger FBTarBlockSize = 512;
+static const NSUInteger FBTarWriteBufferSize = 1024 * 1024;
+static const NSUInteger FBTarMaximumBufferedEntrySize = 1024 * 1024;
+static const uint8_t FBTarAppleDoubleMagic[4] = {0x00, 0x05, 0x16, 0x07};
+
+static NSUInteger FBTarPaddingForSize(unsigned long long size)
+{
+  return (NSUInteger) ((FBTarBlockSize - (size % FBTarBlockSize)) % FBTarBlockSize);
+}
+
+static unsigned long long FBTarOctalMaximum(size_t length)
+{
+  // The field is NUL terminated, leaving one fewer digit than its length.
+  return (1ULL << (3 * (length - 1))) - 1;
+}
+
+static void FBTarWriteOctal(char *field, size_t length, unsigned long long value)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%0*llo", (int) (length - 1), MIN(value, FBTarOctalMaximum(length)));
+  memcpy(field, buffer, length - 1);
+  field[length - 1] = '\0';
+}
+
+static unsigned long long FBTarParseNumeric(const char *field, size_t length)
+{
+  const uint8_t *bytes = (const uint8_t *) field;
+  if (bytes[0] & 0x80) {
+    // GNU base-256 encoding, the remaining bits are a big-endian number.
+    unsigned long long value = bytes[0] & 0x7f;
+    for (size_t index = 1; index < length; index++) {
+      value = (value << 8) | bytes[index];
+    }
+    return value;
+  }
+  size_t index = 0;
+  while (index < length && field[index] == ' ') {
+    index++;
+  }
+  unsigned long long value = 0;
+  for (; index < length && field[index] >= '0' && field[index] <= '7'; index++) {
+    value = (value << 3) | (unsigned long long) (field[index] - '0');
+  }
+  return value;
+}
+
+static NSString *FBTarParseString(const char *field, size_t length)
+{
+  size_t stringLength = strnlen(field, length);
+  NSString *string = [[NSString alloc] initWithBytes:field length:stringLength encoding:NSUTF8StringEncoding];
+  return string ?: [[NSString alloc] initWithBytes:field length:stringLength encoding:NSISOLatin1StringEncoding];
+}
+
+static BOOL FBTarHeaderChecksumIsValid(const uint8_t *block)
+{
+  const FBTarHeader *header = (const FBTarHeader *) block;
+  unsigned long long expected = FBTarParseNumeric(header->checksum, sizeof(header->checksum));
+  size_t checksumStart = offsetof(FBTarHeader, checksum);
+  size_t checksumEnd = checksumStart + sizeof(header->checksum);
+  // Some historical writers summed signed chars, so both sums are accepted.
+  unsigned long long unsignedSum = 0;
+  long long signedSum = 0;
+  for (size_t index = 0; index < FBTarBlockSize; index++) {
+    uint8_t byte = (index >= checksumStart && index < checksumEnd) ? ' ' : block[index];
+    unsignedSum += byte;
+    signedSum += (int8_t) byte;
+  }
+  return expected == unsignedSum || (long long) expected == signedSum;
+}
+
+static void FBTarWriteChecksum(FBTarHeader *header)
+{
+  memset(header->checksum, ' ', sizeof(header->checksum));
+  unsigned int sum = 0;
+  const uint8_t *bytes = (const uint8_t *) header;
+  for (size_t index = 0; index < sizeof(FBTarHeader); index++) {
+    sum += bytes[index];
+  }
+  // Six digits and a NUL, the final byte remains a space.
+  snprintf(header->checksum, sizeof(header->checksum) - 1, "%06o", sum);
+}
+
+static BOOL FBTarSplitName(const char *name, size_t length, FBTarHeader *header)
+{
+  if (length <= sizeof(header->name)) {
+    memcpy(header->name, name, length);
+    return YES;
+  }
+  // ustar can split a long name at a directory separator, into a prefix and a name.
+  size_t start = length - sizeof(header->name) - 1;
+  for (size_t index = MAX(start, 1u); index <= sizeof(header->prefix) && index < length - 1; index++) {
+    if (name[index] != '/') {
+      continue;
+    }
+    memcpy(header->prefix, name, index);
+    memcpy(header->name, name + index + 1, length - index - 1);
+    return YES;
+  }
+  return NO;
+}
+
+static void FBTarAppendPaxRecord(NSMutableData *data, NSString *key, NSString *value)
+{
+  // Each record is prefixed by its own length in decimal, including the length of the prefix.
+  NSData *record = [[NSString stringWithFormat:@" %@=%@\n", key, value] dataUsingEncoding:NSUTF8StringEncoding];
+  NSUInteger digits = 1;
+  while (YES) {
+    NSUInteger actualDigits = [NSString stringWithFormat:@"%lu", (unsigned long) (record.length + digits)].length;
+    if (actualDigits == digits) {
+      break;
+    }
+    digits = actualDigits;
+  }
+  [data appendData:[[NSString stringWithFormat:@"%lu", (unsigned long) (record.length + digits)] dataUsingEncoding:NSUTF8StringEncoding]];
+  [data appendData:record];
+}
+
+static int FBTarCompareEntries(const FTSENT **left, const FTSENT **right)
+{
+  return strcmp((*left)->fts_name, (*right)->fts_name);
+}
+
+static BOOL FBTarWriteFully(int fileDescriptor, const uint8_t *bytes, size_t length)
+{
+  while (length > 0) {
+    ssize_t written = write(fileDescriptor, bytes, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return NO;
+    }
+    bytes += written;
+    length -= (size_t) written;
+  }
+  return YES;
+}
+
+@interface FBTarWriter ()
+
+@property (nonatomic, strong, readonly) id<FBDataConsumer> consumer;
+@property (nonatomic, strong, nullable, readonly) id<FBControlCoreLogger> logger;
+@property (nonatomic, strong, readwrite) NSMutableData *buffer;
+
+@end
+
+@implementation FBTarWriter
+
+#pragma mark Initializers
+
+- (instancetype)initWithConsumer:(id<FBDataConsumer>)consumer logger:(nullable id<FBControlCoreLogger>)logger
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _consumer = consumer;
+  _logger = logger;
+  _buffer = [NSMutableData dataWithCapacity:FBTarWriteBufferSize];
+
+  return self;
+}
+
+#pragma mark Public Methods
+
++ (FBFuture<NSNull *> *)writeArchiveOfPath:(NSString *)path toConsumer:(id<FBDataConsumer>)consumer queue:(dispatch_queue_t)queue logger:(nullable id<FBControlCoreLogger>)logger
+{
+  FBMutableFuture<NSNull *> *future = FBMutableFuture.future;
+  // Reading files will block, so the archive is produced on a queue of its own.
+  dispatch_queue_t writeQueue = dispatch_queue_create("com.facebook.fbcontrolcore.tar.write", DISPATCH_QUEUE_SERIAL);
+  dispatch_async(writeQueue, ^{
+    FBTarWriter *writer = [[FBTarWriter alloc] initWithConsumer:consumer logger:logger];
+    NSError *error = nil;
+    BOOL success = [writer writeArchiveOfPath:path.stringByStandardizingPath error:&error];
+    [consumer consumeEndOfFile];
+    if (success) {
+      [future resolveWithResult:NSNull.null];
+    } else {
+      [future resolveWithError:error];
+    }
+  });
+  return [future onQueue:queue map:^(NSNull *result) {
+    return result;
+  }];
+}
+
++ (BOOL)isTarData:(NSData *)data
+{
+  if (data.length < FBTarBlockSize) {
+    return NO;
+  }
+  const uint8_t *bytes = data.bytes;
+  const FBTarHeader *header = (const FBTarHeader *) bytes;
+  if (memcmp(header->magic, "ustar", 5) != 0) {
+    return NO;
+  }
+  return FBTarHeaderChecksumIsValid(bytes);
+}
+
+#pragma mark Private
+
+- (BOOL)writeArchiveOfPath:(NSString *)path error:(NSError **)error
+{
+  struct stat rootStat;
+  if (lstat(path.fileSystemRepresentation, &rootStat) != 0) {
+    return [[FBControlCoreError
+      describeFormat:@"Path for tarring %@ doesn't exist", path]
+      failBool:error];
+  }
+  // Entries of a directory are relative to the directory, a file is relative to its parent.
+  NSString *archiveRoot = S_ISDIR(rootStat.st_mode) ? @"." : path.lastPathComponent;
+  const char *rootPath = path.fileSystemRepresentation;
+  size_t rootPathLength = strlen(rootPath);
+
+  char *paths[] = {(char *) rootPath, NULL};
+  FTS *fts = fts_open(paths, FTS_PHYSICAL | FTS_NOCHDIR, FBTarCompareEntries);
+  if (!fts) {
+    return [[FBControlCoreError
+      describeFormat:@"Failed to traverse %@: %s", path, strerror(errno)]
+      failBool:error];
+  }
+  BOOL success = YES;
+  FTSENT *entry = NULL;
+  while (success && (entry = fts_read(fts)) != NULL) {
+    @autoreleasepool {
+      success = [self writeEntry:entry archiveRoot:archiveRoot rootPathLength:rootPathLength error:error];
+    }
+  }
+  fts_close(fts);
+  if (!success) {
+    return NO;
+  }
+
+  // The end of the archive is marked by two zero blocks.
+  [self.buffer increaseLengthBy:FBTarBlockSize * 2];
+  [self flush];
+  return YES;
+}
+
+- (BOOL)writeEntry:(FTSENT *)entry archiveRoot:(NSString *)archiveRoot rootPathLength:(size_t)rootPathLength error:(NSError **)error
+{
+  if (entry->fts_info == FTS_DP) {
+    return YES;
+  }
+  if (entry->fts_info == FTS_DNR || entry->fts_info == FTS_ERR || entry->fts_info == FTS_NS) {
+    return [[FBControlCoreError
+      describeFormat:@"Failed to read %s for tarring: %s", entry->fts_path, strerror(entry->fts_errno)]
+      failBool:error];
+  }
+  NSString *relativePath = [NSString stringWithUTF8String:entry->fts_path + rootPathLength];
+  if (!relativePath) {
+    return [[FBControlCoreError
+      describeFormat:@"Path %s is not valid UTF-8", entry->fts_path]
+      failBool:error];
+  }
+  NSString *name = [archiveRoot stringByAppendingString:relativePath];
+  const struct stat *fileStat = entry->fts_statp;
+
+  switch (entry->fts_info) {
+    case FTS_D:
+      return [self writeHeaderForName:[name stringByAppendingString:@"/"] typeflag:'5' size:0 stat:fileStat linkname:nil error:error];
+    case FTS_F:
+      return [self writeHeaderForName:name typeflag:'0' size:(unsigned long long) fileStat->st_size stat:fileStat linkname:nil error:error]
+        && [self writeContentsOfFile:entry->fts_accpath size:(unsigned long long) fileStat->st_size error:error];
+    case FTS_SL:
+    case FTS_SLNONE: {
+      char target[PATH_MAX];
+      ssize_t targetLength = readlink(entry->fts_accpath, target, sizeof(target) - 1);
+      if (targetLength < 0) {
+        return [[FBControlCoreError
+          describeFormat:@"Failed to read link %s: %s", entry->fts_path, strerror(errno)]
+          failBool:error];
+      }
+      target[targetLength] = '\0';
+      return [self writeHeaderForName:name typeflag:'2' size:0 stat:fileStat linkname:[NSString stringWithUTF8String:target] error:error];
+    }
+    default:
+      [self.logger.debug logFormat:@"Skipping %@ as it is not a file, directory or symbolic link", name];
+      return YES;
+  }
+}
+
+- (BOOL)writeHeaderForName:(NSString *)name typeflag:(char)typeflag size:(unsigned long long)size stat:(const struct stat *)fileStat linkname:(nullable NSString *)linkname error:(NSError **)error
+{
+  FBTarHeader header;
+  memset(&header, 0, sizeof(header));
+  NSMutableData *paxRecords = [NSMutableData data];
+
+  const char *nameBytes = name.UTF8String;
+  size_t nameLength = strlen(nameBytes);
+  if (!FBTarSplitName(nameBytes, nameLength, &header)) {
+    FBTarAppendPaxRecord(paxRecords, @"path", name);
+    memcpy(header.name, nameBytes, sizeof(header.name));
+  }
+  if (linkname) {
+    const char *linkBytes = linkname.UTF8String;
+    size_t linkLength = strlen(linkBytes);
+    if (linkLength > sizeof(header.linkname)) {
+      FBTarAppendPaxRecord(paxRecords, @"linkpath", linkname);
+    }
+    memcpy(header.linkname, linkBytes, MIN(linkLength, sizeof(header.linkname)));
+  }
+  if (size > FBTarOctalMaximum(sizeof(header.size))) {
+    FBTarAppendPaxRecord(paxRecords, @"size", [NSString stringWithFormat:@"%llu", size]);
+  }
+  unsigned long long mtime = (unsigned long long) MAX(fileStat->st_mtimespec.tv_sec, 0);
+
+  if (paxRecords.length > 0) {
+    FBTarHeader paxHeader;
+    memset(&paxHeader, 0, sizeof(paxHeader));
+    NSString *paxName = [@"./PaxHeaders/" stringByAppendingString:name.lastPathComponent];
+    const char *paxNameBytes = paxName.UTF8String;
+    memcpy(paxHeader.name, paxNameBytes, MIN(strlen(paxNameBytes), sizeof(paxHeader.name)));
+    FBTarWriteOctal(paxHeader.mode, sizeof(paxHeader.mode), 0644);
+    FBTarWriteOctal(paxHeader.uid, sizeof(paxHeader.uid), 0);
+    FBTarWriteOctal(paxHeader.gid, sizeof(paxHeader.gid), 0);
+    FBTarWriteOctal(paxHeader.size, sizeof(paxHeader.size), paxRecords.length);
+    FBTarWriteOctal(paxHeader.mtime, sizeof(paxHeader.mtime), mtime);
+    paxHeader.typeflag = 'x';
+    memcpy(paxHeader.magic, "ustar", 6);
+    memcpy(paxHeader.version, "00", 2);
+    FBTarWriteChecksum(&paxHeader);
+    [self appendBytes:&paxHeader length:sizeof(paxHeader)];
+    [self appendBytes:paxRecords.bytes length:paxRecords.length];
+    [self appendPaddingForSize:paxRecords.length];
+  }
+
+  FBTarWriteOctal(header.mode, sizeof(header.mode), fileStat->st_mode & 07777);
+  FBTarWriteOctal(header.uid, sizeof(header.uid), fileStat->st_uid);
+  FBTarWriteOctal(header.gid, sizeof(header.gid), fileStat->st_gid);
+  FBTarWriteOctal(header.size, sizeof(header.size), size);
+  FBTarWriteOctal(header.mtime, sizeof(header.mtime), mtime);
+  header.typeflag = typeflag;
+  memcpy(header.magic, "ustar", 6);
+  memcpy(header.version, "00", 2);
+  FBTarWriteChecksum(&header);
+  [self appendBytes:&header length:sizeof(header)];
+  return YES;
+}
+
+- (BOOL)writeContentsOfFile:(const char *)path size:(unsigned long long)size error:(NSError **)error
+{
+  int fileDescriptor = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+  if (fileDescriptor < 0) {
+    return [[FBControlCoreError
+      describeFormat:@"Failed to open %s for tarring: %s", path, strerror(errno)]
+      failBool:error];
+  }
+  unsigned long long remaining = size;
+  BOOL truncated = NO;
+  while (remaining > 0) {
+    NSUInteger available = FBTarWriteBufferSize - self.buffer.length;
+    if (available == 0) {
+      [self flush];
+      continue;
+    }
+    // Read directly into the buffer that is passed to the consumer.
+    size_t length = (size_t) MIN((unsigned long long) available, remaining);
+    NSUInteger offset = self.buffer.length;
+    [self.buffer increaseLengthBy:length];
+    if (truncated) {
+      remaining -= length;
+      continue;
+    }
+    ssize_t readBytes = read(fileDescriptor, (uint8_t *) self.buffer.mutableBytes + offset, length);
+    if (readBytes < 0) {
+      if (errno == EINTR) {
+        self.buffer.length = offset;
+        continue;
+      }
+      close(fileDescriptor);
+      return [[FBControlCoreError
+        describeFormat:@"Failed to read %s for tarring: %s", path, strerror(errno)]
+        failBool:error];
+    }
+    if (readBytes == 0) {
+      // The file shrank after the header was written, so the remainder is padded with zeros as tar does.
+      [self.logger.debug logFormat:@"%s changed as it was read", path];
+      truncated = YES;
+      remaining -= length;
+      continue;
+    }
+    self.buffer.length = offset + (NSUInteger) readBytes;
+    remaining -= (unsigned long long) readBytes;
+  }
+  close(fileDescriptor);
+  [self appendPaddingForSize:size];
+  return YES;
+}
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length
+{
+  [self.buffer appendBytes:bytes length:length];
+  if (self.buffer.length >= FBTarWriteBufferSize) {
+    [self flush];
+  }
+}
+
+- (void)appendPaddingForSize:(unsigned long long)size
+{
+  [self.buffer increaseLengthBy:FBTarPaddingForSize(size)];
+  if (self.buffer.length >= FBTarWriteBufferSize) {
+    [self flush];
+  }
+}
+
+- (void)flush
+{
+  if (self.buffer.length == 0) {
+    return;
+  }
+  // The buffer is handed to the consumer and never mutated again, which avoids a copy.
+  [self.consumer consumeData:self.buffer];
+  self.buffer = [NSMutableData dataWithCapacity:FBTarWriteBufferSize];
+}
+
+@end
+
+typedef NS_ENUM(NSUInteger, FBTarExtractorState) {
+  FBTarExtractorStateHeader = 0,
+  FBTarExtractorStateEntry = 1,
+  FBTarExtractorStatePadding = 2,
+  FBTarExtractorStateEnd = 3,
+};
+
+typedef NS_ENUM(NSUInteger, FBTarExtractorEntryKind) {
+  FBTarExtractorEntryKindDiscard = 0,
+  FBTarExtractorEntryKindFile = 1,
+  FBTarExtractorEntryKindAppleDouble = 2,
+  FBTarExtractorEntryKindPaxHeader = 3,
+  FBTarExtractorEntryKindLongName = 4,
+  FBTarExtractorEntryKindLongLinkName = 5,
+};
+
+@interface FBTarExtractor_Directory : NSObject
+
+@property (nonatomic, copy, readonly) NSString *path;
+@property (nonatomic, assign, readonly) mode_t mode;
+@property (nonatomic, assign, readonly) time_t mtime;
+
+@end
+
+@implementation FBTarExtractor_Directory
+
+- (instancetype)initWithPath:(NSString *)path mode:(mode_t)mode mtime:(time_t)mtime
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _path = path;
+  _mode = mode;
+  _mtime = mtime;
+
+  return self;
+}
+
+@end
+
+@interface FBTarExtractor ()
+
+@property (nonatomic, strong, nullable, readonly) id<FBControlCoreLogger> logger;
+@property (nonatomic, copy, nullable, readonly) FBTarExtractorEntryHandler entryHandler;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *finishedConsumingFuture;
+@property (nonatomic, strong, readonly) NSMutableData *sniffedData;
+@property (nonatomic, strong, readonly) NSMutableSet<NSString *> *createdDirectories;
+@property (nonatomic, strong, readonly) NSMutableArray<FBTarExtractor_Directory *> *directories;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSString *, NSString *> *paxRecords;
+@property (nonatomic, strong, nullable, readwrite) FBGzipDecompressor *decompressor;
+@property (nonatomic, assign, readwrite) BOOL detectedCompression;
+@property (nonatomic, assign, readwrite) BOOL createdRoot;
+@property (nonatomic, assign, readwrite) BOOL finished;
+@property (nonatomic, strong, nullable, readwrite) NSError *error;
+@property (atomic, assign, readwrite) NSUInteger entriesExtracted;
+
+@property (nonatomic, assign, readwrite) FBTarExtractorState state;
+@property (nonatomic, assign, readwrite) NSUInteger headerLength;
+@property (nonatomic, assign, readwrite) NSUInteger zeroBlocks;
+@property (nonatomic, assign, readwrite) unsigned long long entryRemaining;
+@property (nonatomic, assign, readwrite) NSUInteger paddingRemaining;
+@property (nonatomic, assign, readwrite) FBTarExtractorEntryKind entryKind;
+@property (nonatomic, strong, nullable, readwrite) NSMutableData *entryData;
+@property (nonatomic, copy, nullable, readwrite) NSString *entryPath;
+@property (nonatomic, copy, nullable, readwrite) NSString *entryRelativePath;
+@property (nonatomic, assign, readwrite) mode_t entryMode;
+@property (nonatomic, assign, readwrite) time_t entryModificationTime;
+@property (nonatomic, assign, readwrite) int entryFileDescriptor;
+@property (nonatomic, copy, nullable, readwrite) NSString *longName;
+@property (nonatomic, copy, nullable, readwrite) NSString *longLinkName;
+
+@end
+
+@implementation FBTarExtractor
+{
+  uint8_t _header[512];
+}
+
+#pragma mark Initializers
+
++ (instancetype)extractorWithDirectory:(NSString *)directory logger:(nullable id<FBControlCoreLogger>)logger
+{
+  return [[self alloc] initWithDirectory:directory entryHandler:nil logger:logger];
+}
+
++ (instancetype)extractorWithDirectory:(NSString *)directory entryHandler:(nullable FBTarExtractorEntryHandler)entryHandler logger:(nullable id<FBControlCoreLogger>)logger
+{
+  return [[self alloc] initWithDirectory:directory entryHandler:entryHandler logger:logger];
+}
+
+- (instancetype)initWithDirectory:(NSString *)directory entryHandler:(nullable FBTarExtractorEntryHandler)entryHandler logger:(nullable id<FBControlCoreLogger>)logger
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _directory = [directory copy];
+  _entryHandler = [entryHandler copy];
+  _logger = logger;
+  _finishedConsumingFuture = FBMutableFuture.future;
+  _sniffedData = [NSMutableData data];
+  _createdDirectories = [NSMutableSet set];
+  _directories = [NSMutableArray array];
+  _paxRecords = [NSMutableDictionary dictionary];
+  _entryFileDescriptor = -1;
+
+  return self;
+}
+
+- (void)dealloc
+{
+  if (_entryFileDescriptor >= 0) {
+    close(_entryFileDescriptor);
+  }
+}
+
+#pragma mark FBDataConsumer
+
+- (void)consumeData:(NSData *)data
+{
+  if (self.finished || self.error) {
+    return;
+  }
+  if (!self.detectedCompression) {
+    [self.sniffedData appendData:data];
+    if (self.sniffedData.length < 2) {
+      return;
+    }
+    [self detectCompression];
+    data = [self.sniffedData copy];
+    [self.sniffedData setLength:0];
+  }
+  if (self.decompressor) {
+    [self.decompressor consumeData:data];
+  } else {
+    [self parseData:data];
+  }
+}
+
+- (void)consumeEndOfFile
+{
+  if (self.finished) {
+    return;
+  }
+  self.finished = YES;
+  if (!self.detectedCompression) {
+    [self detectCompression];
+    [self parseData:self.sniffedData];
+  }
+  if (self.decompressor) {
+    [self.decompressor consumeEndOfFile];
+    NSError *error = self.decompressor.finishedConsuming.error;
+    if (error && !self.error) {
+      [self failWithError:error];
+    }
+  }
+  if (self.error) {
+    return;
+  }
+  if (self.state != FBTarExtractorStateEnd && !(self.state == FBTarExtractorStateHeader && self.headerLength == 0)) {
+    [self failWithError:[[FBControlCoreError describe:@"Unexpected end of tar archive"] build]];
+    return;
+  }
+  // Apply directory attributes last, deepest first, as populating a directory would otherwise update its modification time.
+  for (FBTarExtractor_Directory *directory in self.directories.reverseObjectEnumerator) {
+    const char *path = directory.path.fileSystemRepresentation;
+    // The attributes are never applied through a symbolic link, so that nothing outside of the destination is modified.
+    struct stat status;
+    if (lstat(path, &status) != 0 || !S_ISDIR(status.st_mode)) {
+      [self.logger.debug logFormat:@"Not applying attributes to %@ as it is no longer a directory", directory.path];
+      continue;
+    }
+    struct timeval times[2] = {{directory.mtime, 0}, {directory.mtime, 0}};
+    lutimes(path, times);
+    if (lchmod(path, directory.mode) != 0) {
+      [self.logger.debug logFormat:@"Failed to apply mode %o to %@: %s", directory.mode, directory.path, strerror(errno)];
+    }
+  }
+  [self.finishedConsumingFuture resolveWithResult:NSNull.null];
+}
+
+#pragma mark FBDataConsumerLifecycle
+
+- (FBFuture<NSNull *> *)finishedConsuming
+{
+  return self.finishedConsumingFuture;
+}
+
+#pragma mark Private
+
+- (void)detectCompression
+{
+  self.detectedCompression = YES;
+  if (![FBGzipDecompressor isGzipData:self.sniffedData]) {
+    return;
+  }
+  __weak typeof(self) weakSelf = self;
+  self.decompressor = [FBGzipDecompressor decompressorWithConsumer:[FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+    [weakSelf parseData:data];
+  }]];
+}
+
+- (void)parseData:(NSData *)data
+{
+  [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+    [self parseBytes:bytes length:byteRange.length];
+    if (self.error || self.state == FBTarExtractorStateEnd) {
+      *stop = YES;
+    }
+  }];
+}
+
+- (void)parseBytes:(const uint8_t *)bytes length:(NSUInteger)length
+{
+  while (length > 0 && !self.error) {
+    switch (self.state) {
+      case FBTarExtractorStateHeader: {
+        NSUInteger consumed = MIN(FBTarBlockSize - self.headerLength, length);
+        memcpy(_header + self.headerLength, bytes, consumed);
+        self.headerLength += consumed;
+        bytes += consumed;
+        length -= consumed;
+        if (self.headerLength == FBTarBlockSize) {
+          self.headerLength = 0;
+          [self handleHeader];
+        }
+        break;
+      }
+      case FBTarExtractorStateEntry: {
+        NSUInteger consumed = (NSUInteger) MIN(self.entryRemaining, (unsigned long long) length);
+        [self handleEntryBytes:bytes length:consumed];
+        self.entryRemaining -= consumed;
+        bytes += consumed;
+        length -= consumed;
+        if (self.entryRemaining == 0) {
+          [self finishEntry];
+        }
+        break;
+      }
+      case FBTarExtractorStatePadding: {
+        NSUInteger consumed = MIN(self.paddingRemaining, length);
+        self.paddingRemaining -= consumed;
+        bytes += consumed;
+        length -= consumed;
+        if (self.paddingRemaining == 0) {
+          self.state = FBTarExtractorStateHeader;
+        }
+        break;
+      }
+      case FBTarExtractorStateEnd:
+        return;
+    }
+  }
+}
+
+- (void)handleHeader
+{
+  BOOL zeroBlock = YES;
+  for (NSUInteger index = 0; index < FBTarBlockSize; index++) {
+    if (_header[index] != 0) {
+      zeroBlock = NO;
+      break;
+    }
+  }
+  if (zeroBlock) {
+    self.zeroBlocks++;
+    if (self.zeroBlocks >= 2) {
+      self.state = FBTarExtractorStateEnd;
+    }
+    return;
+  }
+  self.zeroBlocks = 0;
+  if (!FBTarHeaderChecksumIsValid(_header)) {
+    [self failWithError:[[FBControlCoreError describe:@"Invalid tar header checksum"] build]];
+    return;
+  }
+  if (!self.createdRoot) {
+    NSError *error = nil;
+    if (![NSFileManager.defaultManager createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:&error]) {
+      [self failWithError:error];
+      return;
+    }
+    self.createdRoot = YES;
+  }
+
+  const FBTarHeader *header = (const FBTarHeader *) _header;
+  unsigned long long size = FBTarParseNumeric(header->size, sizeof(header->size));
+  char typeflag = header->typeflag;
+  self.entryKind = FBTarExtractorEntryKindDiscard;
+  self.entryData = nil;
+  self.entryPath = nil;
+
+  switch (typeflag) {
+    case 'x':
+      self.entryKind = FBTarExtractorEntryKindPaxHeader;
+      break;
+    case 'L':
+      self.entryKind = FBTarExtractorEntryKindLongName;
+      break;
+    case 'K':
+      self.entryKind = FBTarExtractorEntryKindLongLinkName;
+      break;
+    case 'g':
+      break;
+    default:
+      if (self.paxRecords[@"size"]) {
+        size = strtoull(self.paxRecords[@"size"].UTF8String, NULL, 10);
+      }
+      [self handleEntryHeader:header size:size];
+      [self.paxRecords removeAllObjects];
+      self.longName = nil;
+      self.longLinkName = nil;
+      break;
+  }
+  if (self.error) {
+    return;
+  }
+  if (self.entryKind == FBTarExtractorEntryKindPaxHeader || self.entryKind == FBTarExtractorEntryKindLongName || self.entryKind == FBTarExtractorEntryKindLongLinkName) {
+    if (size > FBTarMaximumBufferedEntrySize) {
+      [self failWithError:[[FBControlCoreError describeFormat:@"Extended tar header of %llu bytes is too large", size] build]];
+      return;
+    }
+    self.entryData = [NSMutableData dataWithCapacity:(NSUInteger) size];
+  }
+  self.entryRemaining = size;
+  self.paddingRemaining = FBTarPaddingForSize(size);
+  if (size == 0) {
+    [self finishEntry];
+  } else {
+    self.state = FBTarExtractorStateEntry;
+  }
+}
+
+- (void)handleEntryHeader:(const FBTarHeader *)header size:(unsigned long long)size
+{
+  NSString *archivePath = self.paxRecords[@"path"] ?: self.longName;
+  if (!archivePath) {
+    NSString *name = FBTarParseString(header->name, sizeof(header->name));
+    NSString *prefix = memcmp(header->magic, "ustar", 5) == 0 ? FBTarParseString(header->prefix, sizeof(header->prefix)) : @"";
+    archivePath = prefix.length > 0 ? [NSString stringWithFormat:@"%@/%@", prefix, name] : name;
+  }
+  NSString *linkPath = self.paxRecords[@"linkpath"] ?: self.longLinkName ?: FBTarParseString(header->linkname, sizeof(header->linkname));
+  char typeflag = header->typeflag;
+  if (typeflag == '\0' && [archivePath hasSuffix:@"/"]) {
+    typeflag = '5';
+  }
+
+  NSError *error = nil;
+  NSString *relativePath = [self relativePathForArchivePath:archivePath error:&error];
+  if (!relativePath) {
+    [self failWithError:error];
+    return;
+  }
+  NSString *path = [self.directory stringByAppendingPathComponent:relativePath];
+  self.entryPath = path;
+  self.entryRelativePath = relativePath;
+  self.entryMode = (mode_t) (FBTarParseNumeric(header->mode, sizeof(header->mode)) & 0777);
+  self.entryModificationTime = (time_t) FBTarParseNumeric(header->mtime, sizeof(header->mtime));
+
+  switch (typeflag) {
+    case '0':
+    case '\0':
+    case '7': {
+      if (relativePath.length == 0 || ![self createParentOfRelativePath:relativePath error:&error]) {
+        [self failWithError:error ?: [[FBControlCoreError describeFormat:@"Invalid file entry %@", archivePath] build]];
+        return;
+      }
+      if ([relativePath.lastPathComponent hasPrefix:@"._"] && size <= FBTarMaximumBufferedEntrySize) {
+        self.entryKind = FBTarExtractorEntryKindAppleDouble;
+        self.entryData = [NSMutableData dataWithCapacity:(NSUInteger) size];
+        return;
+      }
+      if (![self openEntryFile:&error]) {
+        [self failWithError:error];
+        return;
+      }
+      self.entryKind = FBTarExtractorEntryKindFile;
+      return;
+    }
+    case '5': {
+      if (relativePath.length == 0) {
+        return;
+      }
+      // An existing symbolic link would satisfy the directory creation, the attributes of the entry would then be applied to its target.
+      struct stat status;
+      if (lstat(path.fileSystemRepresentation, &status) == 0 && S_ISLNK(status.st_mode)) {
+        [self failWithError:[[FBControlCoreError describeFormat:@"Refusing to extract directory %@ over the symbolic link of the same name", archivePath] build]];
+        return;
+      }
+      if (![self validateParentsOfRelativePath:relativePath error:&error] || ![NSFileManager.defaultManager createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:&error]) {
+        [self failWithError:error];
+        return;
+      }
+      if (lstat(path.fileSystemRepresentation, &status) != 0 || !S_ISDIR(status.st_mode)) {
+        [self failWithError:[[FBControlCoreError describeFormat:@"Refusing to extract directory %@ as %@ is not a directory", archivePath, path] build]];
+        return;
+      }
+      [self.createdDirectories addObject:relativePath];
+      [self.directories addObject:[[FBTarExtractor_Directory alloc] initWithPath:path mode:self.entryMode mtime:self.entryModificationTime]];
+      self.entriesExtracted++;
+      return;
+    }
+    case '2': {
+      if (relativePath.length == 0 || ![self createParentOfRelativePath:relativePath error:&error]) {
+        [self failWithError:error ?: [[FBControlCoreError describeFormat:@"Invalid symbolic link entry %@", archivePath] build]];
+        return;
+      }
+      unlink(path.fileSystemRepresentation);
+      if (symlink(linkPath.fileSystemRepresentation, path.fileSystemRepresentation) != 0) {
+        [self failWithError:[[FBControlCoreError describeFormat:@"Failed to create symbolic link %@: %s", path, strerror(errno)] build]];
+        return;
+      }
+      self.entriesExtracted++;
+      return;
+    }
+    case '1': {
+      NSString *targetRelativePath = [self relativePathForArchivePath:linkPath error:&error];
+      if (relativePath.length == 0 || targetRelativePath.length == 0 || ![self validateParentsOfRelativePath:targetRelativePath error:&error] || ![self createParentOfRelativePath:relativePath error:&error]) {
+        [self failWithError:error ?: [[FBControlCoreError describeFormat:@"Invalid hard link entry %@", archivePath] build]];
+        return;
+      }
+      NSString *target = [self.directory stringByAppendingPathComponent:targetRelativePath];
+      unlink(path.fileSystemRepresentation);
+      // The link is made to the target entry itself, never to what a symbolic link at that path points to.
+      if (linkat(AT_FDCWD, target.fileSystemRepresentation, AT_FDCWD, path.fileSystemRepresentation, 0) != 0) {
+        [self failWithError:[[FBControlCoreError describeFormat:@"Failed to create hard link %@ to %@: %s", path, target, strerror(errno)] build]];
+        return;
+      }
+      self.entriesExtracted++;
+      return;
+    }
+    default:
+      [self.logger.debug logFormat:@"Skipping %@ of unsupported type '%c'", archivePath, typeflag];
+      return;
+  }
+}
+
+- (void)handleEntryBytes:(const uint8_t *)bytes length:(NSUInteger)length
+{
+  switch (self.entryKind) {
+    case FBTarExtractorEntryKindFile:
+      if (!FBTarWriteFully(self.entryFileDescriptor, bytes, length)) {
+        [self failWithError:[[FBControlCoreError describeFormat:@"Failed to write %@: %s", self.entryPath, strerror(errno)] build]];
+      }
+      return;
+    case FBTarExtractorEntryKindAppleDouble:
+    case FBTarExtractorEntryKindPaxHeader:
+    case FBTarExtractorEntryKindLongName:
+    case FBTarExtractorEntryKindLongLinkName:
+      [self.entryData appendBytes:bytes length:length];
+      return;
+    case FBTarExtractorEntryKindDiscard:
+      return;
+  }
+}
+
+- (void)finishEntry
+{
+  self.state = self.paddingRemaining > 0 ? FBTarExtractorStatePadding : FBTarExtractorStateHeader;
+  NSData *data = self.entryData;
+  self.entryData = nil;
+  switch (self.entryKind) {
+    case FBTarExtractorEntryKindFile:
+      [self closeEntryFile];
+      return;
+    case FBTarExtractorEntryKindAppleDouble: {
+      if (data.length >= sizeof(FBTarAppleDoubleMagic) && memcmp(data.bytes, FBTarAppleDoubleMagic, sizeof(FBTarAppleDoubleMagic)) == 0) {
+        [self.logger.debug logFormat:@"Skipping AppleDouble entry %@", self.entryPath];
+        return;
+      }
+      NSError *error = nil;
+      if (![self openEntryFile:&error]) {
+        [self failWithError:error];
+        return;
+      }
+      [self handleEntryBytes:data.bytes length:data.length];
+      [self closeEntryFile];
+      return;
+    }
+    case FBTarExtractorEntryKindPaxHeader:
+      [self parsePaxRecords:data];
+      return;
+    case FBTarExtractorEntryKindLongName:
+      self.longName = FBTarParseString(data.bytes, data.length);
+      return;
+    case FBTarExtractorEntryKindLongLinkName:
+      self.longLinkName = FBTarParseString(data.bytes, data.length);
+      return;
+    case FBTarExtractorEntryKindDiscard:
+      return;
+  }
+}
+
+- (BOOL)openEntryFile:(NSError **)error
+{
+  const char *path = self.entryPath.fileSystemRepresentation;
+  // Replace any earlier entry at the same path, rather than writing through it.
+  unlink(path);
+  int fileDescriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+  if (fileDescriptor < 0) {
+    return [[FBControlCoreError
+      describeFormat:@"Failed to create %@: %s", self.entryPath, strerror(errno)]
+      failBool:error];
+  }
+  self.entryFileDescriptor = fileDescriptor;
+  return YES;
+}
+
+- (void)closeEntryFile
+{
+  int fileDescriptor = self.entryFileDescriptor;
+  if (fileDescriptor < 0) {
+    return;
+  }
+  self.entryFileDescriptor = -1;
+  if (self.error) {
+    close(fileDescriptor);
+    return;
+  }
+  fchmod(fileDescriptor, self.entryMode);
+  struct timeval times[2] = {{self.entryModificationTime, 0}, {self.entryModificationTime, 0}};
+  futimes(fileDescriptor, times);
+  close(fileDescriptor);
+  self.entriesExtracted++;
+  NSError *error = nil;
+  if (self.entryHandler && !self.entryHandler(self.entryRelativePath, self.entryPath, &error)) {
+    [self failWithError:error ?: [[FBControlCoreError describeFormat:@"Extraction of %@ was rejected", self.entryRelativePath] build]];
+  }
+}
+
+- (void)parsePaxRecords:(NSData *)data
+{
+  const char *bytes = data.bytes;
+  NSUInteger length = data.length;
+  NSUInteger offset = 0;
+  while (offset < length) {
+    // Each record is "<length> <key>=<value>\n", where the length includes the whole record.
+    NSUInteger recordLength = 0;
+    NSUInteger index = offset;
+    for (; index < length && bytes[index] >= '0' && bytes[index] <= '9'; index++) {
+      recordLength = recordLength * 10 + (NSUInteger) (bytes[index] - '0');
+    }
+    if (recordLength == 0 || offset + recordLength > length || index >= length || bytes[index] != ' ') {
+      [self.logger.debug logFormat:@"Ignoring malformed pax header"];
+      return;
+    }
+    NSUInteger keyStart = index + 1;
+    NSUInteger recordEnd = offset + recordLength - 1;
+    NSUInteger separator = keyStart;
+    while (separator < recordEnd && bytes[separator] != '=') {
+      separator++;
+    }
+    if (separator < recordEnd) {
+      NSString *key = [[NSString alloc] initWithBytes:bytes + keyStart length:separator - keyStart encoding:NSUTF8StringEncoding];
+      NSString *value = [[NSString alloc] initWithBytes:bytes + separator + 1 length:recordEnd - separator - 1 encoding:NSUTF8StringEncoding];
+      if (key && value && ([key isEqualToString:@"path"] || [key isEqualToString:@"linkpath"] || [key isEqualToString:@"size"])) {
+        self.paxRecords[key] = value;
+      }
+    }
+    offset += recordLength;
+  }
+}
+
+- (nullable NSString *)relativePathForArchivePath:(NSString *)archivePath error:(NSError **)error
+{
+  // Leading separators are removed, as bsdtar does.
+  NSMutableArray<NSString *> *components = [NSMutableArray array];
+  for (NSString *component in [archivePath componentsSeparatedByString:@"/"]) {
+    if (component.length == 0 || [component isEqualToString:@"."]) {
+      continue;
+    }
+    if ([component isEqualToString:@".."]) {
+      return [[FBControlCoreError
+        describeFormat:@"Refusing to extract %@ as it is outside of the destination", archivePath]
+        fail:error];
+    }
+    [components addObject:component];
+  }
+  return [components componentsJoinedByString:@"/"];
+}
+
+- (BOOL)validateParentsOfRelativePath:(NSString *)relativePath error:(NSError **)error
+{
+  // A symbolic link could point outside of the destination, so nothing is extracted beneath one.
+  // The destination is inspected rather than the names of earlier entries, as the volume may not distinguish names by case or normalization.
+  NSString *path = self.directory;
+  NSArray<NSString *> *components = [relativePath componentsSeparatedByString:@"/"];
+  for (NSUInteger index = 0; index + 1 < components.count; index++) {
+    path = [path stringByAppendingPathComponent:components[index]];
+    struct stat status;
+    if (lstat(path.fileSystemRepresentation, &status) != 0) {
+      // Nothing beneath a missing directory exists yet, it will be created as a directory.
+      return YES;
+    }
+    if (!S_ISDIR(status.st_mode)) {
+      return [[FBControlCoreError
+        describeFormat:@"Refusing to extract %@ as %@ is not a directory", relativePath, path]
+        failBool:error];
+    }
+  }
+  return YES;
+}
+
+- (BOOL)createParentOfRelativePath:(NSString *)relativePath error:(NSError **)error
+{
+  if (![self validateParentsOfRelativePath:relativePath error:error]) {
+    return NO;
+  }
+  NSString *parent = relativePath.stringByDeletingLastPathComponent;
+  if (parent.length == 0 || [self.createdDirectories containsObject:parent]) {
+    return YES;
+  }
+  if (![NSFileManager.defaultManager createDirectoryAtPath:[self.directory stringByAppendingPathComponent:parent] withIntermediateDirectories:YES attributes:nil error:error]) {
+    return NO;
+  }
+  [self.createdDirectories addObject:parent];
+  return YES;
+}
+
+- (void)failWithError:(NSError *)error
+{
+  if (self.error) {
+    return;
+  }
+  self.error = error;
+  int fileDescriptor = self.entryFileDescriptor;
+  if (fileDescriptor >= 0) {
+    self.entryFileDescriptor = -1;
+    close(fileDescriptor);
+  }
+  self.state = FBTarExtractorStateEnd;
+  [self.finishedConsumingFuture resolveWithError:error];
+}
+
+@end
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The encoder settings for a video stream, as chosen by an FBVideoStreamRateController.
+ */
+@interface FBVideoStreamRate : NSObject <NSCopying>
+
+/**
+ The Designated Initializer.
+
+ @param framesPerSecond the frame rate of the stream.
+ @param scaleFactor the scale factor of the stream, relative to the source.
+ @param averageBitRate the average bit rate of the stream, in bits per second.
+ @return a new Video Stream Rate.
+ */
+- (instancetype)initWithFramesPerSecond:(NSUInteger)framesPerSecond scaleFactor:(double)scaleFactor averageBitRate:(NSUInteger)averageBitRate;
+
+/**
+ The frame rate of the stream.
+ */
+@property (nonatomic, assign, readonly) NSUInteger framesPerSecond;
+
+/**
+ The scale factor of the stream, relative to the source.
+ */
+@property (nonatomic, assign, readonly) double scaleFactor;
+
+/**
+ The average bit rate of the stream, in bits per second.
+ */
+@property (nonatomic, assign, readonly) NSUInteger averageBitRate;
+
+@end
+
+/**
+ Adapts the frame rate, scale and bit rate of a video stream to the back-pressure from its destination.
+ The controller steps down a ladder of progressively cheaper rates while the backlog of unwritten frames stays high, and steps back up once it has stayed clear.
+ It holds no reference to the stream itself, samples are provided with the time at which they were taken, so the behaviour is deterministic.
+ */
+@interface FBVideoStreamRateController : NSObject
+
+#pragma mark Initializers
+
+/**
+ Constructs a Rate Controller.
+
+ @param maximumRate the rate to use when there is no back-pressure. Other rates are derived from this.
+ @return a new Rate Controller.
+ */
++ (instancetype)controllerWithMaximumRate:(FBVideoStreamRate *)maximumRate;
+
+#pragma mark Public Methods
+
+/**
+ Provides a sample of the backlog to the controller.
+ The backlog is measured in frames that have been produced but not yet written, as well as the number of bytes that are queued for writing.
+ Bytes are converted to a number of frames with the current rate.
+
+ @param pendingFrames the number of frames that have been submitted to the encoder, but not yet emitted.
+ @param pendingBytes the number of bytes that have been emitted by the encoder, but not yet written.
+ @param time the time at which the sample was taken, in seconds.
+ @return YES if the rate has changed as a result of the sample, NO otherwise.
+ */
+- (BOOL)samplePendingFrames:(NSUInteger)pendingFrames pendingBytes:(NSUInteger)pendingBytes atTime:(NSTimeInterval)time;
+
+#pragma mark Properties
+
+/**
+ The rate that the stream should currently use.
+ */
+@property (nonatomic, copy, readonly) FBVideoStreamRate *rate;
+
+/**
+ The current position on the ladder of rates. 0 is the maximum rate.
+ */
+@property (nonatomic, assign, readonly) NSUInteger level;
+
+/**
+ The number of positions on the ladder of rates.
+ */
+@property (nonatomic, assign, readonly, class) NSUInteger levelCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBVideoStreamRateController.h"
+
+typedef struct {
+  double framesPerSecond;
+  double scaleFactor;
+  double averageBitRate;
+} FBVideoStreamRateStep;
+
+// Each step is relative to the maximum rate. Bit rate is reduced first as it is the cheapest change for the viewer, frame rate and scale follow.
+static const FBVideoStreamRateStep FBVideoStreamRateLadder[] = {
+  {1.0, 1.0, 1.0},
+  {1.0, 1.0, 0.6},
+  {0.5, 0.75, 0.4},
+  {0.5, 0.5, 0.25},
+  {0.25, 0.5, 0.15},
+};
+
+// A backlog of this many frames means that the destination is not keeping up.
+static const double FBVideoStreamRateCongestedFrames = 3;
+// A backlog of less than this many frames means that the destination is keeping up.
+static const double FBVideoStreamRateClearFrames = 1;
+// How long the destination must be congested before stepping down.
+static const NSTimeInterval FBVideoStreamRateStepDownInterval = 0.5;
+// How long the destination must be clear before stepping up. This is longer than stepping down, so that the rate does not oscillate.
+static const NSTimeInterval FBVideoStreamRateStepUpInterval = 5;
+
+@implementation FBVideoStreamRate
+
+- (instancetype)initWithFramesPerSecond:(NSUInteger)framesPerSecond scaleFactor:(double)scaleFactor averageBitRate:(NSUInteger)averageBitRate
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _framesPerSecond = framesPerSecond;
+  _scaleFactor = scaleFactor;
+  _averageBitRate = averageBitRate;
+
+  return self;
+}
+
+#pragma mark NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone
+{
+  return self;
+}
+
+#pragma mark NSObject
+
+- (BOOL)isEqual:(FBVideoStreamRate *)object
+{
+  if (![object isKindOfClass:self.class]) {
+    return NO;
+  }
+  return self.framesPerSecond == object.framesPerSecond
+      && self.scaleFactor == object.scaleFactor
+      && self.averageBitRate == object.averageBitRate;
+}
+
+- (NSUInteger)hash
+{
+  return self.framesPerSecond ^ (NSUInteger) (self.scaleFactor * 100) ^ self.averageBitRate;
+}
+
+- (NSString *)description
+{
+  return [NSString stringWithFormat:@"FPS %lu | Scale %.2f | Bit Rate %lu", (unsigned long) self.framesPerSecond, self.scaleFactor, (unsigned long) self.averageBitRate];
+}
+
+@end
+
+@interface FBVideoStreamRateController ()
+
+@property (nonatomic, copy, readonly) FBVideoStreamRate *maximumRate;
+@property (nonatomic, copy, readwrite) FBVideoStreamRate *rate;
+@property (nonatomic, assign, readwrite) NSUInteger level;
+@property (nonatomic, assign, readwrite) NSTimeInterval congestedSince;
+@property (nonatomic, assign, readwrite) NSTimeInterval clearSince;
+@property (nonatomic, assign, readwrite) NSTimeInterval lastChange;
+
+@end
+
+@implementation FBVideoStreamRateController
+
+#pragma mark Initializers
+
++ (instancetype)controllerWithMaximumRate:(FBVideoStreamRate *)maximumRate
+{
+  return [[self alloc] initWithMaximumRate:maximumRate];
+}
+
+- (instancetype)initWithMaximumRate:(FBVideoStreamRate *)maximumRate
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _maximumRate = maximumRate;
+  _rate = maximumRate;
+  _level = 0;
+  _congestedSince = NAN;
+  _clearSince = NAN;
+  _lastChange = NAN;
+
+  return self;
+}
+
+#pragma mark Public Methods
+
++ (NSUInteger)levelCount
+{
+  return sizeof(FBVideoStreamRateLadder) / sizeof(FBVideoStreamRateLadder[0]);
+}
+
+- (BOOL)samplePendingFrames:(NSUInteger)pendingFrames pendingBytes:(NSUInteger)pendingBytes atTime:(NSTimeInterval)time
+{
+  FBVideoStreamRate *rate = self.rate;
+  double bytesPerFrame = MAX((double) rate.averageBitRate / 8.0 / (double) MAX(rate.framesPerSecond, 1u), 1.0);
+  double backlog = (double) pendingFrames + ((double) pendingBytes / bytesPerFrame);
+
+  // Track how long the backlog has been continuously congested or clear for.
+  if (backlog >= FBVideoStreamRateCongestedFrames) {
+    self.clearSince = NAN;
+    if (isnan(self.congestedSince)) {
+      self.congestedSince = time;
+    }
+  } else if (backlog < FBVideoStreamRateClearFrames) {
+    self.congestedSince = NAN;
+    if (isnan(self.clearSince)) {
+      self.clearSince = time;
+    }
+  } else {
+    self.congestedSince = NAN;
+    self.clearSince = NAN;
+  }
+
+  // Changes are measured from the later of the start of the condition and the previous change, so that each change has time to take effect.
+  NSTimeInterval lastChange = isnan(self.lastChange) ? -INFINITY : self.lastChange;
+  if (!isnan(self.congestedSince) && self.level + 1 < FBVideoStreamRateController.levelCount) {
+    if (time - MAX(self.congestedSince, lastChange) >= FBVideoStreamRateStepDownInterval) {
+      [self moveToLevel:self.level + 1 atTime:time];
+      return YES;
+    }
+  }
+  if (!isnan(self.clearSince) && self.level > 0) {
+    if (time - MAX(self.clearSince, lastChange) >= FBVideoStreamRateStepUpInterval) {
+      [self moveToLevel:self.level - 1 atTime:time];
+      return YES;
+    }
+  }
+  return NO;
+}
+
+#pragma mark Private
+
+- (void)moveToLevel:(NSUInteger)level atTime:(NSTimeInterval)time
+{
+  FBVideoStreamRateStep step = FBVideoStreamRateLadder[level];
+  FBVideoStreamRate *maximumRate = self.maximumRate;
+  self.level = level;
+  self.rate = [[FBVideoStreamRate alloc]
+    initWithFramesPerSecond:MAX((NSUInteger) round(maximumRate.framesPerSecond * step.framesPerSecond), 1u)
+    scaleFactor:maximumRate.scaleFactor * step.scaleFactor
+    averageBitRate:(NSUInteger) (maximumRate.averageBitRate * step.averageBitRate)];
+  self.lastChange = time;
+  self.congestedSince = NAN;
+  self.clearSince = NAN;
+}
+
+@end
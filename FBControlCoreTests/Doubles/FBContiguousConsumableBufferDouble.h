@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBDataConsumer.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*
+ A Double of a Consumable Buffer that keeps its contents in a single contiguous buffer.
+ This is how FBDataBuffer was implemented before it was backed by a queue of segments, it is kept as a baseline for the performance tests of FBDataBuffer.
+ */
+@interface FBContiguousConsumableBufferDouble : NSObject <FBDataConsumer>
+
+/*
+ Constructs a buffer that forwards each terminated chunk of data to the consumer as data is appended.
+ When the consumer is nil, data is only consumed by calling -consumeUntil:
+ */
+- (instancetype)initWithForwardingConsumer:(nullable id<FBDataConsumer>)consumer terminal:(NSData *)terminal;
+
+/*
+ Consumes the data up to the first terminal, removing it and the terminal from the buffer.
+ */
+- (nullable NSData *)consumeUntil:(NSData *)terminal;
+
+@end
+
+NS_ASSUME_NONNULL_END
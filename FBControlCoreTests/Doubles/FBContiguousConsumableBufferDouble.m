@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBContiguousConsumableBufferDouble.h"
+
+@interface FBContiguousConsumableBufferDouble ()
+
+@property (nonatomic, strong, readonly) NSMutableData *buffer;
+@property (nonatomic, strong, nullable, readonly) id<FBDataConsumer> consumer;
+@property (nonatomic, copy, readonly) NSData *terminal;
+
+@end
+
+@implementation FBContiguousConsumableBufferDouble
+
+- (instancetype)initWithForwardingConsumer:(id<FBDataConsumer>)consumer terminal:(NSData *)terminal
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _buffer = NSMutableData.data;
+  _consumer = consumer;
+  _terminal = terminal;
+
+  return self;
+}
+
+- (nullable NSData *)consumeUntil:(NSData *)terminal
+{
+  @synchronized (self) {
+    if (self.buffer.length == 0) {
+      return nil;
+    }
+    NSRange terminalRange = [self.buffer rangeOfData:terminal options:0 range:NSMakeRange(0, self.buffer.length)];
+    if (terminalRange.location == NSNotFound) {
+      return nil;
+    }
+    NSData *data = [self.buffer subdataWithRange:NSMakeRange(0, terminalRange.location)];
+    [self.buffer replaceBytesInRange:NSMakeRange(0, terminalRange.location + terminal.length) withBytes:"" length:0];
+    return data;
+  }
+}
+
+- (void)consumeData:(NSData *)data
+{
+  @synchronized (self) {
+    [self.buffer appendData:data];
+  }
+  id<FBDataConsumer> consumer = self.consumer;
+  if (!consumer) {
+    return;
+  }
+  NSData *partial = [self consumeUntil:self.terminal];
+  while (partial) {
+    [consumer consumeData:partial];
+    partial = [self consumeUntil:self.terminal];
+  }
+}
+
+- (void)consumeEndOfFile
+{
+  [self.consumer consumeEndOfFile];
+}
+
+@end
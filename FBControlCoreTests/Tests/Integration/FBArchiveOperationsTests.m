@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+#import <sys/stat.h>
+
+static NSUInteger const BenchmarkFileCount = 64;
+static NSUInteger const BenchmarkFileSize = 512 * 1024;
+
+@interface FBArchiveOperationsTests : XCTestCase
+
+@property (nonatomic, copy, readwrite) NSString *temporaryDirectory;
+@property (nonatomic, strong, readwrite) id<FBControlCoreLogger> logger;
+
+@end
+
+@implementation FBArchiveOperationsTests
+
+- (void)setUp
+{
+  [super setUp];
+  self.temporaryDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"FBArchiveOperationsTests_%@", NSUUID.UUID.UUIDString]];
+  [NSFileManager.defaultManager createDirectoryAtPath:self.temporaryDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+  self.logger = FBControlCoreGlobalConfiguration.defaultLogger;
+}
+
+- (void)tearDown
+{
+  [NSFileManager.defaultManager removeItemAtPath:self.temporaryDirectory error:nil];
+  [super tearDown];
+}
+
+#pragma mark Helpers
+
++ (NSData *)dataOfLength:(NSUInteger)length seed:(NSUInteger)seed
+{
+  // Repetitive enough to compress, varied enough not to compress to nothing.
+  NSMutableData *data = [NSMutableData dataWithLength:length];
+  uint8_t *bytes = data.mutableBytes;
+  for (NSUInteger index = 0; index < length; index++) {
+    bytes[index] = (uint8_t) (((index * 7) ^ (index >> 9) ^ seed) % 61);
+  }
+  return data;
+}
+
+- (NSString *)createBundleWithFileCount:(NSUInteger)fileCount fileSize:(NSUInteger)fileSize
+{
+  NSString *bundle = [self.temporaryDirectory stringByAppendingPathComponent:@"Source/Foo.app"];
+  NSString *longDirectory = bundle;
+  for (NSUInteger index = 0; index < 8; index++) {
+    longDirectory = [longDirectory stringByAppendingPathComponent:@"a_long_directory_name"];
+  }
+  [NSFileManager.defaultManager createDirectoryAtPath:longDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+  [NSFileManager.defaultManager createDirectoryAtPath:[bundle stringByAppendingPathComponent:@"Frameworks"] withIntermediateDirectories:YES attributes:nil error:nil];
+  for (NSUInteger index = 0; index < fileCount; index++) {
+    NSString *directory = index % 2 == 0 ? bundle : [bundle stringByAppendingPathComponent:@"Frameworks"];
+    NSString *path = [directory stringByAppendingPathComponent:[NSString stringWithFormat:@"file_%lu", (unsigned long) index]];
+    [[self.class dataOfLength:fileSize + index seed:index] writeToFile:path atomically:NO];
+  }
+  NSString *executable = [bundle stringByAppendingPathComponent:@"Foo"];
+  [[self.class dataOfLength:4096 seed:1] writeToFile:executable atomically:NO];
+  chmod(executable.fileSystemRepresentation, 0755);
+  [[self.class dataOfLength:10 seed:2] writeToFile:[longDirectory stringByAppendingPathComponent:@"deep_file"] atomically:NO];
+  [@"" writeToFile:[bundle stringByAppendingPathComponent:@"Empty"] atomically:NO encoding:NSUTF8StringEncoding error:nil];
+  [NSFileManager.defaultManager createSymbolicLinkAtPath:[bundle stringByAppendingPathComponent:@"Link"] withDestinationPath:@"Foo" error:nil];
+  return bundle;
+}
+
+- (void)assertDirectory:(NSString *)actual matches:(NSString *)expected
+{
+  NSDirectoryEnumerator<NSString *> *enumerator = [NSFileManager.defaultManager enumeratorAtPath:expected];
+  NSUInteger count = 0;
+  for (NSString *relativePath in enumerator) {
+    count++;
+    NSString *expectedPath = [expected stringByAppendingPathComponent:relativePath];
+    NSString *actualPath = [actual stringByAppendingPathComponent:relativePath];
+    struct stat expectedStat;
+    struct stat actualStat;
+    XCTAssertEqual(lstat(expectedPath.fileSystemRepresentation, &expectedStat), 0);
+    XCTAssertEqual(lstat(actualPath.fileSystemRepresentation, &actualStat), 0, @"%@ was not extracted", relativePath);
+    XCTAssertEqual(expectedStat.st_mode, actualStat.st_mode, @"Mode of %@", relativePath);
+    if (S_ISLNK(expectedStat.st_mode)) {
+      XCTAssertEqualObjects([NSFileManager.defaultManager destinationOfSymbolicLinkAtPath:actualPath error:nil], [NSFileManager.defaultManager destinationOfSymbolicLinkAtPath:expectedPath error:nil]);
+    } else if (S_ISREG(expectedStat.st_mode)) {
+      XCTAssertEqualObjects([NSData dataWithContentsOfFile:actualPath], [NSData dataWithContentsOfFile:expectedPath], @"Contents of %@", relativePath);
+      XCTAssertEqual(expectedStat.st_mtimespec.tv_sec, actualStat.st_mtimespec.tv_sec, @"Modification time of %@", relativePath);
+    }
+  }
+  XCTAssertEqual([NSFileManager.defaultManager enumeratorAtPath:actual].allObjects.count, count);
+}
+
+- (NSString *)runBSDTar:(NSArray<NSString *> *)arguments
+{
+  NSError *error = nil;
+  FBTask *task = [[[[FBTaskBuilder
+    withLaunchPath:@"/usr/bin/bsdtar"]
+    withArguments:arguments]
+    runUntilCompletion]
+    await:&error];
+  XCTAssertNil(error);
+  XCTAssertNotNil(task);
+  return arguments.lastObject;
+}
+
+#pragma mark Tests
+
+- (void)testGzipRoundTrip
+{
+  NSString *path = [self.temporaryDirectory stringByAppendingPathComponent:@"input"];
+  NSData *expected = [self.class dataOfLength:3 * 1024 * 1024 + 17 seed:3];
+  [expected writeToFile:path atomically:NO];
+
+  id<FBAccumulatingBuffer> compressed = FBDataBuffer.accumulatingBuffer;
+  NSError *error = nil;
+  XCTAssertNotNil([[FBArchiveOperations writeGzipForPath:path toConsumer:compressed queue:dispatch_get_main_queue() logger:self.logger] await:&error]);
+  XCTAssertNil(error);
+  XCTAssertLessThan(compressed.data.length, expected.length);
+
+  id<FBAccumulatingBuffer> decompressed = FBDataBuffer.accumulatingBuffer;
+  FBGzipDecompressor *decompressor = [FBGzipDecompressor decompressorWithConsumer:decompressed];
+  // Deliver the data in uneven pieces, so that gzip members and blocks are split across calls.
+  NSData *data = compressed.data;
+  for (NSUInteger offset = 0; offset < data.length; offset += 4093) {
+    [decompressor consumeData:[data subdataWithRange:NSMakeRange(offset, MIN(4093u, data.length - offset))]];
+  }
+  [decompressor consumeEndOfFile];
+  XCTAssertNil(decompressor.finishedConsuming.error);
+  XCTAssertEqualObjects(decompressed.data, expected);
+
+  // The output is a single gzip member, which gunzip can read.
+  NSString *compressedPath = [self.temporaryDirectory stringByAppendingPathComponent:@"input.gz"];
+  [data writeToFile:compressedPath atomically:NO];
+  FBTask *task = [[[[[FBTaskBuilder
+    withLaunchPath:@"/usr/bin/gunzip"]
+    withArguments:@[@"--to-stdout", compressedPath]]
+    withStdOutInMemoryAsData]
+    runUntilCompletion]
+    await:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects(task.stdOut, expected);
+}
+
+- (void)testGzipDecompressorRejectsCorruptData
+{
+  id<FBAccumulatingBuffer> decompressed = FBDataBuffer.accumulatingBuffer;
+  FBGzipDecompressor *decompressor = [FBGzipDecompressor decompressorWithConsumer:decompressed];
+  uint8_t bytes[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xff, 0xff, 0xff, 0xff};
+  [decompressor consumeData:[NSData dataWithBytes:bytes length:sizeof(bytes)]];
+  [decompressor consumeEndOfFile];
+  XCTAssertNotNil(decompressor.finishedConsuming.error);
+}
+
+- (void)testInProcessTarRoundTrip
+{
+  NSString *bundle = [self createBundleWithFileCount:8 fileSize:1024 * 1024];
+  NSError *error = nil;
+  NSData *archive = [[FBArchiveOperations createGzippedTarDataForPath:bundle queue:dispatch_get_main_queue() logger:self.logger] await:&error];
+  XCTAssertNil(error);
+  XCTAssertNotNil(archive);
+
+  NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:@"InProcess"];
+  NSString *extracted = [[FBArchiveOperations extractArchiveFromStream:[FBProcessInput inputFromData:archive] toPath:destination queue:dispatch_get_main_queue() logger:self.logger compression:FBCompressionFormatGZIP] await:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects(extracted, destination);
+  [self assertDirectory:destination matches:bundle];
+}
+
+- (void)testInProcessTarIsReadableByBSDTar
+{
+  NSString *bundle = [self createBundleWithFileCount:4 fileSize:64 * 1024];
+  NSError *error = nil;
+  NSData *archive = [[FBArchiveOperations createGzippedTarDataForPath:bundle queue:dispatch_get_main_queue() logger:self.logger] await:&error];
+  XCTAssertNil(error);
+  NSString *archivePath = [self.temporaryDirectory stringByAppendingPathComponent:@"archive.tar.gz"];
+  [archive writeToFile:archivePath atomically:NO];
+
+  NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:@"BSDTar"];
+  [NSFileManager.defaultManager createDirectoryAtPath:destination withIntermediateDirectories:YES attributes:nil error:nil];
+  [self runBSDTar:@[@"-xzpf", archivePath, @"-C", destination]];
+  [self assertDirectory:destination matches:bundle];
+}
+
+- (void)testExtractsArchivesCreatedByBSDTar
+{
+  NSString *bundle = [self createBundleWithFileCount:4 fileSize:64 * 1024];
+  NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:@"Extracted"];
+  NSError *error = nil;
+  for (NSString *flags in @[@"-czf", @"-cf"]) {
+    NSString *archivePath = [self.temporaryDirectory stringByAppendingPathComponent:[NSString stringWithFormat:@"archive%@.tar", flags]];
+    [self runBSDTar:@[@"-C", bundle, flags, archivePath, @"."]];
+    [NSFileManager.defaultManager removeItemAtPath:destination error:nil];
+    XCTAssertNotNil([[FBArchiveOperations extractArchiveAtPath:archivePath toPath:destination queue:dispatch_get_main_queue() logger:self.logger] await:&error]);
+    XCTAssertNil(error);
+    [self assertDirectory:destination matches:bundle];
+  }
+}
+
+- (void)testExtractsZipThroughBSDTar
+{
+  NSString *bundle = [self createBundleWithFileCount:2 fileSize:1024];
+  NSString *archivePath = [self.temporaryDirectory stringByAppendingPathComponent:@"archive.zip"];
+  [self runBSDTar:@[@"-C", bundle, @"--format", @"zip", @"-cf", archivePath, @"."]];
+
+  NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:@"Zip"];
+  [NSFileManager.defaultManager createDirectoryAtPath:destination withIntermediateDirectories:YES attributes:nil error:nil];
+  NSError *error = nil;
+  NSData *zip = [NSData dataWithContentsOfFile:archivePath];
+  XCTAssertNotNil([[FBArchiveOperations extractArchiveFromStream:[FBProcessInput inputFromData:zip] toPath:destination queue:dispatch_get_main_queue() logger:self.logger compression:FBCompressionFormatGZIP] await:&error]);
+  XCTAssertNil(error);
+  XCTAssertEqualObjects([NSData dataWithContentsOfFile:[destination stringByAppendingPathComponent:@"Foo"]], [NSData dataWithContentsOfFile:[bundle stringByAppendingPathComponent:@"Foo"]]);
+}
+
+- (void)testFailedArchiveFinishesWritingBeforeFailing
+{
+  id<FBDataConsumer, FBDataConsumerLifecycle> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {}];
+  NSString *path = [self.temporaryDirectory stringByAppendingPathComponent:@"Missing"];
+  NSError *error = nil;
+  XCTAssertNil([[FBArchiveOperations writeGzippedTarForPath:path toConsumer:consumer queue:dispatch_get_main_queue() logger:self.logger] await:&error]);
+  XCTAssertNotNil(error);
+  // The consumer has seen the end of the archive, so nothing more is written to it once the failure is reported.
+  XCTAssertTrue(consumer.finishedConsuming.hasCompleted);
+}
+
+- (void)testRejectsEntriesOutsideOfTheDestination
+{
+  NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:@"Escape"];
+  NSString *source = [self.temporaryDirectory stringByAppendingPathComponent:@"EscapeSource"];
+  [NSFileManager.defaultManager createDirectoryAtPath:source withIntermediateDirectories:YES attributes:nil error:nil];
+  [@"escaped" writeToFile:[source stringByAppendingPathComponent:@"file"] atomically:NO encoding:NSUTF8StringEncoding error:nil];
+  NSString *archivePath = [self.temporaryDirectory stringByAppendingPathComponent:@"escape.tar"];
+  // Rewrite the name of the entry so that it points at the parent of the destination.
+  [self runBSDTar:@[@"-C", source, @"-s", @",^file$,../file,", @"-cPf", archivePath, @"file"]];
+
+  NSError *error = nil;
+  XCTAssertNil([[FBArchiveOperations extractArchiveAtPath:archivePath toPath:destination queue:dispatch_get_main_queue() logger:self.logger] await:&error]);
+  XCTAssertNotNil(error);
+  XCTAssertFalse([NSFileManager.defaultManager fileExistsAtPath:[self.temporaryDirectory stringByAppendingPathComponent:@"file"]]);
+}
+
+- (void)testRejectsDirectoryEntriesOverSymbolicLinks
+{
+  NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:@"Escape"];
+  NSString *source = [self.temporaryDirectory stringByAppendingPathComponent:@"EscapeSource"];
+  NSString *outside = [self.temporaryDirectory stringByAppendingPathComponent:@"Outside"];
+  [NSFileManager.defaultManager createDirectoryAtPath:[source stringByAppendingPathComponent:@"dir"] withIntermediateDirectories:YES attributes:@{NSFilePosixPermissions: @0700} error:nil];
+  [NSFileManager.defaultManager createDirectoryAtPath:outside withIntermediateDirectories:YES attributes:@{NSFilePosixPermissions: @0755} error:nil];
+  [NSFileManager.defaultManager createSymbolicLinkAtPath:[source stringByAppendingPathComponent:@"link"] withDestinationPath:@"../Outside" error:nil];
+  NSString *archivePath = [self.temporaryDirectory stringByAppendingPathComponent:@"escape.tar"];
+  // Rename the directory so that it follows a symbolic link of the same name.
+  [self runBSDTar:@[@"-C", source, @"-s", @",^dir$,link,", @"-cf", archivePath, @"link", @"dir"]];
+
+  NSError *error = nil;
+  XCTAssertNil([[FBArchiveOperations extractArchiveAtPath:archivePath toPath:destination queue:dispatch_get_main_queue() logger:self.logger] await:&error]);
+  XCTAssertNotNil(error);
+  NSNumber *permissions = [NSFileManager.defaultManager attributesOfItemAtPath:outside error:nil][NSFilePosixPermissions];
+  XCTAssertEqual(permissions.unsignedShortValue, 0755);
+}
+
+- (void)testRejectsEntriesBeneathCaseVariantsOfSymbolicLinks
+{
+  NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:@"Escape"];
+  NSString *source = [self.temporaryDirectory stringByAppendingPathComponent:@"EscapeSource"];
+  NSString *outside = [self.temporaryDirectory stringByAppendingPathComponent:@"Outside"];
+  [NSFileManager.defaultManager createDirectoryAtPath:[source stringByAppendingPathComponent:@"dir"] withIntermediateDirectories:YES attributes:nil error:nil];
+  [NSFileManager.defaultManager createDirectoryAtPath:outside withIntermediateDirectories:YES attributes:nil error:nil];
+  [@"escaped" writeToFile:[source stringByAppendingPathComponent:@"dir/file"] atomically:NO encoding:NSUTF8StringEncoding error:nil];
+  [NSFileManager.defaultManager createSymbolicLinkAtPath:[source stringByAppendingPathComponent:@"Link"] withDestinationPath:@"../Outside" error:nil];
+  NSString *archivePath = [self.temporaryDirectory stringByAppendingPathComponent:@"escape.tar"];
+  // Rename the directory so that it differs from the symbolic link only by case.
+  [self runBSDTar:@[@"-C", source, @"-s", @",^dir/,link/,", @"-cf", archivePath, @"Link", @"dir/file"]];
+
+  NSError *error = nil;
+  NSString *extracted = [[FBArchiveOperations extractArchiveAtPath:archivePath toPath:destination queue:dispatch_get_main_queue() logger:self.logger] await:&error];
+  XCTAssertFalse([NSFileManager.defaultManager fileExistsAtPath:[outside stringByAppendingPathComponent:@"file"]]);
+  // A case-sensitive volume keeps the two apart, so the file is extracted into a directory of its own.
+  if (pathconf(self.temporaryDirectory.fileSystemRepresentation, _PC_CASE_SENSITIVE) == 1) {
+    XCTAssertNotNil(extracted);
+    XCTAssertNil(error);
+  } else {
+    XCTAssertNil(extracted);
+    XCTAssertNotNil(error);
+  }
+}
+
+- (void)testArchiveCreationPerformance
+{
+  NSString *bundle = [self createBundleWithFileCount:BenchmarkFileCount fileSize:BenchmarkFileSize];
+  dispatch_queue_t queue = dispatch_queue_create("com.facebook.fbcontrolcore.tests.archive", DISPATCH_QUEUE_SERIAL);
+
+  [self measureBlock:^{
+    NSError *error = nil;
+    NSData *archive = [[FBArchiveOperations createGzippedTarDataForPath:bundle queue:queue logger:self.logger] await:&error];
+    XCTAssertNil(error);
+    XCTAssertGreaterThan(archive.length, 0u);
+  }];
+}
+
+- (void)testArchiveExtractionPerformance
+{
+  NSString *bundle = [self createBundleWithFileCount:BenchmarkFileCount fileSize:BenchmarkFileSize];
+  dispatch_queue_t queue = dispatch_queue_create("com.facebook.fbcontrolcore.tests.archive", DISPATCH_QUEUE_SERIAL);
+  NSError *error = nil;
+  NSData *archive = [[FBArchiveOperations createGzippedTarDataForPath:bundle queue:queue logger:self.logger] await:&error];
+  XCTAssertNil(error);
+
+  // Extraction is from a stream, as an install would be.
+  [self measureBlock:^{
+    NSString *destination = [self.temporaryDirectory stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    NSError *extractError = nil;
+    XCTAssertNotNil([[FBArchiveOperations extractArchiveFromStream:[FBProcessInput inputFromData:archive] toPath:destination queue:queue logger:self.logger compression:FBCompressionFormatGZIP] await:&extractError]);
+    XCTAssertNil(extractError);
+    [self assertDirectory:destination matches:bundle];
+    [NSFileManager.defaultManager removeItemAtPath:destination error:nil];
+  }];
+}
+
+@end
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+static const NSUInteger BenchmarkProcessCount = 64;
+static const NSUInteger BenchmarkQueryCount = 50;
+
+@interface FBProcessFetcherTests : XCTestCase
+
+@property (nonatomic, copy, readwrite) NSArray<FBTask *> *tasks;
+
+@end
+
+@implementation FBProcessFetcherTests
+
+- (void)tearDown
+{
+  for (FBTask *task in self.tasks) {
+    [[task sendSignal:SIGKILL] await:nil];
+  }
+  self.tasks = nil;
+  [super tearDown];
+}
+
+- (NSArray<FBTask *> *)spawnSleepingProcesses:(NSUInteger)count
+{
+  NSMutableArray<FBTask *> *tasks = [NSMutableArray array];
+  for (NSUInteger index = 0; index < count; index++) {
+    NSError *error = nil;
+    FBTask *task = [[[FBTaskBuilder
+      withLaunchPath:@"/bin/sleep" arguments:@[@"1000000", [NSString stringWithFormat:@"%lu", (unsigned long) index]]]
+      start]
+      await:&error];
+    XCTAssertNil(error);
+    XCTAssertNotNil(task);
+    [tasks addObject:task];
+  }
+  self.tasks = [(self.tasks ?: @[]) arrayByAddingObjectsFromArray:tasks];
+  return tasks;
+}
+
+- (NSSet<NSNumber *> *)processIdentifiersOf:(NSArray *)processes
+{
+  return [NSSet setWithArray:[processes valueForKey:@"processIdentifier"]];
+}
+
+- (void)testCachedProcessInfoMatchesFreshFetch
+{
+  FBTask *task = [self spawnSleepingProcesses:1].firstObject;
+  FBProcessFetcher *fetcher = [FBProcessFetcher new];
+
+  FBProcessInfo *first = [fetcher processInfoFor:task.processIdentifier];
+  FBProcessInfo *second = [fetcher processInfoFor:task.processIdentifier];
+  FBProcessInfo *fresh = [[FBProcessFetcher new] processInfoFor:task.processIdentifier];
+  XCTAssertNotNil(first);
+  XCTAssertEqual(first, second);
+  XCTAssertEqualObjects(first, fresh);
+  XCTAssertEqualObjects(first.launchPath, @"/bin/sleep");
+  XCTAssertEqualObjects(first.arguments, (@[@"/bin/sleep", @"1000000", @"0"]));
+}
+
+- (void)testExitedProcessesAreNotReturned
+{
+  NSArray<FBTask *> *tasks = [self spawnSleepingProcesses:3];
+  FBProcessFetcher *fetcher = [FBProcessFetcher new];
+  NSSet<NSNumber *> *expected = [self processIdentifiersOf:tasks];
+  XCTAssertTrue([expected isSubsetOfSet:[self processIdentifiersOf:[fetcher subprocessesOf:getpid()]]]);
+  XCTAssertTrue([expected isSubsetOfSet:[self processIdentifiersOf:[fetcher processesWithLaunchPathSubstring:@"/bin/sleep"]]]);
+
+  FBTask *killed = tasks.firstObject;
+  NSError *error = nil;
+  XCTAssertNotNil([[killed sendSignal:SIGKILL] await:&error]);
+  XCTAssertNil(error);
+  XCTAssertFalse([[self processIdentifiersOf:[fetcher subprocessesOf:getpid()]] containsObject:@(killed.processIdentifier)]);
+  XCTAssertFalse([[self processIdentifiersOf:[fetcher processesWithLaunchPathSubstring:@"/bin/sleep"]] containsObject:@(killed.processIdentifier)]);
+  XCTAssertNil([fetcher processInfoFor:killed.processIdentifier]);
+}
+
+- (void)testUncachedQueryPerformance
+{
+  NSArray<FBTask *> *tasks = [self spawnSleepingProcesses:BenchmarkProcessCount];
+  NSSet<NSNumber *> *expected = [self processIdentifiersOf:tasks];
+
+  [self measureBlock:^{
+    NSArray<FBProcessInfo *> *processes = nil;
+    for (NSUInteger index = 0; index < BenchmarkQueryCount; index++) {
+      processes = [[FBProcessFetcher new] subprocessesOf:getpid()];
+    }
+    XCTAssertTrue([expected isSubsetOfSet:[self processIdentifiersOf:processes]]);
+  }];
+}
+
+- (void)testCachedQueryPerformance
+{
+  NSArray<FBTask *> *tasks = [self spawnSleepingProcesses:BenchmarkProcessCount];
+  NSSet<NSNumber *> *expected = [self processIdentifiersOf:tasks];
+  FBProcessFetcher *fetcher = [FBProcessFetcher new];
+  [fetcher subprocessesOf:getpid()];
+
+  [self measureBlock:^{
+    NSArray<FBProcessInfo *> *processes = nil;
+    for (NSUInteger index = 0; index < BenchmarkQueryCount; index++) {
+      processes = [fetcher subprocessesOf:getpid()];
+    }
+    XCTAssertTrue([expected isSubsetOfSet:[self processIdentifiersOf:processes]]);
+  }];
+}
+
+@end
@@ -462,6 +462,24 @@
   XCTAssertEqualObjects(task.signal.result, @(SIGKILL));
 }
 
+- (void)testWaitingForProcessToDieIsNotifiedOfExit
+{
+  FBTask *task = [[FBTaskBuilder
+    withLaunchPath:@"/bin/sleep" arguments:@[@"1000000"]]
+    startSynchronously];
+  FBFuture<NSNull *> *died = [[FBProcessFetcher new] onQueue:dispatch_get_main_queue() waitForProcessIdentifierToDie:task.processIdentifier];
+  XCTAssertEqual(died.state, FBFutureStateRunning);
+
+  NSError *error = nil;
+  XCTAssertNotNil([[task sendSignal:SIGKILL] await:&error]);
+  XCTAssertNotNil([died awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error]);
+  XCTAssertNil(error);
+  XCTAssertEqual(died.state, FBFutureStateDone);
+
+  // A process that has already exited resolves immediately.
+  XCTAssertNotNil([[[FBProcessFetcher new] onQueue:dispatch_get_main_queue() waitForProcessIdentifierToDie:task.processIdentifier] await:&error]);
+}
+
 - (void)testHUPBackoffToKILL
 {
   FBTask *task = [[FBTaskBuilder
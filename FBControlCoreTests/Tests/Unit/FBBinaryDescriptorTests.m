@@ -9,6 +9,10 @@
 
 #import <FBControlCore/FBControlCore.h>
 
+#include <mach-o/loader.h>
+
+static const NSUInteger BenchmarkParseCount = 50;
+
 @interface FBBinaryDescriptorTests : XCTestCase
 
 @end
@@ -39,4 +43,110 @@
   XCTAssertNotNil(descriptor.uuid);
 }
 
+- (NSSet<NSString *> *)otoolLinkedLibrariesForBinary:(NSString *)path
+{
+  NSError *error = nil;
+  FBTask<NSNull *, NSString *, NSString *> *task = [[[[[FBTaskBuilder
+    withLaunchPath:@"/usr/bin/otool" arguments:@[@"-L", @"-arch", @"all", path]]
+    withStdOutInMemoryAsString]
+    withStdErrToDevNull]
+    runUntilCompletion]
+    await:&error];
+  XCTAssertNil(error);
+  NSMutableSet<NSString *> *libraries = [NSMutableSet set];
+  for (NSString *line in [task.stdOut componentsSeparatedByString:@"\n"]) {
+    if (![line hasPrefix:@"\t"]) {
+      continue;
+    }
+    NSRange suffix = [line rangeOfString:@" (compatibility version"];
+    NSString *library = suffix.location == NSNotFound ? line : [line substringToIndex:suffix.location];
+    [libraries addObject:[library stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet]];
+  }
+  return libraries;
+}
+
+- (void)testLinkedLibrariesMatchOtool
+{
+  NSArray<NSString *> *paths = @[NSProcessInfo.processInfo.arguments.firstObject, @"/usr/bin/codesign"];
+  for (NSString *path in paths) {
+    NSError *error = nil;
+    FBBinaryDescriptor *descriptor = [FBBinaryDescriptor binaryWithPath:path error:&error];
+    XCTAssertNil(error);
+    NSArray<NSString *> *linkedLibraries = [descriptor linkedLibrariesWithError:&error];
+    XCTAssertNil(error);
+    XCTAssertTrue([linkedLibraries containsObject:@"/usr/lib/libSystem.B.dylib"]);
+    XCTAssertEqualObjects([NSSet setWithArray:linkedLibraries], [self otoolLinkedLibrariesForBinary:path]);
+  }
+}
+
+- (void)testDescriptorWithoutParsingReadsLoadCommandsOnDemand
+{
+  NSError *error = nil;
+  FBBinaryDescriptor *parsed = [FBBinaryDescriptor binaryWithPath:@"/usr/bin/codesign" error:&error];
+  XCTAssertNil(error);
+  FBBinaryDescriptor *unparsed = [[FBBinaryDescriptor alloc] initWithName:parsed.name architectures:parsed.architectures uuid:parsed.uuid path:parsed.path];
+  XCTAssertEqualObjects([unparsed linkedLibrariesWithError:&error], [parsed linkedLibrariesWithError:nil]);
+  XCTAssertNil(error);
+  XCTAssertEqualObjects([unparsed rpathsWithError:&error], [parsed rpathsWithError:nil]);
+  XCTAssertNil(error);
+}
+
+- (void)testMalformedBinaries
+{
+  NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"FBBinaryDescriptorTests_%@", NSUUID.UUID.UUIDString]];
+
+  // Not a binary.
+  XCTAssertTrue([[@"not a binary" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:path atomically:YES]);
+  NSError *error = nil;
+  XCTAssertNil([FBBinaryDescriptor binaryWithPath:path error:&error]);
+  XCTAssertNotNil(error);
+
+  // Load commands that extend past the end of the file.
+  struct mach_header_64 header = {
+    .magic = MH_MAGIC_64,
+    .cputype = CPU_TYPE_ARM64,
+    .ncmds = 1,
+    .sizeofcmds = 4096,
+  };
+  XCTAssertTrue([[NSData dataWithBytes:&header length:sizeof(header)] writeToFile:path atomically:YES]);
+  error = nil;
+  XCTAssertNil([FBBinaryDescriptor binaryWithPath:path error:&error]);
+  XCTAssertNotNil(error);
+
+  // A load command with a size that extends past the end of the load commands.
+  NSMutableData *data = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+  struct load_command command = {
+    .cmd = LC_UUID,
+    .cmdsize = 8192,
+  };
+  [data appendBytes:&command length:sizeof(command)];
+  [data increaseLengthBy:header.sizeofcmds - sizeof(command)];
+  XCTAssertTrue([data writeToFile:path atomically:YES]);
+  error = nil;
+  XCTAssertNil([FBBinaryDescriptor binaryWithPath:path error:&error]);
+  XCTAssertNotNil(error);
+
+  [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+}
+
+- (void)testParsingPerformance
+{
+  // clang in the default toolchain is a large binary, that is fat in Universal Xcode installs.
+  NSString *path = [FBXcodeConfiguration.developerDirectory stringByAppendingPathComponent:@"Toolchains/XcodeDefault.xctoolchain/usr/bin/clang"];
+  unsigned long long size = [NSFileManager.defaultManager attributesOfItemAtPath:path error:nil].fileSize;
+  XCTAssertGreaterThan(size, 0u);
+
+  NSSet<NSString *> *otoolLibraries = [self otoolLinkedLibrariesForBinary:path];
+
+  [self measureBlock:^{
+    NSArray<NSString *> *linkedLibraries = nil;
+    for (NSUInteger index = 0; index < BenchmarkParseCount; index++) {
+      FBBinaryDescriptor *descriptor = [FBBinaryDescriptor binaryWithPath:path error:nil];
+      linkedLibraries = [descriptor linkedLibrariesWithError:nil];
+      [descriptor rpathsWithError:nil];
+    }
+    XCTAssertEqualObjects([NSSet setWithArray:linkedLibraries], otoolLibraries);
+  }];
+}
+
 @end
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+static NSData *AnnexBFrame(uint8_t nalUnitType, uint8_t tag)
+{
+  const uint8_t bytes[] = {0x00, 0x00, 0x00, 0x01, nalUnitType, tag};
+  return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
+static NSData *KeyFrame(uint8_t tag)
+{
+  return AnnexBFrame(0x65, tag);
+}
+
+static NSData *PredictedFrame(uint8_t tag)
+{
+  return AnnexBFrame(0x41, tag);
+}
+
+@interface FBBoundedFrameDataConsumerTests : XCTestCase
+
+@property (nonatomic, strong, readwrite) dispatch_semaphore_t semaphore;
+@property (nonatomic, strong, readwrite) NSMutableArray<NSData *> *written;
+
+@end
+
+@implementation FBBoundedFrameDataConsumerTests
+
+- (void)setUp
+{
+  [super setUp];
+
+  self.semaphore = dispatch_semaphore_create(0);
+  self.written = [NSMutableArray array];
+}
+
+- (FBBoundedFrameDataConsumer *)consumerWithEncoding:(FBVideoStreamEncoding)encoding dropPolicy:(FBFrameDropPolicy)dropPolicy
+{
+  // The first frame blocks the destination until it is signalled, so that later frames are queued.
+  dispatch_semaphore_t semaphore = self.semaphore;
+  NSMutableArray<NSData *> *written = self.written;
+  id<FBDataConsumer> destination = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+    BOOL first = NO;
+    @synchronized (written) {
+      first = written.count == 0;
+      [written addObject:[data copy]];
+    }
+    if (first) {
+      dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    }
+  }];
+  return [FBBoundedFrameDataConsumer consumerWithConsumer:destination encoding:encoding maximumQueuedFrames:2 dropPolicy:dropPolicy];
+}
+
+- (void)waitForFirstFrameToBeWritten
+{
+  NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:FBControlCoreGlobalConfiguration.fastTimeout];
+  while (deadline.timeIntervalSinceNow > 0) {
+    @synchronized (self.written) {
+      if (self.written.count > 0) {
+        return;
+      }
+    }
+    [NSThread sleepForTimeInterval:0.01];
+  }
+  XCTFail(@"First frame was not written");
+}
+
+- (void)finish:(FBBoundedFrameDataConsumer *)consumer
+{
+  dispatch_semaphore_signal(self.semaphore);
+  [consumer consumeEndOfFile];
+  NSError *error = nil;
+  XCTAssertNotNil([consumer.finishedConsuming awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error]);
+  XCTAssertNil(error);
+}
+
+- (void)testRecognisesAnnexBKeyframes
+{
+  XCTAssertTrue([FBBoundedFrameDataConsumer isKeyframe:KeyFrame(0) encoding:FBVideoStreamEncodingH264]);
+  XCTAssertTrue([FBBoundedFrameDataConsumer isKeyframe:AnnexBFrame(0x67, 0) encoding:FBVideoStreamEncodingH264]);
+  XCTAssertFalse([FBBoundedFrameDataConsumer isKeyframe:PredictedFrame(0) encoding:FBVideoStreamEncodingH264]);
+  XCTAssertTrue([FBBoundedFrameDataConsumer isKeyframe:PredictedFrame(0) encoding:FBVideoStreamEncodingMJPEG]);
+}
+
+- (void)testAccumulatesDataUntilEndOfFrame
+{
+  FBBoundedFrameDataConsumer *consumer = [self consumerWithEncoding:FBVideoStreamEncodingMJPEG dropPolicy:FBFrameDropPolicyDropOldest];
+  [consumer consumeData:[@"FO" dataUsingEncoding:NSUTF8StringEncoding]];
+  [consumer consumeData:[@"O" dataUsingEncoding:NSUTF8StringEncoding]];
+  [consumer consumeEndOfFrame];
+  [self finish:consumer];
+
+  XCTAssertEqualObjects(self.written, (@[[@"FOO" dataUsingEncoding:NSUTF8StringEncoding]]));
+  XCTAssertEqual(consumer.framesWritten, 1u);
+}
+
+- (void)testDropsOldestFrames
+{
+  FBBoundedFrameDataConsumer *consumer = [self consumerWithEncoding:FBVideoStreamEncodingMJPEG dropPolicy:FBFrameDropPolicyDropOldest];
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(0)], 0u);
+  [self waitForFirstFrameToBeWritten];
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(1)], 0u);
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(2)], 0u);
+  XCTAssertEqual(consumer.queuedFrames, 2u);
+  XCTAssertEqual(consumer.pendingBytes, KeyFrame(1).length * 2);
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(3)], 1u);
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(4)], 1u);
+  [self finish:consumer];
+
+  XCTAssertEqualObjects(self.written, (@[KeyFrame(0), KeyFrame(3), KeyFrame(4)]));
+  XCTAssertEqual(consumer.framesDropped, 2u);
+  XCTAssertEqual(consumer.framesWritten, 3u);
+  XCTAssertEqual(consumer.queuedFrames, 0u);
+  XCTAssertEqual(consumer.pendingBytes, 0u);
+}
+
+- (void)testDropsNonKeyframesUntilNextKeyframe
+{
+  FBBoundedFrameDataConsumer *consumer = [self consumerWithEncoding:FBVideoStreamEncodingH264 dropPolicy:FBFrameDropPolicyDropNonKeyframe];
+  [consumer consumeFrame:KeyFrame(0)];
+  [self waitForFirstFrameToBeWritten];
+  XCTAssertEqual([consumer consumeFrame:PredictedFrame(1)], 0u);
+  XCTAssertEqual([consumer consumeFrame:PredictedFrame(2)], 0u);
+  // The queue is full, so this frame is dropped, as is every frame that depends upon it.
+  XCTAssertEqual([consumer consumeFrame:PredictedFrame(3)], 1u);
+  XCTAssertEqual([consumer consumeFrame:PredictedFrame(4)], 1u);
+  // The keyframe replaces the frames that are queued.
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(5)], 2u);
+  XCTAssertEqual([consumer consumeFrame:PredictedFrame(6)], 0u);
+  [self finish:consumer];
+
+  XCTAssertEqualObjects(self.written, (@[KeyFrame(0), KeyFrame(5), PredictedFrame(6)]));
+  XCTAssertEqual(consumer.framesDropped, 4u);
+  XCTAssertEqual(consumer.framesWritten, 3u);
+}
+
+- (void)testCoalescesFramesThatCannotBeDropped
+{
+  FBBoundedFrameDataConsumer *consumer = [self consumerWithEncoding:FBVideoStreamEncodingBGRATiles dropPolicy:FBFrameDropPolicyCoalesce];
+  [consumer consumeFrame:KeyFrame(0)];
+  [self waitForFirstFrameToBeWritten];
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(1)], 0u);
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(2)], 0u);
+  // The queue is full, so these frames are appended to the last queued frame.
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(3)], 0u);
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(4)], 0u);
+  XCTAssertEqual(consumer.queuedFrames, 2u);
+  XCTAssertEqual(consumer.pendingBytes, KeyFrame(1).length * 4);
+  [self finish:consumer];
+
+  NSMutableData *coalesced = [KeyFrame(2) mutableCopy];
+  [coalesced appendData:KeyFrame(3)];
+  [coalesced appendData:KeyFrame(4)];
+  XCTAssertEqualObjects(self.written, (@[KeyFrame(0), KeyFrame(1), coalesced]));
+  XCTAssertEqual(consumer.framesDropped, 0u);
+  XCTAssertEqual(consumer.framesWritten, 3u);
+}
+
+- (void)testDropPolicyForEncoding
+{
+  XCTAssertEqual([FBBoundedFrameDataConsumer dropPolicyForEncoding:FBVideoStreamEncodingH264], FBFrameDropPolicyDropNonKeyframe);
+  XCTAssertEqual([FBBoundedFrameDataConsumer dropPolicyForEncoding:FBVideoStreamEncodingMJPEG], FBFrameDropPolicyDropOldest);
+  XCTAssertEqual([FBBoundedFrameDataConsumer dropPolicyForEncoding:FBVideoStreamEncodingBGRATiles], FBFrameDropPolicyCoalesce);
+  XCTAssertEqual([FBBoundedFrameDataConsumer dropPolicyForEncoding:FBVideoStreamEncodingMJPEGTiles], FBFrameDropPolicyCoalesce);
+}
+
+- (void)testIgnoresFramesAfterEndOfFile
+{
+  FBBoundedFrameDataConsumer *consumer = [self consumerWithEncoding:FBVideoStreamEncodingMJPEG dropPolicy:FBFrameDropPolicyDropOldest];
+  [consumer consumeFrame:KeyFrame(0)];
+  [self finish:consumer];
+  XCTAssertEqual([consumer consumeFrame:KeyFrame(1)], 0u);
+
+  XCTAssertEqualObjects(self.written, (@[KeyFrame(0)]));
+  XCTAssertEqual(consumer.framesDropped, 0u);
+}
+
+@end
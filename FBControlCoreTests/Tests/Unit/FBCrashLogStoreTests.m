@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+#import "FBControlCoreFixtures.h"
+
+static const NSUInteger BenchmarkCopiesPerFixture = 500;
+static const NSUInteger BenchmarkQueryCount = 100;
+
+@interface FBCrashLogStoreTests : XCTestCase
+
+@property (nonatomic, copy, readwrite) NSString *directory;
+
+@end
+
+@implementation FBCrashLogStoreTests
+
+- (void)setUp
+{
+  [super setUp];
+  self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"FBCrashLogStoreTests_%@", NSUUID.UUID.UUIDString]];
+  [NSFileManager.defaultManager createDirectoryAtPath:self.crashDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown
+{
+  [NSFileManager.defaultManager removeItemAtPath:self.directory error:nil];
+  [super tearDown];
+}
+
+- (NSString *)crashDirectory
+{
+  return [self.directory stringByAppendingPathComponent:@"crashes"];
+}
+
+- (NSString *)indexPath
+{
+  return [self.directory stringByAppendingPathComponent:@"index.plist"];
+}
+
+- (void)copyFixturesToCrashDirectory:(NSUInteger)copies
+{
+  NSArray<NSString *> *fixtures = @[
+    FBControlCoreFixtures.assetsdCrashPathWithCustomDeviceSet,
+    FBControlCoreFixtures.agentCrashPathWithCustomDeviceSet,
+    FBControlCoreFixtures.appCrashPathWithDefaultDeviceSet,
+    FBControlCoreFixtures.appCrashPathWithCustomDeviceSet,
+  ];
+  for (NSUInteger index = 0; index < copies; index++) {
+    for (NSString *fixture in fixtures) {
+      NSString *name = [NSString stringWithFormat:@"%lu_%@", (unsigned long) index, fixture.lastPathComponent];
+      NSError *error = nil;
+      XCTAssertTrue([NSFileManager.defaultManager copyItemAtPath:fixture toPath:[self.crashDirectory stringByAppendingPathComponent:name] error:&error]);
+      XCTAssertNil(error);
+    }
+  }
+}
+
+- (FBCrashLogStore *)storeWithIndex:(BOOL)index
+{
+  return [FBCrashLogStore storeForDirectories:@[self.crashDirectory] indexPath:(index ? self.indexPath : nil) logger:[FBControlCoreLogger systemLoggerWritingToStderr:NO withDebugLogging:NO]];
+}
+
+- (NSArray<NSPredicate *> *)predicates
+{
+  NSDate *date = [NSDate dateWithTimeIntervalSinceReferenceDate:479723500];
+  return @[
+    [FBCrashLogInfo predicateForIdentifier:@"TableSearch"],
+    [FBCrashLogInfo predicateForProcessName:@"assetsd"],
+    [FBCrashLogInfo predicateForCrashLogsWithProcessID:39655],
+    [FBCrashLogInfo predicateForProcessType:FBCrashLogInfoProcessTypeSystem | FBCrashLogInfoProcessTypeCustomAgent],
+    [FBCrashLogInfo predicateNewerThanDate:date],
+    [FBCrashLogInfo predicateOlderThanDate:date],
+    [FBCrashLogInfo predicateForName:@"0_assetsd_custom_set.crash"],
+    [NSCompoundPredicate andPredicateWithSubpredicates:@[
+      [FBCrashLogInfo predicateForIdentifier:@"TableSearch"],
+      [FBCrashLogInfo predicateNewerThanDate:date],
+    ]],
+    [NSCompoundPredicate orPredicateWithSubpredicates:@[
+      [FBCrashLogInfo predicateForIdentifier:@"assetsd"],
+      [FBCrashLogInfo predicateForCrashLogsWithProcessID:40119],
+    ]],
+    [NSCompoundPredicate orPredicateWithSubpredicates:@[
+      [FBCrashLogInfo predicateForIdentifier:@"assetsd"],
+      [FBCrashLogInfo predicateForExecutablePathContains:@"WebDriverAgent"],
+    ]],
+    [NSPredicate predicateWithBlock:^ BOOL (FBCrashLogInfo *crashLog, id _) {
+      return crashLog.parentProcessIdentifier == 39927;
+    }],
+  ];
+}
+
+- (NSSet<NSString *> *)namesOf:(NSArray<FBCrashLogInfo *> *)crashLogs
+{
+  return [NSSet setWithArray:[crashLogs valueForKey:@"name"]];
+}
+
+- (void)testIndexedQueriesMatchLinearScan
+{
+  [self copyFixturesToCrashDirectory:5];
+  FBCrashLogStore *store = [self storeWithIndex:NO];
+  NSArray<FBCrashLogInfo *> *all = [store ingestAllExistingInDirectory];
+  XCTAssertEqual(all.count, 20u);
+
+  for (NSPredicate *predicate in self.predicates) {
+    NSSet<NSString *> *expected = [self namesOf:[all filteredArrayUsingPredicate:predicate]];
+    NSSet<NSString *> *actual = [self namesOf:[store ingestedCrashLogsMatchingPredicate:predicate]];
+    XCTAssertEqualObjects(actual, expected, @"%@", predicate);
+  }
+  XCTAssertEqual([store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForIdentifier:@"TableSearch"]].count, 10u);
+  XCTAssertEqual([store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForName:@"0_assetsd_custom_set.crash"]].count, 1u);
+}
+
+- (void)testRemovalAndPruningUpdateIndices
+{
+  [self copyFixturesToCrashDirectory:3];
+  FBCrashLogStore *store = [self storeWithIndex:NO];
+  NSArray<FBCrashLogInfo *> *all = [store ingestAllExistingInDirectory];
+  XCTAssertEqual(all.count, 12u);
+
+  FBCrashLogInfo *removed = [store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForIdentifier:@"assetsd"]].firstObject;
+  XCTAssertNotNil([store removeCrashLogAtPath:removed.crashPath]);
+  XCTAssertEqual([store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForIdentifier:@"assetsd"]].count, 2u);
+  XCTAssertEqual([store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForCrashLogsWithProcessID:removed.processIdentifier]].count, 2u);
+  XCTAssertFalse([[self namesOf:[store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateOlderThanDate:NSDate.date]]] containsObject:removed.name]);
+
+  NSArray<FBCrashLogInfo *> *pruned = [store pruneCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForIdentifier:@"TableSearch"]];
+  XCTAssertEqual(pruned.count, 6u);
+  XCTAssertEqual([store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForIdentifier:@"TableSearch"]].count, 0u);
+  XCTAssertEqual([store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForProcessType:FBCrashLogInfoProcessTypeApplication]].count, 0u);
+  XCTAssertEqual([store ingestedCrashLogsMatchingPredicate:[FBCrashLogInfo predicateOlderThanDate:NSDate.date]].count, 5u);
+  XCTAssertEqual(store.allIngestedCrashLogs.count, 5u);
+}
+
+- (void)testPersistedIndexRestoresCrashLogs
+{
+  [self copyFixturesToCrashDirectory:2];
+  NSArray<FBCrashLogInfo *> *parsed = [[self storeWithIndex:YES] ingestAllExistingInDirectory];
+  XCTAssertEqual(parsed.count, 8u);
+  [self waitForIndexToBeWritten];
+
+  FBCrashLogStore *store = [self storeWithIndex:YES];
+  NSArray<FBCrashLogInfo *> *restored = [store ingestAllExistingInDirectory];
+  XCTAssertEqual(restored.count, parsed.count);
+  for (FBCrashLogInfo *expected in parsed) {
+    FBCrashLogInfo *actual = [store ingestedCrashLogWithName:expected.name];
+    XCTAssertNotNil(actual);
+    XCTAssertEqualObjects(actual.crashPath, expected.crashPath);
+    XCTAssertEqualObjects(actual.executablePath, expected.executablePath);
+    XCTAssertEqualObjects(actual.identifier, expected.identifier);
+    XCTAssertEqualObjects(actual.processName, expected.processName);
+    XCTAssertEqual(actual.processIdentifier, expected.processIdentifier);
+    XCTAssertEqualObjects(actual.parentProcessName, expected.parentProcessName);
+    XCTAssertEqual(actual.parentProcessIdentifier, expected.parentProcessIdentifier);
+    XCTAssertEqualObjects(actual.date, expected.date);
+    XCTAssertEqual(actual.processType, expected.processType);
+  }
+}
+
+- (void)testPersistedIndexIgnoresModifiedCrashLogs
+{
+  [self copyFixturesToCrashDirectory:1];
+  [[self storeWithIndex:YES] ingestAllExistingInDirectory];
+  [self waitForIndexToBeWritten];
+
+  // Replace the contents of one crash log with another, the index entry for it must not be used.
+  NSString *replaced = [self.crashDirectory stringByAppendingPathComponent:[@"0_" stringByAppendingString:FBControlCoreFixtures.assetsdCrashPathWithCustomDeviceSet.lastPathComponent]];
+  [NSFileManager.defaultManager removeItemAtPath:replaced error:nil];
+  XCTAssertTrue([NSFileManager.defaultManager copyItemAtPath:FBControlCoreFixtures.appCrashPathWithCustomDeviceSet toPath:replaced error:nil]);
+
+  FBCrashLogStore *store = [self storeWithIndex:YES];
+  [store ingestAllExistingInDirectory];
+  XCTAssertEqualObjects([store ingestedCrashLogWithName:replaced.lastPathComponent].identifier, @"TableSearch");
+}
+
+- (void)testPersistedIndexForgetsPrunedAndDeletedCrashLogs
+{
+  [self copyFixturesToCrashDirectory:1];
+  FBCrashLogStore *store = [self storeWithIndex:YES];
+  [store ingestAllExistingInDirectory];
+  [self waitForIndexToBeWritten];
+  [self waitForIndexRecordCount:4];
+
+  NSArray<FBCrashLogInfo *> *pruned = [store pruneCrashLogsMatchingPredicate:[FBCrashLogInfo predicateForIdentifier:@"TableSearch"]];
+  XCTAssertEqual(pruned.count, 2u);
+  [self waitForIndexRecordCount:2];
+
+  // A crash log that is deleted while nothing is running is dropped when the index is next loaded.
+  NSString *deleted = [self.crashDirectory stringByAppendingPathComponent:[@"0_" stringByAppendingString:FBControlCoreFixtures.assetsdCrashPathWithCustomDeviceSet.lastPathComponent]];
+  XCTAssertTrue([NSFileManager.defaultManager removeItemAtPath:deleted error:nil]);
+  for (FBCrashLogInfo *crashLog in pruned) {
+    [NSFileManager.defaultManager removeItemAtPath:crashLog.crashPath error:nil];
+  }
+  [[self storeWithIndex:YES] ingestAllExistingInDirectory];
+  [self waitForIndexRecordCount:1];
+}
+
+- (void)waitForIndexRecordCount:(NSUInteger)count
+{
+  NSPredicate *hasCount = [NSPredicate predicateWithBlock:^ BOOL (NSString *path, id _) {
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    NSDictionary<NSString *, id> *index = data ? [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:nil error:nil] : nil;
+    return [index[@"records"] count] == count;
+  }];
+  [self waitForExpectations:@[[self expectationForPredicate:hasCount evaluatedWithObject:self.indexPath handler:nil]] timeout:5];
+}
+
+- (void)waitForIndexToBeWritten
+{
+  NSPredicate *exists = [NSPredicate predicateWithBlock:^ BOOL (NSString *path, id _) {
+    return [NSFileManager.defaultManager fileExistsAtPath:path];
+  }];
+  [self waitForExpectations:@[[self expectationForPredicate:exists evaluatedWithObject:self.indexPath handler:nil]] timeout:5];
+}
+
+- (void)testIngestionByParsingPerformance
+{
+  [self copyFixturesToCrashDirectory:BenchmarkCopiesPerFixture];
+
+  [self measureBlock:^{
+    NSArray<FBCrashLogInfo *> *all = [[self storeWithIndex:NO] ingestAllExistingInDirectory];
+    XCTAssertEqual(all.count, BenchmarkCopiesPerFixture * 4);
+  }];
+}
+
+- (void)testIngestionFromIndexPerformance
+{
+  [self copyFixturesToCrashDirectory:BenchmarkCopiesPerFixture];
+  [[self storeWithIndex:YES] ingestAllExistingInDirectory];
+  [self waitForIndexToBeWritten];
+
+  [self measureBlock:^{
+    FBCrashLogStore *store = [self storeWithIndex:YES];
+    [store ingestAllExistingInDirectory];
+    XCTAssertEqual(store.allIngestedCrashLogs.count, BenchmarkCopiesPerFixture * 4);
+  }];
+}
+
+- (void)testQueryPerformance
+{
+  [self copyFixturesToCrashDirectory:BenchmarkCopiesPerFixture];
+  NSArray<NSPredicate *> *predicates = self.predicates;
+  FBCrashLogStore *store = [self storeWithIndex:YES];
+  NSArray<FBCrashLogInfo *> *all = [store ingestAllExistingInDirectory];
+  NSMutableArray<NSNumber *> *expected = [NSMutableArray array];
+  for (NSPredicate *predicate in predicates) {
+    [expected addObject:@([all filteredArrayUsingPredicate:predicate].count)];
+  }
+
+  [self measureBlock:^{
+    for (NSUInteger index = 0; index < BenchmarkQueryCount; index++) {
+      for (NSUInteger predicateIndex = 0; predicateIndex < predicates.count; predicateIndex++) {
+        NSArray<FBCrashLogInfo *> *matching = [store ingestedCrashLogsMatchingPredicate:predicates[predicateIndex]];
+        XCTAssertEqual(matching.count, expected[predicateIndex].unsignedIntegerValue);
+      }
+    }
+  }];
+}
+
+@end
@@ -9,12 +9,66 @@
 
 #import <FBControlCore/FBControlCore.h>
 
+#import "FBContiguousConsumableBufferDouble.h"
+
+static NSUInteger const LineBenchmarkChunkCount = 16;
+static NSUInteger const LineBenchmarkLinesPerChunk = 16384;
+static NSUInteger const PayloadBenchmarkMegabytes = 64;
+static NSUInteger const PayloadBenchmarkChunkSize = 16384;
+
 @interface FBDataConsumerTests : XCTestCase
 
 @end
 
 @implementation FBDataConsumerTests
 
++ (NSData *)lineBenchmarkChunk
+{
+  NSMutableData *data = NSMutableData.data;
+  for (NSUInteger index = 0; index < LineBenchmarkLinesPerChunk; index++) {
+    [data appendData:[[NSString stringWithFormat:@"Oct 17 12:00:00 localhost simulated_process[%lu]: a line of log output\n", (unsigned long) index] dataUsingEncoding:NSUTF8StringEncoding]];
+  }
+  return data;
+}
+
++ (dispatch_data_t)payloadBenchmarkData
+{
+  size_t length = PayloadBenchmarkMegabytes * 1024 * 1024;
+  void *bytes = malloc(length);
+  memset(bytes, 'A', length);
+  return dispatch_data_create(bytes, length, NULL, DISPATCH_DATA_DESTRUCTOR_FREE);
+}
+
+// Streams the data in chunks through a data consumer into payloads, returning the number of bytes that were copied on the way.
+// A payload either copies the chunk, as setting the data of a message does, or references its regions, as the slices of a grpc::ByteBuffer do.
++ (NSUInteger)bytesCopiedStreamingData:(dispatch_data_t)data referencingPayloads:(BOOL)referencing
+{
+  const void *buffer = NULL;
+  size_t length = 0;
+  dispatch_data_t contiguous = dispatch_data_create_map(data, &buffer, &length);
+  __block NSUInteger copied = 0;
+  id<FBDataConsumer> payloads = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *chunk) {
+    NSData *payload = chunk;
+    if (!referencing) {
+      NSMutableData *copy = [NSMutableData dataWithCapacity:chunk.length];
+      [copy appendData:chunk];
+      payload = copy;
+    }
+    // A region that is outside of the producer's buffer has been copied.
+    [payload enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+      if (bytes < buffer || (const uint8_t *) bytes + byteRange.length > (const uint8_t *) buffer + length) {
+        copied += byteRange.length;
+      }
+    }];
+  }];
+  id<FBDispatchDataConsumer> consumer = [FBDataConsumerAdaptor dispatchDataConsumerForDataConsumer:payloads];
+  for (size_t offset = 0; offset < length; offset += PayloadBenchmarkChunkSize) {
+    [consumer consumeData:dispatch_data_create_subrange(contiguous, offset, MIN(PayloadBenchmarkChunkSize, length - offset))];
+  }
+  [consumer consumeEndOfFile];
+  return copied;
+}
+
 - (void)testLineBufferAccumulation
 {
   id<FBAccumulatingBuffer> consumer = FBDataBuffer.accumulatingBuffer;
@@ -100,6 +154,50 @@
   XCTAssertTrue(consumer.finishedConsuming.hasCompleted);
 }
 
+- (void)testLineBytesConsumerAcrossChunks
+{
+  NSMutableArray<NSString *> *lines = [NSMutableArray array];
+  id<FBDataConsumer, FBDataConsumerLifecycle> consumer = [FBBlockDataConsumer synchronousLineConsumerWithBytesBlock:^(const char *bytes, NSUInteger length) {
+    [lines addObject:[[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding]];
+  }];
+
+  // Lines that are longer than a vector width, spanning chunks, and empty lines.
+  [consumer consumeData:[@"A line that is longer than sixteen bytes\nFO" dataUsingEncoding:NSUTF8StringEncoding]];
+  [consumer consumeData:[@"O" dataUsingEncoding:NSUTF8StringEncoding]];
+  [consumer consumeData:[@"\n\nBAR\nBAZ" dataUsingEncoding:NSUTF8StringEncoding]];
+  XCTAssertEqualObjects(lines, (@[@"A line that is longer than sixteen bytes", @"FOO", @"", @"BAR"]));
+
+  [consumer consumeData:[@"\n" dataUsingEncoding:NSUTF8StringEncoding]];
+  XCTAssertEqualObjects(lines, (@[@"A line that is longer than sixteen bytes", @"FOO", @"", @"BAR", @"BAZ"]));
+
+  [consumer consumeEndOfFile];
+  XCTAssertTrue(consumer.finishedConsuming.hasCompleted);
+}
+
+- (void)testLineBytesConsumerAsync
+{
+  dispatch_queue_t queue = dispatch_queue_create("testLineBytesConsumerAsync", DISPATCH_QUEUE_SERIAL);
+  NSMutableArray<NSString *> *lines = [NSMutableArray array];
+  XCTestExpectation *expectation = [[XCTestExpectation alloc] initWithDescription:@"Lines Consumed"];
+  id<FBDataConsumer, FBDataConsumerLifecycle> consumer = [FBBlockDataConsumer asynchronousLineConsumerWithQueue:queue bytesConsumer:^(const char *bytes, NSUInteger length) {
+    [lines addObject:[[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding]];
+    if (lines.count == 3) {
+      [expectation fulfill];
+    }
+  }];
+
+  // The buffer is mutated after it is consumed, the consumer should not observe this.
+  NSMutableData *data = [[@"FOO\nBA" dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+  [consumer consumeData:data];
+  [data setData:[@"R\nBAZ\n" dataUsingEncoding:NSUTF8StringEncoding]];
+  [consumer consumeData:data];
+  [consumer consumeEndOfFile];
+
+  [self waitForExpectations:@[expectation] timeout:FBControlCoreGlobalConfiguration.fastTimeout];
+  dispatch_sync(queue, ^{ XCTAssertEqualObjects(lines, (@[@"FOO", @"BAR", @"BAZ"])); });
+  XCTAssertTrue(consumer.finishedConsuming.hasCompleted);
+}
+
 - (void)testUnbufferedConsumer
 {
   NSData *expected = [@"FOOBARBAZ" dataUsingEncoding:NSUTF8StringEncoding];
@@ -296,4 +394,139 @@
   [self waitForExpectations:@[doneExpectation] timeout:FBControlCoreGlobalConfiguration.fastTimeout];
 }
 
+- (void)testTerminalSpanningMultipleChunks
+{
+  id<FBConsumableBuffer> consumer = FBDataBuffer.consumableBuffer;
+  NSData *terminal = [@"$$$" dataUsingEncoding:NSUTF8StringEncoding];
+
+  [consumer consumeData:[@"FOO$" dataUsingEncoding:NSUTF8StringEncoding]];
+  XCTAssertNil([consumer consumeUntil:terminal]);
+  [consumer consumeData:[@"$" dataUsingEncoding:NSUTF8StringEncoding]];
+  XCTAssertNil([consumer consumeUntil:terminal]);
+  [consumer consumeData:[@"$BAR$$" dataUsingEncoding:NSUTF8StringEncoding]];
+  XCTAssertEqualObjects([consumer consumeUntil:terminal], [@"FOO" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertNil([consumer consumeUntil:terminal]);
+  [consumer consumeData:[@"$BAZ" dataUsingEncoding:NSUTF8StringEncoding]];
+  XCTAssertEqualObjects([consumer consumeUntil:terminal], [@"BAR" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertNil(consumer.consumeLineString);
+  XCTAssertEqualObjects(consumer.data, [@"BAZ" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertEqualObjects([consumer consumeLength:2], [@"BA" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertEqualObjects(consumer.consumeCurrentString, @"Z");
+}
+
+- (void)testLineConsumptionPerformance
+{
+  NSData *chunk = FBDataConsumerTests.lineBenchmarkChunk;
+  [self measureBlock:^{
+    id<FBConsumableBuffer> consumer = FBDataBuffer.consumableBuffer;
+    NSUInteger lineCount = 0;
+    for (NSUInteger index = 0; index < LineBenchmarkChunkCount; index++) {
+      [consumer consumeData:chunk];
+      while ([consumer consumeLineData]) {
+        lineCount++;
+      }
+    }
+    XCTAssertEqual(lineCount, LineBenchmarkChunkCount * LineBenchmarkLinesPerChunk);
+  }];
+}
+
+- (void)testContiguousLineConsumptionPerformance
+{
+  // The baseline for testLineConsumptionPerformance, a buffer that moves its remainder on every consumed line.
+  NSData *chunk = FBDataConsumerTests.lineBenchmarkChunk;
+  [self measureBlock:^{
+    FBContiguousConsumableBufferDouble *consumer = [[FBContiguousConsumableBufferDouble alloc] initWithForwardingConsumer:nil terminal:FBDataBuffer.newlineTerminal];
+    NSUInteger lineCount = 0;
+    for (NSUInteger index = 0; index < LineBenchmarkChunkCount; index++) {
+      [consumer consumeData:chunk];
+      while ([consumer consumeUntil:FBDataBuffer.newlineTerminal]) {
+        lineCount++;
+      }
+    }
+    XCTAssertEqual(lineCount, LineBenchmarkChunkCount * LineBenchmarkLinesPerChunk);
+  }];
+}
+
+- (void)testForwardingLineConsumptionPerformance
+{
+  NSData *chunk = FBDataConsumerTests.lineBenchmarkChunk;
+  // Split the chunk at an uneven boundary, so that lines span the appended data.
+  NSUInteger split = chunk.length / 3 + 7;
+  NSData *first = [chunk subdataWithRange:NSMakeRange(0, split)];
+  NSData *second = [chunk subdataWithRange:NSMakeRange(split, chunk.length - split)];
+  [self measureBlock:^{
+    __block NSUInteger lineCount = 0;
+    id<FBDataConsumer> lines = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *line) {
+      lineCount++;
+    }];
+    id<FBNotifyingBuffer> consumer = [FBDataBuffer consumableBufferForwardingToConsumer:lines onQueue:nil terminal:FBDataBuffer.newlineTerminal];
+    for (NSUInteger index = 0; index < LineBenchmarkChunkCount; index++) {
+      [consumer consumeData:first];
+      [consumer consumeData:second];
+    }
+    XCTAssertEqual(lineCount, LineBenchmarkChunkCount * LineBenchmarkLinesPerChunk);
+  }];
+}
+
+- (void)testContiguousForwardingLineConsumptionPerformance
+{
+  // The baseline for testForwardingLineConsumptionPerformance.
+  NSData *chunk = FBDataConsumerTests.lineBenchmarkChunk;
+  NSUInteger split = chunk.length / 3 + 7;
+  NSData *first = [chunk subdataWithRange:NSMakeRange(0, split)];
+  NSData *second = [chunk subdataWithRange:NSMakeRange(split, chunk.length - split)];
+  [self measureBlock:^{
+    __block NSUInteger lineCount = 0;
+    id<FBDataConsumer> lines = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *line) {
+      lineCount++;
+    }];
+    FBContiguousConsumableBufferDouble *consumer = [[FBContiguousConsumableBufferDouble alloc] initWithForwardingConsumer:lines terminal:FBDataBuffer.newlineTerminal];
+    for (NSUInteger index = 0; index < LineBenchmarkChunkCount; index++) {
+      [consumer consumeData:first];
+      [consumer consumeData:second];
+    }
+    XCTAssertEqual(lineCount, LineBenchmarkChunkCount * LineBenchmarkLinesPerChunk);
+  }];
+}
+
+- (void)testLineBytesConsumptionPerformance
+{
+  NSData *chunk = FBDataConsumerTests.lineBenchmarkChunk;
+  NSUInteger split = chunk.length / 3 + 7;
+  NSData *first = [chunk subdataWithRange:NSMakeRange(0, split)];
+  NSData *second = [chunk subdataWithRange:NSMakeRange(split, chunk.length - split)];
+  [self measureBlock:^{
+    __block NSUInteger lineCount = 0;
+    id<FBDataConsumer> consumer = [FBBlockDataConsumer synchronousLineConsumerWithBytesBlock:^(const char *bytes, NSUInteger length) {
+      lineCount++;
+    }];
+    for (NSUInteger index = 0; index < LineBenchmarkChunkCount; index++) {
+      [consumer consumeData:first];
+      [consumer consumeData:second];
+    }
+    XCTAssertEqual(lineCount, LineBenchmarkChunkCount * LineBenchmarkLinesPerChunk);
+  }];
+}
+
+- (void)testCopiedPayloadPerformance
+{
+  dispatch_data_t data = FBDataConsumerTests.payloadBenchmarkData;
+  [self measureBlock:^{
+    NSUInteger copied = [FBDataConsumerTests bytesCopiedStreamingData:data referencingPayloads:NO];
+    NSLog(@"Copied payloads: %lu bytes copied per MB streamed", (unsigned long) (copied / PayloadBenchmarkMegabytes));
+    XCTAssertEqual(copied, dispatch_data_get_size(data));
+  }];
+}
+
+- (void)testReferencedPayloadPerformance
+{
+  // The zero-copy counterpart of testCopiedPayloadPerformance.
+  dispatch_data_t data = FBDataConsumerTests.payloadBenchmarkData;
+  [self measureBlock:^{
+    NSUInteger copied = [FBDataConsumerTests bytesCopiedStreamingData:data referencingPayloads:YES];
+    NSLog(@"Referenced payloads: %lu bytes copied per MB streamed", (unsigned long) (copied / PayloadBenchmarkMegabytes));
+    XCTAssertEqual(copied, 0u);
+  }];
+}
+
 @end
@@ -9,6 +9,10 @@
 
 #import <FBControlCore/FBControlCore.h>
 
+static const NSUInteger FutureBenchmarkCount = 100000;
+static const NSUInteger FutureBenchmarkDepth = 1000;
+static const NSUInteger FutureBenchmarkFanIn = 10000;
+
 @interface FBFutureTests : XCTestCase
 
 @property (nonatomic, strong, readwrite) dispatch_queue_t queue;
@@ -1224,6 +1228,296 @@
   [self waitForExpectations:@[teardownExpectation] timeout:FBControlCoreGlobalConfiguration.fastTimeout];
 }
 
+- (void)testSignalledConditionResolvesWithoutWaitingForAnInterval
+{
+  FBFutureCondition *condition = [FBFutureCondition new];
+  dispatch_semaphore_t evaluated = dispatch_semaphore_create(0);
+  __block BOOL ready = NO;
+
+  FBFuture<NSNull *> *future = [FBFuture onQueue:self.queue resolveWhen:^ BOOL {
+    dispatch_semaphore_signal(evaluated);
+    return ready;
+  } signalledBy:condition];
+
+  // The fallback backoff only evaluates a handful of times within the deadline, so most of these evaluations must come from the signals.
+  NSUInteger signalCount = 20;
+  dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, 2 * NSEC_PER_SEC);
+  XCTAssertEqual(dispatch_semaphore_wait(evaluated, deadline), 0);
+  NSUInteger signalledEvaluations = 0;
+  for (NSUInteger index = 0; index < signalCount; index++) {
+    [condition signal];
+    if (dispatch_semaphore_wait(evaluated, deadline) != 0) {
+      break;
+    }
+    signalledEvaluations++;
+  }
+  XCTAssertEqual(signalledEvaluations, signalCount);
+  XCTAssertEqual(future.state, FBFutureStateRunning);
+
+  dispatch_sync(self.queue, ^{
+    ready = YES;
+  });
+  [condition signal];
+  NSError *error = nil;
+  XCTAssertNotNil([future awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error]);
+  XCTAssertNil(error);
+}
+
+- (void)testSignallingAfterResolutionDoesNotEvaluate
+{
+  FBFutureCondition *condition = [FBFutureCondition new];
+  __block NSUInteger evaluations = 0;
+
+  FBFuture<NSNull *> *future = [FBFuture onQueue:self.queue resolveWhen:^ BOOL {
+    evaluations++;
+    return YES;
+  } signalledBy:condition];
+
+  NSError *error = nil;
+  XCTAssertNotNil([future awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error]);
+  [condition signal];
+  [condition signal];
+  __block NSUInteger finalEvaluations = 0;
+  dispatch_sync(self.queue, ^{
+    finalEvaluations = evaluations;
+  });
+  XCTAssertEqual(finalEvaluations, 1u);
+}
+
+- (void)testBackoffWakesUpLessOftenThanFixedInterval
+{
+  NSDate *readyAt = [NSDate dateWithTimeIntervalSinceNow:2];
+  __block NSUInteger fixedEvaluations = 0;
+  __block NSUInteger backoffEvaluations = 0;
+
+  FBFuture *fixed = [FBFuture onQueue:self.queue resolveWhen:^ BOOL {
+    fixedEvaluations++;
+    return readyAt.timeIntervalSinceNow <= 0;
+  }];
+  FBFuture *backoff = [FBFuture onQueue:self.queue resolveWhen:^ BOOL {
+    backoffEvaluations++;
+    return readyAt.timeIntervalSinceNow <= 0;
+  } backoffFrom:0.05 to:0.4];
+
+  NSError *error = nil;
+  XCTAssertNotNil([[FBFuture futureWithFutures:@[fixed, backoff]] awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error]);
+  XCTAssertNil(error);
+  __block NSUInteger finalFixedEvaluations = 0;
+  __block NSUInteger finalBackoffEvaluations = 0;
+  dispatch_sync(self.queue, ^{
+    finalFixedEvaluations = fixedEvaluations;
+    finalBackoffEvaluations = backoffEvaluations;
+  });
+  // Roughly 20 evaluations against 9, compared rather than counted exactly as timers are delayed on a loaded machine.
+  XCTAssertLessThan(finalBackoffEvaluations, finalFixedEvaluations);
+}
+
+- (void)testBackoffEvaluatesImmediately
+{
+  __block NSUInteger evaluations = 0;
+  // The first interval is far longer than the timeout, so waiting for it before the first evaluation fails the await.
+  FBFuture<NSNull *> *future = [FBFuture onQueue:self.queue resolveWhen:^ BOOL {
+    evaluations++;
+    return YES;
+  } backoffFrom:FBControlCoreGlobalConfiguration.fastTimeout * 10 to:FBControlCoreGlobalConfiguration.fastTimeout * 100];
+
+  NSError *error = nil;
+  XCTAssertNotNil([future awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error]);
+  XCTAssertNil(error);
+  __block NSUInteger finalEvaluations = 0;
+  dispatch_sync(self.queue, ^{
+    finalEvaluations = evaluations;
+  });
+  XCTAssertEqual(finalEvaluations, 1u);
+}
+
+- (void)testCreationPerformance
+{
+  [self measureBlock:^{
+    for (NSUInteger index = 0; index < FutureBenchmarkCount; index++) {
+      FBMutableFuture *future = FBMutableFuture.future;
+      XCTAssertEqual(future.state, FBFutureStateRunning);
+    }
+  }];
+}
+
+- (void)testResolutionPerformance
+{
+  [self measureBlock:^{
+    for (NSUInteger index = 0; index < FutureBenchmarkCount; index++) {
+      FBMutableFuture *future = FBMutableFuture.future;
+      [future resolveWithResult:@(index)];
+      XCTAssertEqual(future.state, FBFutureStateDone);
+    }
+  }];
+}
+
+- (void)testChainPerformance
+{
+  dispatch_queue_t queue = self.queue;
+  [self measureBlock:^{
+    NSMutableArray<FBFuture *> *chained = [NSMutableArray arrayWithCapacity:FutureBenchmarkCount];
+    for (NSUInteger index = 0; index < FutureBenchmarkCount; index++) {
+      FBMutableFuture *future = FBMutableFuture.future;
+      [chained addObject:[future onQueue:queue map:^(NSNumber *value) {
+        return @(value.unsignedIntegerValue + 1);
+      }]];
+      [future resolveWithResult:@(index)];
+    }
+    NSError *error = nil;
+    XCTAssertNotNil([[FBFuture futureWithFutures:chained] await:&error]);
+    XCTAssertNil(error);
+  }];
+}
+
+- (void)testFmapDepthPerformance
+{
+  dispatch_queue_t queue = self.queue;
+  [self measureBlock:^{
+    FBMutableFuture *root = FBMutableFuture.future;
+    FBFuture *future = root;
+    for (NSUInteger index = 0; index < FutureBenchmarkDepth; index++) {
+      future = [future onQueue:queue fmap:^(NSNumber *value) {
+        return [FBFuture futureWithResult:@(value.unsignedIntegerValue + 1)];
+      }];
+    }
+    [root resolveWithResult:@0];
+    NSError *error = nil;
+    XCTAssertEqualObjects([future await:&error], @(FutureBenchmarkDepth));
+    XCTAssertNil(error);
+  }];
+}
+
+- (void)testFanInPerformance
+{
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  [self measureBlock:^{
+    NSMutableArray<FBFuture *> *futures = [NSMutableArray arrayWithCapacity:FutureBenchmarkFanIn];
+    for (NSUInteger index = 0; index < FutureBenchmarkFanIn; index++) {
+      [futures addObject:[FBFuture onQueue:queue resolveValue:^(NSError **_) {
+        return @(index);
+      }]];
+    }
+    NSError *error = nil;
+    NSArray<NSNumber *> *results = [[FBFuture futureWithFutures:futures] await:&error];
+    XCTAssertNil(error);
+    XCTAssertEqual(results.count, FutureBenchmarkFanIn);
+    XCTAssertEqualObjects(results.lastObject, @(FutureBenchmarkFanIn - 1));
+  }];
+}
+
+- (void)testRaceResolvesWithFirstResultAmongConcurrentCompletions
+{
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  for (NSUInteger attempt = 0; attempt < 100; attempt++) {
+    NSMutableArray<FBFuture *> *futures = [NSMutableArray array];
+    for (NSUInteger index = 0; index < 8; index++) {
+      [futures addObject:[FBFuture onQueue:queue resolveValue:^(NSError **_) {
+        return @(index);
+      }]];
+    }
+    NSError *error = nil;
+    NSNumber *result = [[FBFuture race:futures] await:&error];
+    XCTAssertNil(error);
+    XCTAssertLessThan(result.unsignedIntegerValue, 8u);
+  }
+}
+
+- (void)testHandlerForTheExecutingQueueIsCalledInline
+{
+  FBMutableFuture<NSNumber *> *first = FBMutableFuture.future;
+  FBMutableFuture<NSNumber *> *second = FBMutableFuture.future;
+  dispatch_queue_t otherQueue = dispatch_queue_create("com.facebook.fbcontrolcore.tests.future.other", DISPATCH_QUEUE_SERIAL);
+  // The other queue does not run until it is resumed, so a handler for it can only have been called if it was called in-line.
+  dispatch_suspend(otherQueue);
+  __block BOOL sameQueueCalled = NO;
+  __block BOOL otherQueueCalled = NO;
+  [second onQueue:self.queue notifyOfCompletion:^(FBFuture *_) {
+    sameQueueCalled = YES;
+  }];
+  [second onQueue:otherQueue notifyOfCompletion:^(FBFuture *_) {
+    otherQueueCalled = YES;
+  }];
+
+  FBFuture<NSArray<NSNumber *> *> *called = [first onQueue:self.queue map:^(id _) {
+    [second resolveWithResult:@YES];
+    return @[@(sameQueueCalled), @(otherQueueCalled)];
+  }];
+  [first resolveWithResult:@YES];
+
+  NSError *error = nil;
+  XCTAssertEqualObjects([called awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error], (@[@YES, @NO]));
+  XCTAssertNil(error);
+  dispatch_resume(otherQueue);
+}
+
+- (void)testInlineHandlersAreBoundedInDepth
+{
+  NSUInteger chainLength = 64;
+  NSMutableArray<FBMutableFuture<NSNumber *> *> *futures = [NSMutableArray array];
+  for (NSUInteger index = 0; index <= chainLength; index++) {
+    [futures addObject:FBMutableFuture.future];
+  }
+  // Only accessed on the queue that all handlers are called on.
+  __block NSUInteger depth = 0;
+  __block NSUInteger maximumDepth = 0;
+  for (NSUInteger index = 0; index < chainLength; index++) {
+    FBMutableFuture<NSNumber *> *next = futures[index + 1];
+    [futures[index] onQueue:self.queue notifyOfCompletion:^(FBFuture *_) {
+      depth++;
+      maximumDepth = MAX(maximumDepth, depth);
+      [next resolveWithResult:@(index + 1)];
+      depth--;
+    }];
+  }
+  [futures.firstObject resolveWithResult:@0];
+
+  NSError *error = nil;
+  XCTAssertEqualObjects([futures.lastObject awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error], @(chainLength));
+  XCTAssertNil(error);
+  __block NSUInteger finalMaximumDepth = 0;
+  dispatch_sync(self.queue, ^{
+    finalMaximumDepth = maximumDepth;
+  });
+  // The handler that was dispatched calls at most 16 more in-line, before the next one is dispatched.
+  XCTAssertGreaterThan(finalMaximumDepth, 1u);
+  XCTAssertLessThanOrEqual(finalMaximumDepth, 17u);
+}
+
+- (void)testHandlerCalledInlineCanReenterItsFuture
+{
+  FBMutableFuture<NSNumber *> *outer = FBMutableFuture.future;
+  FBMutableFuture<NSNumber *> *inner = FBMutableFuture.future;
+  FBMutableFuture<NSNull *> *done = FBMutableFuture.future;
+  NSMutableArray<NSString *> *events = [NSMutableArray array];
+  [inner onQueue:self.queue notifyOfCompletion:^(FBFuture *future) {
+    [events addObject:@"inner"];
+    // Neither adding a handler to, nor resolving, the Future that is calling this handler may deadlock.
+    [future onQueue:self.queue notifyOfCompletion:^(FBFuture *_) {
+      [events addObject:@"nested"];
+      [done resolveWithResult:NSNull.null];
+    }];
+    [inner resolveWithResult:@NO];
+    [events addObject:@"inner-end"];
+  }];
+  [outer onQueue:self.queue notifyOfCompletion:^(FBFuture *_) {
+    [inner resolveWithResult:@YES];
+    [events addObject:@"outer-end"];
+  }];
+  [outer resolveWithResult:@YES];
+
+  NSError *error = nil;
+  XCTAssertNotNil([done awaitWithTimeout:FBControlCoreGlobalConfiguration.fastTimeout error:&error]);
+  XCTAssertNil(error);
+  __block NSArray<NSString *> *finalEvents = nil;
+  dispatch_sync(self.queue, ^{
+    finalEvents = [events copy];
+  });
+  XCTAssertEqualObjects(finalEvents.firstObject, @"inner");
+  XCTAssertEqualObjects([NSSet setWithArray:finalEvents], ([NSSet setWithArray:@[@"inner", @"nested", @"inner-end", @"outer-end"]]));
+  XCTAssertEqualObjects(inner.result, @YES);
+}
+
 #pragma mark - Helpers
 
 - (void)assertSynchronousResolutionWithBlock:(void (^)(FBMutableFuture *))resolveBlock expectedState:(FBFutureState)state expectedResult:(id)expectedResult expectedError:(NSError *)expectedError
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+#import "FBiOSTargetDouble.h"
+
+static const NSUInteger LoadBenchmarkStreamCount = 500;
+static const NSUInteger LoadBenchmarkChunksPerStream = 10;
+static const int64_t LoadBenchmarkChunkInterval = 1 * NSEC_PER_MSEC;
+// The synchronous server of the companion is capped at this many threads, a streaming call occupies one of them for its lifetime.
+static const NSInteger LoadBenchmarkSynchronousThreads = 10;
+
+static void EmitChunks(id<FBDataConsumer> consumer, NSUInteger remaining, dispatch_queue_t queue, FBMutableFuture<NSNull *> *completed)
+{
+  if (remaining == 0) {
+    [consumer consumeEndOfFile];
+    [completed resolveWithResult:NSNull.null];
+    return;
+  }
+  [consumer consumeData:[@"Oct 17 12:00:00 localhost simulated_process[1]: a line of log output\n" dataUsingEncoding:NSUTF8StringEncoding]];
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, LoadBenchmarkChunkInterval), queue, ^{
+    EmitChunks(consumer, remaining - 1, queue, completed);
+  });
+}
+
+@interface FBStreamingLoadTests_Target : FBiOSTargetDouble
+
+@end
+
+@implementation FBStreamingLoadTests_Target
+
+- (FBFuture<id<FBiOSTargetOperation>> *)tailLog:(NSArray<NSString *> *)arguments consumer:(id<FBDataConsumer>)consumer
+{
+  // Output arrives at an interval, so each stream is long-lived without occupying a thread whilst it waits.
+  FBMutableFuture<NSNull *> *completed = FBMutableFuture.future;
+  EmitChunks(consumer, LoadBenchmarkChunksPerStream, self.asyncQueue, completed);
+  return [FBFuture futureWithResult:FBiOSTargetOperationFromFuture(completed)];
+}
+
+@end
+
+@interface FBStreamingLoadTests : XCTestCase
+
+@property (nonatomic, strong, readwrite) FBStreamingLoadTests_Target *target;
+
+@end
+
+@implementation FBStreamingLoadTests
+
+- (void)setUp
+{
+  [super setUp];
+
+  self.target = [FBStreamingLoadTests_Target new];
+}
+
+- (FBFuture<NSNull *> *)openStream
+{
+  id<FBDataConsumer> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {}];
+  return [[self.target
+    tailLog:@[] consumer:consumer]
+    onQueue:self.target.asyncQueue fmap:^(id<FBiOSTargetOperation> operation) {
+      return operation.completed;
+    }];
+}
+
+- (void)reportLatencies:(NSArray<NSNumber *> *)latencies name:(NSString *)name
+{
+  XCTAssertEqual(latencies.count, LoadBenchmarkStreamCount);
+  NSArray<NSNumber *> *sorted = [latencies sortedArrayUsingSelector:@selector(compare:)];
+  double median = sorted[sorted.count / 2].doubleValue * 1000;
+  double tail = sorted[(sorted.count * 99) / 100].doubleValue * 1000;
+  double maximum = sorted.lastObject.doubleValue * 1000;
+  NSLog(@"%@: %lu concurrent streams, p50 %.1fms, p99 %.1fms, max %.1fms", name, (unsigned long) sorted.count, median, tail, maximum);
+}
+
+- (void)testStreamsCompletedFromCallbacksPerformance
+{
+  dispatch_queue_t queue = self.target.asyncQueue;
+  [self measureBlock:^{
+    NSMutableArray<NSNumber *> *latencies = [NSMutableArray arrayWithCapacity:LoadBenchmarkStreamCount];
+    NSMutableArray<FBFuture *> *streams = [NSMutableArray arrayWithCapacity:LoadBenchmarkStreamCount];
+    for (NSUInteger index = 0; index < LoadBenchmarkStreamCount; index++) {
+      CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+      [streams addObject:[[self openStream] onQueue:queue chain:^(FBFuture<NSNull *> *future) {
+        @synchronized (latencies) {
+          [latencies addObject:@(CFAbsoluteTimeGetCurrent() - start)];
+        }
+        return future;
+      }]];
+    }
+    NSError *error = nil;
+    XCTAssertNotNil([[FBFuture futureWithFutures:streams] await:&error]);
+    XCTAssertNil(error);
+    [self reportLatencies:latencies name:@"Completed from callbacks"];
+  }];
+}
+
+- (void)testStreamsBlockingBoundedThreadsPerformance
+{
+  // The baseline for testStreamsCompletedFromCallbacksPerformance, streams queue behind those that occupy every thread.
+  [self measureBlock:^{
+    NSMutableArray<NSNumber *> *latencies = [NSMutableArray arrayWithCapacity:LoadBenchmarkStreamCount];
+    NSOperationQueue *threads = [NSOperationQueue new];
+    threads.maxConcurrentOperationCount = LoadBenchmarkSynchronousThreads;
+    for (NSUInteger index = 0; index < LoadBenchmarkStreamCount; index++) {
+      CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+      [threads addOperationWithBlock:^{
+        [[self openStream] block:nil];
+        @synchronized (latencies) {
+          [latencies addObject:@(CFAbsoluteTimeGetCurrent() - start)];
+        }
+      }];
+    }
+    [threads waitUntilAllOperationsAreFinished];
+    [self reportLatencies:latencies name:@"Blocking bounded threads"];
+  }];
+}
+
+@end
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+/**
+ A consumer that drains at a fixed number of bytes per second, as a congested link would.
+ */
+@interface FBVideoStreamRateControllerTests_Link : NSObject
+
+@property (nonatomic, assign, readwrite) double bytesPerSecond;
+@property (nonatomic, assign, readwrite) double pendingBytes;
+
+@end
+
+@implementation FBVideoStreamRateControllerTests_Link
+
+- (void)consumeFrameOfSize:(double)size overInterval:(NSTimeInterval)interval
+{
+  self.pendingBytes = MAX(self.pendingBytes + size - (self.bytesPerSecond * interval), 0);
+}
+
+@end
+
+@interface FBVideoStreamRateControllerTests : XCTestCase
+
+@property (nonatomic, strong, readwrite) FBVideoStreamRateController *controller;
+@property (nonatomic, strong, readwrite) FBVideoStreamRateControllerTests_Link *link;
+@property (nonatomic, assign, readwrite) NSTimeInterval time;
+@property (nonatomic, assign, readwrite) double maximumBacklogFrames;
+
+@end
+
+@implementation FBVideoStreamRateControllerTests
+
+static NSUInteger const MaximumFramesPerSecond = 30;
+static NSUInteger const MaximumBitRate = 8000000;
+
+- (void)setUp
+{
+  [super setUp];
+
+  FBVideoStreamRate *rate = [[FBVideoStreamRate alloc] initWithFramesPerSecond:MaximumFramesPerSecond scaleFactor:1 averageBitRate:MaximumBitRate];
+  self.controller = [FBVideoStreamRateController controllerWithMaximumRate:rate];
+  self.link = [FBVideoStreamRateControllerTests_Link new];
+  self.time = 0;
+}
+
+- (void)streamForInterval:(NSTimeInterval)interval linkFraction:(double)linkFraction
+{
+  // Frames are produced at the rate chosen by the controller, the link drains at a fraction of the maximum bit rate.
+  self.link.bytesPerSecond = linkFraction * MaximumBitRate / 8;
+  self.maximumBacklogFrames = 0;
+  NSTimeInterval end = self.time + interval;
+  while (self.time < end) {
+    FBVideoStreamRate *rate = self.controller.rate;
+    NSTimeInterval frameInterval = 1.0 / rate.framesPerSecond;
+    double frameSize = rate.averageBitRate / 8.0 / rate.framesPerSecond;
+    [self.link consumeFrameOfSize:frameSize overInterval:frameInterval];
+    self.time += frameInterval;
+    [self.controller samplePendingFrames:0 pendingBytes:(NSUInteger) self.link.pendingBytes atTime:self.time];
+    self.maximumBacklogFrames = MAX(self.maximumBacklogFrames, self.link.pendingBytes / frameSize);
+  }
+}
+
+- (void)testRemainsAtMaximumRateWithFastLink
+{
+  [self streamForInterval:30 linkFraction:2];
+
+  XCTAssertEqual(self.controller.level, 0u);
+  XCTAssertEqualObjects(self.controller.rate, [[FBVideoStreamRate alloc] initWithFramesPerSecond:MaximumFramesPerSecond scaleFactor:1 averageBitRate:MaximumBitRate]);
+  XCTAssertEqual(self.maximumBacklogFrames, 0);
+}
+
+- (void)testStepsDownWithSlowLink
+{
+  [self streamForInterval:40 linkFraction:0.3];
+
+  XCTAssertGreaterThanOrEqual(self.controller.level, 3u);
+  XCTAssertLessThan(self.controller.rate.framesPerSecond, MaximumFramesPerSecond);
+  XCTAssertLessThan(self.controller.rate.scaleFactor, 1);
+  XCTAssertLessThanOrEqual(self.controller.rate.averageBitRate, MaximumBitRate * 0.3);
+
+  // Once adapted, the backlog stays bounded instead of growing with time.
+  [self streamForInterval:20 linkFraction:0.3];
+  XCTAssertLessThan(self.maximumBacklogFrames, 15);
+}
+
+- (void)testStepsBackUpWhenLinkRecovers
+{
+  [self streamForInterval:30 linkFraction:0.3];
+  XCTAssertGreaterThan(self.controller.level, 0u);
+
+  [self streamForInterval:60 linkFraction:2];
+  XCTAssertEqual(self.controller.level, 0u);
+  XCTAssertEqual(self.controller.rate.framesPerSecond, MaximumFramesPerSecond);
+}
+
+- (void)testPendingFramesCountTowardsBacklog
+{
+  XCTAssertFalse([self.controller samplePendingFrames:5 pendingBytes:0 atTime:0]);
+  XCTAssertFalse([self.controller samplePendingFrames:5 pendingBytes:0 atTime:0.25]);
+  XCTAssertTrue([self.controller samplePendingFrames:5 pendingBytes:0 atTime:0.5]);
+  XCTAssertEqual(self.controller.level, 1u);
+
+  // A backlog between clear and congested holds the current level.
+  XCTAssertFalse([self.controller samplePendingFrames:2 pendingBytes:0 atTime:10]);
+  XCTAssertFalse([self.controller samplePendingFrames:2 pendingBytes:0 atTime:20]);
+  XCTAssertEqual(self.controller.level, 1u);
+}
+
+@end
@@ -30,7 +30,8 @@
 + (instancetype)commandsWithTarget:(FBDevice *)target
 {
   NSString *storeDirectory = [target.auxillaryDirectory stringByAppendingPathComponent:@"crash_store"];
-  FBCrashLogStore *store = [FBCrashLogStore storeForDirectories:@[storeDirectory] logger:target.logger];
+  NSString *indexPath = [target.auxillaryDirectory stringByAppendingPathComponent:@"crash_store_index.plist"];
+  FBCrashLogStore *store = [FBCrashLogStore storeForDirectories:@[storeDirectory] indexPath:indexPath logger:target.logger];
   return [[self alloc] initWithDevice:target store:store];
 }
 
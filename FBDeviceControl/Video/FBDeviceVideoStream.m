@@ -190,6 +190,11 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
   }
   [self.startFuture resolveWithResult:NSNull.null];
   [self consumeSampleBuffer:sampleBuffer];
+  // Each sample buffer is a single frame, so consumers that queue frames can delimit them.
+  id<FBDataConsumer> consumer = self.consumer;
+  if ([consumer conformsToProtocol:@protocol(FBDataConsumerFrameDelimited)]) {
+    [(id<FBDataConsumerFrameDelimited>) consumer consumeEndOfFrame];
+  }
 }
 
 - (void)captureOutput:(AVCaptureOutput *)captureOutput didDropSampleBuffer:(CMSampleBufferRef)sampleBuffer fromConnection:(AVCaptureConnection *)connection
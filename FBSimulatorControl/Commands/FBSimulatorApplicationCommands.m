@@ -15,13 +15,17 @@
 #import "FBSimulator.h"
 #import "FBSimulatorApplicationLaunchStrategy.h"
 #import "FBSimulatorError.h"
+#import "FBSimulatorInstalledApplicationCatalogue.h"
 #import "FBSimulatorLaunchCtlCommands.h"
 #import "FBSimulatorLaunchedApplication.h"
+#import "FBSimulatorRunningApplicationTable.h"
 #import "FBSimulatorSubprocessTerminationStrategy.h"
 
 @interface FBSimulatorApplicationCommands ()
 
 @property (nonatomic, weak, readonly) FBSimulator *simulator;
+@property (nonatomic, strong, readonly) FBSimulatorRunningApplicationTable *runningApplicationTable;
+@property (nonatomic, strong, readonly) FBSimulatorInstalledApplicationCatalogue *installedApplicationCatalogue;
 
 @end
 
@@ -40,6 +44,8 @@
   }
 
   _simulator = simulator;
+  _runningApplicationTable = [FBSimulatorRunningApplicationTable tableWithSimulator:simulator];
+  _installedApplicationCatalogue = [FBSimulatorInstalledApplicationCatalogue catalogueWithSimulator:simulator];
 
   return self;
 }
@@ -63,9 +69,13 @@
 
 - (FBFuture<FBSimulatorLaunchedApplication *> *)launchApplication:(FBApplicationLaunchConfiguration *)configuration
 {
-  return [[FBSimulatorApplicationLaunchStrategy
+  FBSimulatorRunningApplicationTable *runningApplicationTable = self.runningApplicationTable;
+  return [[[FBSimulatorApplicationLaunchStrategy
     strategyWithSimulator:self.simulator]
-    launchApplication:configuration];
+    launchApplication:configuration]
+    onQueue:self.simulator.workQueue doOnResolved:^(FBSimulatorLaunchedApplication *application) {
+      [runningApplicationTable recordLaunchedApplication:configuration.bundleID processIdentifier:application.processIdentifier];
+    }];
 }
 
 - (FBFuture<NSNull *> *)killApplicationWithBundleID:(NSString *)bundleID
@@ -78,28 +88,15 @@
 
 - (FBFuture<NSArray<FBInstalledApplication *> *> *)installedApplications
 {
-  return [[FBFuture
-    resolveValue:^ NSDictionary<NSString *, id> * (NSError **error) {
-      return [self.simulator.device installedAppsWithError:error];
-    }]
-    onQueue:self.simulator.asyncQueue map:^(NSDictionary<NSString *, id> *installedApps) {
-      NSMutableArray<FBInstalledApplication *> *applications = [NSMutableArray array];
-      for (NSDictionary *appInfo in installedApps.allValues) {
-        FBInstalledApplication *application = [FBSimulatorApplicationCommands installedApplicationFromInfo:appInfo error:nil];
-        if (!application) {
-          continue;
-        }
-        [applications addObject:application];
-      }
-      return applications;
-    }];
+  return [self.installedApplicationCatalogue installedApplications];
 }
 
 - (FBFuture<NSNull *> *)uninstallApplicationWithBundleID:(NSString *)bundleID
 {
   NSParameterAssert(bundleID);
 
-  return [[[[self.simulator
+  FBSimulatorInstalledApplicationCatalogue *installedApplicationCatalogue = self.installedApplicationCatalogue;
+  return [[[[[self.simulator
     installedApplicationWithBundleID:bundleID]
     onQueue:self.simulator.asyncQueue fmap:^FBFuture *(FBInstalledApplication *installedApplication) {
       if (installedApplication.installType == FBApplicationInstallTypeSystem) {
@@ -121,111 +118,35 @@
           failFuture];
       }
       return FBFuture.empty;
+    }]
+    onQueue:self.simulator.workQueue chain:^(FBFuture *future) {
+      // Invalidated before the returned future resolves, so that a lookup chained upon it sees the change.
+      [installedApplicationCatalogue invalidate];
+      return future;
     }];
 }
 
 - (FBFuture<FBInstalledApplication *> *)installedApplicationWithBundleID:(NSString *)bundleID
 {
-  return [[self
-    confirmApplicationIsInstalled:bundleID]
-    onQueue:self.simulator.workQueue fmap:^ FBFuture<FBInstalledApplication *> * (id _) {
-      // appInfo is usually always returned, even if there is no app installed.
-      NSError *error = nil;
-      NSDictionary<NSString *, id> *appInfo = [self.simulator.device propertiesOfApplication:bundleID error:&error];
-      if (!appInfo) {
-        return [FBFuture futureWithError:error];
-      }
-      // Therefore we have to parse the app info to see that it is actually a real app.
-      FBInstalledApplication *application = [FBSimulatorApplicationCommands installedApplicationFromInfo:appInfo error:&error];
-      if (!application) {
-        return [[FBSimulatorError
-          describeFormat:@"Application Info %@ could not be parsed (it's probably not installed): %@", [FBCollectionInformation oneLineDescriptionFromDictionary:appInfo], error]
-          failFuture];
-      }
-      return [FBFuture futureWithResult:application];
-    }];
+  return [self.installedApplicationCatalogue installedApplicationWithBundleID:bundleID];
 }
 
 - (FBFuture<NSDictionary<NSString *, NSNumber *> *> *)runningApplications
 {
-  return [[self.simulator
-    serviceNamesAndProcessIdentifiersForSubstring:@"UIKitApplication"]
-    onQueue:self.simulator.asyncQueue map:^(NSDictionary<NSString *, NSNumber *> *serviceNameToProcessIdentifier) {
-      NSMutableDictionary<NSString *, NSNumber *> *mapping = [NSMutableDictionary dictionary];
-      for (NSString *serviceName in serviceNameToProcessIdentifier.allKeys) {
-        NSString *bundleName = [FBSimulatorLaunchCtlCommands extractApplicationBundleIdentifierFromServiceName:serviceName];
-        if (!bundleName) {
-          continue;
-        }
-        mapping[bundleName] = serviceNameToProcessIdentifier[serviceName];
-      }
-      return mapping;
-    }];
+  return [self.runningApplicationTable runningApplications];
 }
 
 - (FBFuture<NSNumber *> *)processIDWithBundleID:(NSString *)bundleID
 {
-  return [[FBFuture
-    onQueue:self.simulator.workQueue resolve:^{
-      NSString *serviceName = [NSString stringWithFormat:@"UIKitApplication:%@", bundleID];
-      return [self.simulator serviceNameAndProcessIdentifierForSubstring:serviceName];
-    }]
-    onQueue:self.simulator.workQueue map:^(NSArray<id> *result) {
-      return result[1];
-    }];
+  return [self.runningApplicationTable processIdentifierForBundleID:bundleID];
 }
 
 #pragma mark Private
 
-static NSString *const KeyDataContainer = @"DataContainer";
-
-+ (FBInstalledApplication *)installedApplicationFromInfo:(NSDictionary<NSString *, id> *)appInfo error:(NSError **)error
-{
-  NSString *appName = appInfo[FBApplicationInstallInfoKeyBundleName];
-  if (![appName isKindOfClass:NSString.class]) {
-    return [[FBControlCoreError
-      describeFormat:@"Bundle Name %@ is not a String for %@ in %@", appName, FBApplicationInstallInfoKeyBundleName, appInfo]
-      fail:error];
-  }
-  NSString *bundleIdentifier = appInfo[FBApplicationInstallInfoKeyBundleIdentifier];
-  if (![bundleIdentifier isKindOfClass:NSString.class]) {
-    return [[FBControlCoreError
-      describeFormat:@"Bundle Identifier %@ is not a String for %@ in %@", bundleIdentifier, FBApplicationInstallInfoKeyBundleIdentifier, appInfo]
-      fail:error];
-  }
-  NSString *appPath = appInfo[FBApplicationInstallInfoKeyPath];
-  if (![appPath isKindOfClass:NSString.class]) {
-    return [[FBControlCoreError
-      describeFormat:@"App Path %@ is not a String for %@ in %@", appPath, FBApplicationInstallInfoKeyPath, appInfo]
-      fail:error];
-  }
-  NSString *typeString = appInfo[FBApplicationInstallInfoKeyApplicationType];
-  if (![typeString isKindOfClass:NSString.class]) {
-    return [[FBControlCoreError
-      describeFormat:@"Install Type %@ is not a String for %@ in %@", typeString, FBApplicationInstallInfoKeyApplicationType, appInfo]
-      fail:error];
-  }
-  NSURL *dataContainer = appInfo[KeyDataContainer];
-  if (dataContainer && ![dataContainer isKindOfClass:NSURL.class]) {
-    return [[FBControlCoreError
-      describeFormat:@"Data Container %@ is not a NSURL for %@ in %@", dataContainer, KeyDataContainer, appInfo]
-      fail:error];
-  }
-
-  FBBundleDescriptor *bundle = [FBBundleDescriptor bundleFromPath:appPath error:error];
-  if (!bundle) {
-    return nil;
-  }
-
-  return [FBInstalledApplication
-    installedApplicationWithBundle:bundle
-    installType:[FBInstalledApplication installTypeFromString:typeString signerIdentity:nil]
-    dataContainer:dataContainer.path];
-}
-
 - (FBFuture<NSNull *> *)installExtractedApplicationWithPath:(NSString *)path
 {
-  return [[self
+  FBSimulatorInstalledApplicationCatalogue *installedApplicationCatalogue = self.installedApplicationCatalogue;
+  return [[[self
     confirmCompatibilityOfApplicationAtPath:path]
     onQueue:self.simulator.workQueue fmap:^FBFuture *(FBBundleDescriptor *application) {
       NSDictionary *options = @{
@@ -254,6 +175,11 @@ static NSString *const KeyDataContainer = @"DataContainer";
         describeFormat:@"Failed to install Application %@ with options %@", application, options]
         causedBy:error]
         failFuture];
+    }]
+    onQueue:self.simulator.workQueue chain:^(FBFuture *future) {
+      // Invalidated before the returned future resolves, so that a lookup chained upon it sees the change.
+      [installedApplicationCatalogue invalidate];
+      return future;
     }];
 }
 
@@ -292,18 +218,4 @@ static NSString *const KeyDataContainer = @"DataContainer";
     }];
 }
 
-- (FBFuture<NSNull *> *)confirmApplicationIsInstalled:(NSString *)bundleID
-{
-  return [[self
-    isApplicationInstalledWithBundleID:bundleID]
-    onQueue:self.simulator.workQueue fmap:^ FBFuture<NSNull *> * (NSNumber *installed) {
-      if (installed.boolValue == NO) {
-        return [[FBSimulatorError
-          describeFormat:@"%@ is not installed", bundleID]
-          failFuture];
-      }
-      return FBFuture.empty;
-    }];
-}
-
 @end
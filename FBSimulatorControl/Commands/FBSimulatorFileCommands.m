@@ -167,6 +167,15 @@
     }];
 }
 
+- (FBFuture<NSString *> *)hostPathOfItemInContainer:(NSString *)containerPath
+{
+  return [[self
+    dataContainer]
+    onQueue:self.queue map:^(NSString *dataContainer) {
+      return [dataContainer stringByAppendingPathComponent:containerPath];
+    }];
+}
+
 - (FBFuture<NSString *> *)dataContainer
 {
   return [FBFuture futureWithResult:self.containerPath];
@@ -107,6 +107,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable NSString *)extractApplicationBundleIdentifierFromServiceName:(NSString *)serviceName;
 
+/**
+ Parses the output of `launchctl list` into a Mapping of Service Name to Process Identifier.
+ Services that do not have a Process Identifier are mapped to -1.
+
+ @param output the output of `launchctl list`.
+ @param substring if provided, only lines containing the substring are parsed. Otherwise all lines after the header are parsed.
+ @param error an error out for any error that occurs.
+ @return a Mapping of Service Name to Process Identifier, or nil if a line could not be parsed.
+ */
++ (nullable NSDictionary<NSString *, NSNumber *> *)servicesFromListOutput:(NSString *)output matchingSubstring:(nullable NSString *)substring error:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
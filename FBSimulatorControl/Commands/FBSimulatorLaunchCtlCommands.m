@@ -16,6 +16,61 @@
 #import "FBSimulatorProcessFetcher.h"
 #import "FBSimulatorProcessLaunchStrategy.h"
 
+static NSString *const ApplicationServicePrefix = @"UIKitApplication:";
+
+static inline BOOL FBIsListSeparator(char character)
+{
+  return character == ' ' || character == '\t';
+}
+
+/**
+ Parses a line of `launchctl list`, which has three whitespace-separated words: a process identifier or '-', a status and a service name.
+ */
+static BOOL FBParseListLine(const char *line, size_t length, pid_t *processIdentifierOut, NSRange *serviceNameRangeOut)
+{
+  NSRange words[3];
+  NSUInteger count = 0;
+  size_t index = 0;
+  while (index < length) {
+    while (index < length && FBIsListSeparator(line[index])) {
+      index++;
+    }
+    if (index == length) {
+      break;
+    }
+    size_t start = index;
+    while (index < length && !FBIsListSeparator(line[index])) {
+      index++;
+    }
+    if (count == 3) {
+      return NO;
+    }
+    words[count++] = NSMakeRange(start, index - start);
+  }
+  if (count != 3) {
+    return NO;
+  }
+  const char *processIdentifierWord = line + words[0].location;
+  if (words[0].length == 1 && processIdentifierWord[0] == '-') {
+    *processIdentifierOut = -1;
+  } else {
+    long long processIdentifier = 0;
+    for (NSUInteger offset = 0; offset < words[0].length; offset++) {
+      char character = processIdentifierWord[offset];
+      if (character < '0' || character > '9' || processIdentifier > INT_MAX) {
+        return NO;
+      }
+      processIdentifier = processIdentifier * 10 + (character - '0');
+    }
+    if (processIdentifier < 1 || processIdentifier > INT_MAX) {
+      return NO;
+    }
+    *processIdentifierOut = (pid_t) processIdentifier;
+  }
+  *serviceNameRangeOut = words[2];
+  return YES;
+}
+
 @interface FBSimulatorLaunchCtlCommands ()
 
 @property (nonatomic, strong, readonly) FBSimulator *simulator;
@@ -89,19 +144,10 @@
   return [[self
     runWithArguments:@[@"list"]]
     onQueue:self.simulator.asyncQueue fmap:^(NSString *text) {
-      NSArray<NSString *> *lines = [text componentsSeparatedByCharactersInSet:NSCharacterSet.newlineCharacterSet];
-      NSMutableDictionary<NSString *, NSNumber *> *mapping = [NSMutableDictionary dictionary];
-      for (NSString *line in lines) {
-        if (![line containsString:substring]) {
-          continue;
-        }
-        NSError *error = nil;
-        pid_t processIdentifier = 0;
-        NSString *serviceName = [FBSimulatorLaunchCtlCommands extractServiceNameFromListLine:line processIdentifierOut:&processIdentifier error:&error];
-        if (!serviceName) {
-          return [FBControlCoreError failFutureWithError:error];
-        }
-        mapping[serviceName] = @(processIdentifier);
+      NSError *error = nil;
+      NSDictionary<NSString *, NSNumber *> *mapping = [FBSimulatorLaunchCtlCommands servicesFromListOutput:text matchingSubstring:substring error:&error];
+      if (!mapping) {
+        return [FBControlCoreError failFutureWithError:error];
       }
       return [FBFuture futureWithResult:mapping];
     }];
@@ -142,26 +188,15 @@
   return [[self
     runWithArguments:@[@"list"]]
     onQueue:self.simulator.asyncQueue fmap:^(NSString *text) {
-      NSArray<NSString *> *lines = [text componentsSeparatedByCharactersInSet:NSCharacterSet.newlineCharacterSet];
-      if (lines.count < 2) {
-        return [[FBSimulatorError
-          describeFormat:@"Insufficient number of lines from output '%@'", text]
-          failFuture];
+      NSError *error = nil;
+      NSDictionary<NSString *, NSNumber *> *mapping = [FBSimulatorLaunchCtlCommands servicesFromListOutput:text matchingSubstring:nil error:&error];
+      if (!mapping) {
+        return [FBSimulatorError failFutureWithError:error];
       }
-      lines = [lines subarrayWithRange:NSMakeRange(1, lines.count -1)];
-
-      NSMutableDictionary<NSString *, id> *services = [NSMutableDictionary dictionary];
-      for (NSString *line in lines) {
-        if (line.length == 0) {
-          continue;
-        }
-        pid_t processIdentifier = -1;
-        NSError *error = nil;
-        NSString *serviceName = [FBSimulatorLaunchCtlCommands extractServiceNameFromListLine:line processIdentifierOut:&processIdentifier error:&error];
-        if (!serviceName) {
-          return [FBSimulatorError failFutureWithError:error];
-        }
-        services[serviceName] = processIdentifier > 0 ? @(processIdentifier) : NSNull.null;
+      NSMutableDictionary<NSString *, id> *services = [NSMutableDictionary dictionaryWithCapacity:mapping.count];
+      for (NSString *serviceName in mapping) {
+        NSNumber *processIdentifier = mapping[serviceName];
+        services[serviceName] = processIdentifier.intValue > 0 ? processIdentifier : NSNull.null;
       }
       return [FBFuture futureWithResult:[services copy]];
     }];
@@ -187,59 +222,69 @@
 
 + (nullable NSString *)extractApplicationBundleIdentifierFromServiceName:(NSString *)serviceName
 {
-  NSRegularExpression *regex = self.regularExpressionForServiceNameToBundleID;
-  NSTextCheckingResult *result = [regex firstMatchInString:serviceName options:0 range:NSMakeRange(0, serviceName.length)];
-  if (!result) {
+  // Application services are named like 'UIKitApplication:com.example.app[0x1234][rb-legacy]'.
+  NSRange prefix = [serviceName rangeOfString:ApplicationServicePrefix];
+  if (prefix.location == NSNotFound) {
     return nil;
   }
-  NSRange range = [result rangeAtIndex:1];
-  return [serviceName substringWithRange:range];
+  NSUInteger start = NSMaxRange(prefix);
+  NSRange suffix = [serviceName rangeOfString:@"[" options:NSLiteralSearch range:NSMakeRange(start, serviceName.length - start)];
+  NSUInteger end = suffix.location == NSNotFound ? serviceName.length : suffix.location;
+  return [serviceName substringWithRange:NSMakeRange(start, end - start)];
 }
 
-#pragma mark Private
-
-+ (NSRegularExpression *)regularExpressionForServiceNameToBundleID
++ (nullable NSDictionary<NSString *, NSNumber *> *)servicesFromListOutput:(NSString *)output matchingSubstring:(nullable NSString *)substring error:(NSError **)error
 {
-  static dispatch_once_t onceToken;
-  static NSRegularExpression *regex;
-  dispatch_once(&onceToken, ^{
-    NSError *error = nil;
-    regex = [NSRegularExpression regularExpressionWithPattern:@"UIKitApplication:([^\\[]*).*" options:NSRegularExpressionDotMatchesLineSeparators error:&error];
-    NSCAssert(regex, @"Should be able to compile regex %@", error);
-  });
-  return regex;
-}
-
-+ (NSString *)extractServiceNameFromListLine:(NSString *)line processIdentifierOut:(pid_t *)processIdentifierOut error:(NSError **)error
-{
-  NSArray<NSString *> *words = [line componentsSeparatedByCharactersInSet:NSCharacterSet.whitespaceCharacterSet];
-  if (words.count != 3) {
-    return [[FBSimulatorError
-      describeFormat:@"Output does not have exactly three words: %@", [FBCollectionInformation oneLineDescriptionFromArray:words]]
-      fail:error];
-  }
-  NSString *serviceName = [words lastObject];
-  NSString *processIdentifierString = [words firstObject];
-  if ([processIdentifierString isEqualToString:@"-"]) {
-    if (processIdentifierOut) {
-      *processIdentifierOut = -1;
+  // The output is scanned as bytes, only creating strings for the names of the services that match.
+  NSData *data = [output dataUsingEncoding:NSUTF8StringEncoding];
+  const char *bytes = data.bytes;
+  const char *end = bytes + data.length;
+  const char *needle = substring.UTF8String;
+  size_t needleLength = needle ? strlen(needle) : 0;
+  NSMutableDictionary<NSString *, NSNumber *> *services = [NSMutableDictionary dictionary];
+  BOOL isHeader = YES;
+
+  for (const char *line = bytes; line < end; ) {
+    const char *lineEnd = (const char *) FBLineScannerFindByte((const uint8_t *) line, (size_t) (end - line), '\n') ?: end;
+    size_t lineLength = (size_t) (lineEnd - line);
+    const char *current = line;
+    line = lineEnd + 1;
+
+    // Without a substring the first line is the header, which is skipped.
+    if (!needle && isHeader) {
+      isHeader = NO;
+      continue;
     }
-    return serviceName;
+    if (lineLength == 0) {
+      continue;
+    }
+    if (needle && !memmem(current, lineLength, needle, needleLength)) {
+      continue;
+    }
+    pid_t processIdentifier = -1;
+    NSRange serviceNameRange = NSMakeRange(NSNotFound, 0);
+    if (!FBParseListLine(current, lineLength, &processIdentifier, &serviceNameRange)) {
+      NSString *lineString = [[NSString alloc] initWithBytes:current length:lineLength encoding:NSUTF8StringEncoding];
+      return [[FBSimulatorError
+        describeFormat:@"Line is not a process identifier, status and service name: %@", lineString]
+        fail:error];
+    }
+    NSString *serviceName = [[NSString alloc] initWithBytes:current + serviceNameRange.location length:serviceNameRange.length encoding:NSUTF8StringEncoding];
+    if (!serviceName) {
+      continue;
+    }
+    services[serviceName] = @(processIdentifier);
   }
-
-  NSInteger processIdentifierInteger = [processIdentifierString integerValue];
-  if (processIdentifierInteger < 1) {
+  if (!needle && isHeader) {
     return [[FBSimulatorError
-      describeFormat:@"Expected a process identifier as first word, but got %@ from %@", processIdentifierString, [FBCollectionInformation oneLineDescriptionFromArray:words]]
+      describeFormat:@"Insufficient number of lines from output '%@'", output]
       fail:error];
   }
-  if (processIdentifierOut) {
-    *processIdentifierOut = (pid_t) processIdentifierInteger;
-  }
-
-  return serviceName;
+  return [services copy];
 }
 
+#pragma mark Private
+
 - (FBFuture<NSString *> *)runWithArguments:(NSArray<NSString *> *)arguments
 {
   // Construct a Launch Configuration for launchctl we'll use the 'list' command.
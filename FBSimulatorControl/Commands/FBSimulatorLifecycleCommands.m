@@ -20,6 +20,7 @@
 #import "FBSimulatorControl.h"
 #import "FBSimulatorControlConfiguration.h"
 #import "FBSimulatorError.h"
+#import "FBSimulatorSet+Private.h"
 #import "FBSimulatorSubprocessTerminationStrategy.h"
 #import "FBSimulatorTerminationStrategy.h"
 
@@ -92,9 +93,9 @@
 - (FBFuture<NSNull *> *)resolveState:(FBiOSTargetState)state
 {
   FBSimulator *simulator = self.simulator;
-  return [[FBFuture onQueue:simulator.workQueue resolveWhen:^ BOOL {
+  return [FBFuture onQueue:simulator.workQueue resolveWhen:^ BOOL {
     return simulator.state == state;
-  }] mapReplace:NSNull.null];
+  } signalledBy:simulator.set.devicesChanged];
 }
 
 #pragma mark Focus
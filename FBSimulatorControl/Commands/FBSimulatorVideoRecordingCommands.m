@@ -14,13 +14,17 @@
 #import "FBSimulatorError.h"
 #import "FBSimulatorSet.h"
 #import "FBFramebuffer.h"
+#import "FBSimulatorSharedVideoStream.h"
 #import "FBSimulatorVideo.h"
 #import "FBSimulatorVideoStream.h"
 
+static NSUInteger const FBSimulatorSharedVideoStreamMaximumQueuedFrames = 8;
+
 @interface FBSimulatorVideoRecordingCommands ()
 
 @property (nonatomic, weak, readonly) FBSimulator *simulator;
 @property (nonatomic, strong, nullable, readwrite) FBSimulatorVideo *video;
+@property (nonatomic, strong, readonly) NSMutableDictionary<FBVideoStreamConfiguration *, FBSimulatorSharedVideoStream *> *sharedStreams;
 
 @end
 
@@ -39,6 +43,7 @@
   }
 
   _simulator = simulator;
+  _sharedStreams = [NSMutableDictionary dictionary];
 
   return self;
 }
@@ -80,13 +85,31 @@
 
 #pragma mark FBSimulatorStreamingCommands
 
-- (FBFuture<FBSimulatorVideoStream *> *)createStreamWithConfiguration:(FBVideoStreamConfiguration *)configuration
+- (FBFuture<id<FBVideoStream>> *)createStreamWithConfiguration:(FBVideoStreamConfiguration *)configuration
 {
   id<FBControlCoreLogger> logger = self.simulator.logger;
   return [[self.simulator
     connectToFramebuffer]
-    onQueue:self.simulator.workQueue map:^ FBSimulatorVideoStream * (FBFramebuffer *framebuffer) {
-      return [FBSimulatorVideoStream streamWithFramebuffer:framebuffer configuration:configuration logger:logger];
+    onQueue:self.simulator.workQueue map:^ id<FBVideoStream> (FBFramebuffer *framebuffer) {
+      if (![FBSimulatorSharedVideoStream canShareStreamWithConfiguration:configuration]) {
+        return [FBSimulatorVideoStream streamWithFramebuffer:framebuffer configuration:configuration logger:logger];
+      }
+      // Streams of the same configuration share a single encoder, a new one is created once the previous one has stopped.
+      id<FBVideoStream> subscriber = [self.sharedStreams[configuration] subscribe];
+      if (subscriber) {
+        [logger logFormat:@"Sharing existing stream for %@", configuration];
+        return subscriber;
+      }
+      FBSimulatorVideoStream *stream = [FBSimulatorVideoStream streamWithFramebuffer:framebuffer configuration:configuration logger:logger];
+      FBSimulatorSharedVideoStream *sharedStream = [FBSimulatorSharedVideoStream sharedStreamWithStream:stream encoding:configuration.encoding maximumQueuedFrames:FBSimulatorSharedVideoStreamMaximumQueuedFrames logger:logger];
+      self.sharedStreams[configuration] = sharedStream;
+      // The entry is removed once the shared stream stops, unless it has already been replaced.
+      [sharedStream.stopped onQueue:self.simulator.workQueue notifyOfCompletion:^(FBFuture *_) {
+        if (self.sharedStreams[configuration] == sharedStream) {
+          [self.sharedStreams removeObjectForKey:configuration];
+        }
+      }];
+      return [sharedStream subscribe];
     }];
 }
 
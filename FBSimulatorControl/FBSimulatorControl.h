@@ -27,6 +27,7 @@
 #import <FBSimulatorControl/FBSimulatorFileCommands.h>
 #import <FBSimulatorControl/FBSimulatorHID.h>
 #import <FBSimulatorControl/FBSimulatorHIDEvent.h>
+#import <FBSimulatorControl/FBSimulatorHIDSchedule.h>
 #import <FBSimulatorControl/FBSimulatorImage.h>
 #import <FBSimulatorControl/FBSimulatorIndigoHID.h>
 #import <FBSimulatorControl/FBSimulatorLaunchCtlCommands.h>
@@ -35,13 +36,16 @@
 #import <FBSimulatorControl/FBSimulatorPredicates.h>
 #import <FBSimulatorControl/FBSimulatorProcessFetcher.h>
 #import <FBSimulatorControl/FBSimulatorProcessSpawnCommands.h>
+#import <FBSimulatorControl/FBSimulatorRunningApplicationTable.h>
 #import <FBSimulatorControl/FBSimulatorScreenshotCommands.h>
 #import <FBSimulatorControl/FBSimulatorServiceContext.h>
 #import <FBSimulatorControl/FBSimulatorSet+Private.h>
 #import <FBSimulatorControl/FBSimulatorSet.h>
 #import <FBSimulatorControl/FBSimulatorSettingsCommands.h>
+#import <FBSimulatorControl/FBSimulatorSharedVideoStream.h>
 #import <FBSimulatorControl/FBSimulatorVideo.h>
 #import <FBSimulatorControl/FBSimulatorVideoRecordingCommands.h>
 #import <FBSimulatorControl/FBSimulatorVideoStream.h>
+#import <FBSimulatorControl/FBSimulatorVideoStreamDamage.h>
 #import <FBSimulatorControl/FBSimulatorXCTestCommands.h>
 #import <FBSimulatorControl/FBSurfaceImageGenerator.h>
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@protocol FBControlCoreLogger;
+
+/**
+ Shares a single Video Stream between many subscribers, so that each frame is encoded once regardless of the number of consumers.
+ Frames are delivered to each subscriber through its own FBBoundedFrameDataConsumer, a subscriber that falls behind has frames dropped, or coalesced for tiled encodings, once its queue is full.
+ The backlog reported to the underlying stream is that of the subscriber that is furthest behind, so that an adaptive stream slows down for it.
+ The underlying stream is started with the first subscriber and stopped when the last started subscriber stops, after which no more subscribers can be added.
+ */
+@interface FBSimulatorSharedVideoStream : NSObject
+
+#pragma mark Initializers
+
+/**
+ Constructs a Shared Video Stream.
+
+ @param stream the stream to share. The stream must delimit frames to its consumer with FBDataConsumerFrameDelimited.
+ @param encoding the encoding of the stream, this determines which frames can be dropped.
+ @param maximumQueuedFrames the maximum number of frames that may be queued for a subscriber.
+ @param logger the logger to log to.
+ @return a new Shared Video Stream.
+ */
++ (instancetype)sharedStreamWithStream:(id<FBVideoStream>)stream encoding:(FBVideoStreamEncoding)encoding maximumQueuedFrames:(NSUInteger)maximumQueuedFrames logger:(id<FBControlCoreLogger>)logger;
+
+/**
+ Returns YES if a stream with the provided configuration can be shared.
+ Encodings that depend on frames that a late subscriber will not have seen, such as the Minicap header or tiled deltas, cannot be shared.
+
+ @param configuration the configuration of the stream.
+ @return YES if the stream can be shared, NO otherwise.
+ */
++ (BOOL)canShareStreamWithConfiguration:(FBVideoStreamConfiguration *)configuration;
+
+#pragma mark Public Methods
+
+/**
+ Creates a new subscriber to the stream.
+ The returned stream receives frames once it has been started.
+
+ @return a new subscriber, or nil if the underlying stream has stopped.
+ */
+- (nullable id<FBVideoStream>)subscribe;
+
+#pragma mark Properties
+
+/**
+ The number of subscribers that have started and not yet stopped.
+ A subscriber that has been created but not started does not keep the underlying stream alive.
+ */
+@property (nonatomic, assign, readonly) NSUInteger subscriberCount;
+
+/**
+ Resolves once the underlying stream has stopped, either when the last subscriber stops or when the underlying stream fails to start.
+ */
+@property (nonatomic, strong, readonly) FBFuture<NSNull *> *stopped;
+
+/**
+ The number of frames that have been produced by the underlying stream.
+ */
+@property (nonatomic, assign, readonly) NSUInteger framesEncoded;
+
+/**
+ The number of encodes that have been saved, by delivering a frame to more than one subscriber.
+ */
+@property (nonatomic, assign, readonly) NSUInteger encodesSaved;
+
+/**
+ The number of frames that have been dropped across all subscribers.
+ */
+@property (nonatomic, assign, readonly) NSUInteger framesDropped;
+
+@end
+
+NS_ASSUME_NONNULL_END
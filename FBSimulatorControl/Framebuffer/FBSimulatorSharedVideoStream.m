@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBSimulatorSharedVideoStream.h"
+
+#import "FBSimulatorError.h"
+
+@class FBSimulatorSharedVideoStream_Subscriber;
+
+@interface FBSimulatorSharedVideoStream () <FBDataConsumer, FBDataConsumerStackConsuming, FBDataConsumerFrameDelimited, FBDataConsumerBacklog>
+
+@property (nonatomic, strong, readonly) id<FBVideoStream> stream;
+@property (nonatomic, copy, readonly) FBVideoStreamEncoding encoding;
+@property (nonatomic, assign, readonly) NSUInteger maximumQueuedFrames;
+@property (nonatomic, strong, readonly) id<FBControlCoreLogger> logger;
+@property (nonatomic, strong, readonly) NSMutableArray<FBSimulatorSharedVideoStream_Subscriber *> *activeSubscribers;
+@property (nonatomic, strong, readwrite) NSMutableData *currentFrame;
+@property (nonatomic, strong, nullable, readwrite) FBFuture<NSNull *> *startedFuture;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *stoppedFuture;
+@property (nonatomic, assign, readwrite) BOOL hasStopped;
+
+@property (nonatomic, assign, readwrite) NSUInteger subscriberCount;
+@property (nonatomic, assign, readwrite) NSUInteger framesEncoded;
+@property (nonatomic, assign, readwrite) NSUInteger encodesSaved;
+@property (nonatomic, assign, readwrite) NSUInteger framesDropped;
+
+- (FBFuture<NSNull *> *)startSubscriber:(FBSimulatorSharedVideoStream_Subscriber *)subscriber consumer:(id<FBDataConsumer>)consumer;
+- (FBFuture<NSNull *> *)stopSubscriber:(FBSimulatorSharedVideoStream_Subscriber *)subscriber;
+- (void)failSubscriber:(FBSimulatorSharedVideoStream_Subscriber *)subscriber;
+
+@end
+
+@interface FBSimulatorSharedVideoStream_Subscriber : NSObject <FBVideoStream>
+
+@property (nonatomic, strong, readonly) FBSimulatorSharedVideoStream *sharedStream;
+@property (nonatomic, strong, readonly) FBMutableFuture<NSNull *> *stoppedFuture;
+@property (nonatomic, strong, nullable, readwrite) FBBoundedFrameDataConsumer *consumer;
+@property (nonatomic, assign, readwrite) BOOL finishing;
+
+@end
+
+@implementation FBSimulatorSharedVideoStream_Subscriber
+
+#pragma mark Initializers
+
+- (instancetype)initWithSharedStream:(FBSimulatorSharedVideoStream *)sharedStream
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _sharedStream = sharedStream;
+  _stoppedFuture = FBMutableFuture.future;
+
+  return self;
+}
+
+#pragma mark FBVideoStream
+
+- (FBFuture<NSNull *> *)startStreaming:(id<FBDataConsumer, FBDataConsumerStackConsuming>)consumer
+{
+  return [self.sharedStream startSubscriber:self consumer:consumer];
+}
+
+- (FBFuture<NSNull *> *)stopStreaming
+{
+  return [self.sharedStream stopSubscriber:self];
+}
+
+#pragma mark FBiOSTargetOperation
+
+- (FBFuture<NSNull *> *)completed
+{
+  return [[FBMutableFuture.future
+    resolveFromFuture:self.stoppedFuture]
+    onQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0) respondToCancellation:^{
+      return [self stopStreaming];
+    }];
+}
+
+#pragma mark Private
+
+- (NSUInteger)enqueueFrame:(NSData *)frame
+{
+  FBBoundedFrameDataConsumer *consumer = nil;
+  @synchronized (self) {
+    if (self.finishing) {
+      return 0;
+    }
+    consumer = self.consumer;
+  }
+  return [consumer consumeFrame:frame];
+}
+
+- (NSUInteger)pendingBytes
+{
+  FBBoundedFrameDataConsumer *consumer = nil;
+  @synchronized (self) {
+    consumer = self.consumer;
+  }
+  return consumer.pendingBytes;
+}
+
+- (FBFuture<NSNull *> *)finish
+{
+  FBBoundedFrameDataConsumer *consumer = nil;
+  @synchronized (self) {
+    if (self.finishing) {
+      return self.stoppedFuture;
+    }
+    self.finishing = YES;
+    consumer = self.consumer;
+  }
+  if (!consumer) {
+    [self.stoppedFuture resolveWithResult:NSNull.null];
+    return self.stoppedFuture;
+  }
+  // Frames that are already queued are written before the end-of-file.
+  [consumer consumeEndOfFile];
+  [self.stoppedFuture resolveFromFuture:consumer.finishedConsuming];
+  return self.stoppedFuture;
+}
+
+@end
+
+@implementation FBSimulatorSharedVideoStream
+
+#pragma mark Initializers
+
++ (instancetype)sharedStreamWithStream:(id<FBVideoStream>)stream encoding:(FBVideoStreamEncoding)encoding maximumQueuedFrames:(NSUInteger)maximumQueuedFrames logger:(id<FBControlCoreLogger>)logger
+{
+  return [[self alloc] initWithStream:stream encoding:encoding maximumQueuedFrames:maximumQueuedFrames logger:logger];
+}
+
+- (instancetype)initWithStream:(id<FBVideoStream>)stream encoding:(FBVideoStreamEncoding)encoding maximumQueuedFrames:(NSUInteger)maximumQueuedFrames logger:(id<FBControlCoreLogger>)logger
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _stream = stream;
+  _encoding = encoding;
+  _maximumQueuedFrames = maximumQueuedFrames;
+  _logger = logger;
+  _activeSubscribers = [NSMutableArray array];
+  _currentFrame = NSMutableData.data;
+  _stoppedFuture = FBMutableFuture.future;
+
+  return self;
+}
+
++ (BOOL)canShareStreamWithConfiguration:(FBVideoStreamConfiguration *)configuration
+{
+  FBVideoStreamEncoding encoding = configuration.encoding;
+  if ([encoding isEqualToString:FBVideoStreamEncodingBGRA] || [encoding isEqualToString:FBVideoStreamEncodingMJPEG]) {
+    return YES;
+  }
+  // A lazy H264 stream may not produce a keyframe for a long time, so a late subscriber would not be able to decode it.
+  if ([encoding isEqualToString:FBVideoStreamEncodingH264]) {
+    return configuration.framesPerSecond.unsignedIntegerValue > 0;
+  }
+  return NO;
+}
+
+#pragma mark Public Methods
+
+- (id<FBVideoStream>)subscribe
+{
+  @synchronized (self) {
+    if (self.hasStopped) {
+      return nil;
+    }
+    return [[FBSimulatorSharedVideoStream_Subscriber alloc] initWithSharedStream:self];
+  }
+}
+
+#pragma mark Properties
+
+- (FBFuture<NSNull *> *)stopped
+{
+  return self.stoppedFuture;
+}
+
+#pragma mark FBDataConsumer
+
+- (void)consumeData:(NSData *)data
+{
+  @synchronized (self) {
+    [self.currentFrame appendData:data];
+  }
+}
+
+- (void)consumeEndOfFile
+{
+}
+
+#pragma mark FBDataConsumerFrameDelimited
+
+- (void)consumeEndOfFrame
+{
+  NSData *frame = nil;
+  NSArray<FBSimulatorSharedVideoStream_Subscriber *> *subscribers = nil;
+  @synchronized (self) {
+    if (self.currentFrame.length == 0) {
+      return;
+    }
+    frame = self.currentFrame;
+    self.currentFrame = NSMutableData.data;
+    subscribers = [self.activeSubscribers copy];
+    self.framesEncoded += 1;
+    if (subscribers.count > 1) {
+      self.encodesSaved += subscribers.count - 1;
+    }
+  }
+  NSUInteger dropped = 0;
+  for (FBSimulatorSharedVideoStream_Subscriber *subscriber in subscribers) {
+    dropped += [subscriber enqueueFrame:frame];
+  }
+  if (dropped > 0) {
+    @synchronized (self) {
+      self.framesDropped += dropped;
+    }
+  }
+}
+
+#pragma mark FBDataConsumerBacklog
+
+- (NSUInteger)pendingBytes
+{
+  // The rate of the shared encoder is adapted to the subscriber that is furthest behind.
+  NSArray<FBSimulatorSharedVideoStream_Subscriber *> *subscribers = nil;
+  @synchronized (self) {
+    subscribers = [self.activeSubscribers copy];
+  }
+  NSUInteger pendingBytes = 0;
+  for (FBSimulatorSharedVideoStream_Subscriber *subscriber in subscribers) {
+    pendingBytes = MAX(pendingBytes, subscriber.pendingBytes);
+  }
+  return pendingBytes;
+}
+
+#pragma mark Private
+
+- (FBFuture<NSNull *> *)startSubscriber:(FBSimulatorSharedVideoStream_Subscriber *)subscriber consumer:(id<FBDataConsumer>)consumer
+{
+  FBFuture<NSNull *> *startedFuture = nil;
+  @synchronized (self) {
+    if (self.hasStopped) {
+      return [[FBSimulatorError
+        describe:@"Cannot start streaming, since the shared stream has stopped"]
+        failFuture];
+    }
+    if (subscriber.consumer) {
+      return [[FBSimulatorError
+        describe:@"Cannot start streaming, since streaming has already has started"]
+        failFuture];
+    }
+    FBFrameDropPolicy dropPolicy = [FBBoundedFrameDataConsumer dropPolicyForEncoding:self.encoding];
+    subscriber.consumer = [FBBoundedFrameDataConsumer consumerWithConsumer:consumer encoding:self.encoding maximumQueuedFrames:self.maximumQueuedFrames dropPolicy:dropPolicy];
+    [self.activeSubscribers addObject:subscriber];
+    self.subscriberCount += 1;
+    if (!self.startedFuture) {
+      self.startedFuture = [self.stream startStreaming:self];
+    }
+    startedFuture = self.startedFuture;
+  }
+  return [startedFuture
+    onQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0) chain:^(FBFuture<NSNull *> *future) {
+      if (future.state == FBFutureStateDone) {
+        return future;
+      }
+      // A stream that fails to start cannot be stopped, so all subscribers are discarded along with it.
+      [self failSubscriber:subscriber];
+      return future;
+    }];
+}
+
+- (void)failSubscriber:(FBSimulatorSharedVideoStream_Subscriber *)subscriber
+{
+  BOOL resolveStopped = NO;
+  @synchronized (self) {
+    if (![self.activeSubscribers containsObject:subscriber]) {
+      return;
+    }
+    [self.activeSubscribers removeObject:subscriber];
+    self.subscriberCount -= 1;
+    if (!self.hasStopped) {
+      self.hasStopped = YES;
+      resolveStopped = YES;
+    }
+  }
+  [subscriber finish];
+  if (resolveStopped) {
+    [self.stoppedFuture resolveWithResult:NSNull.null];
+  }
+}
+
+- (FBFuture<NSNull *> *)stopSubscriber:(FBSimulatorSharedVideoStream_Subscriber *)subscriber
+{
+  BOOL stopStream = NO;
+  @synchronized (self) {
+    if (subscriber.finishing) {
+      return subscriber.stoppedFuture;
+    }
+    // A subscriber that never started was never counted.
+    if ([self.activeSubscribers containsObject:subscriber]) {
+      [self.activeSubscribers removeObject:subscriber];
+      self.subscriberCount -= 1;
+      if (self.subscriberCount == 0 && !self.hasStopped) {
+        self.hasStopped = YES;
+        stopStream = YES;
+      }
+    }
+  }
+  FBFuture<NSNull *> *finished = [subscriber finish];
+  if (!stopStream) {
+    return finished;
+  }
+  [self.logger logFormat:@"Last subscriber of shared stream stopped. %lu frames encoded, %lu encodes saved, %lu frames dropped", (unsigned long) self.framesEncoded, (unsigned long) self.encodesSaved, (unsigned long) self.framesDropped];
+  FBFuture<NSNull *> *streamStopped = [self.stream stopStreaming];
+  [self.stoppedFuture resolveFromFuture:[streamStopped mapReplace:NSNull.null]];
+  return [[FBFuture
+    futureWithFutures:@[finished, streamStopped]]
+    mapReplace:NSNull.null];
+}
+
+@end
@@ -200,7 +200,7 @@ static NSTimeInterval const SimctlResolveFileTimeout = 10;
         return YES;
       }
       return NO;
-    }]
+    } backoffFrom:0.05 to:1]
     timeout:SimctlResolveFileTimeout waitingFor:@"simctl to write file to %@", filePath];
 }
 
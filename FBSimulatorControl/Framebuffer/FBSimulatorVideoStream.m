@@ -13,13 +13,23 @@
 #import <IOSurface/IOSurface.h>
 #import <VideoToolbox/VideoToolbox.h>
 
+#import <stdatomic.h>
+
 #import "FBSimulatorError.h"
+#import "FBSimulatorVideoStreamDamage.h"
 
 @protocol FBSimulatorVideoStreamFramePusher <NSObject>
 
 - (BOOL)setupWithPixelBuffer:(CVPixelBufferRef)pixelBuffer error:(NSError **)error;
 - (BOOL)writeEncodedFrame:(CVPixelBufferRef)pixelBuffer frameNumber:(NSUInteger)frameNumber timeAtFirstFrame:(CFTimeInterval)timeAtFirstFrame error:(NSError **)error;
 
+@optional
+
+- (void)didReceiveDamageRect:(CGRect)rect;
+- (void)invalidate;
+
+@property (nonatomic, assign, readonly) NSUInteger framesInFlight;
+
 @end
 
 @interface FBSimulatorVideoStreamFramePusher_Bitmap : NSObject <FBSimulatorVideoStreamFramePusher>
@@ -30,6 +40,17 @@
 
 @end
 
+@interface FBSimulatorVideoStreamFramePusher_Tiles : NSObject <FBSimulatorVideoStreamFramePusher>
+
+- (instancetype)initWithConsumer:(id<FBDataConsumer>)consumer encodeAsJPEG:(BOOL)encodeAsJPEG compressionQuality:(nullable NSNumber *)compressionQuality;
+
+@property (nonatomic, strong, readonly) id<FBDataConsumer> consumer;
+@property (nonatomic, assign, readonly) BOOL encodeAsJPEG;
+@property (nonatomic, copy, nullable, readonly) NSNumber *compressionQuality;
+@property (nonatomic, strong, nullable, readwrite) FBSimulatorVideoStreamDamage *damage;
+
+@end
+
 @interface FBSimulatorVideoStreamFramePusher_VideoToolbox : NSObject <FBSimulatorVideoStreamFramePusher>
 
 - (instancetype)initWithConfiguration:(FBVideoStreamConfiguration *)configuration compressionSessionProperties:(NSDictionary<NSString *, id> *)compressionSessionProperties videoCodec:(CMVideoCodecType)videoCodec consumer:(id<FBDataConsumer, FBDataConsumerStackConsuming>)consumer compressorCallback:(VTCompressionOutputCallback)compressorCallback logger:(id<FBControlCoreLogger>)logger;
@@ -42,25 +63,39 @@
 @property (nonatomic, strong, readonly) id<FBDataConsumer, FBDataConsumerStackConsuming> consumer;
 @property (nonatomic, strong, readonly) NSDictionary<NSString *, id> *compressionSessionProperties;
 
+- (void)didCompleteFrame;
+
 @end
 
+static void FBSimulatorVideoStreamEndFrame(id<FBDataConsumer> consumer)
+{
+  if ([consumer conformsToProtocol:@protocol(FBDataConsumerFrameDelimited)]) {
+    [(id<FBDataConsumerFrameDelimited>) consumer consumeEndOfFrame];
+  }
+}
+
 static void H264AnnexBCompressorCallback(void *outputCallbackRefCon, void *sourceFrameRefCon, OSStatus encodeStats, VTEncodeInfoFlags infoFlags, CMSampleBufferRef sampleBuffer)
 {
   FBSimulatorVideoStreamFramePusher_VideoToolbox *pusher = (__bridge FBSimulatorVideoStreamFramePusher_VideoToolbox *)(outputCallbackRefCon);
+  [pusher didCompleteFrame];
   WriteFrameToAnnexBStream(sampleBuffer, pusher.consumer, pusher.logger, nil);
+  FBSimulatorVideoStreamEndFrame(pusher.consumer);
 }
 
 static void MJPEGCompressorCallback(void *outputCallbackRefCon, void *sourceFrameRefCon, OSStatus encodeStats, VTEncodeInfoFlags infoFlags, CMSampleBufferRef sampleBuffer)
 {
   FBSimulatorVideoStreamFramePusher_VideoToolbox *pusher = (__bridge FBSimulatorVideoStreamFramePusher_VideoToolbox *)(outputCallbackRefCon);
+  [pusher didCompleteFrame];
   CMBlockBufferRef blockBufffer = CMSampleBufferGetDataBuffer(sampleBuffer);
   WriteJPEGDataToMJPEGStream(blockBufffer, pusher.consumer, pusher.logger, nil);
+  FBSimulatorVideoStreamEndFrame(pusher.consumer);
 }
 
 static void MinicapCompressorCallback(void *outputCallbackRefCon, void *sourceFrameRefCon, OSStatus encodeStats, VTEncodeInfoFlags infoFlags, CMSampleBufferRef sampleBuffer)
 {
   NSUInteger frameNumber = (NSUInteger) sourceFrameRefCon;
   FBSimulatorVideoStreamFramePusher_VideoToolbox *pusher = (__bridge FBSimulatorVideoStreamFramePusher_VideoToolbox *)(outputCallbackRefCon);
+  [pusher didCompleteFrame];
   if (frameNumber == 0) {
     CMFormatDescriptionRef formatDescription = CMSampleBufferGetFormatDescription(sampleBuffer);
     CMVideoDimensions dimensions = CMVideoFormatDescriptionGetDimensions(formatDescription);
@@ -68,6 +103,7 @@ static void MinicapCompressorCallback(void *outputCallbackRefCon, void *sourceFr
   }
   CMBlockBufferRef blockBufffer = CMSampleBufferGetDataBuffer(sampleBuffer);
   WriteJPEGDataToMinicapStream(blockBufffer, pusher.consumer, pusher.logger, nil);
+  FBSimulatorVideoStreamEndFrame(pusher.consumer);
 }
 
 @implementation FBSimulatorVideoStreamFramePusher_Bitmap
@@ -97,6 +133,7 @@ static void MinicapCompressorCallback(void *outputCallbackRefCon, void *sourceFr
   size_t size = CVPixelBufferGetDataSize(pixelBuffer);
   NSData *data = [NSData dataWithBytesNoCopy:baseAddress length:size freeWhenDone:NO];
   [self.consumer consumeData:data];
+  FBSimulatorVideoStreamEndFrame(self.consumer);
 
   CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
 
@@ -105,7 +142,58 @@ static void MinicapCompressorCallback(void *outputCallbackRefCon, void *sourceFr
 
 @end
 
+@implementation FBSimulatorVideoStreamFramePusher_Tiles
+
+- (instancetype)initWithConsumer:(id<FBDataConsumer>)consumer encodeAsJPEG:(BOOL)encodeAsJPEG compressionQuality:(NSNumber *)compressionQuality
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _consumer = consumer;
+  _encodeAsJPEG = encodeAsJPEG;
+  _compressionQuality = compressionQuality;
+
+  return self;
+}
+
+- (BOOL)setupWithPixelBuffer:(CVPixelBufferRef)pixelBuffer error:(NSError **)error
+{
+  // The first frame for a pixel buffer is the whole of the buffer, so that the receiver has an image to apply tiles to.
+  self.damage = [[FBSimulatorVideoStreamDamage alloc] initWithWidth:CVPixelBufferGetWidth(pixelBuffer) height:CVPixelBufferGetHeight(pixelBuffer) tileSize:FBSimulatorVideoStreamDamageTileSize];
+  [self.damage addAll];
+  return YES;
+}
+
+- (void)didReceiveDamageRect:(CGRect)rect
+{
+  [self.damage addRect:rect];
+}
+
+- (BOOL)writeEncodedFrame:(CVPixelBufferRef)pixelBuffer frameNumber:(NSUInteger)frameNumber timeAtFirstFrame:(CFTimeInterval)timeAtFirstFrame error:(NSError **)error
+{
+  // Nothing has changed since the last frame, so there is nothing to send.
+  NSArray<NSValue *> *tiles = [self.damage consumeDamagedRegions];
+  if (tiles.count == 0) {
+    return YES;
+  }
+
+  NSData *frame = [FBSimulatorVideoStreamDamage tileFrameForRegions:tiles pixelBuffer:pixelBuffer encodeAsJPEG:self.encodeAsJPEG compressionQuality:self.compressionQuality error:error];
+  if (!frame) {
+    return NO;
+  }
+  [self.consumer consumeData:frame];
+  FBSimulatorVideoStreamEndFrame(self.consumer);
+  return YES;
+}
+
+@end
+
 @implementation FBSimulatorVideoStreamFramePusher_VideoToolbox
+{
+  atomic_ulong _framesInFlight;
+}
 
 - (instancetype)initWithConfiguration:(FBVideoStreamConfiguration *)configuration compressionSessionProperties:(NSDictionary<NSString *, id> *)compressionSessionProperties videoCodec:(CMVideoCodecType)videoCodec consumer:(id<FBDataConsumer, FBDataConsumerStackConsuming>)consumer compressorCallback:(VTCompressionOutputCallback)compressorCallback logger:(id<FBControlCoreLogger>)logger
 {
@@ -206,11 +294,38 @@ static void MinicapCompressorCallback(void *outputCallbackRefCon, void *sourceFr
       describeFormat:@"Failed to compress %d", status]
       failBool:error];
   }
+  atomic_fetch_add(&_framesInFlight, 1);
   return YES;
 }
 
+- (NSUInteger)framesInFlight
+{
+  return (NSUInteger) atomic_load(&_framesInFlight);
+}
+
+- (void)didCompleteFrame
+{
+  atomic_fetch_sub(&_framesInFlight, 1);
+}
+
+- (void)invalidate
+{
+  VTCompressionSessionRef compressionSession = self.compressionSession;
+  if (!compressionSession) {
+    return;
+  }
+  self.compressionSession = nil;
+  // Frames that are still being encoded are emitted before the session is torn down.
+  VTCompressionSessionCompleteFrames(compressionSession, kCMTimeInvalid);
+  VTCompressionSessionInvalidate(compressionSession);
+  CFRelease(compressionSession);
+}
+
 @end
 
+// An estimate of the compressed bits per pixel of a Simulator's H264 stream, used to derive the maximum bit rate.
+static const double FBSimulatorVideoStreamBitsPerPixel = 0.1;
+
 @interface FBSimulatorVideoStream_Lazy : FBSimulatorVideoStream
 
 @end
@@ -219,6 +334,7 @@ static void MinicapCompressorCallback(void *outputCallbackRefCon, void *sourceFr
 
 @property (nonatomic, assign, readonly) NSUInteger framesPerSecond;
 @property (nonatomic, strong, readwrite) FBDispatchSourceNotifier *timer;
+@property (nonatomic, strong, nullable, readwrite) FBVideoStreamRateController *rateController;
 
 - (instancetype)initWithFramebuffer:(FBFramebuffer *)framebuffer configuration:(FBVideoStreamConfiguration *)configuration framesPerSecond:(NSUInteger)framesPerSecond writeQueue:(dispatch_queue_t)writeQueue logger:(id<FBControlCoreLogger>)logger;
 
@@ -240,7 +356,10 @@ static void MinicapCompressorCallback(void *outputCallbackRefCon, void *sourceFr
 @property (nonatomic, strong, nullable, readwrite) id<FBDataConsumer, FBDataConsumerStackConsuming> consumer;
 @property (nonatomic, strong, nullable, readwrite) id<FBSimulatorVideoStreamFramePusher> framePusher;
 
+@property (nonatomic, copy, readonly) FBVideoStreamConfiguration *encoderConfiguration;
+
 - (void)pushFrame;
+- (BOOL)setupFramePusher:(NSError **)error;
 
 @end
 
@@ -340,6 +459,12 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
       }
       self.consumer = nil;
       [self.framebuffer detachConsumer:self];
+      // Flush any frames that are still in the encoder, before the end-of-file.
+      id<FBSimulatorVideoStreamFramePusher> framePusher = self.framePusher;
+      if ([framePusher respondsToSelector:@selector(invalidate)]) {
+        [framePusher invalidate];
+      }
+      self.framePusher = nil;
       [consumer consumeEndOfFile];
       [self.stoppedFuture resolveWithResult:NSNull.null];
       return self.stoppedFuture;
@@ -373,6 +498,10 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
 
 - (void)didReceiveDamageRect:(CGRect)rect
 {
+  id<FBSimulatorVideoStreamFramePusher> framePusher = self.framePusher;
+  if ([framePusher respondsToSelector:@selector(didReceiveDamageRect:)]) {
+    [framePusher didReceiveDamageRect:rect];
+  }
 }
 
 #pragma mark Private
@@ -414,18 +543,39 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
   self.pixelBuffer = buffer;
   self.pixelBufferAttributes = attributes;
 
-  id<FBSimulatorVideoStreamFramePusher> framePusher = [self.class framePusherForConfiguration:self.configuration compressionSessionProperties:self.compressionSessionProperties consumer:consumer logger:self.logger error:nil];
+  if (![self setupFramePusher:error]) {
+    return NO;
+  }
+
+  // Signal that we've started
+  [self.startedFuture resolveWithResult:NSNull.null];
+
+  return YES;
+}
+
+- (BOOL)setupFramePusher:(NSError **)error
+{
+  id<FBDataConsumer, FBDataConsumerStackConsuming> consumer = self.consumer;
+  CVPixelBufferRef buffer = self.pixelBuffer;
+  if (!consumer || !buffer) {
+    return [[FBSimulatorError
+      describe:@"Cannot setup frame pusher without a consumer and a pixel buffer"]
+      failBool:error];
+  }
+  id<FBSimulatorVideoStreamFramePusher> framePusher = [self.class framePusherForConfiguration:self.encoderConfiguration compressionSessionProperties:self.compressionSessionProperties consumer:consumer logger:self.logger error:error];
   if (!framePusher) {
     return NO;
   }
   if (![framePusher setupWithPixelBuffer:buffer error:error]) {
     return NO;
   }
-  self.framePusher = framePusher;
-
-  // Signal that we've started
-  [self.startedFuture resolveWithResult:NSNull.null];
 
+  // Frames that are still in the old encoder are flushed, so that they are written before those of the new encoder.
+  id<FBSimulatorVideoStreamFramePusher> oldFramePusher = self.framePusher;
+  if ([oldFramePusher respondsToSelector:@selector(invalidate)]) {
+    [oldFramePusher invalidate];
+  }
+  self.framePusher = framePusher;
   return YES;
 }
 
@@ -493,6 +643,12 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
   if ([encoding isEqual:FBVideoStreamEncodingBGRA]) {
     return [[FBSimulatorVideoStreamFramePusher_Bitmap alloc] initWithConsumer:consumer];
   }
+  if ([encoding isEqualToString:FBVideoStreamEncodingBGRATiles]) {
+    return [[FBSimulatorVideoStreamFramePusher_Tiles alloc] initWithConsumer:consumer encodeAsJPEG:NO compressionQuality:nil];
+  }
+  if ([encoding isEqualToString:FBVideoStreamEncodingMJPEGTiles]) {
+    return [[FBSimulatorVideoStreamFramePusher_Tiles alloc] initWithConsumer:consumer encodeAsJPEG:YES compressionQuality:configuration.compressionQuality];
+  }
   return [[FBControlCoreError
     describeFormat:@"%@ is not supported for Simulators", encoding]
     fail:error];
@@ -503,6 +659,11 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
   return @{};
 }
 
+- (FBVideoStreamConfiguration *)encoderConfiguration
+{
+  return self.configuration;
+}
+
 #pragma mark FBiOSTargetOperation
 
 - (FBFuture<NSNull *> *)completed
@@ -520,6 +681,7 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
 
 - (void)didReceiveDamageRect:(CGRect)rect
 {
+  [super didReceiveDamageRect:rect];
   [self pushFrame];
 }
 
@@ -547,23 +709,106 @@ static NSDictionary<NSString *, id> *FBBitmapStreamPixelBufferAttributesFromPixe
     return NO;
   }
 
+  [self startTimer];
+
+  return YES;
+}
+
+- (BOOL)setupFramePusher:(NSError **)error
+{
+  // The rate controller is created before the first encoder, as it determines the rate of the encoder.
+  if (!self.rateController && [self.configuration.encoding isEqualToString:FBVideoStreamEncodingH264] && self.pixelBuffer) {
+    self.rateController = [FBVideoStreamRateController controllerWithMaximumRate:[self maximumRateForPixelBuffer:self.pixelBuffer]];
+  }
+  return [super setupFramePusher:error];
+}
+
+- (void)startTimer
+{
   if (self.timer) {
     [self.timer terminate];
     self.timer = nil;
   }
-  uint64_t timeInterval = NSEC_PER_SEC / self.framesPerSecond;
+  uint64_t timeInterval = NSEC_PER_SEC / self.currentFramesPerSecond;
   self.timer = [FBDispatchSourceNotifier timerNotifierNotifierWithTimeInterval:timeInterval queue:self.writeQueue handler:^(FBDispatchSourceNotifier *_) {
+    [self adaptRate];
     [self pushFrame];
   }];
+}
 
-  return YES;
+- (void)adaptRate
+{
+  FBVideoStreamRateController *rateController = self.rateController;
+  id<FBSimulatorVideoStreamFramePusher> framePusher = self.framePusher;
+  if (!rateController || !framePusher) {
+    return;
+  }
+  NSUInteger pendingFrames = [framePusher respondsToSelector:@selector(framesInFlight)] ? framePusher.framesInFlight : 0;
+  id<FBDataConsumer> consumer = self.consumer;
+  NSUInteger pendingBytes = [consumer conformsToProtocol:@protocol(FBDataConsumerBacklog)] ? ((id<FBDataConsumerBacklog>) consumer).pendingBytes : 0;
+  FBVideoStreamRate *previousRate = rateController.rate;
+  if (![rateController samplePendingFrames:pendingFrames pendingBytes:pendingBytes atTime:CFAbsoluteTimeGetCurrent()]) {
+    return;
+  }
+  FBVideoStreamRate *rate = rateController.rate;
+  [self.logger logFormat:@"Changing stream rate from %@ to %@ with %lu frames and %lu bytes pending", previousRate, rate, (unsigned long) pendingFrames, (unsigned long) pendingBytes];
+
+  // A new encoder is required when the dimensions change, other properties could be changed on the existing session but recreating it is simpler and infrequent.
+  NSError *error = nil;
+  if (![self setupFramePusher:&error]) {
+    [self.logger logFormat:@"Failed to change stream rate %@", error];
+    return;
+  }
+  if (rate.framesPerSecond != previousRate.framesPerSecond) {
+    [self startTimer];
+  }
+}
+
+- (FBVideoStreamRate *)maximumRateForPixelBuffer:(CVPixelBufferRef)pixelBuffer
+{
+  NSNumber *scaleFactorNumber = self.configuration.scaleFactor;
+  double scaleFactor = (scaleFactorNumber && scaleFactorNumber.doubleValue > 0 && scaleFactorNumber.doubleValue < 1) ? scaleFactorNumber.doubleValue : 1;
+  double pixels = CVPixelBufferGetWidth(pixelBuffer) * CVPixelBufferGetHeight(pixelBuffer) * scaleFactor * scaleFactor;
+  // An estimate of the bit rate that the encoder will produce for Simulator content at this size, which is mostly static.
+  NSUInteger averageBitRate = (NSUInteger) (pixels * self.framesPerSecond * FBSimulatorVideoStreamBitsPerPixel);
+  return [[FBVideoStreamRate alloc] initWithFramesPerSecond:self.framesPerSecond scaleFactor:scaleFactor averageBitRate:averageBitRate];
+}
+
+- (NSUInteger)currentFramesPerSecond
+{
+  FBVideoStreamRateController *rateController = self.rateController;
+  return rateController ? rateController.rate.framesPerSecond : self.framesPerSecond;
+}
+
+- (FBVideoStreamConfiguration *)encoderConfiguration
+{
+  FBVideoStreamRateController *rateController = self.rateController;
+  if (!rateController) {
+    return self.configuration;
+  }
+  FBVideoStreamConfiguration *configuration = self.configuration;
+  FBVideoStreamRate *rate = rateController.rate;
+  return [[FBVideoStreamConfiguration alloc]
+    initWithEncoding:configuration.encoding
+    framesPerSecond:@(rate.framesPerSecond)
+    compressionQuality:configuration.compressionQuality
+    scaleFactor:(rate.scaleFactor < 1 ? @(rate.scaleFactor) : nil)];
 }
 
 - (NSDictionary<NSString *, id> *)compressionSessionProperties
 {
+  FBVideoStreamRateController *rateController = self.rateController;
+  if (!rateController) {
+    return @{
+      (NSString *) kVTCompressionPropertyKey_ExpectedFrameRate: @(self.framesPerSecond),
+      (NSString *) kVTCompressionPropertyKey_MaxKeyFrameInterval: @2,
+    };
+  }
+  FBVideoStreamRate *rate = rateController.rate;
   return @{
-    (NSString *) kVTCompressionPropertyKey_ExpectedFrameRate: @(self.framesPerSecond),
+    (NSString *) kVTCompressionPropertyKey_ExpectedFrameRate: @(rate.framesPerSecond),
     (NSString *) kVTCompressionPropertyKey_MaxKeyFrameInterval: @2,
+    (NSString *) kVTCompressionPropertyKey_AverageBitRate: @(rate.averageBitRate),
   };
 }
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+#import <CoreVideo/CoreVideo.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The size of the square tiles that damage is tracked in.
+ */
+extern size_t const FBSimulatorVideoStreamDamageTileSize;
+
+/**
+ Accumulates the Damage Rects of a Framebuffer into a grid of tiles, between frames of a tiled Video Stream.
+ This class is not thread safe, it should be used from the queue that frames are written on.
+ */
+@interface FBSimulatorVideoStreamDamage : NSObject
+
+#pragma mark Initializers
+
+/**
+ Constructs a Damage tracker for a screen of the provided dimensions.
+
+ @param width the width of the screen, in pixels.
+ @param height the height of the screen, in pixels.
+ @param tileSize the size of a tile, in pixels.
+ @return a new Damage tracker, with no damage.
+ */
+- (instancetype)initWithWidth:(size_t)width height:(size_t)height tileSize:(size_t)tileSize;
+
+#pragma mark Public Methods
+
+/**
+ Marks every tile that the rect touches as damaged.
+ The rect is clipped to the screen.
+
+ @param rect the damaged rect.
+ */
+- (void)addRect:(CGRect)rect;
+
+/**
+ Marks the whole screen as damaged.
+ */
+- (void)addAll;
+
+/**
+ Returns the damaged regions and clears the damage.
+ Runs of damaged tiles in a row are joined, as are runs of the same span in consecutive rows.
+
+ @return the damaged regions, clipped to the screen. Empty if there is no damage.
+ */
+- (NSArray<NSValue *> *)consumeDamagedRegions;
+
+/**
+ Encodes a frame of a tiled Video Stream, in the format described alongside FBVideoStreamEncodingBGRATiles.
+
+ @param regions the regions of the pixel buffer to encode.
+ @param pixelBuffer the BGRA pixel buffer to read from.
+ @param encodeAsJPEG YES if each region should be encoded as a JPEG, NO for raw BGRA rows.
+ @param compressionQuality the JPEG compression quality, if any.
+ @param error an error out for any error that occurs.
+ @return the encoded frame, nil on failure.
+ */
++ (nullable NSData *)tileFrameForRegions:(NSArray<NSValue *> *)regions pixelBuffer:(CVPixelBufferRef)pixelBuffer encodeAsJPEG:(BOOL)encodeAsJPEG compressionQuality:(nullable NSNumber *)compressionQuality error:(NSError **)error;
+
+#pragma mark Properties
+
+/**
+ The width of the screen, in pixels.
+ */
+@property (nonatomic, assign, readonly) size_t width;
+
+/**
+ The height of the screen, in pixels.
+ */
+@property (nonatomic, assign, readonly) size_t height;
+
+/**
+ The size of a tile, in pixels.
+ */
+@property (nonatomic, assign, readonly) size_t tileSize;
+
+/**
+ YES if any tile has been damaged since the damage was last consumed.
+ */
+@property (nonatomic, assign, readonly) BOOL hasDamage;
+
+@end
+
+NS_ASSUME_NONNULL_END
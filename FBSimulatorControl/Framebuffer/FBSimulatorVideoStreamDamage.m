@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBSimulatorVideoStreamDamage.h"
+
+#import <CoreServices/CoreServices.h>
+#import <ImageIO/ImageIO.h>
+
+#import "FBSimulatorError.h"
+
+size_t const FBSimulatorVideoStreamDamageTileSize = 64;
+
+static void FBAppendLittleEndianUInt32(NSMutableData *data, uint32_t value)
+{
+  uint32_t littleEndian = OSSwapHostToLittleInt32(value);
+  [data appendBytes:&littleEndian length:sizeof(littleEndian)];
+}
+
+static NSData *FBJPEGDataForTile(const uint8_t *baseAddress, size_t bytesPerRow, CGRect tile, NSNumber *compressionQuality)
+{
+  size_t x = (size_t) CGRectGetMinX(tile);
+  size_t y = (size_t) CGRectGetMinY(tile);
+  size_t width = (size_t) CGRectGetWidth(tile);
+  size_t height = (size_t) CGRectGetHeight(tile);
+
+  // The context references the tile within the pixel buffer, the image that is created from it is a copy.
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(
+    (void *) (baseAddress + (y * bytesPerRow) + (x * 4)),
+    width,
+    height,
+    8,
+    bytesPerRow,
+    colorSpace,
+    kCGImageAlphaNoneSkipFirst | kCGBitmapByteOrder32Little
+  );
+  CGColorSpaceRelease(colorSpace);
+  if (!context) {
+    return nil;
+  }
+  CGImageRef image = CGBitmapContextCreateImage(context);
+  CGContextRelease(context);
+  if (!image) {
+    return nil;
+  }
+
+  NSMutableData *data = NSMutableData.data;
+  CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef) data, kUTTypeJPEG, 1, NULL);
+  NSDictionary<NSString *, id> *properties = compressionQuality ? @{(NSString *) kCGImageDestinationLossyCompressionQuality: compressionQuality} : @{};
+  CGImageDestinationAddImage(destination, image, (__bridge CFDictionaryRef) properties);
+  BOOL success = CGImageDestinationFinalize(destination);
+  CFRelease(destination);
+  CGImageRelease(image);
+  return success ? data : nil;
+}
+
+@interface FBSimulatorVideoStreamDamage ()
+
+@property (nonatomic, assign, readonly) size_t columns;
+@property (nonatomic, assign, readonly) size_t rows;
+@property (nonatomic, strong, readonly) NSMutableData *dirtyTiles;
+@property (nonatomic, assign, readwrite) BOOL hasDamage;
+
+@end
+
+@implementation FBSimulatorVideoStreamDamage
+
+#pragma mark Initializers
+
+- (instancetype)initWithWidth:(size_t)width height:(size_t)height tileSize:(size_t)tileSize
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _width = width;
+  _height = height;
+  _tileSize = tileSize;
+  _columns = (width + tileSize - 1) / tileSize;
+  _rows = (height + tileSize - 1) / tileSize;
+  _dirtyTiles = [NSMutableData dataWithLength:_columns * _rows];
+  _hasDamage = NO;
+
+  return self;
+}
+
+#pragma mark Public Methods
+
+- (void)addRect:(CGRect)rect
+{
+  CGRect bounds = CGRectIntersection(CGRectIntegral(rect), CGRectMake(0, 0, self.width, self.height));
+  if (CGRectIsNull(bounds) || CGRectIsEmpty(bounds)) {
+    return;
+  }
+  size_t tileSize = self.tileSize;
+  size_t minColumn = (size_t) CGRectGetMinX(bounds) / tileSize;
+  size_t maxColumn = ((size_t) CGRectGetMaxX(bounds) - 1) / tileSize;
+  size_t minRow = (size_t) CGRectGetMinY(bounds) / tileSize;
+  size_t maxRow = ((size_t) CGRectGetMaxY(bounds) - 1) / tileSize;
+  uint8_t *dirtyTiles = self.dirtyTiles.mutableBytes;
+  for (size_t row = minRow; row <= maxRow; row++) {
+    memset(dirtyTiles + (row * self.columns) + minColumn, 1, maxColumn - minColumn + 1);
+  }
+  self.hasDamage = YES;
+}
+
+- (void)addAll
+{
+  memset(self.dirtyTiles.mutableBytes, 1, self.dirtyTiles.length);
+  self.hasDamage = self.dirtyTiles.length > 0;
+}
+
+- (NSArray<NSValue *> *)consumeDamagedRegions
+{
+  if (!self.hasDamage) {
+    return @[];
+  }
+  // Runs of damaged tiles in a row are joined, then joined with a run of the same span in the row above.
+  NSMutableArray<NSValue *> *regions = [NSMutableArray array];
+  NSUInteger previousRowStart = 0;
+  uint8_t *dirtyTiles = self.dirtyTiles.mutableBytes;
+  size_t tileSize = self.tileSize;
+  for (size_t row = 0; row < self.rows; row++) {
+    NSUInteger rowStart = regions.count;
+    CGFloat y = row * tileSize;
+    CGFloat height = MIN(tileSize, self.height - (row * tileSize));
+    size_t column = 0;
+    while (column < self.columns) {
+      if (!dirtyTiles[(row * self.columns) + column]) {
+        column++;
+        continue;
+      }
+      size_t runStart = column;
+      while (column < self.columns && dirtyTiles[(row * self.columns) + column]) {
+        column++;
+      }
+      CGFloat x = runStart * tileSize;
+      CGFloat width = MIN(column * tileSize, self.width) - x;
+      BOOL joined = NO;
+      for (NSUInteger index = previousRowStart; index < rowStart; index++) {
+        CGRect previous = regions[index].rectValue;
+        if (CGRectGetMinX(previous) == x && CGRectGetWidth(previous) == width && CGRectGetMaxY(previous) == y) {
+          previous.size.height += height;
+          [regions removeObjectAtIndex:index];
+          [regions addObject:[NSValue valueWithRect:previous]];
+          rowStart--;
+          joined = YES;
+          break;
+        }
+      }
+      if (!joined) {
+        [regions addObject:[NSValue valueWithRect:CGRectMake(x, y, width, height)]];
+      }
+    }
+    previousRowStart = rowStart;
+  }
+  memset(dirtyTiles, 0, self.dirtyTiles.length);
+  self.hasDamage = NO;
+  return regions;
+}
+
++ (NSData *)tileFrameForRegions:(NSArray<NSValue *> *)regions pixelBuffer:(CVPixelBufferRef)pixelBuffer encodeAsJPEG:(BOOL)encodeAsJPEG compressionQuality:(NSNumber *)compressionQuality error:(NSError **)error
+{
+  CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+
+  const uint8_t *baseAddress = CVPixelBufferGetBaseAddress(pixelBuffer);
+  size_t bytesPerRow = CVPixelBufferGetBytesPerRow(pixelBuffer);
+  NSMutableData *frame = NSMutableData.data;
+  FBAppendLittleEndianUInt32(frame, (uint32_t) regions.count);
+  for (NSValue *value in regions) {
+    CGRect tile = value.rectValue;
+    size_t x = (size_t) CGRectGetMinX(tile);
+    size_t y = (size_t) CGRectGetMinY(tile);
+    size_t width = (size_t) CGRectGetWidth(tile);
+    size_t height = (size_t) CGRectGetHeight(tile);
+    NSData *payload = nil;
+    if (encodeAsJPEG) {
+      payload = FBJPEGDataForTile(baseAddress, bytesPerRow, tile, compressionQuality);
+      if (!payload) {
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        return [[FBSimulatorError
+          describeFormat:@"Failed to encode tile %@ as JPEG", NSStringFromRect(tile)]
+          fail:error];
+      }
+    }
+    size_t payloadLength = payload ? payload.length : width * height * 4;
+    FBAppendLittleEndianUInt32(frame, (uint32_t) x);
+    FBAppendLittleEndianUInt32(frame, (uint32_t) y);
+    FBAppendLittleEndianUInt32(frame, (uint32_t) width);
+    FBAppendLittleEndianUInt32(frame, (uint32_t) height);
+    FBAppendLittleEndianUInt32(frame, (uint32_t) payloadLength);
+    if (payload) {
+      [frame appendData:payload];
+      continue;
+    }
+    for (size_t row = y; row < y + height; row++) {
+      [frame appendBytes:baseAddress + (row * bytesPerRow) + (x * 4) length:width * 4];
+    }
+  }
+
+  CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+  return frame;
+}
+
+@end
@@ -9,6 +9,7 @@
 
 #import <FBControlCore/FBControlCore.h>
 
+#import <FBSimulatorControl/FBSimulatorHIDSchedule.h>
 #import <FBSimulatorControl/FBSimulatorIndigoHID.h>
 
 @class FBSimulator;
@@ -80,6 +81,45 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FBFuture<NSNull *> *)sendTouchWithType:(FBSimulatorHIDDirection)type x:(double)x y:(double)y;
 
+/**
+ Sends all of the messages in a schedule, each at its offset from the start of the schedule.
+ Messages are sent from a high priority timer, the future resolves once the schedule has completed.
+
+ @param schedule the schedule to send.
+ @return A future that resolves with the timing that was achieved.
+ */
+- (FBFuture<FBSimulatorHIDScheduleReport *> *)sendSchedule:(FBSimulatorHIDSchedule *)schedule;
+
+#pragma mark Message Serialization
+
+/**
+ Serializes a Keyboard Event, for sending later.
+
+ @param direction the direction of the event.
+ @param keycode the Key Code to send.
+ @return the serialized Indigo message.
+ */
+- (NSData *)keyboardMessageWithDirection:(FBSimulatorHIDDirection)direction keyCode:(unsigned int)keycode;
+
+/**
+ Serializes a Button Event, for sending later.
+
+ @param direction the direction of the event.
+ @param button the button.
+ @return the serialized Indigo message.
+ */
+- (NSData *)buttonMessageWithDirection:(FBSimulatorHIDDirection)direction button:(FBSimulatorHIDButton)button;
+
+/**
+ Serializes a Touch Event, for sending later.
+
+ @param type the event type.
+ @param x the X-Coordinate
+ @param y the Y-Coordinate
+ @return the serialized Indigo message.
+ */
+- (NSData *)touchMessageWithType:(FBSimulatorHIDDirection)type x:(double)x y:(double)y;
+
 #pragma mark Properties
 
 /**
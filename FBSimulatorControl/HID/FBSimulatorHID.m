@@ -200,17 +200,79 @@ static const char *SimulatorHIDClientClassName = "SimulatorKit.SimDeviceLegacyHI
 
 - (FBFuture<NSNull *> *)sendKeyboardEventWithDirection:(FBSimulatorHIDDirection)direction keyCode:(unsigned int)keycode
 {
-  return [self sendIndigoMessageDataOnWorkQueue:[self.indigo keyboardWithDirection:direction keyCode:keycode]];
+  return [self sendIndigoMessageDataOnWorkQueue:[self keyboardMessageWithDirection:direction keyCode:keycode]];
 }
 
 - (FBFuture<NSNull *> *)sendButtonEventWithDirection:(FBSimulatorHIDDirection)direction button:(FBSimulatorHIDButton)button
 {
-  return [self sendIndigoMessageDataOnWorkQueue:[self.indigo buttonWithDirection:direction button:button]];
+  return [self sendIndigoMessageDataOnWorkQueue:[self buttonMessageWithDirection:direction button:button]];
 }
 
 - (FBFuture<NSNull *> *)sendTouchWithType:(FBSimulatorHIDDirection)type x:(double)x y:(double)y
 {
-  return [self sendIndigoMessageDataOnWorkQueue:[self.indigo touchScreenSize:self.mainScreenSize screenScale:self.mainScreenScale direction:type x:x y:y]];
+  return [self sendIndigoMessageDataOnWorkQueue:[self touchMessageWithType:type x:x y:y]];
+}
+
+- (FBFuture<FBSimulatorHIDScheduleReport *> *)sendSchedule:(FBSimulatorHIDSchedule *)schedule
+{
+  dispatch_queue_attr_t attributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_USER_INTERACTIVE, 0);
+  dispatch_queue_t timerQueue = dispatch_queue_create("com.facebook.fbsimulatorcontrol.hid.schedule", attributes);
+  FBMutableFuture<FBSimulatorHIDScheduleReport *> *future = FBMutableFuture.future;
+  dispatch_async(timerQueue, ^{
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    double nanosecondsPerTick = (double) timebase.numer / (double) timebase.denom;
+
+    NSMutableArray<FBFuture<NSNull *> *> *sent = [NSMutableArray arrayWithCapacity:schedule.count];
+    __block double totalJitter = 0;
+    __block double maximumJitter = 0;
+    uint64_t start = mach_absolute_time();
+    [schedule enumerateMessagesUsingBlock:^(NSData *message, NSTimeInterval offset) {
+      // Sleeping until an absolute deadline means that lateness in sending one message does not accumulate into the next.
+      uint64_t deadline = start + (uint64_t) ((offset * NSEC_PER_SEC) / nanosecondsPerTick);
+      mach_wait_until(deadline);
+      uint64_t now = mach_absolute_time();
+      double jitter = now > deadline ? ((now - deadline) * nanosecondsPerTick) / NSEC_PER_SEC : 0;
+      totalJitter += jitter;
+      maximumJitter = MAX(maximumJitter, jitter);
+      __block FBFuture<NSNull *> *messageSent = nil;
+      dispatch_sync(self.queue, ^{
+        // Messages were serialized when the schedule was built, so are stamped with the time at which they are actually sent.
+        [FBSimulatorIndigoHID stampMessage:message withTimestamp:mach_absolute_time()];
+        messageSent = [self sendIndigoMessageData:message];
+      });
+      [sent addObject:messageSent];
+    }];
+    // A delay at the end of the schedule is honoured, as it would be when sending each event individually.
+    mach_wait_until(start + (uint64_t) ((schedule.duration * NSEC_PER_SEC) / nanosecondsPerTick));
+    NSTimeInterval actualDuration = ((mach_absolute_time() - start) * nanosecondsPerTick) / NSEC_PER_SEC;
+
+    FBSimulatorHIDScheduleReport *report = [[FBSimulatorHIDScheduleReport alloc]
+      initWithMessageCount:schedule.count
+      scheduledDuration:schedule.duration
+      actualDuration:actualDuration
+      meanJitter:(schedule.count > 0 ? totalJitter / schedule.count : 0)
+      maximumJitter:maximumJitter];
+    [future resolveFromFuture:[[FBFuture futureWithFutures:sent] mapReplace:report]];
+  });
+  return future;
+}
+
+#pragma mark Message Serialization
+
+- (NSData *)keyboardMessageWithDirection:(FBSimulatorHIDDirection)direction keyCode:(unsigned int)keycode
+{
+  return [self.indigo keyboardWithDirection:direction keyCode:keycode];
+}
+
+- (NSData *)buttonMessageWithDirection:(FBSimulatorHIDDirection)direction button:(FBSimulatorHIDButton)button
+{
+  return [self.indigo buttonWithDirection:direction button:button];
+}
+
+- (NSData *)touchMessageWithType:(FBSimulatorHIDDirection)type x:(double)x y:(double)y
+{
+  return [self.indigo touchScreenSize:self.mainScreenSize screenScale:self.mainScreenScale direction:type x:x y:y];
 }
 
 #pragma mark Private
@@ -400,15 +462,13 @@ static const char *SimulatorHIDClientClassName = "SimulatorKit.SimDeviceLegacyHI
 - (FBFuture<NSNull *> *)sendIndigoMessageData:(NSData *)data
 {
   // The event is delivered asynchronously.
-  // Therefore copy the message and let the client manage the lifecycle of it.
-  // The free of the buffer is performed by the client and the NSData will free when it falls out of scope.
-  size_t size = (mach_msg_size_t) data.length;
-  IndigoMessage *message = malloc(size);
-  memcpy(message, data.bytes, size);
+  // Rather than copying the message for the client to free, the data is retained until the client has completed, so that the buffer can be reused.
+  IndigoMessage *message = (IndigoMessage *) data.bytes;
 
   // Resolve the future when done and pass this back to the caller.
   FBMutableFuture<NSNull *> *future = FBMutableFuture.future;
-  [self.client sendWithMessage:message freeWhenDone:YES completionQueue:self.queue completion:^(NSError *error){
+  [self.client sendWithMessage:message freeWhenDone:NO completionQueue:self.queue completion:^(NSError *error){
+    (void) data;
     if (error) {
       [future resolveWithError:error];
     } else {
@@ -143,6 +143,23 @@ extern double const DEFAULT_SWIPE_DELTA;
  */
 - (FBFuture<NSNull *> *)performOnHID:(FBSimulatorHID *)hid;
 
+/**
+ Materializes the event as a schedule of messages, then sends the schedule on the hid object.
+ Unlike -performOnHID:, all messages are serialized upfront and delays are measured from the start of the schedule, so the timing of the event does not drift.
+
+ @param hid the hid to perform on.
+ @return A future that resolves with the timing achieved when all of the messages have been sent.
+ */
+- (FBFuture<FBSimulatorHIDScheduleReport *> *)performScheduledOnHID:(FBSimulatorHID *)hid;
+
+/**
+ Appends the messages for the event to a schedule.
+
+ @param schedule the schedule to append to.
+ @param hid the hid to serialize messages for.
+ */
+- (void)appendToSchedule:(FBSimulatorHIDSchedule *)schedule hid:(FBSimulatorHID *)hid;
+
 @end
 
 NS_ASSUME_NONNULL_END
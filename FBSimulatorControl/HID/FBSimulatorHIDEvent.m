@@ -72,6 +72,13 @@ static NSString *const KeyEvents = @"events";
     }];
 }
 
+- (void)appendToSchedule:(FBSimulatorHIDSchedule *)schedule hid:(FBSimulatorHID *)hid
+{
+  for (FBSimulatorHIDEvent *event in self.events) {
+    [event appendToSchedule:schedule hid:hid];
+  }
+}
+
 - (NSString *)description
 {
   return [NSString stringWithFormat:@"Composite %@", [FBCollectionInformation oneLineDescriptionFromArray:self.events]];
@@ -122,6 +129,11 @@ static NSString *const KeyY = @"y";
   return [hid sendTouchWithType:self.direction x:self.x y:self.y];
 }
 
+- (void)appendToSchedule:(FBSimulatorHIDSchedule *)schedule hid:(FBSimulatorHID *)hid
+{
+  [schedule appendMessage:[hid touchMessageWithType:self.direction x:self.x y:self.y]];
+}
+
 - (NSString *)description
 {
   return [NSString stringWithFormat:
@@ -180,6 +192,11 @@ static NSString *const ButtonSiri = @"siri";
   return [hid sendButtonEventWithDirection:self.type button:self.button];
 }
 
+- (void)appendToSchedule:(FBSimulatorHIDSchedule *)schedule hid:(FBSimulatorHID *)hid
+{
+  [schedule appendMessage:[hid buttonMessageWithDirection:self.type button:self.button]];
+}
+
 - (NSString *)description
 {
   return [NSString stringWithFormat:
@@ -270,6 +287,11 @@ static NSString *const KeyKeycode = @"keycode";
   return [hid sendKeyboardEventWithDirection:self.direction keyCode:self.keyCode];
 }
 
+- (void)appendToSchedule:(FBSimulatorHIDSchedule *)schedule hid:(FBSimulatorHID *)hid
+{
+  [schedule appendMessage:[hid keyboardMessageWithDirection:self.direction keyCode:self.keyCode]];
+}
+
 - (NSString *)description
 {
   return [NSString stringWithFormat:
@@ -319,6 +341,11 @@ static NSString *const KeyDuration = @"duration";
   return [FBFuture futureWithDelay:self.duration future:FBFuture.empty];
 }
 
+- (void)appendToSchedule:(FBSimulatorHIDSchedule *)schedule hid:(FBSimulatorHID *)hid
+{
+  [schedule advanceBy:self.duration];
+}
+
 - (NSString *)description
 {
   return [NSString stringWithFormat:@"Delay for %f", self.duration];
@@ -459,6 +486,18 @@ static NSString *const KeyDuration = @"duration";
   return nil;
 }
 
+- (FBFuture<FBSimulatorHIDScheduleReport *> *)performScheduledOnHID:(FBSimulatorHID *)hid
+{
+  FBSimulatorHIDSchedule *schedule = [[FBSimulatorHIDSchedule alloc] init];
+  [self appendToSchedule:schedule hid:hid];
+  return [hid sendSchedule:schedule];
+}
+
+- (void)appendToSchedule:(FBSimulatorHIDSchedule *)schedule hid:(FBSimulatorHID *)hid
+{
+  NSAssert(NO, @"-[%@ %@] is abstract and should be overridden", NSStringFromClass(self.class), NSStringFromSelector(_cmd));
+}
+
 #pragma mark Private Methods
 
 static NSString *const DirectionDown = @"down";
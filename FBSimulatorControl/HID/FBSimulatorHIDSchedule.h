@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A timed sequence of serialized Indigo messages.
+ Messages are serialized when they are appended, so that nothing other than sending is performed when the schedule is run.
+ */
+@interface FBSimulatorHIDSchedule : NSObject
+
+#pragma mark Public Methods
+
+/**
+ Appends a message, to be sent at the current offset of the schedule.
+
+ @param message the serialized Indigo message.
+ */
+- (void)appendMessage:(NSData *)message;
+
+/**
+ Advances the offset at which subsequent messages are sent.
+
+ @param duration the duration to advance by, in seconds.
+ */
+- (void)advanceBy:(NSTimeInterval)duration;
+
+/**
+ Enumerates the messages in the schedule, in the order in which they are sent.
+
+ @param block the block to call with each message and the offset from the start of the schedule at which it should be sent.
+ */
+- (void)enumerateMessagesUsingBlock:(void (^)(NSData *message, NSTimeInterval offset))block;
+
+#pragma mark Properties
+
+/**
+ The number of messages in the schedule.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ The total duration of the schedule, including any delay after the last message.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval duration;
+
+@end
+
+/**
+ The timing that was achieved when sending a FBSimulatorHIDSchedule.
+ Jitter is how late a message was sent, relative to its scheduled offset.
+ */
+@interface FBSimulatorHIDScheduleReport : NSObject
+
+/**
+ The Designated Initializer.
+
+ @param messageCount the number of messages that were sent.
+ @param scheduledDuration the duration of the schedule.
+ @param actualDuration the time taken to send the schedule.
+ @param meanJitter the mean jitter across all messages.
+ @param maximumJitter the largest jitter of any message.
+ @return a new Schedule Report.
+ */
+- (instancetype)initWithMessageCount:(NSUInteger)messageCount scheduledDuration:(NSTimeInterval)scheduledDuration actualDuration:(NSTimeInterval)actualDuration meanJitter:(NSTimeInterval)meanJitter maximumJitter:(NSTimeInterval)maximumJitter;
+
+/**
+ The number of messages that were sent.
+ */
+@property (nonatomic, assign, readonly) NSUInteger messageCount;
+
+/**
+ The duration of the schedule, in seconds.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval scheduledDuration;
+
+/**
+ The time taken to send the schedule, in seconds.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval actualDuration;
+
+/**
+ The mean jitter across all messages, in seconds.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval meanJitter;
+
+/**
+ The largest jitter of any message, in seconds.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval maximumJitter;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBSimulatorHIDSchedule.h"
+
+@interface FBSimulatorHIDSchedule ()
+
+@property (nonatomic, strong, readonly) NSMutableArray<NSData *> *messages;
+@property (nonatomic, strong, readonly) NSMutableArray<NSNumber *> *offsets;
+@property (nonatomic, assign, readwrite) NSTimeInterval duration;
+
+@end
+
+@implementation FBSimulatorHIDSchedule
+
+#pragma mark Initializers
+
+- (instancetype)init
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _messages = [NSMutableArray array];
+  _offsets = [NSMutableArray array];
+  _duration = 0;
+
+  return self;
+}
+
+#pragma mark Public Methods
+
+- (void)appendMessage:(NSData *)message
+{
+  [self.messages addObject:message];
+  [self.offsets addObject:@(self.duration)];
+}
+
+- (void)advanceBy:(NSTimeInterval)duration
+{
+  self.duration += MAX(duration, 0);
+}
+
+- (void)enumerateMessagesUsingBlock:(void (^)(NSData *message, NSTimeInterval offset))block
+{
+  NSArray<NSData *> *messages = self.messages;
+  NSArray<NSNumber *> *offsets = self.offsets;
+  for (NSUInteger index = 0; index < messages.count; index++) {
+    block(messages[index], offsets[index].doubleValue);
+  }
+}
+
+#pragma mark Properties
+
+- (NSUInteger)count
+{
+  return self.messages.count;
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+  return [NSString stringWithFormat:@"HID Schedule of %lu messages over %f seconds", (unsigned long) self.count, self.duration];
+}
+
+@end
+
+@implementation FBSimulatorHIDScheduleReport
+
+- (instancetype)initWithMessageCount:(NSUInteger)messageCount scheduledDuration:(NSTimeInterval)scheduledDuration actualDuration:(NSTimeInterval)actualDuration meanJitter:(NSTimeInterval)meanJitter maximumJitter:(NSTimeInterval)maximumJitter
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _messageCount = messageCount;
+  _scheduledDuration = scheduledDuration;
+  _actualDuration = actualDuration;
+  _meanJitter = meanJitter;
+  _maximumJitter = maximumJitter;
+
+  return self;
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+  return [NSString stringWithFormat:
+    @"Sent %lu messages in %.3fs (scheduled %.3fs) | Mean Jitter %.3fms | Max Jitter %.3fms",
+    (unsigned long) self.messageCount,
+    self.actualDuration,
+    self.scheduledDuration,
+    self.meanJitter * 1000,
+    self.maximumJitter * 1000
+  ];
+}
+
+@end
@@ -31,6 +31,8 @@ typedef NS_ENUM(int, FBSimulatorHIDButton) {
 
 /**
  Translates FBSimulatorHID Events into Indigo Structs.
+ A template message is generated once for each kind of event, each message is then a copy of the template with the coordinates and timestamp patched in.
+ Messages are copied into buffers that are pooled by the receiver, a buffer is reused once the data wrapping it has been deallocated.
  */
 @interface FBSimulatorIndigoHID : NSObject
 
@@ -54,7 +56,7 @@ typedef NS_ENUM(int, FBSimulatorHIDButton) {
 
  @param direction the direction of the event.
  @param keycode the Key Code to send. The keycodes are 'Hardware Independent' as described in <HIToolbox/Events.h>.
- @return an NSData-Wrapped IndigoMessage. The data is owned by the receiver and will be freed when the data is deallocated.
+ @return an NSData-Wrapped IndigoMessage. The buffer is owned by the receiver and will be reused when the data is deallocated.
  */
 - (NSData *)keyboardWithDirection:(FBSimulatorHIDDirection)direction keyCode:(unsigned int)keycode;
 
@@ -63,7 +65,7 @@ typedef NS_ENUM(int, FBSimulatorHIDButton) {
 
  @param direction the direction of the event.
  @param button the button.
- @return an NSData-Wrapped IndigoMessage. The data is owned by the receiver and will be freed when the data is deallocated.
+ @return an NSData-Wrapped IndigoMessage. The buffer is owned by the receiver and will be reused when the data is deallocated.
  */
 - (NSData *)buttonWithDirection:(FBSimulatorHIDDirection)direction button:(FBSimulatorHIDButton)button;
 
@@ -74,7 +76,7 @@ typedef NS_ENUM(int, FBSimulatorHIDButton) {
  @param direction the direction of the event.
  @param x the X-Coordinate in pixels
  @param y the Y-Coordinate pixels
- @return an NSData-Wrapped IndigoMessage. The data is owned by the receiver and will be freed when the data is deallocated.
+ @return an NSData-Wrapped IndigoMessage. The buffer is owned by the receiver and will be reused when the data is deallocated.
  */
 - (NSData *)touchScreenSize:(CGSize)screenSize direction:(FBSimulatorHIDDirection)direction x:(double)x y:(double)y;
 
@@ -86,10 +88,27 @@ typedef NS_ENUM(int, FBSimulatorHIDButton) {
  @param direction the direction of the event.
  @param x the X-Coordinate in pixels
  @param y the Y-Coordinate pixels
- @return an NSData-Wrapped IndigoMessage. The data is owned by the receiver and will be freed when the data is deallocated.
+ @return an NSData-Wrapped IndigoMessage. The buffer is owned by the receiver and will be reused when the data is deallocated.
  */
 - (NSData *)touchScreenSize:(CGSize)screenSize screenScale:(float)screenScale direction:(FBSimulatorHIDDirection)direction x:(double)x y:(double)y;
 
+/**
+ Replaces the timestamp of a message, including that of the second payload of a Touch.
+ Messages are stamped when they are generated, this allows a message that is sent later to carry the time at which it is sent.
+
+ @param message an NSData-Wrapped IndigoMessage, as returned by an FBSimulatorIndigoHID instance. It is modified in place.
+ @param timestamp the mach_absolute_time to stamp the message with.
+ */
++ (void)stampMessage:(NSData *)message withTimestamp:(uint64_t)timestamp;
+
+#pragma mark Properties
+
+/**
+ The number of message buffers that have been allocated by the receiver.
+ Since buffers are reused, this is bounded by the number of messages that are alive at any one time, rather than the number of events that have been generated.
+ */
+@property (atomic, assign, readonly) NSUInteger messageBuffersAllocated;
+
 @end
 
 NS_ASSUME_NONNULL_END
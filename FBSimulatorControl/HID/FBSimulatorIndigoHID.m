@@ -36,6 +36,146 @@ typedef struct {
 
 @end
 
+// The number of unused buffers that a pool retains, beyond this buffers are freed.
+static const NSUInteger FBSimulatorIndigoMessagePoolCapacity = 64;
+
+typedef NS_ENUM(uint64_t, FBSimulatorIndigoTemplateKind) {
+  FBSimulatorIndigoTemplateKindKeyboard = 1,
+  FBSimulatorIndigoTemplateKindButton = 2,
+  FBSimulatorIndigoTemplateKindTouch = 3,
+};
+
+// Unused buffers form a linked-list through their first bytes, so that returning a buffer to the pool does not allocate.
+typedef struct FBSimulatorIndigoMessagePoolEntry {
+  struct FBSimulatorIndigoMessagePoolEntry *next;
+} FBSimulatorIndigoMessagePoolEntry;
+
+/**
+ A Pool of equally sized buffers for Indigo Messages.
+ */
+@interface FBSimulatorIndigoMessagePool : NSObject
+{
+  FBSimulatorIndigoMessagePoolEntry *_head;
+  NSUInteger _count;
+}
+
+@property (nonatomic, assign, readonly) size_t messageSize;
+@property (atomic, assign, readonly) NSUInteger buffersAllocated;
+
+@end
+
+@implementation FBSimulatorIndigoMessagePool
+
+@synthesize buffersAllocated = _buffersAllocated;
+
+- (instancetype)initWithMessageSize:(size_t)messageSize
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _messageSize = MAX(messageSize, sizeof(FBSimulatorIndigoMessagePoolEntry));
+
+  return self;
+}
+
+- (void)dealloc
+{
+  while (_head) {
+    FBSimulatorIndigoMessagePoolEntry *next = _head->next;
+    free(_head);
+    _head = next;
+  }
+}
+
+- (IndigoMessage *)dequeueBuffer
+{
+  @synchronized (self) {
+    FBSimulatorIndigoMessagePoolEntry *entry = _head;
+    if (entry) {
+      _head = entry->next;
+      _count -= 1;
+      return (IndigoMessage *) entry;
+    }
+    _buffersAllocated += 1;
+  }
+  return malloc(self.messageSize);
+}
+
+- (void)enqueueBuffer:(IndigoMessage *)buffer
+{
+  @synchronized (self) {
+    if (_count < FBSimulatorIndigoMessagePoolCapacity) {
+      FBSimulatorIndigoMessagePoolEntry *entry = (FBSimulatorIndigoMessagePoolEntry *) buffer;
+      entry->next = _head;
+      _head = entry;
+      _count += 1;
+      return;
+    }
+  }
+  free(buffer);
+}
+
+- (NSUInteger)buffersAllocated
+{
+  @synchronized (self) {
+    return _buffersAllocated;
+  }
+}
+
+@end
+
+/**
+ An NSData that returns its buffer to a pool when it is deallocated.
+ */
+@interface FBSimulatorIndigoMessageData : NSData
+{
+  FBSimulatorIndigoMessagePool *_pool;
+  IndigoMessage *_message;
+}
+
+@end
+
+@implementation FBSimulatorIndigoMessageData
+
+- (instancetype)initWithPool:(FBSimulatorIndigoMessagePool *)pool message:(IndigoMessage *)message
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _pool = pool;
+  _message = message;
+
+  return self;
+}
+
+- (void)dealloc
+{
+  [_pool enqueueBuffer:_message];
+}
+
+- (const void *)bytes
+{
+  return _message;
+}
+
+- (NSUInteger)length
+{
+  return _pool.messageSize;
+}
+
+@end
+
+@interface FBSimulatorIndigoHID ()
+
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSNumber *, NSData *> *templates;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSNumber *, FBSimulatorIndigoMessagePool *> *pools;
+
+@end
+
 @implementation FBSimulatorIndigoHID
 
 #pragma mark Initializers
@@ -59,20 +199,47 @@ typedef struct {
   return [FBSimulatorIndigoHID_Reimplemented new];
 }
 
+- (instancetype)init
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _templates = [NSMutableDictionary dictionary];
+  _pools = [NSMutableDictionary dictionary];
+
+  return self;
+}
+
 #pragma mark Public
 
 - (NSData *)keyboardWithDirection:(FBSimulatorHIDDirection)direction keyCode:(unsigned int)keyCode
 {
-  size_t messageSize;
-  IndigoMessage *message = [self keyboardMessageWithDirection:direction keyCode:keyCode messageSizeOut:&messageSize];
-  return [NSData dataWithBytesNoCopy:message length:messageSize freeWhenDone:YES];
+  NSNumber *key = [FBSimulatorIndigoHID templateKeyForKind:FBSimulatorIndigoTemplateKindKeyboard direction:direction code:keyCode];
+  NSData *template = [self templateForKey:key];
+  if (!template) {
+    size_t messageSize;
+    IndigoMessage *message = [self keyboardMessageWithDirection:direction keyCode:keyCode messageSizeOut:&messageSize];
+    template = [self storeTemplate:message messageSize:messageSize forKey:key];
+  }
+  FBSimulatorIndigoMessagePool *pool = nil;
+  IndigoMessage *message = [self messageFromTemplate:template poolOut:&pool];
+  return [[FBSimulatorIndigoMessageData alloc] initWithPool:pool message:message];
 }
 
 - (NSData *)buttonWithDirection:(FBSimulatorHIDDirection)direction button:(FBSimulatorHIDButton)button
 {
-  size_t messageSize;
-  IndigoMessage *message = [self buttonMessageWithDirection:direction button:button messageSizeOut:&messageSize];
-  return [NSData dataWithBytesNoCopy:message length:messageSize freeWhenDone:YES];
+  NSNumber *key = [FBSimulatorIndigoHID templateKeyForKind:FBSimulatorIndigoTemplateKindButton direction:direction code:(unsigned int) button];
+  NSData *template = [self templateForKey:key];
+  if (!template) {
+    size_t messageSize;
+    IndigoMessage *message = [self buttonMessageWithDirection:direction button:button messageSizeOut:&messageSize];
+    template = [self storeTemplate:message messageSize:messageSize forKey:key];
+  }
+  FBSimulatorIndigoMessagePool *pool = nil;
+  IndigoMessage *message = [self messageFromTemplate:template poolOut:&pool];
+  return [[FBSimulatorIndigoMessageData alloc] initWithPool:pool message:message];
 }
 
 - (NSData *)touchScreenSize:(CGSize)screenSize direction:(FBSimulatorHIDDirection)direction x:(double)x y:(double)y
@@ -82,11 +249,98 @@ typedef struct {
 
 - (NSData *)touchScreenSize:(CGSize)screenSize screenScale:(float)screenScale direction:(FBSimulatorHIDDirection)direction x:(double)x y:(double)y
 {
+  NSNumber *key = [FBSimulatorIndigoHID templateKeyForKind:FBSimulatorIndigoTemplateKindTouch direction:direction code:0];
+  NSData *template = [self templateForKey:key];
+  if (!template) {
+    size_t messageSize;
+    IndigoMessage *message = [self touchMessageWithPoint:CGPointZero direction:direction messageSizeOut:&messageSize];
+    template = [self storeTemplate:message messageSize:messageSize forKey:key];
+  }
+  FBSimulatorIndigoMessagePool *pool = nil;
+  IndigoMessage *message = [self messageFromTemplate:template poolOut:&pool];
+
   // Convert Screen Offset to Ratio for Indigo.
+  // The point is present in both of the payloads of a touch, the second payload immediately follows the first.
   CGPoint point = [self.class screenRatioFromPoint:CGPointMake(x, y) screenSize:screenSize screenScale:screenScale];
-  size_t messageSize;
-  IndigoMessage *message = [self touchMessageWithPoint:point direction:direction messageSizeOut:&messageSize];
-  return [NSData dataWithBytesNoCopy:message length:messageSize freeWhenDone:YES];
+  IndigoPayload *first = &(message->payload);
+  IndigoPayload *second = (IndigoPayload *) ((void *) first + sizeof(IndigoPayload));
+  first->event.touch.xRatio = point.x;
+  first->event.touch.yRatio = point.y;
+  second->event.touch.xRatio = point.x;
+  second->event.touch.yRatio = point.y;
+  second->timestamp = first->timestamp;
+
+  return [[FBSimulatorIndigoMessageData alloc] initWithPool:pool message:message];
+}
+
++ (void)stampMessage:(NSData *)message withTimestamp:(uint64_t)timestamp
+{
+  NSParameterAssert(message.length >= sizeof(IndigoMessage));
+  // The buffer of the message is owned by a pool and is writable, the data only exposes it as immutable.
+  IndigoMessage *indigoMessage = (IndigoMessage *) message.bytes;
+  IndigoPayload *first = &(indigoMessage->payload);
+  first->timestamp = timestamp;
+  if (indigoMessage->eventType == IndigoEventTypeTouch && message.length >= sizeof(IndigoMessage) + sizeof(IndigoPayload)) {
+    IndigoPayload *second = (IndigoPayload *) ((void *) first + sizeof(IndigoPayload));
+    second->timestamp = timestamp;
+  }
+}
+
+#pragma mark Properties
+
+- (NSUInteger)messageBuffersAllocated
+{
+  NSArray<FBSimulatorIndigoMessagePool *> *pools = nil;
+  @synchronized (self) {
+    pools = self.pools.allValues;
+  }
+  NSUInteger buffersAllocated = 0;
+  for (FBSimulatorIndigoMessagePool *pool in pools) {
+    buffersAllocated += pool.buffersAllocated;
+  }
+  return buffersAllocated;
+}
+
+#pragma mark Templates
+
++ (NSNumber *)templateKeyForKind:(FBSimulatorIndigoTemplateKind)kind direction:(FBSimulatorHIDDirection)direction code:(unsigned int)code
+{
+  // Small enough to be a tagged pointer, so constructing a key does not allocate.
+  return @((kind << 40) | ((uint64_t) direction << 32) | code);
+}
+
+- (nullable NSData *)templateForKey:(NSNumber *)key
+{
+  @synchronized (self) {
+    return self.templates[key];
+  }
+}
+
+- (NSData *)storeTemplate:(IndigoMessage *)message messageSize:(size_t)messageSize forKey:(NSNumber *)key
+{
+  NSData *template = [NSData dataWithBytesNoCopy:message length:messageSize freeWhenDone:YES];
+  @synchronized (self) {
+    self.templates[key] = template;
+  }
+  return template;
+}
+
+- (IndigoMessage *)messageFromTemplate:(NSData *)template poolOut:(FBSimulatorIndigoMessagePool **)poolOut
+{
+  FBSimulatorIndigoMessagePool *pool = nil;
+  @synchronized (self) {
+    NSNumber *size = @(template.length);
+    pool = self.pools[size];
+    if (!pool) {
+      pool = [[FBSimulatorIndigoMessagePool alloc] initWithMessageSize:template.length];
+      self.pools[size] = pool;
+    }
+  }
+  IndigoMessage *message = [pool dequeueBuffer];
+  memcpy(message, template.bytes, template.length);
+  message->payload.timestamp = mach_absolute_time();
+  *poolOut = pool;
+  return message;
 }
 
 #pragma mark Event Generation
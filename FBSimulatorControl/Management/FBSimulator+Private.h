@@ -6,6 +6,7 @@
  */
 
 #import <FBSimulatorControl/FBSimulator.h>
+#import <FBSimulatorControl/FBSimulatorRunningApplicationTable.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -14,7 +15,7 @@ NS_ASSUME_NONNULL_BEGIN
 @protocol FBControlCoreLogger;
 @protocol FBEventReporter;
 
-@interface FBSimulator ()
+@interface FBSimulator () <FBSimulatorRunningApplicationTableSource>
 
 @property (nonatomic, copy, readwrite) FBSimulatorConfiguration *configuration;
 @property (nonatomic, copy, readwrite, nullable) FBProcessInfo *containerApplication;
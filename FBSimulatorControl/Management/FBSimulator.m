@@ -308,6 +308,7 @@ static NSString *const DefaultDeviceSet = @"~/Library/Developer/CoreSimulator/De
   static NSSet<Class> *statefulCommands;
   dispatch_once(&onceToken, ^{
     statefulCommands = [NSSet setWithArray:@[
+      FBSimulatorApplicationCommands.class,
       FBSimulatorCrashLogCommands.class,
       FBSimulatorLifecycleCommands.class,
       FBSimulatorScreenshotCommands.class,
@@ -21,4 +21,9 @@
 @property (nonatomic, strong, readonly) FBSimulatorContainerApplicationLifecycleStrategy *containerApplicationStrategy;
 @property (nonatomic, strong, readonly) FBSimulatorNotificationUpdateStrategy *notificationUpdateStrategy;
 
+/**
+ Signalled whenever CoreSimulator notifies of a change to a device in the set, so that waits on the state of a Simulator don't need to poll.
+ */
+@property (nonatomic, strong, readonly) FBFutureCondition *devicesChanged;
+
 @end
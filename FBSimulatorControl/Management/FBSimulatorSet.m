@@ -67,6 +67,7 @@
   _processFetcher = [FBSimulatorProcessFetcher fetcherWithProcessFetcher:[FBProcessFetcher new]];
   _inflationStrategy = [FBSimulatorInflationStrategy strategyForSet:self];
   _containerApplicationStrategy = [FBSimulatorContainerApplicationLifecycleStrategy strategyForSet:self];
+  _devicesChanged = [FBFutureCondition new];
   _notificationUpdateStrategy = [FBSimulatorNotificationUpdateStrategy strategyWithSet:self];
 
   return self;
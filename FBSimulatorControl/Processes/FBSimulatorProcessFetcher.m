@@ -20,6 +20,12 @@
 NSString *const FBSimulatorControlSimulatorLaunchEnvironmentSimulatorUDID = @"FBSIMULATORCONTROL_SIM_UDID";
 NSString *const FBSimulatorControlSimulatorLaunchEnvironmentDeviceSetPath = @"FBSIMULATORCONTROL_SIM_SET_PATH";
 
+@interface FBSimulatorProcessFetcher ()
+
+@property (nonatomic, strong, readonly) NSMutableDictionary<FBProcessInfo *, id> *launchdProcessToUDID;
+
+@end
+
 @implementation FBSimulatorProcessFetcher
 
 + (instancetype)fetcherWithProcessFetcher:(FBProcessFetcher *)processFetcher
@@ -35,6 +41,7 @@ NSString *const FBSimulatorControlSimulatorLaunchEnvironmentDeviceSetPath = @"FB
   }
 
   _processFetcher = processFetcher;
+  _launchdProcessToUDID = [NSMutableDictionary dictionary];
 
   return self;
 }
@@ -121,9 +128,14 @@ NSString *const FBSimulatorControlSimulatorLaunchEnvironmentDeviceSetPath = @"FB
 - (NSDictionary<FBProcessInfo *, NSString *> *)launchdProcessesToContainingDeviceSet
 {
   NSMutableDictionary<FBProcessInfo *, NSString *> *dictionary = [NSMutableDictionary dictionary];
+  NSDictionary<FBProcessInfo *, id> *processToUDID = [self indexLaunchdProcesses];
 
-  for (FBProcessInfo *process in self.launchdProcesses) {
-    NSString *deviceSetPath = [FBSimulatorProcessFetcher deviceSetPathForLaunchdSim:process];
+  for (FBProcessInfo *process in processToUDID) {
+    id udid = processToUDID[process];
+    if (udid == NSNull.null) {
+      continue;
+    }
+    NSString *deviceSetPath = [FBSimulatorProcessFetcher deviceSetPathForLaunchdSim:process udid:udid];
     if (!deviceSetPath) {
       continue;
     }
@@ -189,6 +201,21 @@ NSString *const FBSimulatorControlSimulatorLaunchEnvironmentDeviceSetPath = @"FB
 
 #pragma mark Private
 
+- (NSDictionary<FBProcessInfo *, id> *)indexLaunchdProcesses
+{
+  NSArray<FBProcessInfo *> *processes = self.launchdProcesses;
+  @synchronized (self.launchdProcessToUDID) {
+    NSMutableDictionary<FBProcessInfo *, id> *index = self.launchdProcessToUDID;
+    // Processes that are no longer running are dropped from the index, new ones are added.
+    NSMutableDictionary<FBProcessInfo *, id> *current = [NSMutableDictionary dictionaryWithCapacity:processes.count];
+    for (FBProcessInfo *process in processes) {
+      current[process] = index[process] ?: [FBSimulatorProcessFetcher udidForLaunchdSim:process] ?: NSNull.null;
+    }
+    [index setDictionary:current];
+    return [current copy];
+  }
+}
+
 + (nullable NSString *)udidForLaunchdSim:(FBProcessInfo *)process
 {
   if ([process.launchPath rangeOfString:@"launchd_sim"].location == NSNotFound) {
@@ -204,12 +231,8 @@ NSString *const FBSimulatorControlSimulatorLaunchEnvironmentDeviceSetPath = @"FB
   return [components anyObject];
 }
 
-+ (nullable NSString *)deviceSetPathForLaunchdSim:(FBProcessInfo *)process
++ (nullable NSString *)deviceSetPathForLaunchdSim:(FBProcessInfo *)process udid:(NSString *)udid
 {
-  NSString *udid = [self udidForLaunchdSim:process];
-  if (!udid) {
-    return nil;
-  }
   if (process.arguments.count < 2) {
     return nil;
   }
@@ -87,7 +87,7 @@
       NSMutableSet<NSString *> *remainderSet = [NSMutableSet setWithSet:deletedDeviceUDIDs];
       [remainderSet intersectSet:[NSSet setWithArray:[set.allSimulators valueForKey:@"udid"]]];
       return remainderSet.count == 0;
-    }]
+    } signalledBy:set.devicesChanged]
     timeout:FBControlCoreGlobalConfiguration.regularTimeout waitingFor:@"Simulator to be removed from set"]
     mapReplace:deletedDeviceUDIDs.allObjects];
 }
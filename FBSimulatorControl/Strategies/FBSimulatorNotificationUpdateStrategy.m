@@ -14,6 +14,7 @@
 #import "FBSimulator.h"
 #import "FBSimulatorProcessFetcher.h"
 #import "FBSimulatorSet.h"
+#import "FBSimulatorSet+Private.h"
 #import "FBSimulator+Private.h"
 
 @interface FBSimulatorNotificationUpdateStrategy ()
@@ -58,6 +59,8 @@
 {
   __weak typeof(self) weakSelf = self;
   self.notifier = [FBCoreSimulatorNotifier notifierForSet:self.set queue:dispatch_get_main_queue() block:^(NSDictionary *info) {
+    // Any notification may change the state that a wait on the set is evaluating, including devices being added or removed.
+    [weakSelf.set.devicesChanged signal];
     SimDevice *device = info[@"device"];
     if (!device) {
       return;
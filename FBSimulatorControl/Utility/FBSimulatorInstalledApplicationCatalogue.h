@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FBSimulator;
+
+/**
+ A Cache of the Applications installed on a Simulator, keyed by Bundle ID.
+ The catalogue is loaded from CoreSimulator on first use, then served from memory until it is invalidated.
+ Installs and uninstalls performed through the Simulator invalidate the catalogue explicitly.
+ Changes made by other processes are detected from the change time of the Simulator's Application Bundle container directory.
+ */
+@interface FBSimulatorInstalledApplicationCatalogue : NSObject
+
+#pragma mark Initializers
+
+/**
+ The Designated Initializer.
+
+ @param simulator the Simulator to catalogue Applications for.
+ @return a new Installed Application Catalogue.
+ */
++ (instancetype)catalogueWithSimulator:(FBSimulator *)simulator;
+
+#pragma mark Public Methods
+
+/**
+ Fetches all of the Applications installed on the Simulator.
+
+ @return A future wrapping the installed Applications.
+ */
+- (FBFuture<NSArray<FBInstalledApplication *> *> *)installedApplications;
+
+/**
+ Fetches an installed Application by Bundle ID.
+ Will fail if the Application is not installed.
+
+ @param bundleID the Bundle ID of the Application.
+ @return A future wrapping the installed Application.
+ */
+- (FBFuture<FBInstalledApplication *> *)installedApplicationWithBundleID:(NSString *)bundleID;
+
+/**
+ Marks the catalogue as stale, so that the next query re-loads it.
+ Should be called when an Application is installed or uninstalled, before the install or uninstall is reported as complete.
+ Must not be called on the queue of the catalogue.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBSimulatorInstalledApplicationCatalogue.h"
+
+#import <CoreSimulator/SimDevice.h>
+
+#include <sys/stat.h>
+
+#import "FBSimulator.h"
+#import "FBSimulatorError.h"
+
+static struct timespec FBChangeTime(NSString *path)
+{
+  struct stat info;
+  if (stat(path.fileSystemRepresentation, &info) != 0) {
+    return (struct timespec) {0, 0};
+  }
+  return info.st_ctimespec;
+}
+
+static int FBTimespecCompare(struct timespec left, struct timespec right)
+{
+  if (left.tv_sec != right.tv_sec) {
+    return left.tv_sec < right.tv_sec ? -1 : 1;
+  }
+  if (left.tv_nsec != right.tv_nsec) {
+    return left.tv_nsec < right.tv_nsec ? -1 : 1;
+  }
+  return 0;
+}
+
+@interface FBSimulatorInstalledApplicationCatalogue ()
+
+@property (nonatomic, weak, readonly) FBSimulator *simulator;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, copy, nullable, readwrite) NSDictionary<NSString *, FBInstalledApplication *> *applications;
+@property (nonatomic, assign, readwrite) struct timespec containerChangeTime;
+@property (nonatomic, assign, readwrite) struct timespec loadTime;
+@property (nonatomic, assign, readwrite) BOOL invalidated;
+
+@end
+
+@implementation FBSimulatorInstalledApplicationCatalogue
+
+#pragma mark Initializers
+
++ (instancetype)catalogueWithSimulator:(FBSimulator *)simulator
+{
+  return [[self alloc] initWithSimulator:simulator];
+}
+
+- (instancetype)initWithSimulator:(FBSimulator *)simulator
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _simulator = simulator;
+  _queue = dispatch_queue_create("com.facebook.fbsimulatorcontrol.installed_applications", DISPATCH_QUEUE_SERIAL);
+
+  return self;
+}
+
+#pragma mark Public Methods
+
+- (FBFuture<NSArray<FBInstalledApplication *> *> *)installedApplications
+{
+  return [FBFuture
+    onQueue:self.queue resolveValue:^ NSArray<FBInstalledApplication *> * (NSError **error) {
+      return [[self currentApplicationsWithError:error] allValues];
+    }];
+}
+
+- (FBFuture<FBInstalledApplication *> *)installedApplicationWithBundleID:(NSString *)bundleID
+{
+  return [FBFuture
+    onQueue:self.queue resolveValue:^ FBInstalledApplication * (NSError **error) {
+      NSDictionary<NSString *, FBInstalledApplication *> *applications = [self currentApplicationsWithError:error];
+      if (!applications) {
+        return nil;
+      }
+      FBInstalledApplication *application = applications[bundleID];
+      if (!application) {
+        return [[FBSimulatorError
+          describeFormat:@"%@ is not installed", bundleID]
+          fail:error];
+      }
+      return application;
+    }];
+}
+
+- (void)invalidate
+{
+  // Synchronous, so that a query made after this returns cannot be served from the stale catalogue.
+  dispatch_sync(self.queue, ^{
+    self.invalidated = YES;
+  });
+}
+
+#pragma mark Private
+
+- (nullable NSDictionary<NSString *, FBInstalledApplication *> *)currentApplicationsWithError:(NSError **)error
+{
+  FBSimulator *simulator = self.simulator;
+  if (!simulator) {
+    return [[FBSimulatorError describe:@"Simulator has been deallocated"] fail:error];
+  }
+  // User Applications are installed into their own directory within this one, so installs and uninstalls change it.
+  NSString *containerPath = [simulator.dataDirectory stringByAppendingPathComponent:@"Containers/Bundle/Application"];
+  struct timespec containerChangeTime = FBChangeTime(containerPath);
+  if (self.applications && !self.invalidated && FBTimespecCompare(containerChangeTime, self.containerChangeTime) == 0) {
+    return self.applications;
+  }
+
+  struct timespec loadTime;
+  clock_gettime(CLOCK_REALTIME, &loadTime);
+  NSDictionary<NSString *, NSDictionary<NSString *, id> *> *installedApps = [simulator.device installedAppsWithError:error];
+  if (!installedApps) {
+    return nil;
+  }
+  NSDictionary<NSString *, FBInstalledApplication *> *previousApplications = self.applications ?: @{};
+  NSMutableDictionary<NSString *, FBInstalledApplication *> *applications = [NSMutableDictionary dictionary];
+  for (NSDictionary<NSString *, id> *appInfo in installedApps.allValues) {
+    NSString *bundleID = appInfo[FBApplicationInstallInfoKeyBundleIdentifier];
+    FBInstalledApplication *previous = [bundleID isKindOfClass:NSString.class] ? previousApplications[bundleID] : nil;
+    FBInstalledApplication *application = [FBSimulatorInstalledApplicationCatalogue installedApplicationFromInfo:appInfo previous:previous previousLoad:self.loadTime error:nil];
+    if (!application) {
+      continue;
+    }
+    applications[bundleID] = application;
+  }
+  self.applications = applications;
+  self.containerChangeTime = containerChangeTime;
+  self.loadTime = loadTime;
+  self.invalidated = NO;
+  return self.applications;
+}
+
+static NSString *const KeyDataContainer = @"DataContainer";
+
++ (nullable FBInstalledApplication *)installedApplicationFromInfo:(NSDictionary<NSString *, id> *)appInfo previous:(nullable FBInstalledApplication *)previous previousLoad:(struct timespec)previousLoad error:(NSError **)error
+{
+  NSString *appName = appInfo[FBApplicationInstallInfoKeyBundleName];
+  if (![appName isKindOfClass:NSString.class]) {
+    return [[FBControlCoreError
+      describeFormat:@"Bundle Name %@ is not a String for %@ in %@", appName, FBApplicationInstallInfoKeyBundleName, appInfo]
+      fail:error];
+  }
+  NSString *bundleIdentifier = appInfo[FBApplicationInstallInfoKeyBundleIdentifier];
+  if (![bundleIdentifier isKindOfClass:NSString.class]) {
+    return [[FBControlCoreError
+      describeFormat:@"Bundle Identifier %@ is not a String for %@ in %@", bundleIdentifier, FBApplicationInstallInfoKeyBundleIdentifier, appInfo]
+      fail:error];
+  }
+  NSString *appPath = appInfo[FBApplicationInstallInfoKeyPath];
+  if (![appPath isKindOfClass:NSString.class]) {
+    return [[FBControlCoreError
+      describeFormat:@"App Path %@ is not a String for %@ in %@", appPath, FBApplicationInstallInfoKeyPath, appInfo]
+      fail:error];
+  }
+  NSString *typeString = appInfo[FBApplicationInstallInfoKeyApplicationType];
+  if (![typeString isKindOfClass:NSString.class]) {
+    return [[FBControlCoreError
+      describeFormat:@"Install Type %@ is not a String for %@ in %@", typeString, FBApplicationInstallInfoKeyApplicationType, appInfo]
+      fail:error];
+  }
+  NSURL *dataContainer = appInfo[KeyDataContainer];
+  if (dataContainer && ![dataContainer isKindOfClass:NSURL.class]) {
+    return [[FBControlCoreError
+      describeFormat:@"Data Container %@ is not a NSURL for %@ in %@", dataContainer, KeyDataContainer, appInfo]
+      fail:error];
+  }
+
+  // Loading the bundle descriptor from disk is the expensive part, so an unmodified bundle is re-used from the previous load.
+  FBApplicationInstallType installType = [FBInstalledApplication installTypeFromString:typeString signerIdentity:nil];
+  if (previous && [previous.bundle.path isEqualToString:appPath] && previous.installType == installType && (previous.dataContainer == dataContainer.path || [previous.dataContainer isEqualToString:dataContainer.path])) {
+    struct timespec changed = FBChangeTime([appPath stringByAppendingPathComponent:@"Info.plist"]);
+    if (changed.tv_sec != 0 && FBTimespecCompare(changed, previousLoad) < 0) {
+      return previous;
+    }
+  }
+
+  FBBundleDescriptor *bundle = [FBBundleDescriptor bundleFromPath:appPath error:error];
+  if (!bundle) {
+    return nil;
+  }
+
+  return [FBInstalledApplication
+    installedApplicationWithBundle:bundle
+    installType:installType
+    dataContainer:dataContainer.path];
+}
+
+@end
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The parts of a Simulator that a Running Application Table is populated from.
+ */
+@protocol FBSimulatorRunningApplicationTableSource <NSObject>
+
+/**
+ The launchd_sim of the Simulator, nil if the Simulator is not booted.
+ */
+@property (nonatomic, copy, nullable, readonly) FBProcessInfo *launchdProcess;
+
+/**
+ Fetches the subprocesses of the launchd_sim.
+ */
+- (NSArray<FBProcessInfo *> *)launchdSimSubprocesses;
+
+/**
+ Fetches the launchctl services matching the substring.
+
+ @param substring a Substring of the Service to fetch.
+ @return A Future, wrapping a mapping of Service Name to Process Identifier.
+ */
+- (FBFuture<NSDictionary<NSString *, NSNumber *> *> *)serviceNamesAndProcessIdentifiersForSubstring:(NSString *)substring;
+
+@end
+
+/**
+ A Cache of the Applications running in a Simulator, keyed by Bundle ID.
+ The table is populated from `launchctl list` once, then kept current from process exit notifications and from Applications launched through the Simulator.
+ The table is re-populated when the Simulator's launchd_sim changes.
+ The subprocesses of launchd_sim are only inspected when all running Applications are requested, or when a lookup misses, in which case an Application process that has not been accounted for also re-populates the table.
+ */
+@interface FBSimulatorRunningApplicationTable : NSObject
+
+#pragma mark Initializers
+
+/**
+ The Designated Initializer.
+
+ @param simulator the Simulator to track Applications for.
+ @return a new Running Application Table.
+ */
++ (instancetype)tableWithSimulator:(id<FBSimulatorRunningApplicationTableSource>)simulator;
+
+#pragma mark Public Methods
+
+/**
+ Fetches a Mapping of the Bundle IDs of running Applications to their Process Identifiers.
+
+ @return A future wrapping the Mapping of Bundle ID to Process Identifier.
+ */
+- (FBFuture<NSDictionary<NSString *, NSNumber *> *> *)runningApplications;
+
+/**
+ Fetches the Process Identifier of a running Application.
+ Will fail if the Application is not running.
+
+ @param bundleID the Bundle ID of the Application.
+ @return A future wrapping the Process Identifier.
+ */
+- (FBFuture<NSNumber *> *)processIdentifierForBundleID:(NSString *)bundleID;
+
+/**
+ Records an Application that has been launched, so that it can be found without re-populating the table.
+
+ @param bundleID the Bundle ID of the launched Application.
+ @param processIdentifier the Process Identifier of the launched Application.
+ */
+- (void)recordLaunchedApplication:(NSString *)bundleID processIdentifier:(pid_t)processIdentifier;
+
+@end
+
+NS_ASSUME_NONNULL_END
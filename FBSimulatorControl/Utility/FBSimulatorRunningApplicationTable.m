@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBSimulatorRunningApplicationTable.h"
+
+#import "FBSimulatorError.h"
+#import "FBSimulatorLaunchCtlCommands.h"
+
+static BOOL FBIsApplicationProcess(FBProcessInfo *process)
+{
+  return [process.launchPath.stringByDeletingLastPathComponent.pathExtension isEqualToString:@"app"];
+}
+
+static BOOL FBIsProcessAlive(pid_t processIdentifier)
+{
+  return kill(processIdentifier, 0) == 0 || errno != ESRCH;
+}
+
+@interface FBSimulatorRunningApplicationTable ()
+
+@property (nonatomic, weak, readonly) id<FBSimulatorRunningApplicationTableSource> simulator;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSString *, NSNumber *> *bundleIDToProcessIdentifier;
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSNumber *, FBFuture<NSNumber *> *> *terminationFutures;
+@property (nonatomic, strong, readonly) NSMutableSet<NSNumber *> *ignoredProcessIdentifiers;
+@property (nonatomic, strong, nullable, readwrite) FBFuture<NSNull *> *population;
+@property (nonatomic, assign, readwrite) pid_t launchdProcessIdentifier;
+
+@end
+
+@implementation FBSimulatorRunningApplicationTable
+
+#pragma mark Initializers
+
++ (instancetype)tableWithSimulator:(id<FBSimulatorRunningApplicationTableSource>)simulator
+{
+  return [[self alloc] initWithSimulator:simulator];
+}
+
+- (instancetype)initWithSimulator:(id<FBSimulatorRunningApplicationTableSource>)simulator
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _simulator = simulator;
+  _queue = dispatch_queue_create("com.facebook.fbsimulatorcontrol.running_applications", DISPATCH_QUEUE_SERIAL);
+  _bundleIDToProcessIdentifier = [NSMutableDictionary dictionary];
+  _terminationFutures = [NSMutableDictionary dictionary];
+  _ignoredProcessIdentifiers = [NSMutableSet set];
+
+  return self;
+}
+
+- (void)dealloc
+{
+  for (FBFuture<NSNumber *> *future in _terminationFutures.allValues) {
+    [future cancel];
+  }
+}
+
+#pragma mark Public Methods
+
+- (FBFuture<NSDictionary<NSString *, NSNumber *> *> *)runningApplications
+{
+  return [[FBFuture
+    onQueue:self.queue resolve:^{
+      return [self populatedTableCheckingForUntrackedApplications:YES];
+    }]
+    onQueue:self.queue map:^(id _) {
+      for (NSString *bundleID in self.bundleIDToProcessIdentifier.allKeys) {
+        pid_t processIdentifier = self.bundleIDToProcessIdentifier[bundleID].intValue;
+        if (!FBIsProcessAlive(processIdentifier)) {
+          [self processTerminated:processIdentifier];
+        }
+      }
+      return [self.bundleIDToProcessIdentifier copy];
+    }];
+}
+
+- (FBFuture<NSNumber *> *)processIdentifierForBundleID:(NSString *)bundleID
+{
+  return [[FBFuture
+    onQueue:self.queue resolve:^{
+      return [self populatedTableCheckingForUntrackedApplications:NO];
+    }]
+    onQueue:self.queue fmap:^ FBFuture<NSNumber *> * (id _) {
+      NSNumber *processIdentifier = [self liveProcessIdentifierForBundleID:bundleID];
+      if (processIdentifier) {
+        return [FBFuture futureWithResult:processIdentifier];
+      }
+      // The Application may have been launched by something other than the Simulator, which only the subprocesses of launchd_sim show.
+      return [[self
+        populatedTableCheckingForUntrackedApplications:YES]
+        onQueue:self.queue fmap:^ FBFuture<NSNumber *> * (id __) {
+          NSNumber *repopulatedProcessIdentifier = [self liveProcessIdentifierForBundleID:bundleID];
+          if (!repopulatedProcessIdentifier) {
+            return [[FBSimulatorError
+              describeFormat:@"No Matching processes for UIKitApplication:%@", bundleID]
+              failFuture];
+          }
+          return [FBFuture futureWithResult:repopulatedProcessIdentifier];
+        }];
+    }];
+}
+
+- (void)recordLaunchedApplication:(NSString *)bundleID processIdentifier:(pid_t)processIdentifier
+{
+  if (processIdentifier <= 0) {
+    return;
+  }
+  dispatch_async(self.queue, ^{
+    [self trackApplication:bundleID processIdentifier:processIdentifier];
+  });
+}
+
+#pragma mark Private
+
+- (FBFuture<NSNull *> *)populatedTableCheckingForUntrackedApplications:(BOOL)checkForUntrackedApplications
+{
+  id<FBSimulatorRunningApplicationTableSource> simulator = self.simulator;
+  if (!simulator) {
+    return [[FBSimulatorError describe:@"Simulator has been deallocated"] failFuture];
+  }
+  // Queries that arrive while the table is being populated wait for the same population.
+  FBFuture<NSNull *> *population = self.population;
+  if (population && !population.hasCompleted) {
+    return population;
+  }
+  pid_t launchdProcessIdentifier = simulator.launchdProcess.processIdentifier;
+  NSArray<FBProcessInfo *> *subprocesses = nil;
+  if (population && launchdProcessIdentifier == self.launchdProcessIdentifier) {
+    if (!checkForUntrackedApplications) {
+      return population;
+    }
+    subprocesses = simulator.launchdSimSubprocesses;
+    if (![self hasUntrackedApplicationIn:subprocesses]) {
+      return population;
+    }
+  }
+
+  // Any Application process that exists before the service list is obtained, but is not in it, is not a UIKitApplication.
+  subprocesses = subprocesses ?: simulator.launchdSimSubprocesses;
+  [self clear];
+  self.launchdProcessIdentifier = launchdProcessIdentifier;
+  population = [[simulator
+    serviceNamesAndProcessIdentifiersForSubstring:@"UIKitApplication"]
+    onQueue:self.queue map:^(NSDictionary<NSString *, NSNumber *> *serviceNameToProcessIdentifier) {
+      for (NSString *serviceName in serviceNameToProcessIdentifier.allKeys) {
+        NSString *bundleID = [FBSimulatorLaunchCtlCommands extractApplicationBundleIdentifierFromServiceName:serviceName];
+        pid_t processIdentifier = serviceNameToProcessIdentifier[serviceName].intValue;
+        // Launches recorded while the list was being obtained are more recent.
+        if (!bundleID || processIdentifier <= 0 || self.bundleIDToProcessIdentifier[bundleID]) {
+          continue;
+        }
+        [self trackApplication:bundleID processIdentifier:processIdentifier];
+      }
+      NSSet<NSNumber *> *tracked = [NSSet setWithArray:self.bundleIDToProcessIdentifier.allValues];
+      for (FBProcessInfo *process in subprocesses) {
+        NSNumber *processIdentifier = @(process.processIdentifier);
+        if (FBIsApplicationProcess(process) && ![tracked containsObject:processIdentifier]) {
+          [self.ignoredProcessIdentifiers addObject:processIdentifier];
+        }
+      }
+      return NSNull.null;
+    }];
+  self.population = population;
+  [population onQueue:self.queue notifyOfCompletion:^(FBFuture *future) {
+    if (future.state != FBFutureStateDone && self.population == future) {
+      self.population = nil;
+    }
+  }];
+  return population;
+}
+
+- (nullable NSNumber *)liveProcessIdentifierForBundleID:(NSString *)bundleID
+{
+  NSNumber *processIdentifier = self.bundleIDToProcessIdentifier[bundleID];
+  if (processIdentifier && !FBIsProcessAlive(processIdentifier.intValue)) {
+    [self processTerminated:processIdentifier.intValue];
+    return nil;
+  }
+  return processIdentifier;
+}
+
+- (BOOL)hasUntrackedApplicationIn:(NSArray<FBProcessInfo *> *)subprocesses
+{
+  NSSet<NSNumber *> *tracked = [NSSet setWithArray:self.bundleIDToProcessIdentifier.allValues];
+  for (FBProcessInfo *process in subprocesses) {
+    NSNumber *processIdentifier = @(process.processIdentifier);
+    if (!FBIsApplicationProcess(process) || [tracked containsObject:processIdentifier] || [self.ignoredProcessIdentifiers containsObject:processIdentifier]) {
+      continue;
+    }
+    return YES;
+  }
+  return NO;
+}
+
+- (void)trackApplication:(NSString *)bundleID processIdentifier:(pid_t)processIdentifier
+{
+  NSNumber *key = @(processIdentifier);
+  self.bundleIDToProcessIdentifier[bundleID] = key;
+  [self.ignoredProcessIdentifiers removeObject:key];
+  if (self.terminationFutures[key]) {
+    return;
+  }
+  FBFuture<NSNumber *> *terminationFuture = [FBDispatchSourceNotifier processTerminationFutureNotifierForProcessIdentifier:processIdentifier];
+  self.terminationFutures[key] = terminationFuture;
+  __weak typeof(self) weakSelf = self;
+  [terminationFuture onQueue:self.queue notifyOfCompletion:^(FBFuture *future) {
+    __strong typeof(self) strongSelf = weakSelf;
+    if (strongSelf.terminationFutures[key] != future) {
+      return;
+    }
+    [strongSelf processTerminated:processIdentifier];
+  }];
+}
+
+- (void)processTerminated:(pid_t)processIdentifier
+{
+  NSNumber *key = @(processIdentifier);
+  FBFuture<NSNumber *> *terminationFuture = self.terminationFutures[key];
+  [self.terminationFutures removeObjectForKey:key];
+  [terminationFuture cancel];
+  [self.ignoredProcessIdentifiers removeObject:key];
+  [self.bundleIDToProcessIdentifier removeObjectsForKeys:[self.bundleIDToProcessIdentifier allKeysForObject:key]];
+}
+
+- (void)clear
+{
+  NSArray<FBFuture<NSNumber *> *> *terminationFutures = self.terminationFutures.allValues;
+  [self.terminationFutures removeAllObjects];
+  [self.bundleIDToProcessIdentifier removeAllObjects];
+  [self.ignoredProcessIdentifiers removeAllObjects];
+  for (FBFuture<NSNumber *> *future in terminationFutures) {
+    [future cancel];
+  }
+}
+
+@end
@@ -39,6 +39,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (NSString *)video0Path;
 
+/**
+ A File Path to the output of `launchctl list` for a booted Simulator.
+ */
++ (NSString *)launchCtlListOutputPath;
+
 @end
 
 /**
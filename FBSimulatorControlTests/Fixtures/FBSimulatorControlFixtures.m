@@ -36,6 +36,11 @@
   return [[NSBundle bundleForClass:self] pathForResource:@"video0" ofType:@"mp4"];
 }
 
++ (NSString *)launchCtlListOutputPath
+{
+  return [[NSBundle bundleForClass:self] pathForResource:@"launchctl_list" ofType:@"txt"];
+}
+
 + (NSString *)simulatorSystemLogPath
 {
   return [[NSBundle bundleForClass:self] pathForResource:@"simulator_system" ofType:@"log"];
@@ -160,4 +160,29 @@
   XCTAssertTrue(success);
 }
 
+- (void)testInstalledApplicationsReflectInstallAndUninstall
+{
+  FBBundleDescriptor *application = self.tableSearchApplication;
+  FBSimulator *simulator = [self assertObtainsBootedSimulatorWithInstalledApplication:application];
+
+  NSError *error = nil;
+  NSArray<FBInstalledApplication *> *first = [[simulator installedApplications] await:&error];
+  XCTAssertNil(error);
+  XCTAssertTrue([[first valueForKeyPath:@"bundle.identifier"] containsObject:application.identifier]);
+  NSArray<FBInstalledApplication *> *second = [[simulator installedApplications] await:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects([NSSet setWithArray:first], [NSSet setWithArray:second]);
+  XCTAssertNotNil([[simulator installedApplicationWithBundleID:application.identifier] await:&error]);
+  XCTAssertNil(error);
+
+  BOOL success = [[simulator uninstallApplicationWithBundleID:application.identifier] await:&error] != nil;
+  XCTAssertNil(error);
+  XCTAssertTrue(success);
+  NSArray<FBInstalledApplication *> *third = [[simulator installedApplications] await:&error];
+  XCTAssertNil(error);
+  XCTAssertFalse([[third valueForKeyPath:@"bundle.identifier"] containsObject:application.identifier]);
+  XCTAssertNil([[simulator installedApplicationWithBundleID:application.identifier] await:&error]);
+  XCTAssertNotNil(error);
+}
+
 @end
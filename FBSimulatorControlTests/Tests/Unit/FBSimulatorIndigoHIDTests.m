@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBSimulatorControl/FBSimulatorControl.h>
+#import <SimulatorApp/Indigo.h>
+
+#import <mach/mach_time.h>
+
+static const NSUInteger EncodingBenchmarkEventCount = 100000;
+
+@interface FBSimulatorHID (FBSimulatorIndigoHIDTests)
+
+- (instancetype)initWithIndigo:(FBSimulatorIndigoHID *)indigo mainScreenSize:(CGSize)mainScreenSize queue:(dispatch_queue_t)queue;
+
+@end
+
+@interface FBSimulatorIndigoHIDTests_HID : FBSimulatorHID
+
+@property (nonatomic, strong, readonly) NSMutableArray<NSData *> *sentMessages;
+
+@end
+
+@implementation FBSimulatorIndigoHIDTests_HID
+
+- (instancetype)initWithIndigo:(FBSimulatorIndigoHID *)indigo mainScreenSize:(CGSize)mainScreenSize queue:(dispatch_queue_t)queue
+{
+  self = [super initWithIndigo:indigo mainScreenSize:mainScreenSize queue:queue];
+  if (!self) {
+    return nil;
+  }
+
+  _sentMessages = [NSMutableArray array];
+
+  return self;
+}
+
+- (FBFuture<NSNull *> *)sendIndigoMessageData:(NSData *)data
+{
+  // The buffer of the message is reused once it is released, so the contents at the time of sending are copied.
+  [self.sentMessages addObject:[NSData dataWithBytes:data.bytes length:data.length]];
+  return FBFuture.empty;
+}
+
+- (void)disconnect
+{
+}
+
+- (NSString *)description
+{
+  return @"Test HID";
+}
+
+@end
+
+@interface FBSimulatorIndigoHIDTests : XCTestCase
+
+@end
+
+@implementation FBSimulatorIndigoHIDTests
+
+- (IndigoPayload *)secondPayloadOfMessage:(NSData *)data
+{
+  IndigoMessage *message = (IndigoMessage *) data.bytes;
+  return (IndigoPayload *) ((void *) &(message->payload) + sizeof(IndigoPayload));
+}
+
+- (void)testTouchPatchesCoordinatesAndDirection
+{
+  FBSimulatorIndigoHID *indigo = FBSimulatorIndigoHID.reimplemented;
+  NSData *down = [indigo touchScreenSize:CGSizeMake(100, 100) direction:FBSimulatorHIDDirectionDown x:10 y:20];
+  NSData *up = [indigo touchScreenSize:CGSizeMake(1000, 1000) direction:FBSimulatorHIDDirectionUp x:230 y:177];
+  XCTAssertEqual(down.length, sizeof(IndigoMessage) + sizeof(IndigoPayload));
+  XCTAssertEqual(up.length, down.length);
+
+  IndigoMessage *message = (IndigoMessage *) down.bytes;
+  IndigoPayload *second = [self secondPayloadOfMessage:down];
+  XCTAssertEqual(message->eventType, IndigoEventTypeTouch);
+  XCTAssertEqual(message->payload.event.touch.xRatio, 0.1);
+  XCTAssertEqual(message->payload.event.touch.yRatio, 0.2);
+  XCTAssertEqual(message->payload.event.touch.field9, 1u);
+  XCTAssertEqual(second->event.touch.xRatio, 0.1);
+  XCTAssertEqual(second->event.touch.yRatio, 0.2);
+  XCTAssertEqual(second->event.touch.field1, 1u);
+  XCTAssertEqual(second->event.touch.field2, 2u);
+  XCTAssertEqual(second->timestamp, message->payload.timestamp);
+
+  message = (IndigoMessage *) up.bytes;
+  second = [self secondPayloadOfMessage:up];
+  XCTAssertEqual(message->payload.event.touch.xRatio, 0.23);
+  XCTAssertEqual(message->payload.event.touch.yRatio, 0.177);
+  XCTAssertEqual(message->payload.event.touch.field9, 0u);
+  XCTAssertEqual(second->event.touch.xRatio, 0.23);
+  XCTAssertEqual(second->event.touch.yRatio, 0.177);
+  XCTAssertGreaterThanOrEqual(message->payload.timestamp, ((IndigoMessage *) down.bytes)->payload.timestamp);
+}
+
+- (void)testKeyboardAndButtonPatchDirection
+{
+  FBSimulatorIndigoHID *indigo = FBSimulatorIndigoHID.reimplemented;
+  NSData *keyDown = [indigo keyboardWithDirection:FBSimulatorHIDDirectionDown keyCode:12];
+  NSData *keyUp = [indigo keyboardWithDirection:FBSimulatorHIDDirectionUp keyCode:122];
+  NSData *button = [indigo buttonWithDirection:FBSimulatorHIDDirectionDown button:FBSimulatorHIDButtonSiri];
+
+  IndigoButton *payload = &(((IndigoMessage *) keyDown.bytes)->payload.event.button);
+  XCTAssertEqual(payload->keyCode, 12u);
+  XCTAssertEqual(payload->eventType, (unsigned int) ButtonEventTypeDown);
+  XCTAssertEqual(payload->eventSource, (unsigned int) ButtonEventSourceKeyboard);
+
+  payload = &(((IndigoMessage *) keyUp.bytes)->payload.event.button);
+  XCTAssertEqual(payload->keyCode, 122u);
+  XCTAssertEqual(payload->eventType, (unsigned int) ButtonEventTypeUp);
+
+  payload = &(((IndigoMessage *) button.bytes)->payload.event.button);
+  XCTAssertEqual(((IndigoMessage *) button.bytes)->eventType, IndigoEventTypeButton);
+  XCTAssertEqual(payload->eventSource, (unsigned int) ButtonEventSourceSiri);
+  XCTAssertEqual(payload->eventTarget, (unsigned int) ButtonEventTargetHardware);
+  XCTAssertEqual(button.length, sizeof(IndigoMessage));
+}
+
+- (void)testStampReplacesTheTimestampOfBothTouchPayloads
+{
+  FBSimulatorIndigoHID *indigo = FBSimulatorIndigoHID.reimplemented;
+  NSData *touch = [indigo touchScreenSize:CGSizeMake(100, 100) direction:FBSimulatorHIDDirectionDown x:10 y:20];
+  NSData *key = [indigo keyboardWithDirection:FBSimulatorHIDDirectionDown keyCode:12];
+
+  [FBSimulatorIndigoHID stampMessage:touch withTimestamp:1234];
+  [FBSimulatorIndigoHID stampMessage:key withTimestamp:5678];
+
+  XCTAssertEqual(((IndigoMessage *) touch.bytes)->payload.timestamp, 1234u);
+  XCTAssertEqual([self secondPayloadOfMessage:touch]->timestamp, 1234u);
+  XCTAssertEqual(((IndigoMessage *) touch.bytes)->payload.event.touch.xRatio, 0.1);
+  XCTAssertEqual(((IndigoMessage *) key.bytes)->payload.timestamp, 5678u);
+  XCTAssertEqual(((IndigoMessage *) key.bytes)->payload.event.button.keyCode, 12u);
+}
+
+- (void)testScheduleStampsMessagesWhenTheyAreSent
+{
+  FBSimulatorIndigoHID *indigo = FBSimulatorIndigoHID.reimplemented;
+  dispatch_queue_t queue = dispatch_queue_create("com.facebook.fbsimulatorcontrol.tests.hid", DISPATCH_QUEUE_SERIAL);
+  FBSimulatorIndigoHIDTests_HID *hid = [[FBSimulatorIndigoHIDTests_HID alloc] initWithIndigo:indigo mainScreenSize:CGSizeMake(100, 100) queue:queue];
+  FBSimulatorHIDSchedule *schedule = [[FBSimulatorHIDSchedule alloc] init];
+  [schedule appendMessage:[hid touchMessageWithType:FBSimulatorHIDDirectionDown x:10 y:10]];
+  [schedule advanceBy:0.01];
+  [schedule appendMessage:[hid touchMessageWithType:FBSimulatorHIDDirectionUp x:10 y:10]];
+  [schedule appendMessage:[hid keyboardMessageWithDirection:FBSimulatorHIDDirectionDown keyCode:12]];
+  uint64_t built = mach_absolute_time();
+
+  NSError *error = nil;
+  XCTAssertNotNil([[hid sendSchedule:schedule] await:&error]);
+  XCTAssertNil(error);
+  XCTAssertEqual(hid.sentMessages.count, 3u);
+
+  // Every message carries a time after the schedule was built, in the order that they were sent.
+  uint64_t previous = built;
+  for (NSData *message in hid.sentMessages) {
+    uint64_t timestamp = ((IndigoMessage *) message.bytes)->payload.timestamp;
+    XCTAssertGreaterThanOrEqual(timestamp, previous);
+    previous = timestamp;
+  }
+  for (NSData *touch in [hid.sentMessages subarrayWithRange:NSMakeRange(0, 2)]) {
+    XCTAssertEqual([self secondPayloadOfMessage:touch]->timestamp, ((IndigoMessage *) touch.bytes)->payload.timestamp);
+  }
+}
+
+- (void)testBuffersAreReusedOnceReleased
+{
+  FBSimulatorIndigoHID *indigo = FBSimulatorIndigoHID.reimplemented;
+  for (NSUInteger index = 0; index < 1000; index++) {
+    @autoreleasepool {
+      [indigo touchScreenSize:CGSizeMake(100, 100) direction:FBSimulatorHIDDirectionDown x:index % 100 y:index % 100];
+    }
+  }
+  XCTAssertEqual(indigo.messageBuffersAllocated, 1u);
+
+  // Messages that are alive at the same time cannot share a buffer.
+  NSData *first = [indigo touchScreenSize:CGSizeMake(100, 100) direction:FBSimulatorHIDDirectionDown x:1 y:1];
+  NSData *second = [indigo touchScreenSize:CGSizeMake(100, 100) direction:FBSimulatorHIDDirectionUp x:2 y:2];
+  XCTAssertNotEqual(first.bytes, second.bytes);
+  XCTAssertEqual(((IndigoMessage *) first.bytes)->payload.event.touch.xRatio, 0.01);
+  XCTAssertEqual(indigo.messageBuffersAllocated, 2u);
+}
+
+- (void)testEncodingPerformance
+{
+  FBSimulatorIndigoHID *indigo = FBSimulatorIndigoHID.reimplemented;
+  [self measureBlock:^{
+    NSUInteger buffersBefore = indigo.messageBuffersAllocated;
+    for (NSUInteger index = 0; index < EncodingBenchmarkEventCount; index++) {
+      @autoreleasepool {
+        FBSimulatorHIDDirection direction = index % 2 == 0 ? FBSimulatorHIDDirectionDown : FBSimulatorHIDDirectionUp;
+        [indigo touchScreenSize:CGSizeMake(1000, 1000) direction:direction x:index % 1000 y:index % 1000];
+      }
+    }
+    // Buffers are reused once released, so encoding does not allocate per event.
+    XCTAssertLessThan((double) (indigo.messageBuffersAllocated - buffersBefore) / EncodingBenchmarkEventCount, 0.001);
+  }];
+}
+
+@end
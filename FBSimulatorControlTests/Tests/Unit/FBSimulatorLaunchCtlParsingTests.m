@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+#import <FBSimulatorControl/FBSimulatorControl.h>
+
+#import "FBSimulatorControlFixtures.h"
+
+static const NSUInteger ParsingBenchmarkRepetitions = 200;
+
+@interface FBSimulatorLaunchCtlParsingTests : XCTestCase
+
+@end
+
+@implementation FBSimulatorLaunchCtlParsingTests
+
+- (NSString *)listOutput
+{
+  NSError *error = nil;
+  NSString *output = [NSString stringWithContentsOfFile:FBSimulatorControlFixtures.launchCtlListOutputPath encoding:NSUTF8StringEncoding error:&error];
+  XCTAssertNil(error);
+  XCTAssertNotNil(output);
+  return output;
+}
+
+- (void)testParsesAllServicesAfterHeader
+{
+  NSError *error = nil;
+  NSDictionary<NSString *, NSNumber *> *services = [FBSimulatorLaunchCtlCommands servicesFromListOutput:self.listOutput matchingSubstring:nil error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqual(services.count, 650u);
+  XCTAssertNil(services[@"Label"]);
+  XCTAssertEqualObjects(services[@"UIKitApplication:com.apple.mobilesafari[0x66f3][rb-legacy]"], @26428);
+}
+
+- (void)testParsesMissingProcessIdentifiers
+{
+  NSString *output = @"PID\tStatus\tLabel\n-\t0\tcom.apple.foo\n123\t-9\tcom.apple.bar\n";
+  NSError *error = nil;
+  NSDictionary<NSString *, NSNumber *> *services = [FBSimulatorLaunchCtlCommands servicesFromListOutput:output matchingSubstring:nil error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects(services, (@{@"com.apple.foo": @-1, @"com.apple.bar": @123}));
+}
+
+- (void)testFiltersBySubstring
+{
+  NSError *error = nil;
+  NSDictionary<NSString *, NSNumber *> *services = [FBSimulatorLaunchCtlCommands servicesFromListOutput:self.listOutput matchingSubstring:@"UIKitApplication" error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqual(services.count, 10u);
+  for (NSString *serviceName in services) {
+    XCTAssertTrue([serviceName hasPrefix:@"UIKitApplication:"]);
+  }
+  XCTAssertEqualObjects(services[@"UIKitApplication:com.example.TableSearch[0x1688][rb-legacy]"], @39025);
+}
+
+- (void)testFailsOnMalformedLine
+{
+  NSString *output = @"PID\tStatus\tLabel\n123\tcom.apple.foo\n";
+  NSError *error = nil;
+  XCTAssertNil([FBSimulatorLaunchCtlCommands servicesFromListOutput:output matchingSubstring:nil error:&error]);
+  XCTAssertNotNil(error);
+
+  error = nil;
+  output = @"PID\tStatus\tLabel\nabc\t0\tcom.apple.foo\n";
+  XCTAssertNil([FBSimulatorLaunchCtlCommands servicesFromListOutput:output matchingSubstring:@"com.apple.foo" error:&error]);
+  XCTAssertNotNil(error);
+}
+
+- (void)testFailsOnEmptyOutput
+{
+  NSError *error = nil;
+  XCTAssertNil([FBSimulatorLaunchCtlCommands servicesFromListOutput:@"" matchingSubstring:nil error:&error]);
+  XCTAssertNotNil(error);
+}
+
+- (void)testExtractsBundleIdentifierFromServiceName
+{
+  XCTAssertEqualObjects([FBSimulatorLaunchCtlCommands extractApplicationBundleIdentifierFromServiceName:@"UIKitApplication:com.apple.mobilesafari[0x66f3][rb-legacy]"], @"com.apple.mobilesafari");
+  XCTAssertEqualObjects([FBSimulatorLaunchCtlCommands extractApplicationBundleIdentifierFromServiceName:@"UIKitApplication:com.apple.Maps"], @"com.apple.Maps");
+  XCTAssertNil([FBSimulatorLaunchCtlCommands extractApplicationBundleIdentifierFromServiceName:@"com.apple.springboard"]);
+}
+
+- (void)testParsingPerformance
+{
+  NSMutableString *output = [NSMutableString stringWithString:@"PID\tStatus\tLabel\n"];
+  NSString *body = [self.listOutput substringFromIndex:[self.listOutput rangeOfString:@"\n"].location + 1];
+  for (NSUInteger index = 0; index < ParsingBenchmarkRepetitions; index++) {
+    [output appendString:body];
+  }
+  [self measureBlock:^{
+    NSDictionary<NSString *, NSNumber *> *all = [FBSimulatorLaunchCtlCommands servicesFromListOutput:output matchingSubstring:nil error:nil];
+    NSDictionary<NSString *, NSNumber *> *applications = [FBSimulatorLaunchCtlCommands servicesFromListOutput:output matchingSubstring:@"UIKitApplication" error:nil];
+    XCTAssertEqual(all.count, 650u);
+    XCTAssertEqual(applications.count, 10u);
+  }];
+}
+
+@end
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBSimulatorControl/FBSimulatorControl.h>
+
+@interface FBSimulatorRunningApplicationTableTests_Source : NSObject <FBSimulatorRunningApplicationTableSource>
+
+@property (nonatomic, copy, nullable, readwrite) FBProcessInfo *launchdProcess;
+@property (nonatomic, copy, readwrite) NSArray<FBProcessInfo *> *subprocesses;
+@property (nonatomic, copy, readwrite) NSDictionary<NSString *, NSNumber *> *services;
+@property (nonatomic, strong, nullable, readwrite) FBFuture<NSDictionary<NSString *, NSNumber *> *> *pendingServices;
+@property (nonatomic, assign, readwrite) NSUInteger serviceQueryCount;
+@property (nonatomic, assign, readwrite) NSUInteger subprocessQueryCount;
+
+@end
+
+@implementation FBSimulatorRunningApplicationTableTests_Source
+
+- (instancetype)init
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _launchdProcess = [[FBProcessInfo alloc] initWithProcessIdentifier:1 launchPath:@"/sbin/launchd_sim" arguments:@[] environment:@{}];
+  _subprocesses = @[];
+  _services = @{};
+
+  return self;
+}
+
+- (NSArray<FBProcessInfo *> *)launchdSimSubprocesses
+{
+  @synchronized (self) {
+    self.subprocessQueryCount += 1;
+    return self.subprocesses;
+  }
+}
+
+- (FBFuture<NSDictionary<NSString *, NSNumber *> *> *)serviceNamesAndProcessIdentifiersForSubstring:(NSString *)substring
+{
+  @synchronized (self) {
+    self.serviceQueryCount += 1;
+    return self.pendingServices ?: [FBFuture futureWithResult:self.services];
+  }
+}
+
+@end
+
+@interface FBSimulatorRunningApplicationTableTests : XCTestCase
+
+@property (nonatomic, strong, readwrite) NSMutableArray<FBTask *> *tasks;
+
+@end
+
+@implementation FBSimulatorRunningApplicationTableTests
+
+- (void)setUp
+{
+  [super setUp];
+  self.tasks = [NSMutableArray array];
+}
+
+- (void)tearDown
+{
+  for (FBTask *task in self.tasks) {
+    [[task sendSignal:SIGKILL] await:nil];
+  }
+  self.tasks = nil;
+  [super tearDown];
+}
+
+- (FBTask *)launchApplicationProcess
+{
+  NSError *error = nil;
+  FBTask *task = [[[FBTaskBuilder
+    withLaunchPath:@"/bin/sleep" arguments:@[@"1000000"]]
+    start]
+    await:&error];
+  XCTAssertNil(error);
+  XCTAssertNotNil(task);
+  [self.tasks addObject:task];
+  return task;
+}
+
+- (FBProcessInfo *)applicationProcessInfo:(FBTask *)task
+{
+  return [[FBProcessInfo alloc] initWithProcessIdentifier:task.processIdentifier launchPath:@"/Applications/Foo.app/Foo" arguments:@[] environment:@{}];
+}
+
+- (void)testPopulatesOnceFromServices
+{
+  FBTask *task = [self launchApplicationProcess];
+  FBSimulatorRunningApplicationTableTests_Source *source = [FBSimulatorRunningApplicationTableTests_Source new];
+  source.services = @{[NSString stringWithFormat:@"UIKitApplication:com.example.foo[0x1234][%d]", task.processIdentifier]: @(task.processIdentifier)};
+  FBSimulatorRunningApplicationTable *table = [FBSimulatorRunningApplicationTable tableWithSimulator:source];
+
+  NSError *error = nil;
+  XCTAssertEqualObjects([[table processIdentifierForBundleID:@"com.example.foo"] await:&error], @(task.processIdentifier));
+  XCTAssertEqualObjects([[table processIdentifierForBundleID:@"com.example.foo"] await:&error], @(task.processIdentifier));
+  XCTAssertEqual(source.serviceQueryCount, 1u);
+  // A lookup that is answered from the table does not inspect the subprocesses of launchd_sim.
+  NSUInteger subprocessQueryCount = source.subprocessQueryCount;
+  XCTAssertNotNil([[table processIdentifierForBundleID:@"com.example.foo"] await:&error]);
+  XCTAssertEqual(source.subprocessQueryCount, subprocessQueryCount);
+}
+
+- (void)testRepopulatesWhenLaunchdChanges
+{
+  FBSimulatorRunningApplicationTableTests_Source *source = [FBSimulatorRunningApplicationTableTests_Source new];
+  FBSimulatorRunningApplicationTable *table = [FBSimulatorRunningApplicationTable tableWithSimulator:source];
+
+  NSError *error = nil;
+  XCTAssertEqualObjects([[table runningApplications] await:&error], @{});
+  XCTAssertEqual(source.serviceQueryCount, 1u);
+  XCTAssertEqualObjects([[table runningApplications] await:&error], @{});
+  XCTAssertEqual(source.serviceQueryCount, 1u);
+
+  FBTask *task = [self launchApplicationProcess];
+  source.launchdProcess = [[FBProcessInfo alloc] initWithProcessIdentifier:2 launchPath:@"/sbin/launchd_sim" arguments:@[] environment:@{}];
+  source.services = @{@"UIKitApplication:com.example.foo[0x1234]": @(task.processIdentifier)};
+  XCTAssertEqualObjects([[table runningApplications] await:&error], (@{@"com.example.foo": @(task.processIdentifier)}));
+  XCTAssertEqual(source.serviceQueryCount, 2u);
+}
+
+- (void)testRepopulatesForUntrackedApplicationOnMiss
+{
+  FBSimulatorRunningApplicationTableTests_Source *source = [FBSimulatorRunningApplicationTableTests_Source new];
+  FBSimulatorRunningApplicationTable *table = [FBSimulatorRunningApplicationTable tableWithSimulator:source];
+
+  NSError *error = nil;
+  XCTAssertNil([[table processIdentifierForBundleID:@"com.example.foo"] await:&error]);
+  XCTAssertNotNil(error);
+  XCTAssertEqual(source.serviceQueryCount, 1u);
+
+  // An Application launched outside of the Simulator appears as a subprocess of launchd_sim.
+  FBTask *task = [self launchApplicationProcess];
+  source.subprocesses = @[[self applicationProcessInfo:task]];
+  source.services = @{@"UIKitApplication:com.example.foo[0x1234]": @(task.processIdentifier)};
+  error = nil;
+  XCTAssertEqualObjects([[table processIdentifierForBundleID:@"com.example.foo"] await:&error], @(task.processIdentifier));
+  XCTAssertEqual(source.serviceQueryCount, 2u);
+
+  // A process that is not an Application service is only accounted for once.
+  FBTask *other = [self launchApplicationProcess];
+  source.subprocesses = @[[self applicationProcessInfo:task], [self applicationProcessInfo:other]];
+  XCTAssertNil([[table processIdentifierForBundleID:@"com.example.bar"] await:nil]);
+  XCTAssertNil([[table processIdentifierForBundleID:@"com.example.bar"] await:nil]);
+  XCTAssertEqual(source.serviceQueryCount, 3u);
+}
+
+- (void)testRecordsLaunchedApplications
+{
+  FBTask *task = [self launchApplicationProcess];
+  FBSimulatorRunningApplicationTableTests_Source *source = [FBSimulatorRunningApplicationTableTests_Source new];
+  FBSimulatorRunningApplicationTable *table = [FBSimulatorRunningApplicationTable tableWithSimulator:source];
+
+  NSError *error = nil;
+  XCTAssertEqualObjects([[table runningApplications] await:&error], @{});
+  [table recordLaunchedApplication:@"com.example.foo" processIdentifier:task.processIdentifier];
+  XCTAssertEqualObjects([[table processIdentifierForBundleID:@"com.example.foo"] await:&error], @(task.processIdentifier));
+  XCTAssertEqualObjects([[table runningApplications] await:&error], (@{@"com.example.foo": @(task.processIdentifier)}));
+  XCTAssertEqual(source.serviceQueryCount, 1u);
+}
+
+- (void)testRemovesApplicationsThatExit
+{
+  FBTask *task = [self launchApplicationProcess];
+  FBSimulatorRunningApplicationTableTests_Source *source = [FBSimulatorRunningApplicationTableTests_Source new];
+  source.services = @{@"UIKitApplication:com.example.foo[0x1234]": @(task.processIdentifier)};
+  FBSimulatorRunningApplicationTable *table = [FBSimulatorRunningApplicationTable tableWithSimulator:source];
+
+  NSError *error = nil;
+  XCTAssertEqualObjects([[table runningApplications] await:&error], (@{@"com.example.foo": @(task.processIdentifier)}));
+  XCTAssertNotNil([[task sendSignal:SIGKILL] await:&error]);
+
+  XCTAssertEqualObjects([[table runningApplications] await:&error], @{});
+  XCTAssertNil([[table processIdentifierForBundleID:@"com.example.foo"] await:nil]);
+  XCTAssertEqual(source.serviceQueryCount, 1u);
+}
+
+- (void)testConcurrentQueriesShareThePopulation
+{
+  FBTask *task = [self launchApplicationProcess];
+  FBSimulatorRunningApplicationTableTests_Source *source = [FBSimulatorRunningApplicationTableTests_Source new];
+  FBMutableFuture<NSDictionary<NSString *, NSNumber *> *> *services = FBMutableFuture.future;
+  source.pendingServices = services;
+  // Untracked Application processes must not restart a population that is in flight.
+  source.subprocesses = @[[self applicationProcessInfo:task]];
+  FBSimulatorRunningApplicationTable *table = [FBSimulatorRunningApplicationTable tableWithSimulator:source];
+
+  FBFuture<NSDictionary<NSString *, NSNumber *> *> *first = [table runningApplications];
+  FBFuture<NSNumber *> *second = [table processIdentifierForBundleID:@"com.example.foo"];
+  FBFuture<NSDictionary<NSString *, NSNumber *> *> *third = [table runningApplications];
+  [services resolveWithResult:@{@"UIKitApplication:com.example.foo[0x1234]": @(task.processIdentifier)}];
+
+  NSError *error = nil;
+  NSDictionary<NSString *, NSNumber *> *expected = @{@"com.example.foo": @(task.processIdentifier)};
+  XCTAssertEqualObjects([first await:&error], expected);
+  XCTAssertEqualObjects([second await:&error], @(task.processIdentifier));
+  XCTAssertEqualObjects([third await:&error], expected);
+  XCTAssertEqual(source.serviceQueryCount, 1u);
+}
+
+@end
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <FBSimulatorControl/FBSimulatorControl.h>
+
+@interface FBSimulatorSharedVideoStreamTests_Stream : NSObject <FBVideoStream>
+
+@property (nonatomic, strong, nullable, readwrite) id<FBDataConsumer, FBDataConsumerFrameDelimited> consumer;
+@property (nonatomic, assign, readwrite) NSUInteger startCount;
+@property (nonatomic, assign, readwrite) NSUInteger stopCount;
+@property (nonatomic, strong, nullable, readwrite) NSError *startError;
+
+@end
+
+@implementation FBSimulatorSharedVideoStreamTests_Stream
+
+- (FBFuture<NSNull *> *)startStreaming:(id<FBDataConsumer, FBDataConsumerStackConsuming>)consumer
+{
+  self.consumer = (id<FBDataConsumer, FBDataConsumerFrameDelimited>) consumer;
+  self.startCount += 1;
+  if (self.startError) {
+    return [FBFuture futureWithError:self.startError];
+  }
+  return FBFuture.empty;
+}
+
+- (FBFuture<NSNull *> *)stopStreaming
+{
+  self.stopCount += 1;
+  return FBFuture.empty;
+}
+
+- (FBFuture<NSNull *> *)completed
+{
+  return FBFuture.empty;
+}
+
+- (void)pushFrame:(NSString *)frame
+{
+  NSData *data = [frame dataUsingEncoding:NSUTF8StringEncoding];
+  [self.consumer consumeData:[data subdataWithRange:NSMakeRange(0, 1)]];
+  [self.consumer consumeData:[data subdataWithRange:NSMakeRange(1, data.length - 1)]];
+  [self.consumer consumeEndOfFrame];
+}
+
+@end
+
+@interface FBSimulatorSharedVideoStreamTests : XCTestCase
+
+@end
+
+@implementation FBSimulatorSharedVideoStreamTests
+
+- (id<FBDataConsumer, FBDataConsumerLifecycle, FBDataConsumerStackConsuming>)consumerAppendingTo:(NSMutableArray<NSString *> *)frames
+{
+  return [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+    @synchronized (frames) {
+      [frames addObject:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+    }
+  }];
+}
+
+- (void)testFramesAreEncodedOnceForAllSubscribers
+{
+  FBSimulatorSharedVideoStreamTests_Stream *stream = [FBSimulatorSharedVideoStreamTests_Stream new];
+  FBSimulatorSharedVideoStream *sharedStream = [FBSimulatorSharedVideoStream sharedStreamWithStream:stream encoding:FBVideoStreamEncodingBGRA maximumQueuedFrames:8 logger:FBControlCoreGlobalConfiguration.defaultLogger];
+
+  NSMutableArray<NSString *> *firstFrames = [NSMutableArray array];
+  NSMutableArray<NSString *> *secondFrames = [NSMutableArray array];
+  id<FBDataConsumer, FBDataConsumerLifecycle, FBDataConsumerStackConsuming> firstConsumer = [self consumerAppendingTo:firstFrames];
+  id<FBDataConsumer, FBDataConsumerLifecycle, FBDataConsumerStackConsuming> secondConsumer = [self consumerAppendingTo:secondFrames];
+  id<FBVideoStream> first = [sharedStream subscribe];
+  id<FBVideoStream> second = [sharedStream subscribe];
+  XCTAssertEqual(sharedStream.subscriberCount, 0u);
+
+  NSError *error = nil;
+  XCTAssertNotNil([[first startStreaming:firstConsumer] await:&error]);
+  XCTAssertNotNil([[second startStreaming:secondConsumer] await:&error]);
+  XCTAssertEqual(stream.startCount, 1u);
+  XCTAssertEqual(sharedStream.subscriberCount, 2u);
+
+  [stream pushFrame:@"FOO"];
+  [stream pushFrame:@"BAR"];
+
+  XCTAssertNotNil([[first stopStreaming] await:&error]);
+  XCTAssertEqual(stream.stopCount, 0u);
+  XCTAssertNotNil([[second stopStreaming] await:&error]);
+  XCTAssertEqual(stream.stopCount, 1u);
+
+  XCTAssertEqualObjects(firstFrames, (@[@"FOO", @"BAR"]));
+  XCTAssertEqualObjects(secondFrames, (@[@"FOO", @"BAR"]));
+  XCTAssertTrue(firstConsumer.finishedConsuming.hasCompleted);
+  XCTAssertTrue(secondConsumer.finishedConsuming.hasCompleted);
+  XCTAssertEqual(sharedStream.framesEncoded, 2u);
+  XCTAssertEqual(sharedStream.encodesSaved, 2u);
+  XCTAssertEqual(sharedStream.framesDropped, 0u);
+
+  // Once the last subscriber has stopped, the stream cannot be subscribed to.
+  XCTAssertTrue(sharedStream.stopped.hasCompleted);
+  XCTAssertNil([sharedStream subscribe]);
+}
+
+- (void)testSubscriberThatNeverStartsDoesNotKeepStreamAlive
+{
+  FBSimulatorSharedVideoStreamTests_Stream *stream = [FBSimulatorSharedVideoStreamTests_Stream new];
+  FBSimulatorSharedVideoStream *sharedStream = [FBSimulatorSharedVideoStream sharedStreamWithStream:stream encoding:FBVideoStreamEncodingBGRA maximumQueuedFrames:8 logger:FBControlCoreGlobalConfiguration.defaultLogger];
+
+  id<FBVideoStream> started = [sharedStream subscribe];
+  id<FBVideoStream> unstarted = [sharedStream subscribe];
+  NSError *error = nil;
+  XCTAssertNotNil([[started startStreaming:[self consumerAppendingTo:[NSMutableArray array]]] await:&error]);
+  XCTAssertEqual(sharedStream.subscriberCount, 1u);
+
+  XCTAssertNotNil([[unstarted stopStreaming] await:&error]);
+  XCTAssertEqual(sharedStream.subscriberCount, 1u);
+  XCTAssertEqual(stream.stopCount, 0u);
+
+  XCTAssertNotNil([[started stopStreaming] await:&error]);
+  XCTAssertEqual(sharedStream.subscriberCount, 0u);
+  XCTAssertEqual(stream.stopCount, 1u);
+  XCTAssertNotNil([sharedStream.stopped await:&error]);
+}
+
+- (void)testFailureToStartIsNotCountedAsSubscriber
+{
+  FBSimulatorSharedVideoStreamTests_Stream *stream = [FBSimulatorSharedVideoStreamTests_Stream new];
+  stream.startError = [NSError errorWithDomain:@"com.facebook.FBSimulatorControlTests" code:1 userInfo:nil];
+  FBSimulatorSharedVideoStream *sharedStream = [FBSimulatorSharedVideoStream sharedStreamWithStream:stream encoding:FBVideoStreamEncodingBGRA maximumQueuedFrames:8 logger:FBControlCoreGlobalConfiguration.defaultLogger];
+
+  id<FBVideoStream> subscriber = [sharedStream subscribe];
+  NSError *error = nil;
+  XCTAssertNil([[subscriber startStreaming:[self consumerAppendingTo:[NSMutableArray array]]] await:&error]);
+  XCTAssertNotNil(error);
+  XCTAssertEqual(sharedStream.subscriberCount, 0u);
+  XCTAssertEqual(stream.stopCount, 0u);
+  XCTAssertTrue(sharedStream.stopped.hasCompleted);
+  XCTAssertNil([sharedStream subscribe]);
+}
+
+- (void)testPendingBytesIsThatOfTheSlowestSubscriber
+{
+  FBSimulatorSharedVideoStreamTests_Stream *stream = [FBSimulatorSharedVideoStreamTests_Stream new];
+  FBSimulatorSharedVideoStream *sharedStream = [FBSimulatorSharedVideoStream sharedStreamWithStream:stream encoding:FBVideoStreamEncodingBGRA maximumQueuedFrames:8 logger:FBControlCoreGlobalConfiguration.defaultLogger];
+
+  // The slow subscriber blocks on its first frame, so later frames are queued.
+  dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+  id<FBDataConsumer, FBDataConsumerLifecycle, FBDataConsumerStackConsuming> slowConsumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+  }];
+  id<FBVideoStream> fast = [sharedStream subscribe];
+  id<FBVideoStream> slow = [sharedStream subscribe];
+  NSError *error = nil;
+  XCTAssertNotNil([[fast startStreaming:[self consumerAppendingTo:[NSMutableArray array]]] await:&error]);
+  XCTAssertNotNil([[slow startStreaming:slowConsumer] await:&error]);
+
+  for (NSUInteger index = 0; index < 4; index++) {
+    [stream pushFrame:@"FRAME"];
+  }
+  XCTAssertTrue([stream.consumer conformsToProtocol:@protocol(FBDataConsumerBacklog)]);
+  NSUInteger pendingBytes = ((id<FBDataConsumerBacklog>) stream.consumer).pendingBytes;
+  XCTAssertGreaterThanOrEqual(pendingBytes, 3u * 5u);
+
+  for (NSUInteger index = 0; index < 4; index++) {
+    dispatch_semaphore_signal(semaphore);
+  }
+  XCTAssertNotNil([[fast stopStreaming] await:&error]);
+  XCTAssertNotNil([[slow stopStreaming] await:&error]);
+}
+
+- (void)testSlowSubscriberDropsOldestFrames
+{
+  FBSimulatorSharedVideoStreamTests_Stream *stream = [FBSimulatorSharedVideoStreamTests_Stream new];
+  FBSimulatorSharedVideoStream *sharedStream = [FBSimulatorSharedVideoStream sharedStreamWithStream:stream encoding:FBVideoStreamEncodingBGRA maximumQueuedFrames:2 logger:FBControlCoreGlobalConfiguration.defaultLogger];
+
+  // The first frame blocks the subscriber until all frames have been pushed.
+  dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+  NSMutableArray<NSString *> *frames = [NSMutableArray array];
+  id<FBDataConsumer, FBDataConsumerLifecycle, FBDataConsumerStackConsuming> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+    NSString *frame = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    if ([frame isEqualToString:@"0"]) {
+      dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    }
+    @synchronized (frames) {
+      [frames addObject:frame];
+    }
+  }];
+  id<FBVideoStream> subscriber = [sharedStream subscribe];
+  NSError *error = nil;
+  XCTAssertNotNil([[subscriber startStreaming:consumer] await:&error]);
+
+  [stream pushFrame:@"0"];
+  // Wait for the first frame to be dequeued by the subscriber.
+  [NSThread sleepForTimeInterval:0.1];
+  for (NSUInteger index = 1; index <= 5; index++) {
+    [stream pushFrame:[NSString stringWithFormat:@"%lu", (unsigned long) index]];
+  }
+  dispatch_semaphore_signal(semaphore);
+  XCTAssertNotNil([[subscriber stopStreaming] await:&error]);
+
+  XCTAssertEqualObjects(frames, (@[@"0", @"4", @"5"]));
+  XCTAssertEqual(sharedStream.framesEncoded, 6u);
+  XCTAssertEqual(sharedStream.encodesSaved, 0u);
+  XCTAssertEqual(sharedStream.framesDropped, 3u);
+}
+
+@end
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <CoreServices/CoreServices.h>
+#import <ImageIO/ImageIO.h>
+
+#import <FBSimulatorControl/FBSimulatorControl.h>
+
+static NSValue *FBRect(CGFloat x, CGFloat y, CGFloat width, CGFloat height)
+{
+  return [NSValue valueWithRect:CGRectMake(x, y, width, height)];
+}
+
+static uint32_t FBReadLittleEndianUInt32(NSData *data, NSUInteger offset)
+{
+  uint32_t value = 0;
+  [data getBytes:&value range:NSMakeRange(offset, sizeof(value))];
+  return OSSwapLittleToHostInt32(value);
+}
+
+@interface FBSimulatorVideoStreamDamageTests : XCTestCase
+
+@end
+
+@implementation FBSimulatorVideoStreamDamageTests
+
+- (FBSimulatorVideoStreamDamage *)damage
+{
+  return [[FBSimulatorVideoStreamDamage alloc] initWithWidth:95 height:45 tileSize:10];
+}
+
+- (CVPixelBufferRef)createPixelBufferWithWidth:(size_t)width height:(size_t)height
+{
+  CVPixelBufferRef pixelBuffer = NULL;
+  CVReturn status = CVPixelBufferCreate(kCFAllocatorDefault, width, height, kCVPixelFormatType_32BGRA, NULL, &pixelBuffer);
+  XCTAssertEqual(status, kCVReturnSuccess);
+
+  // Each pixel is distinct, so that a tile read from the wrong place is noticed.
+  CVPixelBufferLockBaseAddress(pixelBuffer, 0);
+  uint8_t *baseAddress = CVPixelBufferGetBaseAddress(pixelBuffer);
+  size_t bytesPerRow = CVPixelBufferGetBytesPerRow(pixelBuffer);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      uint8_t *pixel = baseAddress + (y * bytesPerRow) + (x * 4);
+      pixel[0] = (uint8_t) x;
+      pixel[1] = (uint8_t) y;
+      pixel[2] = 0x7F;
+      pixel[3] = 0xFF;
+    }
+  }
+  CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+  return pixelBuffer;
+}
+
+- (void)testNoDamageHasNoRegions
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  XCTAssertFalse(damage.hasDamage);
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[]);
+}
+
+- (void)testRectIsExpandedToTheTilesItTouches
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  [damage addRect:CGRectMake(12, 12, 5, 5)];
+  XCTAssertTrue(damage.hasDamage);
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[FBRect(10, 10, 10, 10)]);
+
+  [damage addRect:CGRectMake(15, 5, 10, 10)];
+  XCTAssertEqualObjects([damage consumeDamagedRegions], (@[FBRect(10, 0, 20, 20)]));
+}
+
+- (void)testConsumingClearsTheDamage
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  [damage addRect:CGRectMake(0, 0, 10, 10)];
+  XCTAssertEqual([damage consumeDamagedRegions].count, 1u);
+  XCTAssertFalse(damage.hasDamage);
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[]);
+}
+
+- (void)testOverlappingRectsAreMerged
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  [damage addRect:CGRectMake(0, 0, 15, 15)];
+  [damage addRect:CGRectMake(12, 12, 15, 15)];
+
+  // Each row has a different span, so the rows are not joined.
+  XCTAssertEqualObjects([damage consumeDamagedRegions], (@[
+    FBRect(0, 0, 20, 10),
+    FBRect(0, 10, 30, 10),
+    FBRect(10, 20, 20, 10),
+  ]));
+
+  [damage addRect:CGRectMake(0, 0, 20, 20)];
+  [damage addRect:CGRectMake(5, 5, 10, 10)];
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[FBRect(0, 0, 20, 20)]);
+}
+
+- (void)testAdjacentRectsAreJoined
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  [damage addRect:CGRectMake(0, 0, 10, 10)];
+  [damage addRect:CGRectMake(10, 0, 10, 10)];
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[FBRect(0, 0, 20, 10)]);
+
+  [damage addRect:CGRectMake(30, 0, 20, 10)];
+  [damage addRect:CGRectMake(30, 10, 20, 10)];
+  [damage addRect:CGRectMake(30, 20, 20, 10)];
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[FBRect(30, 0, 20, 30)]);
+}
+
+- (void)testSeparateRectsAreNotJoined
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  [damage addRect:CGRectMake(0, 0, 10, 10)];
+  [damage addRect:CGRectMake(30, 0, 10, 10)];
+  [damage addRect:CGRectMake(0, 30, 10, 10)];
+  XCTAssertEqualObjects([damage consumeDamagedRegions], (@[
+    FBRect(0, 0, 10, 10),
+    FBRect(30, 0, 10, 10),
+    FBRect(0, 30, 10, 10),
+  ]));
+}
+
+- (void)testRectsAreClippedToTheScreen
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  [damage addRect:CGRectMake(200, 200, 10, 10)];
+  [damage addRect:CGRectMake(-20, -20, 10, 10)];
+  XCTAssertFalse(damage.hasDamage);
+
+  [damage addRect:CGRectMake(85, 35, 100, 100)];
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[FBRect(80, 30, 15, 15)]);
+}
+
+- (void)testFullFrameIsASingleRegion
+{
+  FBSimulatorVideoStreamDamage *damage = self.damage;
+  [damage addRect:CGRectMake(0, 0, 10, 10)];
+  [damage addAll];
+  XCTAssertEqualObjects([damage consumeDamagedRegions], @[FBRect(0, 0, 95, 45)]);
+}
+
+- (void)testEncodesBGRATiles
+{
+  CVPixelBufferRef pixelBuffer = [self createPixelBufferWithWidth:40 height:30];
+  NSArray<NSValue *> *regions = @[FBRect(10, 0, 20, 10), FBRect(0, 20, 10, 10)];
+
+  NSError *error = nil;
+  NSData *frame = [FBSimulatorVideoStreamDamage tileFrameForRegions:regions pixelBuffer:pixelBuffer encodeAsJPEG:NO compressionQuality:nil error:&error];
+  CVPixelBufferRelease(pixelBuffer);
+  XCTAssertNil(error);
+  XCTAssertNotNil(frame);
+
+  XCTAssertEqual(frame.length, 4u + (20u + (20 * 10 * 4)) + (20u + (10 * 10 * 4)));
+  XCTAssertEqual(FBReadLittleEndianUInt32(frame, 0), 2u);
+
+  NSUInteger offset = 4;
+  for (NSValue *region in regions) {
+    CGRect rect = region.rectValue;
+    XCTAssertEqual(FBReadLittleEndianUInt32(frame, offset), (uint32_t) CGRectGetMinX(rect));
+    XCTAssertEqual(FBReadLittleEndianUInt32(frame, offset + 4), (uint32_t) CGRectGetMinY(rect));
+    XCTAssertEqual(FBReadLittleEndianUInt32(frame, offset + 8), (uint32_t) CGRectGetWidth(rect));
+    XCTAssertEqual(FBReadLittleEndianUInt32(frame, offset + 12), (uint32_t) CGRectGetHeight(rect));
+    uint32_t payloadLength = FBReadLittleEndianUInt32(frame, offset + 16);
+    XCTAssertEqual(payloadLength, (uint32_t) (CGRectGetWidth(rect) * CGRectGetHeight(rect) * 4));
+    offset += 20;
+
+    // The payload is the rows of the tile with no padding, so the last pixel is that of the bottom right of the tile.
+    const uint8_t *first = (const uint8_t *) frame.bytes + offset;
+    const uint8_t *last = first + payloadLength - 4;
+    XCTAssertEqual(first[0], (uint8_t) CGRectGetMinX(rect));
+    XCTAssertEqual(first[1], (uint8_t) CGRectGetMinY(rect));
+    XCTAssertEqual(last[0], (uint8_t) (CGRectGetMaxX(rect) - 1));
+    XCTAssertEqual(last[1], (uint8_t) (CGRectGetMaxY(rect) - 1));
+    offset += payloadLength;
+  }
+  XCTAssertEqual(offset, frame.length);
+}
+
+- (void)testEncodesMJPEGTiles
+{
+  CVPixelBufferRef pixelBuffer = [self createPixelBufferWithWidth:40 height:30];
+  NSArray<NSValue *> *regions = @[FBRect(10, 10, 30, 20)];
+
+  NSError *error = nil;
+  NSData *frame = [FBSimulatorVideoStreamDamage tileFrameForRegions:regions pixelBuffer:pixelBuffer encodeAsJPEG:YES compressionQuality:@0.5 error:&error];
+  CVPixelBufferRelease(pixelBuffer);
+  XCTAssertNil(error);
+  XCTAssertNotNil(frame);
+
+  XCTAssertEqual(FBReadLittleEndianUInt32(frame, 0), 1u);
+  XCTAssertEqual(FBReadLittleEndianUInt32(frame, 4), 10u);
+  XCTAssertEqual(FBReadLittleEndianUInt32(frame, 8), 10u);
+  XCTAssertEqual(FBReadLittleEndianUInt32(frame, 12), 30u);
+  XCTAssertEqual(FBReadLittleEndianUInt32(frame, 16), 20u);
+  uint32_t payloadLength = FBReadLittleEndianUInt32(frame, 20);
+  XCTAssertEqual(frame.length, 24u + payloadLength);
+
+  // The payload is a JPEG of the dimensions of the tile.
+  NSData *payload = [frame subdataWithRange:NSMakeRange(24, payloadLength)];
+  CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef) payload, NULL);
+  XCTAssertTrue(source != NULL);
+  XCTAssertEqualObjects((__bridge NSString *) CGImageSourceGetType(source), (__bridge NSString *) kUTTypeJPEG);
+  CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, NULL);
+  CFRelease(source);
+  XCTAssertTrue(image != NULL);
+  XCTAssertEqual(CGImageGetWidth(image), 30u);
+  XCTAssertEqual(CGImageGetHeight(image), 20u);
+  CGImageRelease(image);
+}
+
+@end
@@ -13,6 +13,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface FBOToolOperation : NSObject
 
+/**
+ Lists the sanitiser dylibs that the executable of a bundle links against.
+ These are obtained from the load commands of the executable, rather than by running otool.
+
+ @param testBundlePath the path of the bundle.
+ @param queue the queue to read the executable on.
+ @return a future wrapping the file names of the sanitiser dylibs.
+ */
 +(FBFuture<NSArray<NSString*>*>*)listSanitiserDylibsRequiredByBundle:(NSString*)testBundlePath onQueue:(dispatch_queue_t)queue;
 
 @end
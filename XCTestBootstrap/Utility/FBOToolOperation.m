@@ -22,32 +22,30 @@
     return [FBFuture futureWithError:[[XCTestBootstrapError describe:message] build]];
   }
   
-  FBTaskBuilder *builder = [[[[[FBTaskBuilder
-                                withLaunchPath:@"/usr/bin/otool"]
-                               withArguments:@[@"-L", [bundle executablePath]]]
-                              withAcceptableExitCodes:[NSSet setWithObject:@0]]
-                             withStdOutInMemoryAsString]
-                            withStdErrInMemoryAsString];
-  
-  return [[builder runUntilCompletion] onQueue:queue map:^NSArray<NSString*>* _Nonnull(FBTask<id,NSString*,NSString*> * _Nonnull task) {
-    return [[self class] extractSanitiserDylibsfromOtoolOutput:task.stdOut];
+  NSString *executablePath = [bundle executablePath];
+  return [FBFuture onQueue:queue resolveValue:^ NSArray<NSString *> * (NSError **error) {
+    FBBinaryDescriptor *binary = [FBBinaryDescriptor binaryWithPath:executablePath error:error];
+    NSArray<NSString *> *linkedLibraries = [binary linkedLibrariesWithError:error];
+    if (!linkedLibraries) {
+      return nil;
+    }
+    return [[self class] extractSanitiserDylibsFromLinkedLibraries:linkedLibraries];
   }];
 }
 
-+ (NSArray<NSString *> *)extractSanitiserDylibsfromOtoolOutput:(NSString *)otool_output {
-  NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:@"@rpath/(libclang_rt\\..*san_.*_dynamic.dylib)"
++ (NSArray<NSString *> *)extractSanitiserDylibsFromLinkedLibraries:(NSArray<NSString *> *)linkedLibraries {
+  NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:@"^@rpath/(libclang_rt\\..*san_.*_dynamic.dylib)$"
                                                                          options:NSRegularExpressionCaseInsensitive
                                                                            error:nil];
   NSMutableArray *libs = NSMutableArray.array;
   
-  [regex enumerateMatchesInString:otool_output
-                          options:0
-                            range:NSMakeRange(0, otool_output.length)
-                       usingBlock:^(NSTextCheckingResult * _Nullable result, NSMatchingFlags flags, BOOL * _Nonnull stop) {
-    NSRange range = [result rangeAtIndex:1];
-    NSString *libName = [otool_output substringWithRange:range];
-    [libs addObject:libName];
-  }];
+  for (NSString *linkedLibrary in linkedLibraries) {
+    NSTextCheckingResult *result = [regex firstMatchInString:linkedLibrary options:0 range:NSMakeRange(0, linkedLibrary.length)];
+    if (!result) {
+      continue;
+    }
+    [libs addObject:[linkedLibrary substringWithRange:[result rangeAtIndex:1]]];
+  }
   return [NSArray arrayWithArray:libs];
 }
 
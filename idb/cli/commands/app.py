@@ -30,6 +30,11 @@ class AppInstallCommand(ClientCommand):
         parser.add_argument(
             "bundle_path", help="Path to the .app/.ipa to install", type=str
         )
+        parser.add_argument(
+            "--delta",
+            help="Only upload the files of an .app that the companion does not already have. Requires a companion that supports installing from a manifest",
+            action="store_true",
+        )
         super().add_parser_arguments(parser)
 
     async def run_with_client(self, args: Namespace, client: Client) -> None:
@@ -37,7 +42,9 @@ class AppInstallCommand(ClientCommand):
         compression = (
             Compression[args.compression] if args.compression is not None else None
         )
-        async for info in client.install(args.bundle_path, compression):
+        async for info in client.install(
+            args.bundle_path, compression, delta=args.delta
+        ):
             artifact = info
             progress = info.progress
             if progress is None:
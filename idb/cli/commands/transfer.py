@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+# Copyright (c) Facebook, Inc. and its affiliates.
+#
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+from argparse import Namespace
+
+from idb.cli import ClientCommand
+from idb.common.format import human_format_transfer_stats, json_format_transfer_stats
+from idb.common.types import Client
+
+
+class CompanionTransferStatsCommand(ClientCommand):
+    @property
+    def description(self) -> str:
+        return (
+            "Show the bytes, chunks and time in each stage of the calls that "
+            "transfer data through the companion"
+        )
+
+    @property
+    def name(self) -> str:
+        return "transfer-stats"
+
+    async def run_with_client(self, args: Namespace, client: Client) -> None:
+        formatter = human_format_transfer_stats
+        if args.json:
+            formatter = json_format_transfer_stats
+        for stats in await client.transfer_stats():
+            print(formatter(stats))
@@ -83,6 +83,7 @@ from idb.cli.commands.target import (
     TargetListCommand,
     TargetShutdownCommand,
 )
+from idb.cli.commands.transfer import CompanionTransferStatsCommand
 from idb.cli.commands.url import UrlOpenCommand
 from idb.cli.commands.video import VideoRecordCommand, VideoStreamCommand
 from idb.cli.commands.xctest import (
@@ -280,7 +281,7 @@ async def gen_main(cmd_input: Optional[List[str]] = None) -> int:
         CommandGroup(
             name="companion",
             description="commands related to the companion",
-            commands=[CompanionLogCommand()],
+            commands=[CompanionLogCommand(), CompanionTransferStatsCommand()],
         ),
         CommandGroup(
             name="xctrace",
@@ -14,12 +14,14 @@ from idb.common.types import (
     AppProcessState,
     CompanionInfo,
     DomainSocketAddress,
+    Histogram,
     InstalledAppInfo,
     InstalledTestInfo,
     TargetDescription,
     TCPAddress,
     TestActivity,
     TestRunInfo,
+    TransferStats,
 )
 from treelib import Tree
 
@@ -289,3 +291,81 @@ def json_format_installed_test_info(test: InstalledTestInfo) -> str:
         "architectures": list(test.architectures) if test.architectures else None,
     }
     return json.dumps(data)
+
+
+def histogram_percentile(histogram: Histogram, fraction: float) -> int:
+    # The upper bound of the bucket that the value at the fraction falls in.
+    rank = fraction * histogram.count
+    seen = 0
+    for (index, count) in enumerate(histogram.bucket_counts):
+        seen += count
+        if count and seen >= rank:
+            return 0 if index == 0 else min(1 << index, histogram.maximum)
+    return histogram.maximum
+
+
+def human_format_histogram(histogram: Histogram) -> str:
+    if histogram.count == 0:
+        return "none"
+    return " ".join(
+        [
+            f"count={histogram.count}",
+            f"mean={histogram.sum // histogram.count}",
+            f"p50<={histogram_percentile(histogram, 0.5)}",
+            f"p90<={histogram_percentile(histogram, 0.9)}",
+            f"p99<={histogram_percentile(histogram, 0.99)}",
+            f"max={histogram.maximum}",
+        ]
+    )
+
+
+def human_format_transfer_stats(stats: TransferStats) -> str:
+    lines = [
+        " | ".join(
+            [
+                stats.name,
+                f"{stats.calls} calls",
+                f"{stats.bytes_in} bytes in {stats.chunks_in} chunks",
+                f"{stats.bytes_out} bytes out {stats.chunks_out} chunks",
+            ]
+        ),
+        f"  duration (us): {human_format_histogram(stats.duration_micros)}",
+        "  throughput (bytes/s): "
+        + human_format_histogram(stats.throughput_bytes_per_second),
+    ]
+    for stage in sorted(stats.stage_micros):
+        histogram = human_format_histogram(stats.stage_micros[stage])
+        lines.append(f"  {stage} (us): {histogram}")
+    return "\n".join(lines)
+
+
+def json_data_histogram(histogram: Histogram) -> Dict[str, Any]:
+    return {
+        "bucket_counts": histogram.bucket_counts,
+        "count": histogram.count,
+        "sum": histogram.sum,
+        "maximum": histogram.maximum,
+        "p50": histogram_percentile(histogram, 0.5),
+        "p90": histogram_percentile(histogram, 0.9),
+        "p99": histogram_percentile(histogram, 0.99),
+    }
+
+
+def json_format_transfer_stats(stats: TransferStats) -> str:
+    data = {
+        "name": stats.name,
+        "calls": stats.calls,
+        "bytes_in": stats.bytes_in,
+        "chunks_in": stats.chunks_in,
+        "bytes_out": stats.bytes_out,
+        "chunks_out": stats.chunks_out,
+        "stage_micros": {
+            stage: json_data_histogram(histogram)
+            for (stage, histogram) in stats.stage_micros.items()
+        },
+        "duration_micros": json_data_histogram(stats.duration_micros),
+        "throughput_bytes_per_second": json_data_histogram(
+            stats.throughput_bytes_per_second
+        ),
+    }
+    return json.dumps(data)
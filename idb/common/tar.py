@@ -6,11 +6,25 @@
 
 import asyncio
 import os
+import plistlib
+import stat
 import sys
+import tarfile
 import tempfile
 import uuid
+import zlib
 from abc import abstractmethod
-from typing import AsyncGenerator, AsyncIterator, List, Optional
+from collections import deque
+from concurrent.futures import ThreadPoolExecutor
+from typing import (
+    AsyncGenerator,
+    AsyncIterator,
+    Deque,
+    Iterator,
+    List,
+    Optional,
+    Tuple,
+)
 
 from idb.common.types import Compression
 from idb.utils.contextlib import asynccontextmanager
@@ -26,6 +40,9 @@ def _has_executable(exe: str) -> bool:
 
 
 READ_CHUNK_SIZE: int = 1024 * 1024 * 4  # 4Mb, the default max read for gRPC
+# The size of the blocks of the archive that are compressed independently.
+COMPRESSION_BLOCK_SIZE: int = 1024 * 1024
+COMPRESSION_LEVEL: int = 4
 
 
 async def is_gnu_tar() -> bool:
@@ -150,6 +167,151 @@ class ZstdArchive(TarArchiveProcess):
         )
 
 
+def _priority_paths(path: str) -> List[str]:
+    # The companion validates an App from its Info.plist and executable,
+    # so these are archived first so that a bad App fails before it's uploaded.
+    if not path.endswith(".app"):
+        return []
+    info_plist = os.path.join(path, "Info.plist")
+    try:
+        with open(info_plist, "rb") as f:
+            executable = plistlib.load(f).get("CFBundleExecutable")
+    except (OSError, plistlib.InvalidFileException):
+        return []
+    paths = [info_plist]
+    if isinstance(executable, str):
+        paths.append(os.path.join(path, executable))
+    return [path for path in paths if os.path.isfile(path)]
+
+
+def _walk(path: str) -> Iterator[str]:
+    yield path
+    if os.path.islink(path) or not os.path.isdir(path):
+        return
+    priority = _priority_paths(path)
+    yield from priority
+    for (directory, directory_names, file_names) in os.walk(path):
+        directory_names.sort()
+        for name in directory_names + sorted(file_names):
+            entry = os.path.join(directory, name)
+            if entry not in priority:
+                yield entry
+
+
+def _archive_entries(
+    paths: List[str], place_in_subfolders: bool
+) -> Iterator[Tuple[str, str]]:
+    for path in paths:
+        path = os.path.abspath(path)
+        root = os.path.dirname(path)
+        prefix = str(uuid.uuid4()) if place_in_subfolders else ""
+        for entry in _walk(path):
+            yield (entry, os.path.join(prefix, os.path.relpath(entry, root)))
+
+
+def _tar_info(path: str, name: str) -> tarfile.TarInfo:
+    info = tarfile.TarInfo(name)
+    stat_result = os.lstat(path)
+    info.mode = stat.S_IMODE(stat_result.st_mode)
+    # An integral mtime doesn't need a pax header.
+    info.mtime = int(stat_result.st_mtime)
+    info.uid = stat_result.st_uid
+    info.gid = stat_result.st_gid
+    if stat.S_ISLNK(stat_result.st_mode):
+        info.type = tarfile.SYMTYPE
+        info.linkname = os.readlink(path)
+    elif stat.S_ISDIR(stat_result.st_mode):
+        info.type = tarfile.DIRTYPE
+    elif stat.S_ISREG(stat_result.st_mode):
+        info.size = stat_result.st_size
+    else:
+        raise TarException(f"{path} can't be archived, it isn't a file or directory")
+    return info
+
+
+def _tar_data(entries: Iterator[Tuple[str, str]]) -> Iterator[bytes]:
+    for (path, name) in entries:
+        info = _tar_info(path, name)
+        yield info.tobuf(format=tarfile.PAX_FORMAT)
+        if not info.isreg():
+            continue
+        remaining = info.size
+        with open(path, "rb") as f:
+            while remaining > 0:
+                data = f.read(min(remaining, COMPRESSION_BLOCK_SIZE))
+                if not data:
+                    raise TarException(f"{path} was truncated while being archived")
+                remaining -= len(data)
+                yield data
+        padding = -info.size % tarfile.BLOCKSIZE
+        if padding:
+            yield tarfile.NUL * padding
+    yield tarfile.NUL * (tarfile.BLOCKSIZE * 2)
+
+
+def _tar_blocks(
+    paths: List[str], place_in_subfolders: bool, block_size: int
+) -> Iterator[bytes]:
+    buffer = bytearray()
+    for data in _tar_data(_archive_entries(paths, place_in_subfolders)):
+        buffer += data
+        while len(buffer) >= block_size:
+            yield bytes(buffer[:block_size])
+            del buffer[:block_size]
+    if buffer:
+        yield bytes(buffer)
+
+
+def _compress_block(block: bytes, level: int) -> bytes:
+    # Each block is a complete gzip member, which gunzip reads as a single stream.
+    compressor = zlib.compressobj(level, zlib.DEFLATED, 16 + zlib.MAX_WBITS)
+    return compressor.compress(block) + compressor.flush()
+
+
+async def generate_parallel_tar(
+    paths: List[str],
+    place_in_subfolders: bool = False,
+    block_size: int = COMPRESSION_BLOCK_SIZE,
+    message_size: int = READ_CHUNK_SIZE,
+    level: int = COMPRESSION_LEVEL,
+    workers: Optional[int] = None,
+) -> AsyncIterator[bytes]:
+    """
+    Generates a gzipped tar of the paths, without launching tar or gzip.
+    The archive is cut into blocks that are compressed concurrently as separate
+    gzip members, as pigz does. The compressed blocks are yielded in order,
+    coalesced into chunks of message_size, apart from the first, which is
+    yielded as soon as it is ready.
+    """
+    workers = workers or os.cpu_count() or 1
+    loop = asyncio.get_event_loop()
+    blocks = _tar_blocks(paths, place_in_subfolders, block_size)
+    with ThreadPoolExecutor(max_workers=workers + 1) as executor:
+        compressing: Deque["asyncio.Future[bytes]"] = deque()
+        message = bytearray()
+        sent = False
+        exhausted = False
+        while not exhausted or compressing:
+            # Files are read on a single thread, the blocks are compressed on the rest.
+            while not exhausted and len(compressing) < workers * 2:
+                block = await loop.run_in_executor(executor, next, blocks, None)
+                if block is None:
+                    exhausted = True
+                    break
+                compressing.append(
+                    loop.run_in_executor(executor, _compress_block, block, level)
+                )
+            if not compressing:
+                break
+            message += await compressing.popleft()
+            while len(message) >= message_size or (message and not sent):
+                yield bytes(message[:message_size])
+                del message[:message_size]
+                sent = True
+        if message:
+            yield bytes(message)
+
+
 def _create_untar_command(
     output_path: str, gnu_tar: bool, verbose: bool = False
 ) -> List[str]:
@@ -210,6 +372,14 @@ async def generate_tar(
     else:
         raise Exception(f"Unsupported compression format: {compression}")
 
+    # tar is only needed for its additional arguments, or to list what it archives.
+    if compression == Compression.GZIP and not additional_tar_args and not verbose:
+        async for data in generate_parallel_tar(
+            paths=paths, place_in_subfolders=place_in_subfolders
+        ):
+            yield data
+        return
+
     async with tar_process.run() as process:
         reader = none_throws(process.stdout)
         while not reader.at_eof():
@@ -4,15 +4,21 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+import json
+
 from idb.common.format import (
+    histogram_percentile,
+    human_format_transfer_stats,
     json_data_companions,
     json_format_target_info,
+    json_format_transfer_stats,
     json_to_companion_info,
     target_description_from_json,
 )
 from idb.common.types import (
     AppProcessState,
     CompanionInfo,
+    Histogram,
     InstalledAppInfo,
     InstalledTestInfo,
     TargetDescription,
@@ -20,6 +26,7 @@ from idb.common.types import (
     TestActivity,
     TestRunFailureInfo,
     TestRunInfo,
+    TransferStats,
 )
 from idb.utils.testing import TestCase
 
@@ -74,6 +81,28 @@ INSTALLED_TEST_INFO = InstalledTestInfo(
     bundle_id="MyBundleID", name="MyName", architectures={"ArchA", "ArchB"}
 )
 
+EMPTY_HISTOGRAM_FIXTURE = Histogram(bucket_counts=[], count=0, sum=0, maximum=0)
+# Three reads of 1us, 100us and 3000us.
+READ_HISTOGRAM_FIXTURE = Histogram(
+    bucket_counts=[0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1],
+    count=3,
+    sum=3101,
+    maximum=3000,
+)
+TRANSFER_STATS_FIXTURE = TransferStats(
+    name="install",
+    calls=1,
+    bytes_in=1024,
+    chunks_in=3,
+    bytes_out=12,
+    chunks_out=1,
+    stage_micros={"read": READ_HISTOGRAM_FIXTURE},
+    duration_micros=Histogram(
+        bucket_counts=[0] * 13 + [1], count=1, sum=5000, maximum=5000
+    ),
+    throughput_bytes_per_second=EMPTY_HISTOGRAM_FIXTURE,
+)
+
 
 class FormattingTests(TestCase):
     def test_json_to_companion_info(self) -> None:
@@ -89,3 +118,32 @@ class FormattingTests(TestCase):
                 json_format_target_info(TARGET_DESCRIPTION_FIXTURE)
             ),
         )
+
+    def test_histogram_percentile(self) -> None:
+        self.assertEqual(2, histogram_percentile(READ_HISTOGRAM_FIXTURE, 0.3))
+        self.assertEqual(128, histogram_percentile(READ_HISTOGRAM_FIXTURE, 0.5))
+        self.assertEqual(3000, histogram_percentile(READ_HISTOGRAM_FIXTURE, 0.99))
+        self.assertEqual(0, histogram_percentile(EMPTY_HISTOGRAM_FIXTURE, 0.5))
+
+    def test_human_format_transfer_stats(self) -> None:
+        self.assertEqual(
+            "\n".join(
+                [
+                    "install | 1 calls | 1024 bytes in 3 chunks | "
+                    "12 bytes out 1 chunks",
+                    "  duration (us): count=1 mean=5000 p50<=5000 p90<=5000 "
+                    "p99<=5000 max=5000",
+                    "  throughput (bytes/s): none",
+                    "  read (us): count=3 mean=1033 p50<=128 p90<=3000 p99<=3000 "
+                    "max=3000",
+                ]
+            ),
+            human_format_transfer_stats(TRANSFER_STATS_FIXTURE),
+        )
+
+    def test_json_format_transfer_stats(self) -> None:
+        data = json.loads(json_format_transfer_stats(TRANSFER_STATS_FIXTURE))
+        self.assertEqual(1024, data["bytes_in"])
+        self.assertEqual(3, data["stage_micros"]["read"]["count"])
+        self.assertEqual(128, data["stage_micros"]["read"]["p50"])
+        self.assertEqual(0, data["throughput_bytes_per_second"]["count"])
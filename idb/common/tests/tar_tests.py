@@ -4,7 +4,15 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
-from idb.common.tar import _create_untar_command
+import gzip
+import io
+import os
+import plistlib
+import tarfile
+import tempfile
+from typing import AsyncIterator
+
+from idb.common.tar import _create_untar_command, drain_untar, generate_parallel_tar
 from idb.utils.testing import TestCase
 
 
@@ -32,3 +40,68 @@ class UdidTests(TestCase):
             _create_untar_command(output_path=output_path, gnu_tar=False, verbose=True),
             ["tar", "-C", output_path, "-xzpfv", "-"],
         )
+
+
+class ParallelTarTests(TestCase):
+    def setUp(self) -> None:
+        self.temp = tempfile.TemporaryDirectory()
+        self.app = os.path.join(self.temp.name, "Foo.app")
+        os.makedirs(os.path.join(self.app, "Frameworks"))
+        with open(os.path.join(self.app, "Frameworks", "Bar"), "wb") as f:
+            f.write(b"0123456789" * 1000)
+        with open(os.path.join(self.app, "Foo"), "wb") as f:
+            f.write(os.urandom(5000))
+        os.chmod(os.path.join(self.app, "Foo"), 0o755)
+        with open(os.path.join(self.app, "Info.plist"), "wb") as f:
+            plistlib.dump({"CFBundleExecutable": "Foo"}, f)
+        os.symlink("Foo", os.path.join(self.app, "Link"))
+
+    def tearDown(self) -> None:
+        self.temp.cleanup()
+
+    async def _archive(self, **kwargs: int) -> bytes:
+        chunks = [chunk async for chunk in generate_parallel_tar([self.app], **kwargs)]
+        return b"".join(chunks)
+
+    async def test_archive_is_extracted_by_tar(self) -> None:
+        data = await self._archive(block_size=1024, workers=4)
+
+        async def generator() -> AsyncIterator[bytes]:
+            yield data
+
+        output = os.path.join(self.temp.name, "output")
+        await drain_untar(generator(), output_path=output)
+        for name in ["Foo", "Info.plist", "Frameworks/Bar"]:
+            with open(os.path.join(self.app, name), "rb") as expected:
+                with open(os.path.join(output, "Foo.app", name), "rb") as actual:
+                    self.assertEqual(expected.read(), actual.read())
+        binary = os.path.join(output, "Foo.app", "Foo")
+        self.assertEqual(os.stat(binary).st_mode & 0o777, 0o755)
+        self.assertEqual(os.readlink(os.path.join(output, "Foo.app", "Link")), "Foo")
+
+    async def test_blocks_are_separate_gzip_members(self) -> None:
+        data = await self._archive(block_size=1024)
+        self.assertGreater(data.count(b"\x1f\x8b\x08"), 10)
+        archive = tarfile.open(fileobj=io.BytesIO(gzip.decompress(data)))
+        self.assertEqual(archive.getmember("Foo.app/Frameworks/Bar").size, 10000)
+
+    async def test_info_plist_and_executable_are_archived_first(self) -> None:
+        data = await self._archive()
+        archive = tarfile.open(fileobj=io.BytesIO(gzip.decompress(data)))
+        self.assertEqual(
+            archive.getnames()[:3], ["Foo.app", "Foo.app/Info.plist", "Foo.app/Foo"]
+        )
+        self.assertEqual(len(archive.getnames()), 6)
+
+    async def test_chunks_are_coalesced_to_the_message_size(self) -> None:
+        chunks = [
+            chunk
+            async for chunk in generate_parallel_tar(
+                [self.app], block_size=512, message_size=4096
+            )
+        ]
+        # The first block is sent as soon as it is ready, so the head of the
+        # archive isn't held back.
+        self.assertLess(len(chunks[0]), 4096)
+        self.assertTrue(all(len(chunk) == 4096 for chunk in chunks[1:-1]))
+        self.assertLessEqual(len(chunks[-1]), 4096)
@@ -18,6 +18,7 @@ from typing import (
     AsyncIterable,
     AsyncIterator,
     Dict,
+    Iterable,
     List,
     Mapping,
     Optional,
@@ -70,6 +71,8 @@ class VideoFormat(Enum):
     RBGA = "rbga"
     MJPEG = "mjpeg"
     MINICAP = "minicap"
+    RBGA_TILES = "rbga-tiles"
+    MJPEG_TILES = "mjpeg-tiles"
 
 
 @dataclass(frozen=True)
@@ -316,6 +319,37 @@ class HIDDelay:
 HIDEvent = Union[HIDPress, HIDSwipe, HIDDelay]
 
 
+@dataclass(frozen=True)
+class HIDBatchResult:
+    message_count: int
+    scheduled_duration: float
+    actual_duration: float
+    mean_jitter: float
+    max_jitter: float
+
+
+@dataclass(frozen=True)
+class Histogram:
+    # Power-of-two buckets: bucket i counts values less than 2^i, bucket 0 counts zeros.
+    bucket_counts: List[int]
+    count: int
+    sum: int
+    maximum: int
+
+
+@dataclass(frozen=True)
+class TransferStats:
+    name: str
+    calls: int
+    bytes_in: int
+    chunks_in: int
+    bytes_out: int
+    chunks_out: int
+    stage_micros: Dict[str, Histogram]
+    duration_micros: Histogram
+    throughput_bytes_per_second: Histogram
+
+
 @dataclass(frozen=True)
 class InstalledArtifact:
     name: str
@@ -466,6 +500,7 @@ class Client(ABC):
         self,
         bundle: Union[str, IO[bytes]],
         compression: Optional[Compression] = None,
+        delta: bool = False,
     ) -> AsyncIterator[InstalledArtifact]:
         yield
 
@@ -691,6 +726,14 @@ class Client(ABC):
     async def hid(self, event_iterator: AsyncIterable[HIDEvent]) -> None:
         pass
 
+    @abstractmethod
+    async def hid_batch(self, events: Iterable[HIDEvent]) -> HIDBatchResult:
+        pass
+
+    @abstractmethod
+    async def transfer_stats(self) -> List[TransferStats]:
+        pass
+
     @abstractmethod
     async def ls_single(
         self, container: FileContainer, path: str
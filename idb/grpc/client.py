@@ -29,6 +29,7 @@ from typing import (
 
 import idb.common.plugin as plugin
 from grpclib.client import Channel
+from grpclib.const import Status
 from grpclib.exceptions import GRPCError, ProtocolError, StreamTerminatedError
 from idb.common.constants import TESTS_POLL_INTERVAL
 from idb.common.file import drain_to_file
@@ -59,6 +60,7 @@ from idb.common.types import (
     FileContainer,
     FileEntryInfo,
     FileListing,
+    HIDBatchResult,
     HIDButtonType,
     HIDEvent,
     IdbConnectionException,
@@ -72,6 +74,7 @@ from idb.common.types import (
     TargetDescription,
     TCPAddress,
     TestRunInfo,
+    TransferStats,
     VideoFormat,
 )
 from idb.grpc.crash import (
@@ -80,7 +83,7 @@ from idb.grpc.crash import (
     _to_crash_log_query_proto,
 )
 from idb.grpc.file import container_to_grpc as file_container_to_grpc
-from idb.grpc.hid import event_to_grpc
+from idb.grpc.hid import batch_result_from_grpc, event_to_grpc, events_to_batch_grpc
 from idb.grpc.idb_grpc import CompanionServiceStub
 from idb.grpc.idb_pb2 import (
     AccessibilityInfoRequest,
@@ -94,6 +97,7 @@ from idb.grpc.idb_pb2 import (
     DebugServerResponse,
     FocusRequest,
     InstallRequest,
+    InstallResponse,
     InstrumentsRunRequest,
     LaunchRequest,
     ListAppsRequest,
@@ -117,17 +121,21 @@ from idb.grpc.idb_pb2 import (
     SettingRequest,
     TargetDescriptionRequest,
     TerminateRequest,
+    TransferStatsRequest,
     UninstallRequest,
     VideoStreamRequest,
     XctestListBundlesRequest,
     XctestListTestsRequest,
+    XctestRunResponse,
     XctraceRecordRequest,
 )
 from idb.grpc.install import (
     Bundle,
     Destination,
+    build_manifest,
     generate_binary_chunks,
     generate_io_chunks,
+    generate_manifest_chunks,
     generate_requests,
 )
 from idb.grpc.instruments import (
@@ -136,15 +144,19 @@ from idb.grpc.instruments import (
     translate_instruments_timings,
 )
 from idb.grpc.launch import drain_launch_stream, end_launch_stream
+from idb.grpc.pull import drain_pull
 from idb.grpc.stream import (
+    Stream,
     cancel_wrapper,
     drain_to_stream,
     generate_bytes,
     stop_wrapper,
 )
 from idb.grpc.target import companion_to_py, target_to_py
+from idb.grpc.transfer_stats import transfer_stats_from_grpc
 from idb.grpc.video import generate_video_bytes
 from idb.grpc.xctest import (
+    StreamedArtifact,
     make_request,
     make_results,
     save_attachments,
@@ -156,6 +168,7 @@ from idb.grpc.xctrace import (
     xctrace_generate_bytes,
 )
 from idb.utils.contextlib import asynccontextmanager
+from idb.utils.typing import none_throws
 
 
 APPROVE_MAP: Dict[Permission, "ApproveRequest.Permission"] = {
@@ -172,6 +185,8 @@ VIDEO_FORMAT_MAP: Dict[VideoFormat, "VideoStreamRequest.Format"] = {
     VideoFormat.RBGA: VideoStreamRequest.RBGA,
     VideoFormat.MJPEG: VideoStreamRequest.MJPEG,
     VideoFormat.MINICAP: VideoStreamRequest.MINICAP,
+    VideoFormat.RBGA_TILES: VideoStreamRequest.RBGA_TILES,
+    VideoFormat.MJPEG_TILES: VideoStreamRequest.MJPEG_TILES,
 }
 
 COMPRESSION_MAP: Dict[Compression, "Payload.Compression"] = {
@@ -329,14 +344,33 @@ class Client(ClientBase):
             async for message in cancel_wrapper(stream=stream, stop=stop):
                 yield message.output.decode()
 
+    async def _send_manifest(
+        self, stream: Stream[InstallRequest, InstallResponse], path: str
+    ) -> None:
+        manifest, locations = await asyncio.get_event_loop().run_in_executor(
+            None, build_manifest, path
+        )
+        await stream.send_message(InstallRequest(manifest=manifest))
+        response = none_throws(await stream.recv_message())
+        missing = response.missing_chunks
+        self.logger.info(
+            f"Sending {len(missing)} of {len(locations)} chunks that the companion does not have"
+        )
+        async for message in generate_manifest_chunks(
+            digests=missing, locations=locations, logger=self.logger
+        ):
+            await stream.send_message(message)
+
     async def _install_to_destination(
         self,
         bundle: Bundle,
         destination: Destination,
         compression: Optional[Compression] = None,
+        delta: bool = False,
     ) -> AsyncIterator[InstalledArtifact]:
         async with self.stub.install.open() as stream:
             generator = None
+            manifest_path = None
             if isinstance(bundle, str):
                 url = urllib.parse.urlparse(bundle)
                 if url.scheme:
@@ -351,6 +385,13 @@ class Client(ClientBase):
                         generator = generate_requests(
                             [InstallRequest(payload=Payload(file_path=file_path))]
                         )
+                    elif (
+                        delta
+                        and destination == InstallRequest.APP
+                        and os.path.isdir(file_path)
+                    ):
+                        # send only the chunks that the companion does not have
+                        manifest_path = file_path
                     else:
                         # chunk file from file_path
                         generator = generate_binary_chunks(
@@ -365,14 +406,17 @@ class Client(ClientBase):
                 generator = generate_io_chunks(io=bundle, logger=self.logger)
                 # stream to companion
             await stream.send_message(InstallRequest(destination=destination))
-            if compression is not None:
-                await stream.send_message(
-                    InstallRequest(
-                        payload=Payload(compression=COMPRESSION_MAP[compression])
+            if manifest_path is not None:
+                await self._send_manifest(stream=stream, path=manifest_path)
+            else:
+                if compression is not None:
+                    await stream.send_message(
+                        InstallRequest(
+                            payload=Payload(compression=COMPRESSION_MAP[compression])
+                        )
                     )
-                )
-            async for message in generator:
-                await stream.send_message(message)
+                async for message in none_throws(generator):
+                    await stream.send_message(message)
             await stream.end()
             async for response in stream:
                 yield InstalledArtifact(
@@ -580,9 +624,13 @@ class Client(ClientBase):
         self,
         bundle: Bundle,
         compression: Optional[Compression] = None,
+        delta: bool = False,
     ) -> AsyncIterator[InstalledArtifact]:
         async for response in self._install_to_destination(
-            bundle=bundle, destination=InstallRequest.APP, compression=compression
+            bundle=bundle,
+            destination=InstallRequest.APP,
+            compression=compression,
+            delta=delta,
         ):
             yield response
 
@@ -649,21 +697,27 @@ class Client(ClientBase):
     async def pull(
         self, container: FileContainer, src_path: str, dest_path: str
     ) -> None:
-        async with self.stub.pull.open() as stream:
-            request = request = PullRequest(
-                src_path=src_path,
-                # not sending the destination to remote companion
-                # so it streams the file back
-                dst_path=dest_path if self.is_local else None,
-                container=file_container_to_grpc(container),
-            )
-            await stream.send_message(request)
-            await stream.end()
-            if self.is_local:
+        request = PullRequest(
+            src_path=src_path,
+            # not sending the destination to remote companion
+            # so it streams the file back
+            dst_path=dest_path if self.is_local else None,
+            container=file_container_to_grpc(container),
+        )
+        if self.is_local:
+            async with self.stub.pull.open() as stream:
+                await stream.send_message(request)
+                await stream.end()
                 await stream.recv_message()
-            else:
-                await drain_untar(generate_bytes(stream), output_path=dest_path)
-            self.logger.info(f"pulled file to {dest_path}")
+        else:
+            # Files are written as they arrive, across several concurrent streams.
+            await drain_pull(
+                open_stream=self.stub.pull.open,
+                request=request,
+                output_path=dest_path,
+                logger=self.logger,
+            )
+        self.logger.info(f"pulled file to {dest_path}")
 
     @log_and_handle_exceptions
     async def list_test_bundle(self, test_bundle_id: str, app_path: str) -> List[str]:
@@ -686,7 +740,18 @@ class Client(ClientBase):
 
     @log_and_handle_exceptions
     async def send_events(self, events: Iterable[HIDEvent]) -> None:
-        await self.hid(iterator_to_async_iterator(events))
+        # The whole script is known upfront, so the companion can schedule it.
+        events = list(events)
+        try:
+            response = await self.stub.hid_batch(events_to_batch_grpc(events))
+        except GRPCError as e:
+            if e.status != Status.UNIMPLEMENTED:
+                raise
+            # Older companions only have the streaming RPC.
+            self.logger.debug("Companion does not implement hid_batch, streaming events")
+            await self.hid(iterator_to_async_iterator(events))
+            return
+        self.logger.debug(f"Sent HID events {batch_result_from_grpc(response)}")
 
     @log_and_handle_exceptions
     async def tap(self, x: float, y: float, duration: Optional[float] = None) -> None:
@@ -739,6 +804,16 @@ class Client(ClientBase):
             )
             await stream.recv_message()
 
+    @log_and_handle_exceptions
+    async def hid_batch(self, events: Iterable[HIDEvent]) -> HIDBatchResult:
+        response = await self.stub.hid_batch(events_to_batch_grpc(events))
+        return batch_result_from_grpc(response)
+
+    @log_and_handle_exceptions
+    async def transfer_stats(self) -> List[TransferStats]:
+        response = await self.stub.transfer_stats(TransferStatsRequest())
+        return transfer_stats_from_grpc(response)
+
     @log_and_handle_exceptions
     async def debug_server(self, request: DebugServerRequest) -> DebugServerResponse:
         async with self.stub.debugserver.open() as stream:
@@ -1010,50 +1085,79 @@ class Client(ClientBase):
                 wait_for_debugger=wait_for_debugger,
             )
             log_parser = XCTestLogParser()
+            # Artifacts arrive as chunks ahead of the final response.
+            artifacts: Dict[int, StreamedArtifact] = {}
+            if result_bundle_path:
+                artifacts[XctestRunResponse.Artifact.RESULT_BUNDLE] = StreamedArtifact(
+                    description="result bundle",
+                    output_path=result_bundle_path,
+                    logger=self.logger,
+                )
+            if log_directory_path:
+                artifacts[XctestRunResponse.Artifact.LOG_DIRECTORY] = StreamedArtifact(
+                    description="log directory",
+                    output_path=log_directory_path,
+                    logger=self.logger,
+                )
             await stream.send_message(request)
             await stream.end()
-            async for response in stream:
-                # response.log_output is a container of strings.
-                # google.protobuf.pyext._message.RepeatedScalarContainer.
-                for line in [
-                    line
-                    for lines in response.log_output
-                    for line in lines.splitlines(keepends=True)
-                ]:
-                    log_parser.parse_streaming_log(line.rstrip())
-                    self._log_from_companion(line)
-                    if idb_log_buffer:
-                        idb_log_buffer.write(line)
-
-                if result_bundle_path:
-                    await untar_into_path(
-                        payload=response.result_bundle,
-                        description="result bundle",
-                        output_path=result_bundle_path,
-                        logger=self.logger,
-                    )
-                if log_directory_path:
-                    await untar_into_path(
-                        payload=response.log_directory,
-                        description="log directory",
-                        output_path=log_directory_path,
-                        logger=self.logger,
-                    )
-                if response.coverage_json and coverage_output_path:
-                    with open(coverage_output_path, "w") as f:
-                        f.write(response.coverage_json)
-
-                if wait_for_debugger and response.debugger.pid:
-                    print("Tests waiting for debugger. To debug run:")
-                    print(f"lldb -p {response.debugger.pid}")
-
-                for result in make_results(response, log_parser):
-                    if activities_output_path:
-                        save_attachments(
-                            run_info=result,
-                            activities_output_path=activities_output_path,
+            try:
+                async for response in stream:
+                    if response.HasField("artifact"):
+                        artifact = artifacts.get(response.artifact.kind)
+                        if artifact is not None and response.artifact.error:
+                            artifact.fail(response.artifact.error)
+                        elif artifact is not None:
+                            await artifact.write(response.artifact.data)
+                        continue
+                    if response.status != XctestRunResponse.RUNNING:
+                        for artifact in artifacts.values():
+                            await artifact.finish()
+                    # response.log_output is a container of strings.
+                    # google.protobuf.pyext._message.RepeatedScalarContainer.
+                    for line in [
+                        line
+                        for lines in response.log_output
+                        for line in lines.splitlines(keepends=True)
+                    ]:
+                        log_parser.parse_streaming_log(line.rstrip())
+                        self._log_from_companion(line)
+                        if idb_log_buffer:
+                            idb_log_buffer.write(line)
+
+                    # Companions that don't stream artifacts inline them instead.
+                    if result_bundle_path:
+                        await untar_into_path(
+                            payload=response.result_bundle,
+                            description="result bundle",
+                            output_path=result_bundle_path,
+                            logger=self.logger,
+                        )
+                    if log_directory_path:
+                        await untar_into_path(
+                            payload=response.log_directory,
+                            description="log directory",
+                            output_path=log_directory_path,
+                            logger=self.logger,
                         )
-                    yield result
+                    if response.coverage_json and coverage_output_path:
+                        with open(coverage_output_path, "w") as f:
+                            f.write(response.coverage_json)
+
+                    if wait_for_debugger and response.debugger.pid:
+                        print("Tests waiting for debugger. To debug run:")
+                        print(f"lldb -p {response.debugger.pid}")
+
+                    for result in make_results(response, log_parser):
+                        if activities_output_path:
+                            save_attachments(
+                                run_info=result,
+                                activities_output_path=activities_output_path,
+                            )
+                        yield result
+            finally:
+                for artifact in artifacts.values():
+                    artifact.cancel()
 
     @log_and_handle_exceptions
     async def tail_logs(
@@ -4,9 +4,10 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
-from typing import List, Tuple, TypeVar
+from typing import Iterable, List, Tuple, TypeVar
 
 from idb.common.types import (
+    HIDBatchResult,
     HIDButton,
     HIDButtonType,
     HIDDelay,
@@ -19,7 +20,12 @@ from idb.common.types import (
     HIDTouch,
     Point,
 )
-from idb.grpc.idb_pb2 import HIDEvent as GrpcHIDEvent, Point as GrpcPoint
+from idb.grpc.idb_pb2 import (
+    HIDBatchRequest as GrpcHIDBatchRequest,
+    HIDBatchResponse as GrpcHIDBatchResponse,
+    HIDEvent as GrpcHIDEvent,
+    Point as GrpcPoint,
+)
 
 
 GrpcHIDButton = GrpcHIDEvent.HIDButton
@@ -109,6 +115,20 @@ def delay_to_grpc(delay: HIDDelay) -> GrpcHIDDelay:
     return GrpcHIDDelay(duration=delay.duration)
 
 
+def events_to_batch_grpc(events: Iterable[HIDEvent]) -> GrpcHIDBatchRequest:
+    return GrpcHIDBatchRequest(events=[event_to_grpc(event) for event in events])
+
+
+def batch_result_from_grpc(response: GrpcHIDBatchResponse) -> HIDBatchResult:
+    return HIDBatchResult(
+        message_count=response.message_count,
+        scheduled_duration=response.scheduled_duration,
+        actual_duration=response.actual_duration,
+        mean_jitter=response.mean_jitter,
+        max_jitter=response.max_jitter,
+    )
+
+
 def event_to_grpc(event: HIDEvent) -> GrpcHIDEvent:
     if isinstance(event, HIDPress):
         return GrpcHIDEvent(press=press_to_grpc(event))
@@ -4,9 +4,21 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+import hashlib
 import os
+import stat
 from logging import Logger
-from typing import IO, AsyncIterator, List, Union, Optional
+from typing import (
+    IO,
+    AsyncIterator,
+    Dict,
+    Iterable,
+    List,
+    NamedTuple,
+    Optional,
+    Tuple,
+    Union,
+)
 
 import aiofiles
 import idb.common.gzip as gzip
@@ -18,11 +30,18 @@ from idb.grpc.idb_pb2 import InstallRequest, Payload
 from idb.grpc.xctest import xctest_paths_to_tar
 
 
-CHUNK_SIZE = 16384
+CHUNK_SIZE: int = tar.READ_CHUNK_SIZE
+MANIFEST_CHUNK_SIZE = 1024 * 1024
 Destination = InstallRequest.Destination
 Bundle = Union[str, IO[bytes]]
 
 
+class ChunkLocation(NamedTuple):
+    path: str
+    offset: int
+    length: int
+
+
 async def _generate_ipa_chunks(
     ipa_path: str, logger: Logger
 ) -> AsyncIterator[InstallRequest]:
@@ -129,3 +148,87 @@ def generate_binary_chunks(
         status=Status(Status.FAILED_PRECONDITION),
         message=f"install invalid for {path} {destination}",
     )
+
+
+def _manifest_file(
+    path: str,
+    relative_path: str,
+    chunk_size: int,
+    locations: Dict[str, ChunkLocation],
+) -> InstallRequest.ManifestFile:
+    file_digest = hashlib.sha256()
+    chunks = []
+    offset = 0
+    with open(path, "rb") as f:
+        while True:
+            data = f.read(chunk_size)
+            if not data:
+                break
+            file_digest.update(data)
+            digest = hashlib.sha256(data).hexdigest()
+            chunks.append(digest)
+            locations.setdefault(
+                digest, ChunkLocation(path=path, offset=offset, length=len(data))
+            )
+            offset += len(data)
+    return InstallRequest.ManifestFile(
+        path=relative_path,
+        mode=stat.S_IMODE(os.lstat(path).st_mode),
+        digest=file_digest.hexdigest(),
+        chunks=chunks,
+    )
+
+
+def build_manifest(
+    path: str, chunk_size: int = MANIFEST_CHUNK_SIZE
+) -> Tuple[InstallRequest.Manifest, Dict[str, ChunkLocation]]:
+    # Paths are relative to the parent of the bundle, as they are in a tar of the bundle.
+    root = os.path.dirname(os.path.abspath(path))
+    files = []
+    locations: Dict[str, ChunkLocation] = {}
+    pending = [os.path.abspath(path)]
+    while pending:
+        directory = pending.pop()
+        relative_path = os.path.relpath(directory, root)
+        files.append(
+            InstallRequest.ManifestFile(
+                path=relative_path,
+                mode=stat.S_IMODE(os.lstat(directory).st_mode),
+                directory=True,
+            )
+        )
+        for name in sorted(os.listdir(directory), reverse=True):
+            entry = os.path.join(directory, name)
+            entry_relative_path = os.path.join(relative_path, name)
+            if os.path.islink(entry):
+                files.append(
+                    InstallRequest.ManifestFile(
+                        path=entry_relative_path, symlink_target=os.readlink(entry)
+                    )
+                )
+            elif os.path.isdir(entry):
+                pending.append(entry)
+            else:
+                files.append(
+                    _manifest_file(
+                        path=entry,
+                        relative_path=entry_relative_path,
+                        chunk_size=chunk_size,
+                        locations=locations,
+                    )
+                )
+    return (InstallRequest.Manifest(files=files), locations)
+
+
+async def generate_manifest_chunks(
+    digests: Iterable[str], locations: Dict[str, ChunkLocation], logger: Logger
+) -> AsyncIterator[InstallRequest]:
+    sent = 0
+    for digest in digests:
+        location = locations[digest]
+        async with aiofiles.open(location.path, "rb") as f:
+            await f.seek(location.offset)
+            data = await f.read(location.length)
+        sent += len(data)
+        yield InstallRequest(chunk=InstallRequest.Chunk(digest=digest, data=data))
+    logger.debug(f"Finished sending {sent} bytes of missing chunks")
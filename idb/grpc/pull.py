@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+# Copyright (c) Facebook, Inc. and its affiliates.
+#
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+import asyncio
+import os
+from logging import Logger
+from typing import (
+    AsyncContextManager,
+    AsyncIterator,
+    Awaitable,
+    Callable,
+    Dict,
+    List,
+    Optional,
+)
+
+from grpclib.exceptions import GRPCError, ProtocolError, StreamTerminatedError
+from idb.common.tar import drain_untar
+from idb.grpc.idb_pb2 import PullRequest, PullResponse
+from idb.grpc.stream import Stream, generate_bytes
+
+
+# The number of concurrent streams that the files of a pull are spread across.
+PULL_STREAM_COUNT = 4
+# The number of times that the outstanding files are requested after a stream fails.
+PULL_MAX_ATTEMPTS = 3
+
+PullStreamFactory = Callable[
+    [], AsyncContextManager[Stream[PullRequest, PullResponse]]
+]
+
+
+class PullException(Exception):
+    pass
+
+
+def _is_relative_path(path: str) -> bool:
+    return bool(path) and not os.path.isabs(path) and ".." not in path.split(os.sep)
+
+
+class PullWriter:
+    """
+    Writes the entries of a streamed pull to a directory as they arrive.
+    Chunks of a file may arrive on any stream. The bytes received for each file
+    are tracked, so that an interrupted pull can be resumed from where it stopped.
+    """
+
+    def __init__(self, output_path: str) -> None:
+        self.output_path = output_path
+        self.entries: Dict[str, PullResponse.Entry] = {}
+        self.received: Dict[str, int] = {}
+        self._fds: Dict[str, int] = {}
+        os.makedirs(output_path, exist_ok=True)
+
+    def _resolve(self, path: str) -> str:
+        if not _is_relative_path(path):
+            raise PullException(f"{path} is not a path within {self.output_path}")
+        return os.path.join(self.output_path, path)
+
+    def add_listing(self, listing: PullResponse.Listing) -> None:
+        for entry in listing.entries:
+            destination = self._resolve(entry.path)
+            self.entries[entry.path] = entry
+            if entry.directory:
+                os.makedirs(destination, exist_ok=True)
+            elif entry.symlink_target:
+                if os.path.lexists(destination):
+                    os.unlink(destination)
+                os.symlink(entry.symlink_target, destination)
+            elif entry.path not in self.received:
+                # Created up front, so that empty files exist without any chunks.
+                os.makedirs(os.path.dirname(destination), exist_ok=True)
+                os.close(
+                    os.open(destination, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o600)
+                )
+                self.received[entry.path] = 0
+
+    def write_chunk(self, chunk: PullResponse.Chunk) -> None:
+        fd = self._fds.get(chunk.path)
+        if fd is None:
+            destination = self._resolve(chunk.path)
+            os.makedirs(os.path.dirname(destination), exist_ok=True)
+            fd = os.open(destination, os.O_WRONLY | os.O_CREAT, 0o600)
+            self._fds[chunk.path] = fd
+        os.pwrite(fd, chunk.data, chunk.offset)
+        received = max(
+            self.received.get(chunk.path, 0), chunk.offset + len(chunk.data)
+        )
+        self.received[chunk.path] = received
+        entry = self.entries.get(chunk.path)
+        if entry is not None and received >= entry.size:
+            os.close(self._fds.pop(chunk.path))
+
+    def outstanding(self) -> List[PullRequest.Range]:
+        return [
+            PullRequest.Range(path=path, offset=self.received.get(path, 0))
+            for (path, entry) in self.entries.items()
+            if not entry.directory
+            and not entry.symlink_target
+            and self.received.get(path, 0) < entry.size
+        ]
+
+    def close(self) -> None:
+        for fd in self._fds.values():
+            os.close(fd)
+        self._fds = {}
+
+    def finish(self) -> None:
+        self.close()
+        directories = []
+        for (path, entry) in self.entries.items():
+            if entry.symlink_target:
+                continue
+            if entry.directory:
+                directories.append(entry)
+                continue
+            destination = self._resolve(path)
+            os.chmod(destination, entry.mode)
+            os.utime(destination, (entry.modification_time, entry.modification_time))
+        # Deepest first, so populating a directory doesn't change its times after.
+        for entry in reversed(directories):
+            destination = self._resolve(entry.path)
+            os.chmod(destination, entry.mode)
+            os.utime(destination, (entry.modification_time, entry.modification_time))
+
+
+async def _chain(
+    first: PullResponse, stream: Stream[PullRequest, PullResponse]
+) -> AsyncIterator[PullResponse]:
+    yield first
+    async for response in stream:
+        yield response
+
+
+async def _drain_chunks(
+    stream: Stream[PullRequest, PullResponse], writer: PullWriter
+) -> None:
+    async for response in stream:
+        if response.HasField("chunk"):
+            writer.write_chunk(response.chunk)
+
+
+async def _pull_ranges(
+    open_stream: PullStreamFactory,
+    request: PullRequest,
+    ranges: List[PullRequest.Range],
+    writer: PullWriter,
+) -> None:
+    async with open_stream() as stream:
+        shard = PullRequest()
+        shard.CopyFrom(request)
+        shard.ranges.extend(ranges)
+        await stream.send_message(shard)
+        await stream.end()
+        await _drain_chunks(stream, writer)
+
+
+async def _pull_shard(
+    open_stream: PullStreamFactory,
+    request: PullRequest,
+    stream_index: int,
+    listed: asyncio.Event,
+    writer: PullWriter,
+) -> None:
+    # The listing must be complete first, otherwise files can't be resumed.
+    await listed.wait()
+    async with open_stream() as stream:
+        shard = PullRequest()
+        shard.CopyFrom(request)
+        shard.stream_index = stream_index
+        await stream.send_message(shard)
+        await stream.end()
+        await _drain_chunks(stream, writer)
+
+
+async def _guarded(pull: Awaitable[None], logger: Logger) -> Optional[Exception]:
+    try:
+        await pull
+        return None
+    except (GRPCError, ProtocolError, StreamTerminatedError) as ex:
+        logger.warning(f"Pull stream failed, outstanding files will be resumed: {ex}")
+        return ex
+
+
+async def drain_pull(
+    open_stream: PullStreamFactory,
+    request: PullRequest,
+    output_path: str,
+    logger: Logger,
+    stream_count: int = PULL_STREAM_COUNT,
+) -> None:
+    request.stream_files = True
+    request.stream_count = stream_count
+    writer = PullWriter(output_path)
+    listed = asyncio.Event()
+    try:
+        async with open_stream() as stream:
+            first_request = PullRequest()
+            first_request.CopyFrom(request)
+            first_request.stream_index = 0
+            await stream.send_message(first_request)
+            await stream.end()
+            first = await stream.recv_message()
+            if first is None:
+                return
+            if first.HasField("payload"):
+                # Companions that can't stream the files send a tarball instead.
+                logger.info("Companion sent a tarball, extracting it")
+                await drain_untar(
+                    generate_bytes(_chain(first, stream)), output_path=output_path
+                )
+                return
+            shards = [
+                asyncio.ensure_future(
+                    _pull_shard(open_stream, request, index, listed, writer)
+                )
+                for index in range(1, stream_count)
+            ]
+            try:
+                response: Optional[PullResponse] = first
+                while response is not None and not response.HasField("chunk"):
+                    writer.add_listing(response.listing)
+                    response = await stream.recv_message()
+                listed.set()
+                if response is not None:
+                    writer.write_chunk(response.chunk)
+                first_error = await _guarded(_drain_chunks(stream, writer), logger)
+            finally:
+                # A failure during the listing can't be resumed, so abandon the shards.
+                if not listed.is_set():
+                    for shard in shards:
+                        shard.cancel()
+            errors = [first_error] + [
+                await _guarded(shard, logger) for shard in shards
+            ]
+        attempt = 0
+        while any(errors):
+            ranges = writer.outstanding()
+            if not ranges:
+                break
+            attempt += 1
+            if attempt > PULL_MAX_ATTEMPTS:
+                raise PullException(
+                    f"Failed to pull {len(ranges)} files "
+                    f"after {PULL_MAX_ATTEMPTS} attempts"
+                ) from next(error for error in errors if error)
+            logger.info(f"Resuming the pull of {len(ranges)} files")
+            errors = await asyncio.gather(
+                *[
+                    _guarded(
+                        _pull_ranges(
+                            open_stream, request, ranges[index::stream_count], writer
+                        ),
+                        logger,
+                    )
+                    for index in range(min(stream_count, len(ranges)))
+                ]
+            )
+        writer.finish()
+    finally:
+        writer.close()
@@ -5,6 +5,8 @@
 # LICENSE file in the root directory of this source tree.
 
 from idb.grpc.hid import (
+    GrpcHIDBatchRequest,
+    GrpcHIDBatchResponse,
     GrpcHIDButton,
     GrpcHIDDelay,
     GrpcHIDEvent,
@@ -14,6 +16,7 @@ from idb.grpc.hid import (
     GrpcHIDSwipe,
     GrpcHIDTouch,
     GrpcPoint,
+    HIDBatchResult,
     HIDButton,
     HIDButtonType,
     HIDDelay,
@@ -23,7 +26,9 @@ from idb.grpc.hid import (
     HIDSwipe,
     HIDTouch,
     Point,
+    batch_result_from_grpc,
     event_to_grpc,
+    events_to_batch_grpc,
 )
 from idb.utils.testing import TestCase
 
@@ -75,3 +80,49 @@ class HidTests(TestCase):
             event_to_grpc(HIDDelay(duration=1)),
             GrpcHIDEvent(delay=GrpcHIDDelay(duration=1)),
         )
+
+    def test_batch(self) -> None:
+        self.assertEqual(
+            events_to_batch_grpc(
+                [
+                    HIDPress(
+                        action=HIDTouch(point=Point(x=1, y=2)),
+                        direction=HIDDirection.DOWN,
+                    ),
+                    HIDDelay(duration=0.1),
+                ]
+            ),
+            GrpcHIDBatchRequest(
+                events=[
+                    GrpcHIDEvent(
+                        press=GrpcHIDPress(
+                            action=GrpcHIDPressAction(
+                                touch=GrpcHIDTouch(point=GrpcPoint(x=1, y=2))
+                            ),
+                            direction=GrpcHIDEvent.DOWN,
+                        )
+                    ),
+                    GrpcHIDEvent(delay=GrpcHIDDelay(duration=0.1)),
+                ]
+            ),
+        )
+
+    def test_batch_result(self) -> None:
+        self.assertEqual(
+            batch_result_from_grpc(
+                GrpcHIDBatchResponse(
+                    message_count=2,
+                    scheduled_duration=0.1,
+                    actual_duration=0.11,
+                    mean_jitter=0.001,
+                    max_jitter=0.002,
+                )
+            ),
+            HIDBatchResult(
+                message_count=2,
+                scheduled_duration=0.1,
+                actual_duration=0.11,
+                mean_jitter=0.001,
+                max_jitter=0.002,
+            ),
+        )
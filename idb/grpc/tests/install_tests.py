@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# Copyright (c) Facebook, Inc. and its affiliates.
+#
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+import hashlib
+import logging
+import os
+import tempfile
+import time
+from typing import AsyncIterator, Tuple
+
+from idb.common.tar import READ_CHUNK_SIZE, GzipArchive, drain_untar
+from idb.common.types import Compression
+from idb.grpc.idb_pb2 import InstallRequest, Payload
+from idb.grpc.install import (
+    build_manifest,
+    generate_binary_chunks,
+    generate_manifest_chunks,
+)
+from idb.utils.testing import TestCase
+from idb.utils.typing import none_throws
+
+
+BENCHMARK_FILE_SIZE = 4 * 1024 * 1024
+BENCHMARK_FILE_COUNT = 8
+
+
+class InstallManifestTests(TestCase):
+    def setUp(self) -> None:
+        self.temp = tempfile.TemporaryDirectory()
+        self.app = os.path.join(self.temp.name, "Foo.app")
+        os.makedirs(os.path.join(self.app, "Frameworks"))
+        with open(os.path.join(self.app, "Foo"), "wb") as f:
+            f.write(b"0123456789")
+        os.chmod(os.path.join(self.app, "Foo"), 0o755)
+        with open(os.path.join(self.app, "Frameworks", "Info.plist"), "wb") as f:
+            f.write(b"0123")
+        os.symlink("Foo", os.path.join(self.app, "Link"))
+
+    def tearDown(self) -> None:
+        self.temp.cleanup()
+
+    def test_manifest_entries(self) -> None:
+        manifest, _ = build_manifest(self.app, chunk_size=4)
+        files = {file.path: file for file in manifest.files}
+        self.assertEqual(
+            list(files.keys()),
+            [
+                "Foo.app",
+                "Foo.app/Link",
+                "Foo.app/Foo",
+                "Foo.app/Frameworks",
+                "Foo.app/Frameworks/Info.plist",
+            ],
+        )
+        self.assertTrue(files["Foo.app"].directory)
+        self.assertTrue(files["Foo.app/Frameworks"].directory)
+        self.assertEqual(files["Foo.app/Link"].symlink_target, "Foo")
+        binary = files["Foo.app/Foo"]
+        self.assertEqual(binary.mode, 0o755)
+        self.assertEqual(binary.digest, hashlib.sha256(b"0123456789").hexdigest())
+        self.assertEqual(
+            list(binary.chunks),
+            [
+                hashlib.sha256(b"0123").hexdigest(),
+                hashlib.sha256(b"4567").hexdigest(),
+                hashlib.sha256(b"89").hexdigest(),
+            ],
+        )
+
+    def test_identical_chunks_are_located_once(self) -> None:
+        _, locations = build_manifest(self.app, chunk_size=4)
+        # "0123" is the first chunk of both files.
+        self.assertEqual(len(locations), 3)
+
+    async def test_generates_missing_chunks(self) -> None:
+        manifest, locations = build_manifest(self.app, chunk_size=4)
+        missing = [hashlib.sha256(b"4567").hexdigest()]
+        requests = [
+            request
+            async for request in generate_manifest_chunks(
+                digests=missing, locations=locations, logger=logging.getLogger()
+            )
+        ]
+        self.assertEqual(len(requests), 1)
+        self.assertEqual(requests[0].chunk.digest, missing[0])
+        self.assertEqual(requests[0].chunk.data, b"4567")
+
+
+class StandInCompanion:
+    """
+    Receives an upload as the companion does, extracting the payloads with tar.
+    Each message is serialized and parsed, as it is when crossing the channel.
+    """
+
+    def __init__(self, output_path: str) -> None:
+        self.output_path = output_path
+        self.messages = 0
+        self.received = 0
+
+    async def _payloads(
+        self, requests: AsyncIterator[InstallRequest]
+    ) -> AsyncIterator[bytes]:
+        async for request in requests:
+            data = request.SerializeToString()
+            self.messages += 1
+            self.received += len(data)
+            yield InstallRequest.FromString(data).payload.data
+
+    async def receive(self, requests: AsyncIterator[InstallRequest]) -> None:
+        await drain_untar(self._payloads(requests), output_path=self.output_path)
+
+
+async def _tar_process_requests(path: str) -> AsyncIterator[InstallRequest]:
+    async with GzipArchive(
+        paths=[path], additional_tar_args=None, place_in_subfolders=False, verbose=False
+    ).run() as process:
+        while True:
+            data = await none_throws(process.stdout).read(READ_CHUNK_SIZE)
+            if not data:
+                break
+            yield InstallRequest(payload=Payload(data=data))
+
+
+class InstallUploadBenchmark(TestCase):
+    def setUp(self) -> None:
+        self.temp = tempfile.TemporaryDirectory()
+        self.app = os.path.join(self.temp.name, "Foo.app")
+        os.makedirs(self.app)
+        # Half of the files are incompressible, as binaries and assets are.
+        for index in range(BENCHMARK_FILE_COUNT):
+            with open(os.path.join(self.app, f"File{index}"), "wb") as f:
+                if index % 2:
+                    f.write(os.urandom(BENCHMARK_FILE_SIZE))
+                else:
+                    f.write(b"0123456789abcdef" * (BENCHMARK_FILE_SIZE // 16))
+        self.size = BENCHMARK_FILE_SIZE * BENCHMARK_FILE_COUNT
+
+    def tearDown(self) -> None:
+        self.temp.cleanup()
+
+    async def _upload(
+        self, name: str, requests: AsyncIterator[InstallRequest]
+    ) -> Tuple[float, StandInCompanion]:
+        companion = StandInCompanion(os.path.join(self.temp.name, name))
+        start = time.monotonic()
+        await companion.receive(requests)
+        elapsed = time.monotonic() - start
+        for index in range(BENCHMARK_FILE_COUNT):
+            extracted = os.path.join(companion.output_path, "Foo.app", f"File{index}")
+            self.assertEqual(os.path.getsize(extracted), BENCHMARK_FILE_SIZE)
+        megabytes = self.size / (1024 * 1024)
+        logging.getLogger().info(
+            f"{name}: {megabytes:.0f} MB in {companion.messages} messages "
+            f"({companion.received} bytes) at {megabytes / elapsed:.1f} MB/s"
+        )
+        return (elapsed, companion)
+
+    async def test_app_upload(self) -> None:
+        (_, companion) = await self._upload(
+            "parallel",
+            generate_binary_chunks(
+                path=self.app,
+                destination=InstallRequest.APP,
+                compression=Compression.GZIP,
+                logger=logging.getLogger(),
+            ),
+        )
+        await self._upload("tar_process", _tar_process_requests(self.app))
+        # Messages are coalesced up to the maximum read size.
+        self.assertLessEqual(
+            companion.messages, companion.received // READ_CHUNK_SIZE + 2
+        )
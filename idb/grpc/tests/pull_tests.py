@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+# Copyright (c) Facebook, Inc. and its affiliates.
+#
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+import logging
+import os
+import stat
+import tempfile
+from typing import Dict, List, Optional
+
+from grpclib.exceptions import StreamTerminatedError
+from idb.grpc.idb_pb2 import PullRequest, PullResponse
+from idb.grpc.pull import PullException, PullWriter, drain_pull
+from idb.utils.testing import TestCase
+
+
+CHUNK_SIZE = 4
+
+
+class FakeCompanion:
+    def __init__(self, files: Dict[str, bytes]) -> None:
+        self.files = files
+        self.requests: List[PullRequest] = []
+        # Streams with this index fail after sending one chunk.
+        self.failing_stream_index: Optional[int] = None
+
+    def respond(self, request: PullRequest) -> List[PullResponse]:
+        self.requests.append(request)
+        ranges = [(r.path, r.offset) for r in request.ranges]
+        responses = []
+        if not ranges:
+            paths = sorted(self.files.keys())
+            if request.stream_index == 0:
+                listing = PullResponse.Listing(
+                    entries=[
+                        PullResponse.Entry(
+                            path=path,
+                            mode=0o644,
+                            size=len(self.files[path]),
+                            modification_time=1000000000.0,
+                        )
+                        for path in paths
+                    ]
+                )
+                responses.append(PullResponse(listing=listing))
+            ranges = [
+                (path, 0)
+                for (index, path) in enumerate(paths)
+                if index % request.stream_count == request.stream_index
+            ]
+        for (path, offset) in ranges:
+            data = self.files[path]
+            for start in range(offset, len(data), CHUNK_SIZE):
+                chunk = PullResponse.Chunk(
+                    path=path, offset=start, data=data[start : start + CHUNK_SIZE]
+                )
+                responses.append(PullResponse(chunk=chunk))
+        return responses
+
+    def open(self) -> "FakeStream":
+        return FakeStream(self)
+
+
+class FakeStream:
+    def __init__(self, companion: FakeCompanion) -> None:
+        self.companion = companion
+        self.responses: List[PullResponse] = []
+        self.fail_after: Optional[int] = None
+
+    async def __aenter__(self) -> "FakeStream":
+        return self
+
+    async def __aexit__(self, *args: object) -> None:
+        pass
+
+    async def send_message(self, message: PullRequest) -> None:
+        self.responses = self.companion.respond(message)
+        if (
+            not len(message.ranges)
+            and message.stream_index == self.companion.failing_stream_index
+        ):
+            self.fail_after = 1
+
+    async def end(self) -> None:
+        pass
+
+    async def recv_message(self) -> Optional[PullResponse]:
+        if self.fail_after is not None:
+            if self.fail_after == 0:
+                raise StreamTerminatedError("Connection lost")
+            self.fail_after -= 1
+        if not self.responses:
+            return None
+        return self.responses.pop(0)
+
+    def __aiter__(self) -> "FakeStream":
+        return self
+
+    async def __anext__(self) -> PullResponse:
+        response = await self.recv_message()
+        if response is None:
+            raise StopAsyncIteration
+        return response
+
+
+class PullTests(TestCase):
+    def setUp(self) -> None:
+        self.temp = tempfile.TemporaryDirectory()
+        self.output = os.path.join(self.temp.name, "output")
+        self.files = {
+            "a": b"0123456789",
+            "b/c": b"abcdef",
+            "b/d": b"ghijklmnopqrs",
+            "e": b"tuv",
+        }
+
+    def tearDown(self) -> None:
+        self.temp.cleanup()
+
+    def assertOutput(self) -> None:
+        for (path, data) in self.files.items():
+            with open(os.path.join(self.output, path), "rb") as f:
+                self.assertEqual(f.read(), data)
+
+    def test_writer_writes_listing_and_chunks(self) -> None:
+        writer = PullWriter(self.output)
+        writer.add_listing(
+            PullResponse.Listing(
+                entries=[
+                    PullResponse.Entry(path="Dir", mode=0o755, directory=True),
+                    PullResponse.Entry(path="Dir/Foo", mode=0o755, size=8),
+                    PullResponse.Entry(path="Empty", mode=0o600, size=0),
+                    PullResponse.Entry(path="Link", symlink_target="Dir/Foo"),
+                ]
+            )
+        )
+        writer.write_chunk(PullResponse.Chunk(path="Dir/Foo", offset=4, data=b"4567"))
+        self.assertEqual(
+            [(r.path, r.offset) for r in writer.outstanding()], [("Dir/Foo", 8)]
+        )
+        writer.write_chunk(PullResponse.Chunk(path="Dir/Foo", offset=0, data=b"0123"))
+        self.assertEqual(writer.outstanding(), [])
+        writer.finish()
+        foo = os.path.join(self.output, "Dir/Foo")
+        with open(foo, "rb") as f:
+            self.assertEqual(f.read(), b"01234567")
+        self.assertEqual(stat.S_IMODE(os.stat(foo).st_mode), 0o755)
+        self.assertEqual(os.path.getsize(os.path.join(self.output, "Empty")), 0)
+        self.assertEqual(os.readlink(os.path.join(self.output, "Link")), "Dir/Foo")
+
+    def test_writer_tracks_outstanding_offsets(self) -> None:
+        writer = PullWriter(self.output)
+        writer.add_listing(
+            PullResponse.Listing(entries=[PullResponse.Entry(path="Foo", size=10)])
+        )
+        writer.write_chunk(PullResponse.Chunk(path="Foo", offset=0, data=b"0123"))
+        self.assertEqual(
+            [(r.path, r.offset) for r in writer.outstanding()], [("Foo", 4)]
+        )
+        writer.close()
+
+    def test_writer_rejects_paths_outside_of_output(self) -> None:
+        writer = PullWriter(self.output)
+        with self.assertRaises(PullException):
+            writer.write_chunk(PullResponse.Chunk(path="../Foo", offset=0, data=b"0"))
+        with self.assertRaises(PullException):
+            writer.add_listing(
+                PullResponse.Listing(entries=[PullResponse.Entry(path="/tmp/Foo")])
+            )
+        self.assertFalse(os.path.exists(os.path.join(self.temp.name, "Foo")))
+
+    async def test_pull_spreads_files_across_streams(self) -> None:
+        companion = FakeCompanion(self.files)
+        await drain_pull(
+            open_stream=companion.open,
+            request=PullRequest(src_path="foo"),
+            output_path=self.output,
+            logger=logging.getLogger(),
+            stream_count=2,
+        )
+        self.assertOutput()
+        self.assertEqual(
+            [(r.stream_index, r.stream_count) for r in companion.requests],
+            [(0, 2), (1, 2)],
+        )
+        self.assertTrue(all(r.stream_files for r in companion.requests))
+
+    async def test_pull_resumes_a_failed_stream(self) -> None:
+        companion = FakeCompanion(self.files)
+        companion.failing_stream_index = 1
+        await drain_pull(
+            open_stream=companion.open,
+            request=PullRequest(src_path="foo"),
+            output_path=self.output,
+            logger=logging.getLogger(),
+            stream_count=2,
+        )
+        self.assertOutput()
+        # The second stream sent the first chunk of "b/c", then failed.
+        resumed = [
+            (r.path, r.offset) for request in companion.requests for r in request.ranges
+        ]
+        self.assertEqual(resumed, [("b/c", 4), ("e", 0)])
@@ -4,12 +4,20 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+import io
+import logging
 import os.path
 import plistlib
+import tarfile
 import tempfile
 from unittest import TestCase
 
-from idb.grpc.xctest import extract_paths_from_xctestrun
+from idb.grpc.xctest import (
+    StreamedArtifact,
+    XCTestException,
+    extract_paths_from_xctestrun,
+)
+from idb.utils import testing
 
 
 class XCTestsTestCase(TestCase):
@@ -28,3 +36,68 @@ class XCTestsTestCase(TestCase):
             self.assertEqual(
                 [file_path, tmp_dir + "/rest1", tmp_dir + "/rest2"], results
             )
+
+
+class StreamedArtifactTests(testing.TestCase):
+    async def test_extracts_chunks_as_they_arrive(self) -> None:
+        contents = os.urandom(100000)
+        archive = io.BytesIO()
+        with tarfile.open(fileobj=archive, mode="w:gz") as tar:
+            info = tarfile.TarInfo("Foo.xcresult/Info.plist")
+            info.size = len(contents)
+            tar.addfile(info, io.BytesIO(contents))
+        data = archive.getvalue()
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            artifact = StreamedArtifact(
+                description="result bundle",
+                output_path=tmp_dir,
+                logger=logging.getLogger(),
+            )
+            for offset in range(0, len(data), 4096):
+                await artifact.write(data[offset : offset + 4096])
+            await artifact.finish()
+            with open(os.path.join(tmp_dir, "Foo.xcresult/Info.plist"), "rb") as f:
+                self.assertEqual(f.read(), contents)
+
+    async def test_nothing_is_written_without_chunks(self) -> None:
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            output_path = os.path.join(tmp_dir, "logs")
+            artifact = StreamedArtifact(
+                description="log directory",
+                output_path=output_path,
+                logger=logging.getLogger(),
+            )
+            await artifact.finish()
+            self.assertFalse(os.path.exists(output_path))
+
+    async def test_failed_extraction_is_raised_when_writing(self) -> None:
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            artifact = StreamedArtifact(
+                description="result bundle",
+                output_path=os.path.join(tmp_dir, "missing", "Foo.xcresult"),
+                logger=logging.getLogger(),
+            )
+            # The queue fills up once nothing is draining it.
+            with self.assertRaises(FileNotFoundError):
+                for _ in range(100):
+                    await artifact.write(b"\0" * 4096)
+
+    async def test_failure_is_raised_when_finished(self) -> None:
+        archive = io.BytesIO()
+        with tarfile.open(fileobj=archive, mode="w:gz") as tar:
+            info = tarfile.TarInfo("Foo.xcresult/Info.plist")
+            info.size = 100000
+            tar.addfile(info, io.BytesIO(os.urandom(100000)))
+        data = archive.getvalue()
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            artifact = StreamedArtifact(
+                description="result bundle",
+                output_path=tmp_dir,
+                logger=logging.getLogger(),
+            )
+            await artifact.write(data[:4096])
+            artifact.fail("No space left on device")
+            # Chunks that arrive after the failure are ignored.
+            await artifact.write(data[4096:])
+            with self.assertRaisesRegex(XCTestException, "No space left on device"):
+                await artifact.finish()
@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+# Copyright (c) Facebook, Inc. and its affiliates.
+#
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+from typing import List
+
+from idb.common.types import Histogram, TransferStats
+from idb.grpc.idb_pb2 import TransferStatsResponse
+
+
+def _to_histogram(proto: TransferStatsResponse.Histogram) -> Histogram:
+    return Histogram(
+        bucket_counts=list(proto.bucket_counts),
+        count=proto.count,
+        sum=proto.sum,
+        maximum=proto.maximum,
+    )
+
+
+def _to_transfer_stats(proto: TransferStatsResponse.Call) -> TransferStats:
+    return TransferStats(
+        name=proto.name,
+        calls=proto.calls,
+        bytes_in=proto.bytes_in,
+        chunks_in=proto.chunks_in,
+        bytes_out=proto.bytes_out,
+        chunks_out=proto.chunks_out,
+        stage_micros={
+            stage: _to_histogram(histogram)
+            for (stage, histogram) in proto.stage_micros.items()
+        },
+        duration_micros=_to_histogram(proto.duration_micros),
+        throughput_bytes_per_second=_to_histogram(proto.throughput_bytes_per_second),
+    )
+
+
+def transfer_stats_from_grpc(response: TransferStatsResponse) -> List[TransferStats]:
+    return [_to_transfer_stats(call) for call in response.calls]
@@ -4,13 +4,14 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+import asyncio
 import os
 import plistlib
 from enum import Enum
 from logging import Logger
-from typing import Any, Dict, List, Optional, Set
+from typing import Any, AsyncIterator, Dict, List, Optional, Set
 
-from idb.common.tar import untar
+from idb.common.tar import drain_untar, untar
 from idb.common.types import (
     TestActivity,
     TestAttachment,
@@ -26,6 +27,9 @@ Logic = XctestRunRequest.Logic
 Application = XctestRunRequest.Application
 UI = XctestRunRequest.UI
 
+# The number of artifact chunks that are buffered while tar catches up.
+ARTIFACT_QUEUE_SIZE = 8
+
 
 class XCTestException(Exception):
     pass
@@ -131,6 +135,7 @@ def make_request(
         timeout=(timeout if timeout is not None else 0),
         collect_logs=collect_logs,
         wait_for_debugger=wait_for_debugger,
+        stream_artifacts=True,
     )
 
 
@@ -237,3 +242,76 @@ def attachment_to_file_extension(attachment: TestAttachment) -> str:
         return "png"
     else:
         return "data"
+
+
+class StreamedArtifact:
+    """
+    Extracts an artifact that arrives as a series of chunks of a gzipped tarball.
+    Chunks are piped into tar as they arrive, so the artifact is never held in memory.
+    """
+
+    def __init__(self, description: str, output_path: str, logger: Logger) -> None:
+        self.description = description
+        self.output_path = output_path
+        self.logger = logger
+        self._queue: "asyncio.Queue[Optional[bytes]]" = asyncio.Queue(
+            maxsize=ARTIFACT_QUEUE_SIZE
+        )
+        self._task: "Optional[asyncio.Future[None]]" = None
+        self._error: Optional[str] = None
+
+    async def _generate(self) -> AsyncIterator[bytes]:
+        while True:
+            data = await self._queue.get()
+            if data is None:
+                return
+            yield data
+
+    async def write(self, data: bytes) -> None:
+        if self._error is not None:
+            return
+        if self._task is None:
+            self.logger.info(f"Writing {self.description} to {self.output_path}")
+            self._task = asyncio.ensure_future(
+                drain_untar(self._generate(), output_path=self.output_path)
+            )
+        await self._put(self._task, data)
+
+    async def _put(self, task: "asyncio.Future[None]", data: Optional[bytes]) -> None:
+        # Nothing drains the queue once the extraction has stopped,
+        # so its failure is raised instead of waiting for room forever.
+        put = asyncio.ensure_future(self._queue.put(data))
+        await asyncio.wait([put, task], return_when=asyncio.FIRST_COMPLETED)
+        if put.done():
+            return
+        put.cancel()
+        self._task = None
+        task.result()
+        raise XCTestException(
+            f"Extracting {self.description} to {self.output_path} "
+            "stopped before it was complete"
+        )
+
+    def fail(self, error: str) -> None:
+        self.logger.error(f"Failed to stream {self.description}: {error}")
+        self._error = error
+        self.cancel()
+
+    async def finish(self) -> None:
+        if self._error is not None:
+            raise XCTestException(
+                f"{self.description} at {self.output_path} is incomplete: "
+                f"{self._error}"
+            )
+        task = self._task
+        if task is None:
+            return
+        await self._put(task, None)
+        self._task = None
+        await task
+        self.logger.info(f"Finished writing {self.description} to {self.output_path}")
+
+    def cancel(self) -> None:
+        if self._task is not None:
+            self._task.cancel()
+            self._task = None
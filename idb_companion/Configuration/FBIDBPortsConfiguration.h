@@ -44,6 +44,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign, readonly) NSString *tlsCertPath;
 
+/**
+ YES if the long-lived streaming calls should be served asynchronously from a completion queue, NO otherwise.
+ */
+@property (nonatomic, assign, readonly) BOOL grpcAsyncStreams;
+
+/**
+ The number of frames that are queued for a video stream client that is slow to read them, in addition to the frame that is being written.
+ */
+@property (nonatomic, assign, readonly) NSUInteger videoStreamMaximumQueuedFrames;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -8,6 +8,7 @@
 #import "FBIDBPortsConfiguration.h"
 
 static NSString *const GrpcPortKey = @"-grpc-port";
+static NSString *const VideoStreamMaximumQueuedFramesKey = @"-video-stream-max-queued-frames";
 
 @implementation FBIDBPortsConfiguration
 
@@ -29,6 +30,8 @@ static NSString *const GrpcPortKey = @"-grpc-port";
   _grpcPort = [userDefaults stringForKey:GrpcPortKey] ? [userDefaults integerForKey:GrpcPortKey] : 10882;
   _grpcDomainSocket = [userDefaults stringForKey:@"-grpc-domain-sock"];
   _tlsCertPath = [userDefaults stringForKey:@"-tls-cert-path"];
+  _grpcAsyncStreams = [userDefaults boolForKey:@"-grpc-async-streams"];
+  _videoStreamMaximumQueuedFrames = [userDefaults integerForKey:VideoStreamMaximumQueuedFramesKey] > 0 ? (NSUInteger) [userDefaults integerForKey:VideoStreamMaximumQueuedFramesKey] : 4;
 
   return self;
 }
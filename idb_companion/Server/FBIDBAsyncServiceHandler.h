@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <idbGRPC/idb.grpc.pb.h>
+
+#import "FBIDBServiceHandler.h"
+
+#pragma once
+
+/**
+ A Service Handler that serves the long-lived streaming calls (log, video_stream) from a completion queue.
+ These calls are completed from FBFuture callbacks, so they do not occupy a thread of the synchronous server for their lifetime.
+ video_stream is served as a raw method, so that frames are written as slices that reference the encoder's buffers instead of being copied into a message.
+ All other calls are handled synchronously by FBIDBServiceHandler.
+ */
+class FBIDBAsyncServiceHandler final : public CompanionService::WithAsyncMethod_log<CompanionService::WithRawMethod_video_stream<FBIDBServiceHandler>> {
+public:
+  // Constructors
+  FBIDBAsyncServiceHandler(FBIDBCommandExecutor *commandExecutor, id<FBiOSTarget> target, id<FBEventReporter> eventReporter, FBIDBTransferMetrics *transferMetrics, FBIDBPortsConfiguration *portsConfig);
+
+  // Serves the asynchronous calls from the completion queue. Returns once the queue has been shutdown and drained.
+  void serve(grpc::ServerCompletionQueue *queue);
+};
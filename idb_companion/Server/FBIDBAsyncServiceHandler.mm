@@ -0,0 +1,743 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBIDBAsyncServiceHandler.h"
+
+#import <condition_variable>
+#import <deque>
+#import <memory>
+#import <mutex>
+#import <vector>
+
+#import <grpcpp/grpcpp.h>
+#import <FBSimulatorControl/FBSimulatorControl.h>
+
+#import "FBIDBCommandExecutor.h"
+#import "FBIDBPortsConfiguration.h"
+#import "FBIDBTransferMetrics.h"
+
+using grpc::ServerAsyncReaderWriter;
+using grpc::ServerAsyncWriter;
+using grpc::ServerCompletionQueue;
+
+#pragma mark Private Functions
+
+// Field numbers from idb.proto, used when serializing responses by hand.
+static const uint32_t VideoStreamResponsePayloadField = 2;
+static const uint32_t PayloadDataField = 2;
+static const uint8_t WireTypeLengthDelimited = 2;
+
+static size_t varint_size(uint64_t value)
+{
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+static size_t write_varint(uint8_t *buffer, uint64_t value)
+{
+  size_t size = 0;
+  while (value >= 0x80) {
+    buffer[size++] = (uint8_t) (value | 0x80);
+    value >>= 7;
+  }
+  buffer[size++] = (uint8_t) value;
+  return size;
+}
+
+static size_t response_size(const grpc::ByteBuffer &response)
+{
+  return response.Length();
+}
+
+static size_t response_size(const google::protobuf::Message &response)
+{
+  return response.ByteSizeLong();
+}
+
+static void release_data(void *data)
+{
+  CFRelease(data);
+}
+
+// Serializes a response message that contains a single Payload with the provided data.
+// If the data does not own its bytes, the header and the data are copied into a single slice, as the bytes are only valid until the consumer returns.
+// Otherwise only the few bytes of the message header are copied, the regions of the data are referenced by slices that retain it.
+static grpc::ByteBuffer payload_byte_buffer(NSData *data, uint32_t payloadField, bool ownsData)
+{
+  const uint64_t dataLength = data.length;
+  const uint64_t payloadLength = 1 + varint_size(dataLength) + dataLength;
+  uint8_t header[2 * (1 + 10)];
+  size_t headerLength = 0;
+  header[headerLength++] = (uint8_t) ((payloadField << 3) | WireTypeLengthDelimited);
+  headerLength += write_varint(header + headerLength, payloadLength);
+  header[headerLength++] = (uint8_t) ((PayloadDataField << 3) | WireTypeLengthDelimited);
+  headerLength += write_varint(header + headerLength, dataLength);
+
+  if (!ownsData) {
+    grpc_slice slice = grpc_slice_malloc(headerLength + dataLength);
+    __block uint8_t *destination = GRPC_SLICE_START_PTR(slice);
+    memcpy(destination, header, headerLength);
+    destination += headerLength;
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+      memcpy(destination, bytes, byteRange.length);
+      destination += byteRange.length;
+    }];
+    grpc::Slice copied(slice, grpc::Slice::STEAL_REF);
+    return grpc::ByteBuffer(&copied, 1);
+  }
+
+  __block std::vector<grpc::Slice> slices;
+  slices.emplace_back(header, headerLength);
+  // A dispatch_data backed NSData may be made up of many regions, none of these are flattened.
+  [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+    if (byteRange.length == 0) {
+      return;
+    }
+    slices.emplace_back(const_cast<void *>(bytes), byteRange.length, release_data, (void *) CFBridgingRetain(data));
+  }];
+  return grpc::ByteBuffer(slices.data(), slices.size());
+}
+
+#pragma mark Calls
+
+// The events that a call can receive from the completion queue.
+enum class FBIDBAsyncEvent : size_t {
+  Request = 0,
+  Read,
+  Write,
+  Finish,
+  Done,
+  Count,
+};
+
+class FBIDBAsyncCall;
+
+// The tag that is passed to the completion queue, identifying both the call and the event.
+struct FBIDBAsyncTag {
+  FBIDBAsyncCall *call;
+  FBIDBAsyncEvent event;
+};
+
+class FBIDBAsyncCall : public std::enable_shared_from_this<FBIDBAsyncCall> {
+public:
+  virtual ~FBIDBAsyncCall() = default;
+  virtual void proceed(FBIDBAsyncEvent event, bool ok) = 0;
+};
+
+/**
+ The state of a single call with a streamed response.
+ Responses are enqueued from any queue and are written one-at-a-time, as the async API only permits a single outstanding write.
+ The call keeps itself alive until every operation that it has started on the completion queue has been delivered back.
+ */
+template <class Response, class Stream>
+class FBIDBAsyncStreamingCall : public FBIDBAsyncCall {
+public:
+  FBIDBAsyncStreamingCall(FBIDBAsyncServiceHandler *service, ServerCompletionQueue *queue, FBIDBCommandExecutor *commandExecutor, id<FBiOSTarget> target)
+    : _service(service), _queue(queue), _commandExecutor(commandExecutor), _target(target), _stream(&_context)
+  {
+    for (size_t index = 0; index < (size_t) FBIDBAsyncEvent::Count; index++) {
+      _tags[index] = {this, (FBIDBAsyncEvent) index};
+    }
+  }
+
+  // Starts waiting for an incoming call.
+  void start()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _self = shared_from_this();
+    // Both the request and the done notification are outstanding from this point.
+    _outstanding = 2;
+    _context.AsyncNotifyWhenDone(tag(FBIDBAsyncEvent::Done));
+    request();
+  }
+
+  // Enqueues a response, this is written after any responses that are already enqueued.
+  void write(const Response &response)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_finishing || _broken) {
+      return;
+    }
+    _pending.push_back(response);
+    _pendingBytes += response_size(response);
+    if (!_writing) {
+      write_next();
+    }
+  }
+
+  // The number of bytes of responses that have been enqueued, but have not yet been written.
+  size_t pending_bytes()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pendingBytes;
+  }
+
+  // Blocks until no more than the provided number of bytes are enqueued, or until nothing more will be written.
+  void wait_for_pending_bytes(size_t maximumPendingBytes)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _written.wait(lock, [&] {
+      return _pendingBytes <= maximumPendingBytes || _finishing || _broken;
+    });
+  }
+
+  // Finishes the call once all of the enqueued responses have been written.
+  void finish(const grpc::Status &status)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_finishing) {
+      return;
+    }
+    _finishing = true;
+    _status = status;
+    _written.notify_all();
+    if (!_writing) {
+      finish_now();
+    }
+  }
+
+  void proceed(FBIDBAsyncEvent event, bool ok) override
+  {
+    std::shared_ptr<FBIDBAsyncCall> strongSelf = shared_from_this();
+    switch (event) {
+      case FBIDBAsyncEvent::Request: {
+        if (!ok) {
+          // The server is shutting down, a call that never started will not recieve a done notification.
+          std::lock_guard<std::mutex> lock(_mutex);
+          _self.reset();
+          return;
+        }
+        spawn();
+        did_start();
+        break;
+      }
+      case FBIDBAsyncEvent::Read: {
+        did_read(ok);
+        break;
+      }
+      case FBIDBAsyncEvent::Write: {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _writing = false;
+        _pendingBytes -= response_size(_current);
+        if (!ok) {
+          // The stream is broken, there's no point in writing anything more.
+          _broken = true;
+          _pending.clear();
+          _pendingBytes = 0;
+        }
+        if (!_pending.empty()) {
+          write_next();
+        } else if (_finishing) {
+          finish_now();
+        }
+        _written.notify_all();
+        break;
+      }
+      case FBIDBAsyncEvent::Finish: {
+        break;
+      }
+      case FBIDBAsyncEvent::Done: {
+        did_complete(_context.IsCancelled());
+        break;
+      }
+      default:
+        break;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _outstanding--;
+    if (_outstanding == 0) {
+      _self.reset();
+    }
+  }
+
+protected:
+  // Requests the next incoming call of this type.
+  virtual void request() = 0;
+  // Creates the call that will wait for the next incoming call of this type.
+  virtual void spawn() = 0;
+  // Called once the call has started.
+  virtual void did_start() = 0;
+  // Called when a read started with read() has completed.
+  virtual void did_read(bool ok) {}
+  // Called when the call has completed, either normally or through cancellation by the client.
+  virtual void did_complete(bool cancelled) {}
+
+  void *tag(FBIDBAsyncEvent event)
+  {
+    return &_tags[(size_t) event];
+  }
+
+  // Starts reading the next message from the client.
+  template <class Request>
+  void read(Request *request)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_finishing) {
+      return;
+    }
+    _outstanding++;
+    _stream.Read(request, tag(FBIDBAsyncEvent::Read));
+  }
+
+  FBIDBAsyncServiceHandler *_service;
+  ServerCompletionQueue *_queue;
+  FBIDBCommandExecutor *_commandExecutor;
+  id<FBiOSTarget> _target;
+  grpc::ServerContext _context;
+  Stream _stream;
+
+private:
+  // Must be called with the lock held.
+  void write_next()
+  {
+    _writing = true;
+    _outstanding++;
+    _current = _pending.front();
+    _pending.pop_front();
+    _stream.Write(_current, tag(FBIDBAsyncEvent::Write));
+  }
+
+  // Must be called with the lock held.
+  void finish_now()
+  {
+    _outstanding++;
+    _stream.Finish(_status, tag(FBIDBAsyncEvent::Finish));
+  }
+
+  FBIDBAsyncTag _tags[(size_t) FBIDBAsyncEvent::Count];
+  std::mutex _mutex;
+  std::condition_variable _written;
+  std::shared_ptr<FBIDBAsyncCall> _self;
+  std::deque<Response> _pending;
+  Response _current;
+  grpc::Status _status;
+  size_t _outstanding = 0;
+  size_t _pendingBytes = 0;
+  bool _writing = false;
+  bool _finishing = false;
+  bool _broken = false;
+};
+
+#pragma mark log
+
+/**
+ Serves a log call.
+ Log output arrives in many small pieces, so it is coalesced into larger responses rather than writing a response for each piece.
+ A response is written once it reaches a byte budget, or once the oldest output in it has waited for the coalescing interval.
+ */
+class FBIDBAsyncLogCall final : public FBIDBAsyncStreamingCall<idb::LogResponse, ServerAsyncWriter<idb::LogResponse>> {
+public:
+  using FBIDBAsyncStreamingCall::FBIDBAsyncStreamingCall;
+
+protected:
+  void request() override
+  {
+    _service->Requestlog(&_context, &_request, &_stream, _queue, _queue, tag(FBIDBAsyncEvent::Request));
+  }
+
+  void spawn() override
+  {
+    std::make_shared<FBIDBAsyncLogCall>(_service, _queue, _commandExecutor, _target)->start();
+  }
+
+  void did_start() override
+  {
+    std::weak_ptr<FBIDBAsyncLogCall> weakCall = std::static_pointer_cast<FBIDBAsyncLogCall>(shared_from_this());
+    NSMutableArray<NSString *> *arguments = NSMutableArray.array;
+    for (auto argument : _request.arguments()) {
+      [arguments addObject:[NSString stringWithUTF8String:argument.c_str()]];
+    }
+    id<FBDataConsumer> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+      std::shared_ptr<FBIDBAsyncLogCall> call = weakCall.lock();
+      if (!call) {
+        return;
+      }
+      call->coalesce(data);
+    }];
+    BOOL logFromCompanion = _request.source() == idb::LogRequest::Source::LogRequest_Source_COMPANION;
+    FBFuture<id<FBLogOperation>> *operationFuture = logFromCompanion ? [_commandExecutor tail_companion_logs:consumer] : [_target tailLog:arguments consumer:consumer];
+    [operationFuture onQueue:_target.asyncQueue notifyOfCompletion:^(FBFuture<id<FBLogOperation>> *future) {
+      std::shared_ptr<FBIDBAsyncLogCall> call = weakCall.lock();
+      if (!call) {
+        [future.result.completed cancel];
+        return;
+      }
+      call->did_start_operation(future);
+    }];
+  }
+
+  void did_complete(bool cancelled) override
+  {
+    id<FBLogOperation> operation = nil;
+    {
+      std::lock_guard<std::mutex> lock(_operationMutex);
+      _clientClosed = true;
+      operation = _operation;
+    }
+    // Cancelling the operation will finish the call.
+    [operation.completed cancel];
+  }
+
+private:
+  void did_start_operation(FBFuture<id<FBLogOperation>> *future)
+  {
+    id<FBLogOperation> operation = future.result;
+    if (!operation) {
+      finish(grpc::Status(grpc::StatusCode::INTERNAL, future.error.localizedDescription.UTF8String ?: "Failed to start log operation"));
+      return;
+    }
+    bool clientClosed = false;
+    {
+      std::lock_guard<std::mutex> lock(_operationMutex);
+      _operation = operation;
+      clientClosed = _clientClosed;
+    }
+    std::weak_ptr<FBIDBAsyncLogCall> weakCall = std::static_pointer_cast<FBIDBAsyncLogCall>(shared_from_this());
+    [operation.completed onQueue:_target.asyncQueue notifyOfCompletion:^(FBFuture *_) {
+      std::shared_ptr<FBIDBAsyncLogCall> call = weakCall.lock();
+      if (!call) {
+        return;
+      }
+      call->flush();
+      call->finish(grpc::Status::OK);
+    }];
+    if (clientClosed) {
+      [operation.completed cancel];
+    }
+  }
+
+  void coalesce(NSData *data)
+  {
+    std::lock_guard<std::mutex> lock(_coalescingMutex);
+    std::string *output = _coalesced.mutable_output();
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+      output->append(static_cast<const char *>(bytes), byteRange.length);
+    }];
+    if (output->length() >= LogCoalescingMaximumBytes) {
+      flush_locked();
+      return;
+    }
+    if (_flushScheduled || output->empty()) {
+      return;
+    }
+    // The first output since the last write starts the interval, later output is written along with it.
+    _flushScheduled = true;
+    std::weak_ptr<FBIDBAsyncLogCall> weakCall = std::static_pointer_cast<FBIDBAsyncLogCall>(shared_from_this());
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, LogCoalescingInterval), _target.asyncQueue, ^{
+      std::shared_ptr<FBIDBAsyncLogCall> call = weakCall.lock();
+      if (!call) {
+        return;
+      }
+      call->flush();
+    });
+  }
+
+  void flush()
+  {
+    std::lock_guard<std::mutex> lock(_coalescingMutex);
+    flush_locked();
+  }
+
+  // Must be called with the coalescing lock held.
+  void flush_locked()
+  {
+    _flushScheduled = false;
+    if (_coalesced.output().empty()) {
+      return;
+    }
+    write(_coalesced);
+    _coalesced.clear_output();
+  }
+
+  idb::LogRequest _request;
+  std::mutex _operationMutex;
+  id<FBLogOperation> _operation;
+  bool _clientClosed = false;
+  std::mutex _coalescingMutex;
+  idb::LogResponse _coalesced;
+  bool _flushScheduled = false;
+};
+
+#pragma mark video_stream
+
+class FBIDBAsyncVideoStreamCall;
+
+/**
+ Writes the frames of a video stream to a call.
+ Reports the bytes that are enqueued on the call, so that the stream can adapt to a client that is slow to read them.
+ This consumer must be written to from the queue of a FBBoundedFrameDataConsumer that belongs to the call.
+ The end of each frame blocks that queue until the frame has been written, so that later frames are dropped or coalesced there, without blocking the producer or any other call.
+ Each frame is recorded as a single write, timed from the end of the frame until it has been written.
+ */
+@interface FBIDBVideoStreamCallConsumer : NSObject <FBDataConsumer, FBDataConsumerStackConsuming, FBDataConsumerFrameDelimited, FBDataConsumerBacklog>
+
+- (instancetype)initWithCall:(std::weak_ptr<FBIDBAsyncVideoStreamCall>)call recording:(FBIDBTransferRecording *)recording;
+
+@end
+
+class FBIDBAsyncVideoStreamCall final : public FBIDBAsyncStreamingCall<grpc::ByteBuffer, ServerAsyncReaderWriter<grpc::ByteBuffer, grpc::ByteBuffer>> {
+public:
+  using FBIDBAsyncStreamingCall::FBIDBAsyncStreamingCall;
+
+  ~FBIDBAsyncVideoStreamCall() override
+  {
+    [_recording finish];
+  }
+
+protected:
+  void request() override
+  {
+    _service->Requestvideo_stream(&_context, &_stream, _queue, _queue, tag(FBIDBAsyncEvent::Request));
+  }
+
+  void spawn() override
+  {
+    std::make_shared<FBIDBAsyncVideoStreamCall>(_service, _queue, _commandExecutor, _target)->start();
+  }
+
+  void did_start() override
+  {
+    // The first message from the client contains the configuration of the stream.
+    read(&_requestBuffer);
+  }
+
+  void did_read(bool ok) override
+  {
+    bool startedStreaming = false;
+    {
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      startedStreaming = _startedStreaming;
+      _startedStreaming = true;
+    }
+    if (startedStreaming) {
+      // Any further message, or the client closing its side of the stream, means that streaming should stop.
+      stop();
+      return;
+    }
+    if (!ok) {
+      finish(grpc::Status(grpc::StatusCode::INTERNAL, "No start message was received"));
+      return;
+    }
+    idb::VideoStreamRequest request;
+    grpc::Status status = grpc::SerializationTraits<idb::VideoStreamRequest>::Deserialize(&_requestBuffer, &request);
+    if (!status.ok()) {
+      finish(status);
+      return;
+    }
+    start_streaming(request.start());
+  }
+
+  void did_complete(bool cancelled) override
+  {
+    if (cancelled) {
+      stop();
+    }
+  }
+
+private:
+  void start_streaming(const idb::VideoStreamRequest_Start &start)
+  {
+    NSError *error = nil;
+    FBVideoStreamConfiguration *configuration = video_stream_configuration(start, &error);
+    if (!configuration) {
+      finish(grpc::Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String));
+      return;
+    }
+    _recording = [_service->transfer_metrics() recordingForCall:@"video_stream"];
+    std::weak_ptr<FBIDBAsyncVideoStreamCall> weakCall = std::static_pointer_cast<FBIDBAsyncVideoStreamCall>(shared_from_this());
+    id<FBDataConsumer, FBDataConsumerStackConsuming> consumer = nil;
+    const std::string requestedFilePath = start.file_path();
+    if (requestedFilePath.length() > 0) {
+      consumer = [FBFileWriter syncWriterForFilePath:[NSString stringWithUTF8String:requestedFilePath.c_str()] error:&error];
+      if (!consumer) {
+        finish(grpc::Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String));
+        return;
+      }
+    } else {
+      // Every call has its own bounded consumer, so a slow client only holds up the queue that writes to it.
+      consumer = [[FBIDBVideoStreamCallConsumer alloc] initWithCall:weakCall recording:_recording];
+      consumer = video_stream_bounded_consumer(consumer, configuration, _service->ports_config().videoStreamMaximumQueuedFrames);
+    }
+    dispatch_queue_t queue = _target.asyncQueue;
+    [[[_target
+      createStreamWithConfiguration:configuration]
+      onQueue:queue fmap:^(id<FBVideoStream> videoStream) {
+        return [[videoStream startStreaming:consumer] mapReplace:videoStream];
+      }]
+      onQueue:queue notifyOfCompletion:^(FBFuture<id<FBVideoStream>> *future) {
+        std::shared_ptr<FBIDBAsyncVideoStreamCall> call = weakCall.lock();
+        if (!call) {
+          [future.result stopStreaming];
+          return;
+        }
+        call->did_start_streaming(future);
+      }];
+  }
+
+  void did_start_streaming(FBFuture<id<FBVideoStream>> *future)
+  {
+    id<FBVideoStream> videoStream = future.result;
+    if (!videoStream) {
+      finish(grpc::Status(grpc::StatusCode::INTERNAL, future.error.localizedDescription.UTF8String ?: "Failed to start video stream"));
+      return;
+    }
+    bool stopRequested = false;
+    {
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      _videoStream = videoStream;
+      stopRequested = _stopRequested;
+    }
+    if (stopRequested) {
+      stop_video_stream(videoStream);
+      return;
+    }
+    // Stop when the stream stops by itself, or when the client sends the stop message or hangs up.
+    std::weak_ptr<FBIDBAsyncVideoStreamCall> weakCall = std::static_pointer_cast<FBIDBAsyncVideoStreamCall>(shared_from_this());
+    [videoStream.completed onQueue:_target.asyncQueue notifyOfCompletion:^(FBFuture *_) {
+      std::shared_ptr<FBIDBAsyncVideoStreamCall> call = weakCall.lock();
+      if (!call) {
+        return;
+      }
+      call->stop();
+    }];
+    read(&_stopBuffer);
+  }
+
+  void stop()
+  {
+    id<FBVideoStream> videoStream = nil;
+    {
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      if (_stopRequested) {
+        return;
+      }
+      _stopRequested = true;
+      videoStream = _videoStream;
+    }
+    // When the stream has not started yet, it will be stopped as soon as it has.
+    if (videoStream) {
+      stop_video_stream(videoStream);
+    }
+  }
+
+  void stop_video_stream(id<FBVideoStream> videoStream)
+  {
+    std::weak_ptr<FBIDBAsyncVideoStreamCall> weakCall = std::static_pointer_cast<FBIDBAsyncVideoStreamCall>(shared_from_this());
+    // It may have stopped already in which case this resolves instantly.
+    [[videoStream stopStreaming] onQueue:_target.asyncQueue notifyOfCompletion:^(FBFuture *future) {
+      std::shared_ptr<FBIDBAsyncVideoStreamCall> call = weakCall.lock();
+      if (!call) {
+        return;
+      }
+      if (future.error) {
+        call->finish(grpc::Status(grpc::StatusCode::INTERNAL, future.error.localizedDescription.UTF8String));
+        return;
+      }
+      call->finish(grpc::Status::OK);
+    }];
+  }
+
+  grpc::ByteBuffer _requestBuffer;
+  grpc::ByteBuffer _stopBuffer;
+  std::mutex _streamMutex;
+  id<FBVideoStream> _videoStream;
+  FBIDBTransferRecording *_recording;
+  bool _startedStreaming = false;
+  bool _stopRequested = false;
+};
+
+@implementation FBIDBVideoStreamCallConsumer
+{
+  std::weak_ptr<FBIDBAsyncVideoStreamCall> _call;
+  FBIDBTransferRecording *_recording;
+  uint64_t _frameBytes;
+}
+
+- (instancetype)initWithCall:(std::weak_ptr<FBIDBAsyncVideoStreamCall>)call recording:(FBIDBTransferRecording *)recording
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _call = call;
+  _recording = recording;
+
+  return self;
+}
+
+- (void)consumeData:(NSData *)data
+{
+  std::shared_ptr<FBIDBAsyncVideoStreamCall> call = _call.lock();
+  if (!call) {
+    return;
+  }
+  // Frames are copies that are owned by the bounded consumer, so the response can reference them.
+  grpc::ByteBuffer response = payload_byte_buffer(data, VideoStreamResponsePayloadField, true);
+  _frameBytes += response_size(response);
+  call->write(response);
+}
+
+- (void)consumeEndOfFile
+{
+}
+
+- (void)consumeEndOfFrame
+{
+  std::shared_ptr<FBIDBAsyncVideoStreamCall> call = _call.lock();
+  if (!call) {
+    return;
+  }
+  uint64_t start = FBIDBTransferMetrics.now;
+  call->wait_for_pending_bytes(0);
+  [_recording recordWriteOfBytes:_frameBytes nanoseconds:FBIDBTransferMetrics.now - start];
+  _frameBytes = 0;
+}
+
+- (NSUInteger)pendingBytes
+{
+  std::shared_ptr<FBIDBAsyncVideoStreamCall> call = _call.lock();
+  if (!call) {
+    return 0;
+  }
+  return call->pending_bytes();
+}
+
+@end
+
+#pragma mark Constructors
+
+FBIDBAsyncServiceHandler::FBIDBAsyncServiceHandler(FBIDBCommandExecutor *commandExecutor, id<FBiOSTarget> target, id<FBEventReporter> eventReporter, FBIDBTransferMetrics *transferMetrics, FBIDBPortsConfiguration *portsConfig)
+{
+  _commandExecutor = commandExecutor;
+  _target = target;
+  _eventReporter = eventReporter;
+  _transferMetrics = transferMetrics;
+  _portsConfig = portsConfig;
+}
+
+#pragma mark Public
+
+void FBIDBAsyncServiceHandler::serve(ServerCompletionQueue *queue)
+{@autoreleasepool{
+  // Each call type always has one call waiting for the next incoming request.
+  std::make_shared<FBIDBAsyncLogCall>(this, queue, _commandExecutor, _target)->start();
+  std::make_shared<FBIDBAsyncVideoStreamCall>(this, queue, _commandExecutor, _target)->start();
+
+  void *tag = nullptr;
+  bool ok = false;
+  while (queue->Next(&tag, &ok)) {
+    @autoreleasepool {
+      FBIDBAsyncTag *asyncTag = static_cast<FBIDBAsyncTag *>(tag);
+      asyncTag->call->proceed(asyncTag->event, ok);
+    }
+  }
+}}
@@ -13,6 +13,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class FBApplicationArchiveExtractor;
+@class FBBundleManifestFile;
 @class FBBundleStorageManager;
 @class FBIDBLogger;
 @class FBIDBPortsConfiguration;
@@ -94,6 +96,24 @@ extern FBFileContainerKind const FBFileContainerKindDiskImages;
  */
 - (FBFuture<FBInstalledArtifact *> *)install_app_stream:(FBProcessInput *)input compression:(FBCompressionFormat)compression;
 
+/**
+ Install an App from an archive that is extracted as it is received.
+ The App is installed from where it was extracted, then moved into storage.
+
+ @param extractor the extractor that the archive is being fed to.
+ @return A future that resolves with the App Bundle Id
+ */
+- (FBFuture<FBInstalledArtifact *> *)install_app_archive:(FBApplicationArchiveExtractor *)extractor;
+
+/**
+ Install an App from a Manifest.
+ The App is rebuilt from the content store, so every chunk of the manifest must be present in the store.
+
+ @param manifest the manifest of the directory containing the App.
+ @return A future that resolves with the App Bundle Id
+ */
+- (FBFuture<FBInstalledArtifact *> *)install_app_manifest:(NSArray<FBBundleManifestFile *> *)manifest;
+
 /**
  Installs an xctest bundle by file path.
 
@@ -192,6 +212,14 @@ extern FBFileContainerKind const FBFileContainerKindDiskImages;
  */
 - (FBFuture<NSNull *> *)hid:(FBSimulatorHIDEvent *)event;
 
+/**
+ Perform a hid event on the target, as a schedule of messages that is sent from a timer
+
+ @param event hid event to perform
+ @return a Future that resolves with the timing that was achieved
+ */
+- (FBFuture<FBSimulatorHIDScheduleReport *> *)hid_schedule:(FBSimulatorHIDEvent *)event;
+
 /**
  Sets latitude and longitude of the Simulator.
  The behaviour of a directly-launched Simulator differs from Simulator.app slightly, in that the location isn't automatically set.
@@ -442,6 +470,15 @@ This allows to avoid the permission popup the first time we open a deeplink
  */
 - (FBFuture<NSData *> *)pull_file:(NSString *)path containerType:(nullable NSString *)containerType;
 
+/**
+ Resolves the path on the host of a file in an applications container, so that it can be read without being copied out first.
+
+ @param path relative path to the container where file resides
+ @param containerType the container.
+ @return A future that resolves with the path on the host, or fails if the container is not on the host's filesystem.
+ */
+- (FBFuture<NSString *> *)pull_file_host_path:(NSString *)path containerType:(nullable NSString *)containerType;
+
 /**
  Remove path within the container
 
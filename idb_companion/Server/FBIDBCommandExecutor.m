@@ -10,6 +10,8 @@
 #import <FBSimulatorControl/FBSimulatorControl.h>
 #import <FBDeviceControl/FBDeviceControl.h>
 
+#import "FBApplicationArchiveExtractor.h"
+#import "FBContentAddressedStore.h"
 #import "FBIDBStorageManager.h"
 #import "FBIDBError.h"
 #import "FBIDBLogger.h"
@@ -94,6 +96,43 @@ FBFileContainerKind const FBFileContainerKindDiskImages = @"disk_images";
   return [self installExtractedApp:[self.temporaryDirectory withArchiveExtractedFromStream:input compression:compression]];
 }
 
+- (FBFuture<FBInstalledArtifact *> *)install_app_archive:(FBApplicationArchiveExtractor *)extractor
+{
+  FBBundleStorage *storage = self.storageManager.application;
+  return [extractor.extractedApplication
+    onQueue:self.target.asyncQueue pop:^(FBBundleDescriptor *appBundle) {
+      if (!appBundle) {
+        return [FBFuture futureWithError:[FBControlCoreError errorForDescription:@"No app bundle could be extracted"]];
+      }
+      NSError *error = nil;
+      if (![storage checkArchitecture:appBundle error:&error]) {
+        return [FBFuture futureWithError:error];
+      }
+      // The extracted App is moved into storage once installed, so it is written to disk only once.
+      return [[[self.target
+        installApplicationWithPath:appBundle.path]
+        onQueue:self.target.workQueue]
+        onQueue:self.target.asyncQueue fmap:^(id _) {
+          return [storage moveBundleIntoStorage:appBundle];
+        }];
+  }];
+}
+
+- (FBFuture<FBInstalledArtifact *> *)install_app_manifest:(NSArray<FBBundleManifestFile *> *)manifest
+{
+  FBContentAddressedStore *store = self.storageManager.contentStore;
+  FBFutureContext<NSURL *> *materialized = [[self.temporaryDirectory
+    withTemporaryDirectory]
+    onQueue:self.target.asyncQueue pend:^(NSURL *directory) {
+      NSError *error = nil;
+      if (![store materializeManifest:manifest inDirectory:directory error:&error]) {
+        return [FBFuture futureWithError:error];
+      }
+      return [FBFuture futureWithResult:directory];
+    }];
+  return [self installExtractedApp:materialized];
+}
+
 - (FBFuture<FBInstalledArtifact *> *)install_xctest_app_file_path:(NSString *)filePath
 {
   return [self installXctestFilePath:[FBFutureContext futureContextWithFuture:[FBFuture futureWithResult:[NSURL fileURLWithPath:filePath]]]];
@@ -476,6 +515,14 @@ static const NSTimeInterval ListTestBundleTimeout = 60.0;
     }];
 }
 
+- (FBFuture<FBSimulatorHIDScheduleReport *> *)hid_schedule:(FBSimulatorHIDEvent *)event
+{
+  return [self.connectToHID
+    onQueue:self.target.workQueue fmap:^FBFuture *(FBSimulatorHID *hid) {
+      return [event performScheduledOnHID:hid];
+    }];
+}
+
 - (FBFuture<NSNull *> *)set_hardware_keyboard_enabled:(BOOL)enabled
 {
   return [[self
@@ -581,6 +628,20 @@ static const NSTimeInterval ListTestBundleTimeout = 60.0;
     }];
 }
 
+- (FBFuture<NSString *> *)pull_file_host_path:(NSString *)path containerType:(NSString *)containerType
+{
+  return [[self
+    applicationDataContainerCommands:containerType]
+    onQueue:self.target.workQueue pop:^FBFuture *(id<FBFileContainer> container) {
+      if (![container respondsToSelector:@selector(hostPathOfItemInContainer:)]) {
+        return [[FBIDBError
+          describeFormat:@"%@ is not on the host's filesystem", container]
+          failFuture];
+      }
+      return [container hostPathOfItemInContainer:path];
+    }];
+}
+
 - (FBFuture<NSNull *> *)create_directory:(NSString *)directoryPath containerType:(NSString *)containerType
 {
   return [[self
@@ -11,12 +11,14 @@
 #import <grpcpp/resource_quota.h>
 #import <idbGRPC/idb.grpc.pb.h>
 
+#import "FBIDBAsyncServiceHandler.h"
 #import "FBIDBStorageManager.h"
 #import "FBIDBCommandExecutor.h"
 #import "FBIDBError.h"
 #import "FBIDBPortsConfiguration.h"
 #import "FBIDBLogger.h"
 #import "FBIDBServiceHandler.h"
+#import "FBIDBTransferMetrics.h"
 
 @interface FBIDBCompanionServer ()
 
@@ -33,6 +35,7 @@
 
 using grpc::Server;
 using grpc::ServerBuilder;
+using grpc::ServerCompletionQueue;
 using grpc::ServerContext;
 using grpc::Status;
 using grpc::ResourceQuota;
@@ -98,7 +101,6 @@ using namespace std;
         [self.logger logFormat:@"Starting GRPC server with TLS path %@", tlsCertPath];
       }
     }
-    FBIDBServiceHandler service = FBIDBServiceHandler(self.commandExecutor, self.target, self.eventReporter);
     int selectedPort = 0;
     std::shared_ptr<grpc::ServerCredentials> server_cred = grpc::InsecureServerCredentials();
     if (tlsCertPath && !domainSocket) {
@@ -110,19 +112,35 @@ using namespace std;
       sslOpts.pem_key_cert_pairs.push_back({key, cert});
       server_cred = grpc::SslServerCredentials(sslOpts);
     }
-    unique_ptr<Server> server(ServerBuilder()
+    ServerBuilder builder;
+    builder
       .AddListeningPort(server_address, server_cred, &selectedPort)
-      .RegisterService(&service)
       .SetResourceQuota(ResourceQuota("idb_resource.quota").SetMaxThreads(10))
       .SetMaxReceiveMessageSize(16777216) // 16MB (16 * 1024 * 1024). Default is 4MB (4 * 1024 * 1024)
-      .AddChannelArgument(GRPC_ARG_ALLOW_REUSEPORT, 0)
-      .BuildAndStart()
-    );
+      .AddChannelArgument(GRPC_ARG_ALLOW_REUSEPORT, 0);
+    // The services and completion queue must outlive the server, so are declared before it.
+    unique_ptr<grpc::Service> service;
+    unique_ptr<ServerCompletionQueue> completionQueue;
+    FBIDBAsyncServiceHandler *asyncService = nullptr;
+    FBIDBTransferMetrics *transferMetrics = [FBIDBTransferMetrics new];
+    if (self.ports.grpcAsyncStreams) {
+      [self.logger log:@"Serving long-lived streams from a completion queue"];
+      asyncService = new FBIDBAsyncServiceHandler(self.commandExecutor, self.target, self.eventReporter, transferMetrics, self.ports);
+      service.reset(asyncService);
+      completionQueue = builder.AddCompletionQueue();
+    } else {
+      service.reset(new FBIDBServiceHandler(self.commandExecutor, self.target, self.eventReporter, transferMetrics, self.ports));
+    }
+    builder.RegisterService(service.get());
+    unique_ptr<Server> server(builder.BuildAndStart());
     // AddListeningPort will either set this to 0 or not modify it.
     // For 0 TCP input that binds: The selectedPort is whatever port that the server has bound on
     // For PORT TCP input that binds: The selectedPort is PORT.
     // For a Unix Domain Socket: The selectedPort is 1.
     if (selectedPort == 0) {
+      if (completionQueue) {
+        completionQueue->Shutdown();
+      }
       [serverStarted resolveWithError:[[FBIDBError describeFormat:@"Failed to start GRPC Server"] build]];
       return;
     }
@@ -133,7 +151,18 @@ using namespace std;
       [self.logger.info logFormat:@"Started GRPC server on port %u", selectedPort];
       [serverStarted resolveWithResult:@{@"grpc_port": @(selectedPort)}];
     }
+    dispatch_group_t completionQueueDrained = dispatch_group_create();
+    if (completionQueue) {
+      ServerCompletionQueue *queuePtr = completionQueue.get();
+      dispatch_group_async(completionQueueDrained, dispatch_queue_create("com.facebook.idb.grpc.completion_queue", DISPATCH_QUEUE_SERIAL), ^{
+        asyncService->serve(queuePtr);
+      });
+    }
     server->Wait();
+    if (completionQueue) {
+      completionQueue->Shutdown();
+      dispatch_group_wait(completionQueueDrained, DISPATCH_TIME_FOREVER);
+    }
     [self.logger.info logFormat:@"GRPC server is no longer running on port %u", selectedPort];
     [self.serverTerminated resolveWithResult:NSNull.null];
   });
@@ -9,6 +9,8 @@
 
 @class FBIDBCommandExecutor;
 @class FBIDBPortsConfiguration;
+@class FBIDBTransferMetrics;
+@class FBIDBTransferRecording;
 
 using idb::CompanionService;
 using grpc::Status;
@@ -16,19 +18,53 @@ using grpc::ServerContext;
 
 #pragma once
 
-class FBIDBServiceHandler final : public CompanionService::Service {
-private:
+/**
+ Builds the configuration for a video stream from the initial request of a video_stream call.
+ */
+FBVideoStreamConfiguration *video_stream_configuration(const idb::VideoStreamRequest_Start &start, NSError **error);
+
+/**
+ Bounds the frames of a video stream that are queued for a client, so that a slow client does not cause memory to grow without bound.
+ Frames must be delimited by the producer with FBDataConsumerFrameDelimited, as the data of a frame is accumulated until the end of the frame.
+ The client is written to from a queue of its own, so it may block without blocking the producer. Frames that cannot be dropped are coalesced instead.
+ */
+id<FBDataConsumer, FBDataConsumerStackConsuming> video_stream_bounded_consumer(id<FBDataConsumer> consumer, FBVideoStreamConfiguration *configuration, NSUInteger maximumQueuedFrames);
+
+/**
+ Log output is coalesced until a response holds at least this many bytes. Output is not split, so a single chunk that is larger is written as one response.
+ */
+extern const size_t LogCoalescingMaximumBytes;
+
+/**
+ Log output that is smaller than a full response is written after at most this delay.
+ */
+extern const int64_t LogCoalescingInterval;
+
+class FBIDBServiceHandler : public CompanionService::Service {
+protected:
+  // Default constructor for subclasses that are composed from the generated async method templates.
+  FBIDBServiceHandler() = default;
+
   FBIDBCommandExecutor *_commandExecutor;
   id<FBiOSTarget> _target;
   id<FBEventReporter> _eventReporter;
-  FBFuture<FBInstalledArtifact *> *install_future(const idb::InstallRequest_Destination destination, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream);
+  FBIDBTransferMetrics *_transferMetrics;
+  FBIDBPortsConfiguration *_portsConfig;
+  FBFuture<FBInstalledArtifact *> *install_future(const idb::InstallRequest_Destination destination, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream, FBIDBTransferRecording *recording);
+  FBFuture<FBInstalledArtifact *> *install_app_archive_future(const idb::Payload &initial, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream, FBIDBTransferRecording *recording);
+  FBFuture<FBInstalledArtifact *> *install_manifest_future(const idb::InstallRequest_Destination destination, const idb::InstallRequest_Manifest &manifest, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream, FBIDBTransferRecording *recording);
 
 public:
-  FBIDBPortsConfiguration *portsConfig;
   // Constructors
-  FBIDBServiceHandler(FBIDBCommandExecutor *commandExecutor, id<FBiOSTarget> target, id<FBEventReporter> eventReporter);
+  FBIDBServiceHandler(FBIDBCommandExecutor *commandExecutor, id<FBiOSTarget> target, id<FBEventReporter> eventReporter, FBIDBTransferMetrics *transferMetrics, FBIDBPortsConfiguration *portsConfig);
   FBIDBServiceHandler(const FBIDBServiceHandler &c);
 
+  // The metrics that calls that transfer data are recorded to.
+  FBIDBTransferMetrics *transfer_metrics();
+
+  // The configuration of the companion. Used for the limits of video streams.
+  FBIDBPortsConfiguration *ports_config();
+
   // Handled Methods
   Status accessibility_info(ServerContext *context, const idb::AccessibilityInfoRequest *request, idb::AccessibilityInfoResponse *response);
   Status add_media(ServerContext *context,grpc::ServerReader<idb::AddMediaRequest> *reader, idb::AddMediaResponse *response);
@@ -43,6 +79,7 @@ public:
   Status describe(ServerContext *context, const idb::TargetDescriptionRequest *request, idb::TargetDescriptionResponse *response);
   Status focus(ServerContext *context, const idb::FocusRequest *request, idb::FocusResponse *response);
   Status hid(ServerContext *context,grpc::ServerReader<idb::HIDEvent> *reader, idb::HIDResponse *response);
+  Status hid_batch(ServerContext *context, const idb::HIDBatchRequest *request, idb::HIDBatchResponse *response);
   Status install(ServerContext *context,grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream);
   Status instruments_run(ServerContext *context,grpc::ServerReaderWriter<idb::InstrumentsRunResponse, idb::InstrumentsRunRequest> *stream);
   Status launch(ServerContext *context,grpc::ServerReaderWriter<idb::LaunchResponse, idb::LaunchRequest> *stream);
@@ -62,6 +99,7 @@ public:
   Status get_setting(ServerContext* context, const idb::GetSettingRequest* request, idb::GetSettingResponse* response);
   Status list_settings(ServerContext* context, const idb::ListSettingRequest* request, idb::ListSettingResponse* response);
   Status terminate(ServerContext *context, const idb::TerminateRequest *request, idb::TerminateResponse *response);
+  Status transfer_stats(ServerContext *context, const idb::TransferStatsRequest *request, idb::TransferStatsResponse *response);
   Status uninstall(ServerContext *context, const idb::UninstallRequest *request, idb::UninstallResponse *response);
   Status video_stream(ServerContext* context, grpc::ServerReaderWriter<idb::VideoStreamResponse, idb::VideoStreamRequest>* stream);
   Status xctest_list_bundles(ServerContext *context, const idb::XctestListBundlesRequest *request, idb::XctestListBundlesResponse *response);
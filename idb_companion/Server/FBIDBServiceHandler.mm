@@ -6,18 +6,25 @@
  */
 
 #import <string>
+#import <vector>
+
+#import <fts.h>
+#import <sys/stat.h>
 
 #import <idbGRPC/idb.grpc.pb.h>
 #import <idbGRPC/idb.pb.h>
 #import <grpcpp/grpcpp.h>
 #import <FBSimulatorControl/FBSimulatorControl.h>
 
+#import "FBApplicationArchiveExtractor.h"
+#import "FBContentAddressedStore.h"
 #import "FBDataDownloadInput.h"
 #import "FBIDBCommandExecutor.h"
 #import "FBIDBPortsConfiguration.h"
 #import "FBIDBServiceHandler.h"
 #import "FBIDBStorageManager.h"
 #import "FBIDBTestOperation.h"
+#import "FBIDBTransferMetrics.h"
 #import "FBIDBXCTestReporter.h"
 #import "FBStorageUtils.h"
 #import "FBTemporaryDirectory.h"
@@ -34,7 +41,54 @@ static NSString *nsstring_from_c_string(const ::std::string& string)
   return [NSString stringWithUTF8String:string.c_str()];
 }
 
-static int BufferOutputSize = 16384; //  # 16Kb
+const size_t LogCoalescingMaximumBytes = 64 * 1024;
+
+const int64_t LogCoalescingInterval = 20 * NSEC_PER_MSEC;
+
+// Files that are pulled individually are sent in chunks of this size.
+static const size_t PullChunkSize = 1024 * 1024;
+
+// The listing of a pull is sent in batches of this many entries, so that it arrives while the walk is in progress.
+static const int PullListingBatchSize = 512;
+
+// Finishes the recording of a call when it goes out of scope, so that every return from a handler is recorded.
+struct FBIDBTransferRecordingScope {
+  FBIDBTransferRecording *recording;
+  ~FBIDBTransferRecordingScope()
+  {
+    [recording finish];
+  }
+};
+
+template <class T>
+static bool recorded_read(grpc::internal::ReaderInterface<T> *reader, T *message, FBIDBTransferRecording *recording)
+{
+  uint64_t start = FBIDBTransferMetrics.now;
+  if (!reader->Read(message)) {
+    return false;
+  }
+  [recording recordReadOfBytes:message->ByteSizeLong() nanoseconds:FBIDBTransferMetrics.now - start];
+  return true;
+}
+
+template <class T>
+static bool recorded_write(grpc::internal::WriterInterface<T> *writer, const T &message, FBIDBTransferRecording *recording)
+{
+  uint64_t start = FBIDBTransferMetrics.now;
+  if (!writer->Write(message)) {
+    return false;
+  }
+  [recording recordWriteOfBytes:message.ByteSizeLong() nanoseconds:FBIDBTransferMetrics.now - start];
+  return true;
+}
+
+static id recorded_block(FBFuture *future, NSError **error, FBIDBTransferRecording *recording)
+{
+  uint64_t start = FBIDBTransferMetrics.now;
+  id result = [future block:error];
+  [recording recordStage:FBIDBTransferStageBlock nanoseconds:FBIDBTransferMetrics.now - start];
+  return result;
+}
 
 template <class T>
 static FBFuture<NSNull *> * resolve_next_read(grpc::internal::ReaderInterface<T> *reader)
@@ -50,62 +104,61 @@ static FBFuture<NSNull *> * resolve_next_read(grpc::internal::ReaderInterface<T>
 }
 
 template <class T>
-static id<FBDataConsumer, FBDataConsumerStackConsuming> drain_consumer(grpc::internal::WriterInterface<T> *writer, FBFuture<NSNull *> *done)
+static id<FBDataConsumer, FBDataConsumerStackConsuming> drain_consumer(grpc::internal::WriterInterface<T> *writer, FBFuture<NSNull *> *done, FBIDBTransferRecording *recording)
 {
   return [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
-    if (done.hasCompleted) {
-      return;
+    // Writes hold the same lock as finish_drain, so none is in flight once done has resolved.
+    @synchronized (done) {
+      if (done.hasCompleted) {
+        return;
+      }
+      T response;
+      idb::Payload *payload = response.mutable_payload();
+      // Append each region, a dispatch_data backed NSData would otherwise be flattened into a contiguous copy first.
+      std::string *payloadData = payload->mutable_data();
+      payloadData->reserve(data.length);
+      [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        payloadData->append(static_cast<const char *>(bytes), byteRange.length);
+      }];
+      recorded_write(writer, response, recording);
     }
-    T response;
-    idb::Payload *payload = response.mutable_payload();
-    payload->set_data(data.bytes, data.length);
-    writer->Write(response);
   }];
 }
 
+static void finish_drain(FBMutableFuture<NSNull *> *done)
+{
+  // Waits for a write of a drain_consumer that is in flight, any later write is dropped.
+  @synchronized (done) {
+    [done resolveWithResult:NSNull.null];
+  }
+}
+
 template <class Write, class Read>
-static id<FBDataConsumer, FBDataConsumerStackConsuming> consumer_from_request(grpc::ServerReaderWriter<Write, Read> *stream, Read& request, FBFuture<NSNull *> *done, NSError **error)
+static id<FBDataConsumer, FBDataConsumerStackConsuming> consumer_from_request(grpc::ServerReaderWriter<Write, Read> *stream, Read& request, FBFuture<NSNull *> *done, FBIDBTransferRecording *recording, NSError **error)
 {
   Read initial;
-  stream->Read(&initial);
+  recorded_read(stream, &initial, recording);
   request = initial;
   const std::string requestedFilePath = initial.start().file_path();
   if (requestedFilePath.length() > 0) {
     return [FBFileWriter syncWriterForFilePath:nsstring_from_c_string(requestedFilePath.c_str()) error:error];
   }
-  return drain_consumer(stream, done);
+  return drain_consumer(stream, done, recording);
 }
 
 template <class T>
-static Status drain_writer(FBFuture<FBTask<NSNull *, NSInputStream *, id> *> *taskFuture, grpc::internal::WriterInterface<T> *stream)
+static Status drain_writer(FBFuture<NSNull *> * (^writeToConsumer)(id<FBDataConsumer> consumer), grpc::internal::WriterInterface<T> *stream, FBIDBTransferRecording *recording)
 {
   NSError *error = nil;
-  FBTask<NSNull *, NSInputStream *, id> *task = [taskFuture block:&error];
-  if (!task) {
+  FBMutableFuture<NSNull *> *done = FBMutableFuture.future;
+  // The archive is written to the stream as it is produced in-process, rather than being read from the stdout of a process.
+  id<FBDataConsumer> consumer = drain_consumer(stream, done, recording);
+  BOOL success = [writeToConsumer(consumer) succeeds:&error];
+  // The stream is not valid once the call has returned.
+  finish_drain(done);
+  if (!success) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
-  NSInputStream *inputStream = task.stdOut;
-  [inputStream open];
-  while (true) {
-    uintptr_t buffer[BufferOutputSize];
-    NSInteger size = [inputStream read:(uint8_t *)buffer maxLength:BufferOutputSize];
-    if (size == 0) {
-      break;
-    }
-    if (size < 0) {
-      return Status::OK;
-    }
-    T response;
-    idb::Payload *payload = response.mutable_payload();
-    payload->set_data(reinterpret_cast<void *>(buffer), size);
-    stream->Write(response);
-  }
-  [inputStream close];
-  NSNumber *exitCode = [task.exitCode block:&error];
-  if (exitCode.integerValue != 0) {
-    NSString *errorString = [NSString stringWithFormat:@"Draining operation failed with exit code %ld", (long)exitCode.integerValue];
-    return Status(grpc::StatusCode::INTERNAL, errorString.UTF8String);
-  }
   return Status::OK;
 }
 
@@ -126,7 +179,7 @@ static Status respond_file_path(NSURL *source, NSString *destination, grpc::inte
 }
 
 template <class T>
-static FBProcessInput<NSOutputStream *> *pipe_to_input(const idb::Payload initial, grpc::ServerReader<T> *reader)
+static FBProcessInput<NSOutputStream *> *pipe_to_input(const idb::Payload initial, grpc::ServerReader<T> *reader, FBIDBTransferRecording *recording)
 {
   const std::string initialData = initial.data();
   FBProcessInput<NSOutputStream *> *input = [FBProcessInput inputFromStream];
@@ -136,7 +189,7 @@ static FBProcessInput<NSOutputStream *> *pipe_to_input(const idb::Payload initia
     T request;
     [stream open];
     [stream write:(const uint8_t *)initialData.c_str() maxLength:initialData.length()];
-    while (reader->Read(&request)) {
+    while (recorded_read(reader, &request, recording)) {
       const auto tarData = request.payload().data();
       [stream write:(const uint8_t *)tarData.c_str() maxLength:tarData.length()];
     }
@@ -145,7 +198,7 @@ static FBProcessInput<NSOutputStream *> *pipe_to_input(const idb::Payload initia
   return input;
 }
 
-static FBProcessInput<NSOutputStream *> *pipe_to_input_output(const idb::Payload initial, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream)
+static FBProcessInput<NSOutputStream *> *pipe_to_input_output(const idb::Payload initial, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream, FBIDBTransferRecording *recording)
 {
   const std::string initialData = initial.data();
   FBProcessInput<NSOutputStream *> *input = [FBProcessInput inputFromStream];
@@ -155,7 +208,7 @@ static FBProcessInput<NSOutputStream *> *pipe_to_input_output(const idb::Payload
     idb::InstallRequest request;
     [appStream open];
     [appStream write:(const uint8_t *)initialData.c_str() maxLength:initialData.length()];
-    while (stream->Read(&request)) {
+    while (recorded_read(stream, &request, recording)) {
       const auto tarData = request.payload().data();
       [appStream write:(const uint8_t *)tarData.c_str() maxLength:tarData.length()];
     }
@@ -214,14 +267,14 @@ static FBFutureContext<NSArray<NSURL *> *> *filepaths_from_tar(FBTemporaryDirect
 }
 
 template<class T>
-static FBFutureContext<NSArray<NSURL *> *> *filepaths_from_reader(FBTemporaryDirectory *temporaryDirectory, grpc::ServerReader<T> *reader, bool extract_from_subdir, id<FBControlCoreLogger> logger)
+static FBFutureContext<NSArray<NSURL *> *> *filepaths_from_reader(FBTemporaryDirectory *temporaryDirectory, grpc::ServerReader<T> *reader, bool extract_from_subdir, FBIDBTransferRecording *recording, id<FBControlCoreLogger> logger)
 {
   T request;
-  reader->Read(&request);
+  recorded_read(reader, &request, recording);
   idb::Payload firstPayload = request.payload();
   switch (firstPayload.source_case()) {
     case idb::Payload::kData: {
-      FBProcessInput<NSOutputStream *> *input = pipe_to_input(firstPayload, reader);
+      FBProcessInput<NSOutputStream *> *input = pipe_to_input(firstPayload, reader, recording);
       return filepaths_from_tar(temporaryDirectory, input, extract_from_subdir, logger);
     }
     case idb::Payload::kFilePath: {
@@ -340,7 +393,7 @@ static void fill_crash_log_response(idb::CrashLogResponse *response, const NSArr
   }
 }
 
-static FBSimulatorHIDEvent *translate_event(idb::HIDEvent &event, NSError **error)
+static FBSimulatorHIDEvent *translate_event(const idb::HIDEvent &event, NSError **error)
 {
   if (event.has_press()) {
     idb::HIDEvent_HIDDirection direction = event.press().direction();
@@ -475,13 +528,266 @@ static FBCompressionFormat read_compression_format(const idb::Payload payload)
   }
 }
 
+static NSArray<FBBundleManifestFile *> *translate_manifest(const idb::InstallRequest_Manifest &manifest)
+{
+  NSMutableArray<FBBundleManifestFile *> *files = [NSMutableArray arrayWithCapacity:(NSUInteger) manifest.files_size()];
+  for (const idb::InstallRequest_ManifestFile &file : manifest.files()) {
+    NSMutableArray<NSString *> *chunks = [NSMutableArray arrayWithCapacity:(NSUInteger) file.chunks_size()];
+    for (const std::string &chunk : file.chunks()) {
+      [chunks addObject:nsstring_from_c_string(chunk)];
+    }
+    [files addObject:[[FBBundleManifestFile alloc]
+      initWithPath:nsstring_from_c_string(file.path())
+      mode:(mode_t) file.mode()
+      digest:(file.digest().length() ? nsstring_from_c_string(file.digest()) : nil)
+      chunks:chunks
+      symlinkTarget:(file.symlink_target().length() ? nsstring_from_c_string(file.symlink_target()) : nil)
+      directory:file.directory()]];
+  }
+  return files;
+}
+
+static bool pull_relative_path_is_valid(NSString *path)
+{
+  if (path.length == 0 || path.isAbsolutePath) {
+    return false;
+  }
+  return ![path.pathComponents containsObject:@".."];
+}
+
+static Status stream_pull_file(NSString *hostPath, const std::string &path, uint64_t offset, ServerContext *context, grpc::ServerWriter<idb::PullResponse> *stream, FBIDBTransferRecording *recording)
+{
+  int fd = open(hostPath.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return Status(grpc::StatusCode::INTERNAL, [NSString stringWithFormat:@"Failed to open %@: %s", hostPath, strerror(errno)].UTF8String);
+  }
+  idb::PullResponse response;
+  idb::PullResponse_Chunk *chunk = response.mutable_chunk();
+  chunk->set_path(path);
+  std::string *data = chunk->mutable_data();
+  uint64_t position = offset;
+  while (true) {
+    if (context->IsCancelled()) {
+      close(fd);
+      return Status(grpc::StatusCode::CANCELLED, "The pull was cancelled");
+    }
+    // The file is read directly into the response, there is no intermediate buffer.
+    data->resize(PullChunkSize);
+    ssize_t length = pread(fd, &(*data)[0], PullChunkSize, (off_t) position);
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length < 0) {
+      NSString *message = [NSString stringWithFormat:@"Failed to read %@: %s", hostPath, strerror(errno)];
+      close(fd);
+      return Status(grpc::StatusCode::INTERNAL, message.UTF8String);
+    }
+    if (length == 0) {
+      break;
+    }
+    data->resize((size_t) length);
+    chunk->set_offset(position);
+    if (!recorded_write(stream, response, recording)) {
+      close(fd);
+      return Status(grpc::StatusCode::CANCELLED, "The client went away during the pull");
+    }
+    position += (uint64_t) length;
+  }
+  close(fd);
+  return Status::OK;
+}
+
+static void fill_pull_entry(idb::PullResponse_Entry *entry, const std::string &path, const char *hostPath, const struct stat *stat)
+{
+  entry->set_path(path);
+  entry->set_mode(stat->st_mode & 07777);
+  entry->set_modification_time((double) stat->st_mtimespec.tv_sec + (double) stat->st_mtimespec.tv_nsec / NSEC_PER_SEC);
+  if (S_ISDIR(stat->st_mode)) {
+    entry->set_directory(true);
+  } else if (S_ISLNK(stat->st_mode)) {
+    char target[PATH_MAX];
+    ssize_t length = readlink(hostPath, target, sizeof(target) - 1);
+    if (length >= 0) {
+      entry->set_symlink_target(std::string(target, (size_t) length));
+    }
+  } else {
+    entry->set_size((uint64_t) stat->st_size);
+  }
+}
+
+static int compare_pull_entries(const FTSENT **left, const FTSENT **right)
+{
+  return strcmp((*left)->fts_name, (*right)->fts_name);
+}
+
+static Status stream_pull_files(NSString *root, const idb::PullRequest *request, ServerContext *context, grpc::ServerWriter<idb::PullResponse> *stream, FBIDBTransferRecording *recording)
+{
+  struct stat rootStat;
+  if (lstat(root.fileSystemRepresentation, &rootStat) != 0) {
+    return Status(grpc::StatusCode::NOT_FOUND, [NSString stringWithFormat:@"Source path does not exist: %@", root].UTF8String);
+  }
+  BOOL rootIsDirectory = S_ISDIR(rootStat.st_mode);
+
+  // A resumed pull names the files that are outstanding. The listing has already been received.
+  if (request->ranges_size() > 0) {
+    for (const idb::PullRequest_Range &range : request->ranges()) {
+      NSString *path = nsstring_from_c_string(range.path());
+      if (!pull_relative_path_is_valid(path)) {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, [NSString stringWithFormat:@"%@ is not a path within %@", path, root].UTF8String);
+      }
+      NSString *hostPath = rootIsDirectory ? [root stringByAppendingPathComponent:path] : root;
+      Status status = stream_pull_file(hostPath, range.path(), range.offset(), context, stream, recording);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status::OK;
+  }
+
+  uint32_t streamCount = MAX(request->stream_count(), 1u);
+  uint32_t streamIndex = request->stream_index();
+  if (streamIndex >= streamCount) {
+    return Status(grpc::StatusCode::INVALID_ARGUMENT, "stream_index must be less than stream_count");
+  }
+  // Every stream walks the same tree, so each can work out its share of the files without coordinating with the others.
+  bool sendListing = streamIndex == 0;
+  std::vector<std::pair<std::string, std::string>> files;
+  idb::PullResponse listing;
+  uint64_t fileIndex = 0;
+  if (!rootIsDirectory) {
+    std::string path = root.lastPathComponent.UTF8String;
+    fill_pull_entry(listing.mutable_listing()->add_entries(), path, root.fileSystemRepresentation, &rootStat);
+    if (S_ISREG(rootStat.st_mode) && streamIndex == 0) {
+      files.push_back({path, root.fileSystemRepresentation});
+    }
+  } else {
+    char *paths[] = {(char *) root.fileSystemRepresentation, NULL};
+    FTS *fts = fts_open(paths, FTS_PHYSICAL | FTS_NOCHDIR, compare_pull_entries);
+    if (!fts) {
+      return Status(grpc::StatusCode::INTERNAL, [NSString stringWithFormat:@"Failed to walk %@: %s", root, strerror(errno)].UTF8String);
+    }
+    size_t rootLength = strlen(paths[0]);
+    FTSENT *entry = NULL;
+    while ((entry = fts_read(fts)) != NULL) {
+      if (entry->fts_level == FTS_ROOTLEVEL || entry->fts_info == FTS_DP) {
+        continue;
+      }
+      if (entry->fts_info == FTS_DNR || entry->fts_info == FTS_ERR || entry->fts_info == FTS_NS) {
+        NSString *message = [NSString stringWithFormat:@"Failed to read %s: %s", entry->fts_path, strerror(entry->fts_errno)];
+        fts_close(fts);
+        return Status(grpc::StatusCode::INTERNAL, message.UTF8String);
+      }
+      mode_t mode = entry->fts_statp->st_mode;
+      if (!S_ISDIR(mode) && !S_ISREG(mode) && !S_ISLNK(mode)) {
+        continue;
+      }
+      std::string path = std::string(entry->fts_path + rootLength + 1);
+      if (S_ISREG(mode) && fileIndex++ % streamCount == streamIndex) {
+        files.push_back({path, entry->fts_path});
+      }
+      if (!sendListing) {
+        continue;
+      }
+      fill_pull_entry(listing.mutable_listing()->add_entries(), path, entry->fts_path, entry->fts_statp);
+      if (listing.listing().entries_size() >= PullListingBatchSize) {
+        if (!recorded_write(stream, listing, recording)) {
+          fts_close(fts);
+          return Status(grpc::StatusCode::CANCELLED, "The client went away during the pull");
+        }
+        listing.clear_listing();
+      }
+    }
+    fts_close(fts);
+  }
+  // The listing is always sent on the first stream, even when empty, so the client can tell that the files are being streamed.
+  if (sendListing) {
+    listing.mutable_listing();
+    if (!recorded_write(stream, listing, recording)) {
+      return Status(grpc::StatusCode::CANCELLED, "The client went away during the pull");
+    }
+  }
+  for (const auto &file : files) {
+    Status status = stream_pull_file(nsstring_from_c_string(file.second), file.first, 0, context, stream, recording);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return Status::OK;
+}
+
+static void fill_histogram(idb::TransferStatsResponse_Histogram *histogram, FBIDBHistogram *source)
+{
+  for (NSNumber *count in source.bucketCounts) {
+    histogram->add_bucket_counts(count.unsignedLongLongValue);
+  }
+  histogram->set_count(source.count);
+  histogram->set_sum(source.sum);
+  histogram->set_maximum(source.maximum);
+}
+
+#pragma mark Shared Functions
+
+FBVideoStreamConfiguration *video_stream_configuration(const idb::VideoStreamRequest_Start &start, NSError **error)
+{
+  NSNumber *framesPerSecond = start.fps() > 0 ? @(start.fps()) : nil;
+  FBVideoStreamEncoding encoding = @"";
+  switch (start.format()) {
+    case idb::VideoStreamRequest_Format_RBGA:
+      encoding = FBVideoStreamEncodingBGRA;
+      break;
+    case idb::VideoStreamRequest_Format_H264:
+      encoding = FBVideoStreamEncodingH264;
+      break;
+    case idb::VideoStreamRequest_Format_MJPEG:
+      encoding = FBVideoStreamEncodingMJPEG;
+      break;
+    case idb::VideoStreamRequest_Format_MINICAP:
+      encoding = FBVideoStreamEncodingMinicap;
+      break;
+    case idb::VideoStreamRequest_Format_RBGA_TILES:
+      encoding = FBVideoStreamEncodingBGRATiles;
+      break;
+    case idb::VideoStreamRequest_Format_MJPEG_TILES:
+      encoding = FBVideoStreamEncodingMJPEGTiles;
+      break;
+    default:
+      if (error) {
+        *error = [FBControlCoreError errorForDescription:@"Invalid Video format provided"];
+      }
+      return nil;
+  }
+  NSNumber *compressionQuality = @(start.compression_quality());
+  NSNumber *scaleFactor = @(start.scale_factor());
+  return [[FBVideoStreamConfiguration alloc] initWithEncoding:encoding framesPerSecond:framesPerSecond compressionQuality:compressionQuality scaleFactor:scaleFactor];
+}
+
+id<FBDataConsumer, FBDataConsumerStackConsuming> video_stream_bounded_consumer(id<FBDataConsumer> consumer, FBVideoStreamConfiguration *configuration, NSUInteger maximumQueuedFrames)
+{
+  FBVideoStreamEncoding encoding = configuration.encoding;
+  FBFrameDropPolicy dropPolicy = [FBBoundedFrameDataConsumer dropPolicyForEncoding:encoding];
+  return [FBBoundedFrameDataConsumer consumerWithConsumer:consumer encoding:encoding maximumQueuedFrames:maximumQueuedFrames dropPolicy:dropPolicy];
+}
+
+// The compression format defaults to gzip when the client does not send one, but clients also send zipped .ipa files this way.
+// Only a gzipped or uncompressed tar can be extracted as it arrives, so the first bytes of the archive are checked for either.
+static BOOL is_streamable_app_archive(const std::string &data)
+{
+  static const size_t TarMagicOffset = 257;
+  if (data.length() >= 2 && (uint8_t) data[0] == 0x1f && (uint8_t) data[1] == 0x8b) {
+    return YES;
+  }
+  return data.length() >= TarMagicOffset + 5 && data.compare(TarMagicOffset, 5, "ustar") == 0;
+}
+
 #pragma mark Constructors
 
-FBIDBServiceHandler::FBIDBServiceHandler(FBIDBCommandExecutor *commandExecutor, id<FBiOSTarget> target, id<FBEventReporter> eventReporter)
+FBIDBServiceHandler::FBIDBServiceHandler(FBIDBCommandExecutor *commandExecutor, id<FBiOSTarget> target, id<FBEventReporter> eventReporter, FBIDBTransferMetrics *transferMetrics, FBIDBPortsConfiguration *portsConfig)
 {
   _commandExecutor = commandExecutor;
   _target = target;
   _eventReporter = eventReporter;
+  _transferMetrics = transferMetrics;
+  _portsConfig = portsConfig;
 }
 
 FBIDBServiceHandler::FBIDBServiceHandler(const FBIDBServiceHandler &c)
@@ -489,31 +795,49 @@ FBIDBServiceHandler::FBIDBServiceHandler(const FBIDBServiceHandler &c)
   _commandExecutor = c._commandExecutor;
   _target = c._target;
   _eventReporter = c._eventReporter;
+  _transferMetrics = c._transferMetrics;
+  _portsConfig = c._portsConfig;
+}
+
+FBIDBTransferMetrics *FBIDBServiceHandler::transfer_metrics()
+{
+  return _transferMetrics;
+}
+
+FBIDBPortsConfiguration *FBIDBServiceHandler::ports_config()
+{
+  return _portsConfig;
 }
 
 #pragma mark Handled Methods
 
-FBFuture<FBInstalledArtifact *> *FBIDBServiceHandler::install_future(const idb::InstallRequest_Destination destination, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream)
+FBFuture<FBInstalledArtifact *> *FBIDBServiceHandler::install_future(const idb::InstallRequest_Destination destination, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream, FBIDBTransferRecording *recording)
 {@autoreleasepool{
   idb::InstallRequest request;
-  stream->Read(&request);
+  recorded_read(stream, &request, recording);
   idb::Payload payload;
   NSString *name = NSUUID.UUID.UUIDString;
   if (request.name_hint().length()) {
     name = nsstring_from_c_string(request.name_hint());
-    stream->Read(&request);
+    recorded_read(stream, &request, recording);
   }
   payload = request.payload();
   FBCompressionFormat compression = FBCompressionFormatGZIP;
   if (payload.source_case() == idb::Payload::kCompression) {
     compression = read_compression_format(payload);
-    stream->Read(&request);
+    recorded_read(stream, &request, recording);
     payload = request.payload();
   }
-  
+  if (request.value_case() == idb::InstallRequest::kManifest) {
+    return install_manifest_future(destination, request.manifest(), stream, recording);
+  }
+
   switch (payload.source_case()) {
     case idb::Payload::kData: {
-      FBProcessInput<NSOutputStream *> *dataStream = pipe_to_input_output(payload, stream);
+      if (destination == idb::InstallRequest_Destination::InstallRequest_Destination_APP && compression == FBCompressionFormatGZIP && is_streamable_app_archive(payload.data())) {
+        return install_app_archive_future(payload, stream, recording);
+      }
+      FBProcessInput<NSOutputStream *> *dataStream = pipe_to_input_output(payload, stream, recording);
       switch (destination) {
         case idb::InstallRequest_Destination::InstallRequest_Destination_APP:
           return [_commandExecutor install_app_stream:dataStream compression:compression];
@@ -569,6 +893,66 @@ FBFuture<FBInstalledArtifact *> *FBIDBServiceHandler::install_future(const idb::
   }
 }}
 
+FBFuture<FBInstalledArtifact *> *FBIDBServiceHandler::install_app_archive_future(const idb::Payload &initial, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream, FBIDBTransferRecording *recording)
+{@autoreleasepool{
+  NSError *error = nil;
+  FBApplicationArchiveExtractor *extractor = [FBApplicationArchiveExtractor extractorWithStorage:_commandExecutor.storageManager.application queue:_target.asyncQueue logger:_target.logger error:&error];
+  if (!extractor) {
+    return [FBFuture futureWithError:error];
+  }
+  // The archive is extracted as it is read, so that an App that can't be installed fails without reading the remainder of the archive.
+  const std::string &initialData = initial.data();
+  uint64_t start = FBIDBTransferMetrics.now;
+  [extractor consumeData:[NSData dataWithBytes:initialData.data() length:initialData.length()]];
+  [recording recordStage:FBIDBTransferStageExtract nanoseconds:FBIDBTransferMetrics.now - start];
+  idb::InstallRequest request;
+  while (!extractor.finishedConsuming.hasCompleted && recorded_read(stream, &request, recording)) {
+    const std::string &data = request.payload().data();
+    start = FBIDBTransferMetrics.now;
+    [extractor consumeData:[NSData dataWithBytes:data.data() length:data.length()]];
+    [recording recordStage:FBIDBTransferStageExtract nanoseconds:FBIDBTransferMetrics.now - start];
+  }
+  start = FBIDBTransferMetrics.now;
+  [extractor consumeEndOfFile];
+  [recording recordStage:FBIDBTransferStageExtract nanoseconds:FBIDBTransferMetrics.now - start];
+  return [_commandExecutor install_app_archive:extractor];
+}}
+
+FBFuture<FBInstalledArtifact *> *FBIDBServiceHandler::install_manifest_future(const idb::InstallRequest_Destination destination, const idb::InstallRequest_Manifest &manifest, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream, FBIDBTransferRecording *recording)
+{@autoreleasepool{
+  if (destination != idb::InstallRequest_Destination::InstallRequest_Destination_APP) {
+    return [FBFuture futureWithError:[FBControlCoreError errorForDescription:@"Installing from a manifest is only supported for Apps"]];
+  }
+  NSArray<FBBundleManifestFile *> *files = translate_manifest(manifest);
+  FBContentAddressedStore *store = _commandExecutor.storageManager.contentStore;
+
+  // Reply with the chunks that the store does not have, the client then sends only these.
+  idb::InstallResponse response;
+  for (NSString *chunk in [store missingChunksForManifest:files]) {
+    response.add_missing_chunks(chunk.UTF8String);
+  }
+  recorded_write(stream, response, recording);
+
+  idb::InstallRequest request;
+  NSUInteger received = 0;
+  unsigned long long receivedBytes = 0;
+  while (recorded_read(stream, &request, recording)) {
+    if (request.value_case() != idb::InstallRequest::kChunk) {
+      return [FBFuture futureWithError:[FBControlCoreError errorForFormat:@"Expected a chunk of the manifest, but got request %d", request.value_case()]];
+    }
+    const idb::InstallRequest_Chunk &chunk = request.chunk();
+    NSData *data = [NSData dataWithBytes:chunk.data().data() length:chunk.data().length()];
+    NSError *error = nil;
+    if (![store storeChunk:data digest:nsstring_from_c_string(chunk.digest()) error:&error]) {
+      return [FBFuture futureWithError:error];
+    }
+    received += 1;
+    receivedBytes += data.length;
+  }
+  [_target.logger logFormat:@"Received %lu chunks (%llu bytes) of a manifest of %lu files", (unsigned long) received, receivedBytes, (unsigned long) files.count];
+  return [_commandExecutor install_app_manifest:files];
+}}
+
 Status FBIDBServiceHandler::list_apps(ServerContext *context, const idb::ListAppsRequest *request, idb::ListAppsResponse *response)
 {@autoreleasepool{
   NSError *error = nil;
@@ -610,19 +994,20 @@ Status FBIDBServiceHandler::open_url(ServerContext *context, const idb::OpenUrlR
 
 Status FBIDBServiceHandler::install(ServerContext *context, grpc::ServerReaderWriter<idb::InstallResponse, idb::InstallRequest> *stream)
 {@autoreleasepool{
+  FBIDBTransferRecordingScope scope = {[_transferMetrics recordingForCall:@"install"]};
   idb::InstallRequest request;
-  stream->Read(&request);
+  recorded_read(stream, &request, scope.recording);
   idb::InstallRequest_Destination destination = request.destination();
 
   NSError *error = nil;
-  FBInstalledArtifact *artifact = [install_future(destination, stream) block:&error];
+  FBInstalledArtifact *artifact = recorded_block(install_future(destination, stream, scope.recording), &error, scope.recording);
   if (!artifact) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String ?: "An internal error occured when installing");
   }
   idb::InstallResponse response;
   response.set_name(artifact.name.UTF8String);
   response.set_uuid(artifact.uuid.UUIDString.UTF8String ?: "");
-  stream->Write(response);
+  recorded_write(stream, response, scope.recording);
   return Status::OK;
 }}
 
@@ -805,6 +1190,26 @@ Status FBIDBServiceHandler::terminate(ServerContext *context, const idb::Termina
   return Status::OK;
 }}
 
+Status FBIDBServiceHandler::transfer_stats(ServerContext *context, const idb::TransferStatsRequest *request, idb::TransferStatsResponse *response)
+{@autoreleasepool{
+  for (FBIDBCallMetrics *metrics in _transferMetrics.snapshot) {
+    idb::TransferStatsResponse_Call *call = response->add_calls();
+    call->set_name(metrics.name.UTF8String);
+    call->set_calls(metrics.calls);
+    call->set_bytes_in(metrics.bytesIn);
+    call->set_chunks_in(metrics.chunksIn);
+    call->set_bytes_out(metrics.bytesOut);
+    call->set_chunks_out(metrics.chunksOut);
+    NSDictionary<FBIDBTransferStage, FBIDBHistogram *> *stages = metrics.stageMicroseconds;
+    for (FBIDBTransferStage stage in stages) {
+      fill_histogram(&(*call->mutable_stage_micros())[stage.UTF8String], stages[stage]);
+    }
+    fill_histogram(call->mutable_duration_micros(), metrics.durationMicroseconds);
+    fill_histogram(call->mutable_throughput_bytes_per_second(), metrics.throughputBytesPerSecond);
+  }
+  return Status::OK;
+}}
+
 Status FBIDBServiceHandler::hid(grpc::ServerContext *context, grpc::ServerReader<idb::HIDEvent> *reader, idb::HIDResponse *response)
 {@autoreleasepool{
   NSError *error = nil;
@@ -822,6 +1227,31 @@ Status FBIDBServiceHandler::hid(grpc::ServerContext *context, grpc::ServerReader
   return Status::OK;
 }}
 
+Status FBIDBServiceHandler::hid_batch(ServerContext *context, const idb::HIDBatchRequest *request, idb::HIDBatchResponse *response)
+{@autoreleasepool{
+  NSError *error = nil;
+  // The whole script is translated upfront, so that it can be scheduled as a single event.
+  NSMutableArray<FBSimulatorHIDEvent *> *events = [NSMutableArray arrayWithCapacity:(NSUInteger) request->events_size()];
+  for (const idb::HIDEvent &grpcEvent : request->events()) {
+    FBSimulatorHIDEvent *event = translate_event(grpcEvent, &error);
+    if (!event) {
+      return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
+    }
+    [events addObject:event];
+  }
+  FBSimulatorHIDScheduleReport *report = [[_commandExecutor hid_schedule:[FBSimulatorHIDEvent eventWithEvents:events]] block:&error];
+  if (!report) {
+    return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
+  }
+  [_target.logger logFormat:@"HID batch %@", report];
+  response->set_message_count(report.messageCount);
+  response->set_scheduled_duration(report.scheduledDuration);
+  response->set_actual_duration(report.actualDuration);
+  response->set_mean_jitter(report.meanJitter);
+  response->set_max_jitter(report.maximumJitter);
+  return Status::OK;
+}}
+
 Status FBIDBServiceHandler::set_location(ServerContext *context, const idb::SetLocationRequest *request, idb::SetLocationResponse *response)
 {@autoreleasepool{
   NSError *error = nil;
@@ -1043,6 +1473,7 @@ Status FBIDBServiceHandler::xctest_run(ServerContext *context, const idb::Xctest
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
   reporter.configuration = operation.reporterConfiguration;
+  reporter.streamArtifacts = request->stream_artifacts();
 
   // First wait for the test operation to finish
   [operation.completed block:&error];
@@ -1054,16 +1485,46 @@ Status FBIDBServiceHandler::xctest_run(ServerContext *context, const idb::Xctest
 Status FBIDBServiceHandler::log(ServerContext *context, const idb::LogRequest *request, grpc::ServerWriter<idb::LogResponse> *response)
 {@autoreleasepool{
   NSArray<NSString *> *arguments = extract_string_array(request->arguments());
-  FBFuture<NSNull *> *clientClosed = [FBFuture onQueue:_target.asyncQueue resolveWhen:^ BOOL {
+  dispatch_queue_t queue = _target.asyncQueue;
+  // A synchronous call isn't notified of cancellation, so this has to poll. A log stream lives for a long time, so the polling backs off.
+  FBFuture<NSNull *> *clientClosed = [FBFuture onQueue:queue resolveWhen:^ BOOL {
     return context->IsCancelled();
-  }];
-  id<FBDataConsumer, FBDataConsumerLifecycle> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
-    if (clientClosed.hasCompleted) {
+  } backoffFrom:0.1 to:1];
+  // Output is coalesced in the same way as the asynchronous call, the writer is only used with the lock held and not after returning.
+  NSObject *writeLock = [NSObject new];
+  NSMutableData *pending = NSMutableData.data;
+  __block BOOL flushScheduled = NO;
+  __block BOOL finished = NO;
+  void (^flushLocked)(void) = ^{
+    flushScheduled = NO;
+    if (finished || pending.length == 0) {
       return;
     }
     idb::LogResponse item;
-    item.set_output(data.bytes, data.length);
+    item.set_output(pending.bytes, pending.length);
+    pending.length = 0;
     response->Write(item);
+  };
+  id<FBDataConsumer, FBDataConsumerLifecycle> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+    if (clientClosed.hasCompleted) {
+      return;
+    }
+    @synchronized (writeLock) {
+      [pending appendData:data];
+      if (pending.length >= LogCoalescingMaximumBytes) {
+        flushLocked();
+        return;
+      }
+      if (flushScheduled) {
+        return;
+      }
+      flushScheduled = YES;
+    }
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, LogCoalescingInterval), queue, ^{
+      @synchronized (writeLock) {
+        flushLocked();
+      }
+    });
   }];
   NSError *error = nil;
   BOOL logFromCompanion = request->source() == idb::LogRequest::Source::LogRequest_Source_COMPANION;
@@ -1073,6 +1534,12 @@ Status FBIDBServiceHandler::log(ServerContext *context, const idb::LogRequest *r
   }
   FBFuture<NSNull *> *completed = [FBFuture race:@[clientClosed, operation.completed]];
   [completed block:nil];
+  @synchronized (writeLock) {
+    if (!clientClosed.hasCompleted) {
+      flushLocked();
+    }
+    finished = YES;
+  }
   return Status::OK;
 }}
 
@@ -1095,7 +1562,11 @@ Status FBIDBServiceHandler::record(grpc::ServerContext *context, grpc::ServerRea
   if (requestedFilePath.length() > 0) {
     return respond_file_path(nil, filePath, stream);
   } else {
-    return drain_writer([FBArchiveOperations createGzipForPath:filePath queue:dispatch_queue_create("com.facebook.idb.record", DISPATCH_QUEUE_SERIAL) logger:_target.logger], stream);
+    dispatch_queue_t queue = dispatch_queue_create("com.facebook.idb.record", DISPATCH_QUEUE_SERIAL);
+    id<FBControlCoreLogger> logger = _target.logger;
+    return drain_writer(^(id<FBDataConsumer> consumer) {
+      return [FBArchiveOperations writeGzipForPath:filePath toConsumer:consumer queue:queue logger:logger];
+    }, stream, nil);
   }
 }}
 
@@ -1104,32 +1575,18 @@ Status FBIDBServiceHandler::video_stream(ServerContext* context, grpc::ServerRea
   NSError *error = nil;
   idb::VideoStreamRequest request;
   FBMutableFuture<NSNull *> *done = FBMutableFuture.future;
-  id<FBDataConsumer, FBDataConsumerStackConsuming> consumer = consumer_from_request(stream, request, done, &error);
+  FBIDBTransferRecordingScope scope = {[_transferMetrics recordingForCall:@"video_stream"]};
+  id<FBDataConsumer, FBDataConsumerStackConsuming> consumer = consumer_from_request(stream, request, done, scope.recording, &error);
   if (!consumer) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
-  idb::VideoStreamRequest_Start start = request.start();
-  NSNumber *framesPerSecond = start.fps() > 0 ? @(start.fps()) : nil;
-  FBVideoStreamEncoding encoding = @"";
-  switch (start.format()) {
-    case idb::VideoStreamRequest_Format_RBGA:
-      encoding = FBVideoStreamEncodingBGRA;
-      break;
-    case idb::VideoStreamRequest_Format_H264:
-      encoding = FBVideoStreamEncodingH264;
-      break;
-    case idb::VideoStreamRequest_Format_MJPEG:
-      encoding = FBVideoStreamEncodingMJPEG;
-      break;
-    case idb::VideoStreamRequest_Format_MINICAP:
-      encoding = FBVideoStreamEncodingMinicap;
-      break;
-    default:
-      return Status(grpc::StatusCode::INTERNAL, "Invalid Video format provided");
+  FBVideoStreamConfiguration *configuration = video_stream_configuration(request.start(), &error);
+  if (!configuration) {
+    return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
+  }
+  if (request.start().file_path().length() == 0) {
+    consumer = video_stream_bounded_consumer(consumer, configuration, _portsConfig.videoStreamMaximumQueuedFrames);
   }
-  NSNumber *compressionQuality = @(start.compression_quality());
-  NSNumber *scaleFactor = @(start.scale_factor());
-  FBVideoStreamConfiguration *configuration = [[FBVideoStreamConfiguration alloc] initWithEncoding:encoding framesPerSecond:framesPerSecond compressionQuality:compressionQuality scaleFactor:scaleFactor];
   id<FBVideoStream> videoStream = [[_target createStreamWithConfiguration:configuration] block:&error];
   if (!stream) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
@@ -1145,8 +1602,12 @@ Status FBIDBServiceHandler::video_stream(ServerContext* context, grpc::ServerRea
 
   // Stop the streaming for real. It may have stopped already in which case this returns instantly.
   success = [[videoStream stopStreaming] block:&error] != nil;
+  // Frames that are still queued are written before returning, as the stream is not valid afterwards.
+  if (success && [consumer isKindOfClass:FBBoundedFrameDataConsumer.class]) {
+    [((FBBoundedFrameDataConsumer *) consumer).finishedConsuming block:nil];
+  }
   // Signal that we're done so we don't write to a dangling pointer.
-  [done resolveWithResult:NSNull.null];
+  finish_drain(done);
   if (success == NO) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
@@ -1156,16 +1617,18 @@ Status FBIDBServiceHandler::video_stream(ServerContext* context, grpc::ServerRea
 Status FBIDBServiceHandler::push(grpc::ServerContext *context, grpc::ServerReader<idb::PushRequest> *reader, idb::PushResponse *response)
 {@autoreleasepool{
   NSError *error = nil;
+  FBIDBTransferRecordingScope scope = {[_transferMetrics recordingForCall:@"push"]};
   idb::PushRequest request;
-  reader->Read(&request);
+  recorded_read(reader, &request, scope.recording);
   if (request.value_case() != idb::PushRequest::kInner) {
     return Status(grpc::StatusCode::INTERNAL, "First message must contain the commands information");
   }
   const idb::PushRequest_Inner inner = request.inner();
 
-  [[filepaths_from_reader(_commandExecutor.temporaryDirectory, reader, false, _target.logger) onQueue:_target.asyncQueue pop:^FBFuture<NSNull *> *(NSArray<NSURL *> *files) {
+  FBFuture<NSNull *> *pushed = [filepaths_from_reader(_commandExecutor.temporaryDirectory, reader, false, scope.recording, _target.logger) onQueue:_target.asyncQueue pop:^FBFuture<NSNull *> *(NSArray<NSURL *> *files) {
     return [_commandExecutor push_files:files to_path:nsstring_from_c_string(inner.dst_path()) containerType:file_container(inner.container())];
-  }] block:&error];
+  }];
+  recorded_block(pushed, &error, scope.recording);
   if (error) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
@@ -1176,6 +1639,14 @@ Status FBIDBServiceHandler::pull(ServerContext *context, const ::idb::PullReques
 {@autoreleasepool{
   NSString *path = nsstring_from_c_string(request->src_path());
   NSError *error = nil;
+  FBIDBTransferRecordingScope scope = {[_transferMetrics recordingForCall:@"pull"]};
+  if (request->dst_path().length() == 0 && request->stream_files()) {
+    NSString *hostPath = [[_commandExecutor pull_file_host_path:path containerType:file_container(request->container())] block:nil];
+    if (hostPath) {
+      return stream_pull_files(hostPath, request, context, stream, scope.recording);
+    }
+    // Containers that are not on the host's filesystem are sent as a tarball, which the client accepts in place of a listing.
+  }
   if (request->dst_path().length() > 0) {
     NSString *filePath = [[_commandExecutor pull_file_path:path destination_path:nsstring_from_c_string(request->dst_path()) containerType:file_container(request->container()) ] block:&error];
     if (error) {
@@ -1185,15 +1656,15 @@ Status FBIDBServiceHandler::pull(ServerContext *context, const ::idb::PullReques
   } else {
     NSURL *url = [_commandExecutor.temporaryDirectory temporaryDirectory];
     NSString *tempPath = [url.path stringByAppendingPathComponent:path.lastPathComponent];
-    NSString *filePath = [[_commandExecutor pull_file_path:path destination_path:tempPath containerType:file_container(request->container())] block:&error];
+    NSString *filePath = recorded_block([_commandExecutor pull_file_path:path destination_path:tempPath containerType:file_container(request->container())], &error, scope.recording);
     if (error) {
       return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
     }
-    return drain_writer([FBArchiveOperations
-                         createGzippedTarForPath:filePath
-                         queue:dispatch_queue_create("com.facebook.idb.pull", DISPATCH_QUEUE_SERIAL)
-                         logger:_target.logger],
-                        stream);
+    dispatch_queue_t queue = dispatch_queue_create("com.facebook.idb.pull", DISPATCH_QUEUE_SERIAL);
+    id<FBControlCoreLogger> logger = _target.logger;
+    return drain_writer(^(id<FBDataConsumer> consumer) {
+      return [FBArchiveOperations writeGzippedTarForPath:filePath toConsumer:consumer queue:queue logger:logger];
+    }, stream, scope.recording);
   }
 }}
 
@@ -1249,11 +1720,12 @@ Status FBIDBServiceHandler::describe(ServerContext *context, const idb::TargetDe
 Status FBIDBServiceHandler::add_media(grpc::ServerContext *context, grpc::ServerReader<idb::AddMediaRequest> *reader, idb::AddMediaResponse *response)
 {@autoreleasepool{
   NSError *error = nil;
-  [[filepaths_from_reader(_commandExecutor.temporaryDirectory, reader, true, _target.logger)
+  FBIDBTransferRecordingScope scope = {[_transferMetrics recordingForCall:@"add_media"]};
+  FBFuture<NSNull *> *added = [filepaths_from_reader(_commandExecutor.temporaryDirectory, reader, true, scope.recording, _target.logger)
     onQueue:_target.asyncQueue pop:^(NSArray<NSURL *> *files) {
       return [_commandExecutor add_media:files];
-    }]
-    block:&error];
+    }];
+  recorded_block(added, &error, scope.recording);
   if (error) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
@@ -1325,7 +1797,10 @@ Status FBIDBServiceHandler::instruments_run(grpc::ServerContext *context, grpc::
   if (!processed) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
-  return drain_writer([FBArchiveOperations createGzippedTarForPath:processed.path queue:queue logger:_target.logger], stream);
+  id<FBControlCoreLogger> targetLogger = _target.logger;
+  return drain_writer(^(id<FBDataConsumer> consumer) {
+    return [FBArchiveOperations writeGzippedTarForPath:processed.path toConsumer:consumer queue:queue logger:targetLogger];
+  }, stream, nil);
 }}
 
 Status FBIDBServiceHandler::debugserver(grpc::ServerContext *context, grpc::ServerReaderWriter<idb::DebugServerResponse, idb::DebugServerRequest> *stream)
@@ -1447,5 +1922,8 @@ Status FBIDBServiceHandler::xctrace_record(ServerContext *context,grpc::ServerRe
   if (!processed) {
     return Status(grpc::StatusCode::INTERNAL, error.localizedDescription.UTF8String);
   }
-  return drain_writer([FBArchiveOperations createGzippedTarForPath:processed.path queue:queue logger:_target.logger], stream);
+  id<FBControlCoreLogger> targetLogger = _target.logger;
+  return drain_writer(^(id<FBDataConsumer> consumer) {
+    return [FBArchiveOperations writeGzippedTarForPath:processed.path toConsumer:consumer queue:queue logger:targetLogger];
+  }, stream, nil);
 }}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FBBundleStorage;
+
+/**
+ A consumer that extracts an archive of an Application as it arrives, validating the Application from its first entries.
+ The archive is extracted into an incoming directory of the storage, so that the Application can be persisted without a copy.
+ The Info.plist and the main executable of the Application are inspected as soon as each has been extracted.
+ An Application that can't run on the target fails `finishedConsuming` at that point, rather than after the whole archive has been received.
+ */
+@interface FBApplicationArchiveExtractor : NSObject <FBDataConsumer, FBDataConsumerLifecycle>
+
+#pragma mark Initializers
+
+/**
+ Constructs an Application Archive Extractor.
+
+ @param storage the storage that the Application will be persisted to, which is used to check its architectures.
+ @param queue the queue to resolve futures on.
+ @param logger the logger to log to.
+ @param error an error out for any error that occurs.
+ @return a new Application Archive Extractor, or nil if the incoming directory could not be created.
+ */
++ (nullable instancetype)extractorWithStorage:(FBBundleStorage *)storage queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger error:(NSError **)error;
+
+#pragma mark Properties
+
+/**
+ The directory that the archive is extracted into.
+ */
+@property (nonatomic, copy, readonly) NSURL *directory;
+
+/**
+ The Application within the archive, once the archive has been extracted in full.
+ The incoming directory is removed when the context is torn down, so the Application should be moved into storage before then.
+ */
+@property (nonatomic, strong, readonly) FBFutureContext<FBBundleDescriptor *> *extractedApplication;
+
+@end
+
+NS_ASSUME_NONNULL_END
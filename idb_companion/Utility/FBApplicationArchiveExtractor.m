@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBApplicationArchiveExtractor.h"
+
+#import "FBIDBError.h"
+#import "FBIDBStorageManager.h"
+
+static NSString *FBApplicationRelativePath(NSString *relativePath)
+{
+  // Applications are archived either at the root, or within the 'Payload' directory of an IPA.
+  NSArray<NSString *> *components = relativePath.pathComponents;
+  for (NSUInteger index = 0; index + 1 < components.count; index++) {
+    if ([components[index].pathExtension isEqualToString:@"app"]) {
+      return [NSString pathWithComponents:[components subarrayWithRange:NSMakeRange(0, index + 1)]];
+    }
+  }
+  return nil;
+}
+
+@interface FBApplicationArchiveExtractor ()
+
+@property (nonatomic, strong, readonly) FBBundleStorage *storage;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, strong, readonly) id<FBControlCoreLogger> logger;
+@property (nonatomic, strong, readwrite) FBTarExtractor *extractor;
+@property (nonatomic, assign, readwrite) unsigned long long bytesConsumed;
+@property (nonatomic, copy, nullable, readwrite) NSString *applicationRelativePath;
+@property (nonatomic, copy, nullable, readwrite) NSString *bundleIdentifier;
+@property (nonatomic, copy, nullable, readwrite) NSString *executableName;
+@property (nonatomic, assign, readwrite) BOOL validated;
+
+@end
+
+@implementation FBApplicationArchiveExtractor
+
+#pragma mark Initializers
+
++ (nullable instancetype)extractorWithStorage:(FBBundleStorage *)storage queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger error:(NSError **)error
+{
+  NSURL *directory = [storage createIncomingDirectoryWithError:error];
+  if (!directory) {
+    return nil;
+  }
+  return [[self alloc] initWithDirectory:directory storage:storage queue:queue logger:logger];
+}
+
+- (instancetype)initWithDirectory:(NSURL *)directory storage:(FBBundleStorage *)storage queue:(dispatch_queue_t)queue logger:(id<FBControlCoreLogger>)logger
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _directory = directory;
+  _storage = storage;
+  _queue = queue;
+  _logger = logger;
+
+  // The extractor retains the handler, so the handler must not retain the receiver.
+  __weak typeof(self) weakSelf = self;
+  _extractor = [FBTarExtractor extractorWithDirectory:directory.path entryHandler:^ BOOL (NSString *relativePath, NSString *path, NSError **innerError) {
+    return [weakSelf inspectEntryAtRelativePath:relativePath path:path error:innerError];
+  } logger:logger];
+
+  FBFuture<NSNull *> *extracted = _extractor.finishedConsuming;
+  _extractedApplication = [[[FBFuture
+    futureWithResult:directory]
+    onQueue:queue contextualTeardown:^(id _, FBFutureState __) {
+      NSError *innerError = nil;
+      if (![NSFileManager.defaultManager removeItemAtURL:directory error:&innerError]) {
+        [logger logFormat:@"Failed to delete incoming directory %@: %@", directory, innerError];
+      }
+      return FBFuture.empty;
+    }]
+    onQueue:queue pend:^(NSURL *extractionDirectory) {
+      return [extracted onQueue:queue fmap:^(id _) {
+        return [FBBundleDescriptor findAppPathFromDirectory:extractionDirectory];
+      }];
+    }];
+
+  return self;
+}
+
+#pragma mark FBDataConsumer
+
+- (void)consumeData:(NSData *)data
+{
+  self.bytesConsumed += data.length;
+  [self.extractor consumeData:data];
+}
+
+- (void)consumeEndOfFile
+{
+  [self.extractor consumeEndOfFile];
+}
+
+#pragma mark FBDataConsumerLifecycle
+
+- (FBFuture<NSNull *> *)finishedConsuming
+{
+  return self.extractor.finishedConsuming;
+}
+
+#pragma mark Private
+
+- (BOOL)inspectEntryAtRelativePath:(NSString *)relativePath path:(NSString *)path error:(NSError **)error
+{
+  if (self.validated) {
+    return YES;
+  }
+  NSString *applicationRelativePath = FBApplicationRelativePath(relativePath);
+  if (!applicationRelativePath) {
+    return YES;
+  }
+  // Only the first Application is inspected, the contents of any other are extracted as-is.
+  if (!self.applicationRelativePath) {
+    self.applicationRelativePath = applicationRelativePath;
+  } else if (![self.applicationRelativePath isEqualToString:applicationRelativePath]) {
+    return YES;
+  }
+  NSString *pathInApplication = [relativePath substringFromIndex:applicationRelativePath.length + 1];
+  NSString *applicationPath = [self.directory.path stringByAppendingPathComponent:applicationRelativePath];
+
+  if ([pathInApplication isEqualToString:@"Info.plist"]) {
+    NSDictionary<NSString *, id> *infoPlist = [NSDictionary dictionaryWithContentsOfFile:path];
+    NSString *bundleIdentifier = infoPlist[@"CFBundleIdentifier"];
+    NSString *executableName = infoPlist[@"CFBundleExecutable"];
+    if (![bundleIdentifier isKindOfClass:NSString.class] || ![executableName isKindOfClass:NSString.class]) {
+      return [[FBIDBError
+        describeFormat:@"Info.plist of %@ does not contain a CFBundleIdentifier and CFBundleExecutable", applicationRelativePath]
+        failBool:error];
+    }
+    self.bundleIdentifier = bundleIdentifier;
+    self.executableName = executableName;
+    // The executable may have been archived before the Info.plist.
+    NSString *executablePath = [applicationPath stringByAppendingPathComponent:executableName];
+    if (![NSFileManager.defaultManager fileExistsAtPath:executablePath]) {
+      return YES;
+    }
+    return [self validateExecutableAtPath:executablePath error:error];
+  }
+  if (self.executableName && [pathInApplication isEqualToString:self.executableName]) {
+    return [self validateExecutableAtPath:path error:error];
+  }
+  return YES;
+}
+
+- (BOOL)validateExecutableAtPath:(NSString *)path error:(NSError **)error
+{
+  FBBinaryDescriptor *binary = [FBBinaryDescriptor binaryWithPath:path error:error];
+  if (!binary) {
+    return NO;
+  }
+  NSError *innerError = nil;
+  if (![self.storage checkArchitectures:binary.architectures error:&innerError]) {
+    [self.logger logFormat:@"Rejecting %@ after %llu bytes: %@", self.bundleIdentifier, self.bytesConsumed, innerError.localizedDescription];
+    if (error) {
+      *error = innerError;
+    }
+    return NO;
+  }
+  self.validated = YES;
+  [self.logger logFormat:@"Validated %@ (%@, %@) after %llu bytes", self.bundleIdentifier, [binary.architectures.allObjects componentsJoinedByString:@", "], binary.uuid.UUIDString, self.bytesConsumed];
+  return YES;
+}
+
+@end
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <FBControlCore/FBControlCore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ An entry in the manifest of a bundle.
+ Each entry is one of a regular file, a directory or a symbolic link.
+ */
+@interface FBBundleManifestFile : NSObject
+
+/**
+ The Designated Initializer.
+
+ @param path the path of the entry, relative to the root of the manifest.
+ @param mode the permission bits of the entry.
+ @param digest the SHA-256 of the contents of a regular file, nil otherwise.
+ @param chunks the SHA-256 of each chunk of a regular file, in order.
+ @param symlinkTarget the target of a symbolic link, nil otherwise.
+ @param directory YES if the entry is a directory.
+ @return a new Manifest File.
+ */
+- (instancetype)initWithPath:(NSString *)path mode:(mode_t)mode digest:(nullable NSString *)digest chunks:(NSArray<NSString *> *)chunks symlinkTarget:(nullable NSString *)symlinkTarget directory:(BOOL)directory;
+
+/**
+ The path of the entry, relative to the root of the manifest.
+ */
+@property (nonatomic, copy, readonly) NSString *path;
+
+/**
+ The permission bits of the entry.
+ */
+@property (nonatomic, assign, readonly) mode_t mode;
+
+/**
+ The SHA-256 of the contents of a regular file, as lowercase hex.
+ */
+@property (nonatomic, copy, nullable, readonly) NSString *digest;
+
+/**
+ The SHA-256 of each chunk of a regular file, as lowercase hex.
+ The contents of the file are the concatenation of the chunks.
+ */
+@property (nonatomic, copy, readonly) NSArray<NSString *> *chunks;
+
+/**
+ The target of a symbolic link.
+ */
+@property (nonatomic, copy, nullable, readonly) NSString *symlinkTarget;
+
+/**
+ YES if the entry is a directory.
+ */
+@property (nonatomic, assign, readonly) BOOL directory;
+
+@end
+
+/**
+ A store of file contents, addressed by the SHA-256 of the contents.
+ Files are stored both as chunks, which are uploaded by a client, and as whole files that are assembled from those chunks.
+ A bundle is rebuilt from the store by cloning the whole files, so an unchanged file costs neither an upload nor a copy.
+ The least recently used contents are removed once the store exceeds its maximum size.
+ */
+@interface FBContentAddressedStore : NSObject
+
+#pragma mark Initializers
+
+/**
+ Constructs a store at the provided path, creating it if it does not exist.
+
+ @param basePath the directory of the store.
+ @param maximumSize the size in bytes above which the store is trimmed.
+ @param logger the logger to use.
+ @param error an error out for any error that occurs.
+ @return a new store if successful, nil otherwise.
+ */
++ (nullable instancetype)storeWithBasePath:(NSURL *)basePath maximumSize:(unsigned long long)maximumSize logger:(id<FBControlCoreLogger>)logger error:(NSError **)error;
+
+#pragma mark Public Methods
+
+/**
+ Determines the chunks that must be provided for a manifest to be materialized.
+ Chunks of files that are already present as a whole file are not required.
+ Every object that is present is touched, so that it is not trimmed before the manifest is materialized.
+
+ @param manifest the manifest to check.
+ @return the digests of the missing chunks, without duplicates, in the order they first appear in the manifest.
+ */
+- (NSArray<NSString *> *)missingChunksForManifest:(NSArray<FBBundleManifestFile *> *)manifest;
+
+/**
+ Adds a chunk to the store, verifying that the data matches the digest.
+
+ @param data the data of the chunk.
+ @param digest the SHA-256 of the data, as lowercase hex.
+ @param error an error out for any error that occurs.
+ @return YES if successful, NO otherwise.
+ */
+- (BOOL)storeChunk:(NSData *)data digest:(NSString *)digest error:(NSError **)error;
+
+/**
+ Rebuilds the entries of a manifest in a directory from the contents of the store.
+ Every chunk that was reported as missing must have been stored first.
+
+ @param manifest the manifest to materialize.
+ @param directory the directory to materialize into.
+ @param error an error out for any error that occurs.
+ @return YES if successful, NO otherwise.
+ */
+- (BOOL)materializeManifest:(NSArray<FBBundleManifestFile *> *)manifest inDirectory:(NSURL *)directory error:(NSError **)error;
+
+/**
+ Removes the least recently used contents until the store is no larger than its maximum size.
+ Contents used in the last hour are retained, so that an install in progress is not disturbed.
+
+ @param error an error out for any error that occurs.
+ @return YES if successful, NO otherwise.
+ */
+- (BOOL)trim:(NSError **)error;
+
+/**
+ Removes all contents of the store.
+
+ @param error an error out for any error that occurs.
+ @return YES if successful, NO otherwise.
+ */
+- (BOOL)clean:(NSError **)error;
+
+#pragma mark Properties
+
+/**
+ The directory of the store.
+ */
+@property (nonatomic, strong, readonly) NSURL *basePath;
+
+/**
+ The size in bytes above which the store is trimmed.
+ */
+@property (nonatomic, assign, readonly) unsigned long long maximumSize;
+
+@end
+
+NS_ASSUME_NONNULL_END
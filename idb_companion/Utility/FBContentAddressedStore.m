@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBContentAddressedStore.h"
+
+#import <CommonCrypto/CommonDigest.h>
+#import <sys/time.h>
+#import <fcntl.h>
+
+#import "FBIDBError.h"
+#import "FBStorageUtils.h"
+
+static NSString *const ChunksDirectory = @"chunks";
+static NSString *const FilesDirectory = @"files";
+static NSString *const StagingDirectory = @"staging";
+
+// Contents that have been used more recently than this are never trimmed.
+static const NSTimeInterval MinimumAgeForTrimming = 60 * 60;
+
+static NSString *HexDigest(const unsigned char *digest)
+{
+  NSMutableString *string = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+  for (NSUInteger index = 0; index < CC_SHA256_DIGEST_LENGTH; index++) {
+    [string appendFormat:@"%02x", digest[index]];
+  }
+  return string;
+}
+
+static BOOL WriteFully(int fileDescriptor, const uint8_t *bytes, size_t length)
+{
+  while (length > 0) {
+    ssize_t written = write(fileDescriptor, bytes, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return NO;
+    }
+    bytes += written;
+    length -= (size_t) written;
+  }
+  return YES;
+}
+
+static BOOL IsDigest(NSString *digest)
+{
+  // Digests are used as paths in the store, so must not contain anything other than hex.
+  static NSCharacterSet *nonHex;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    nonHex = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdef"] invertedSet];
+  });
+  return digest.length == CC_SHA256_DIGEST_LENGTH * 2 && [digest rangeOfCharacterFromSet:nonHex].location == NSNotFound;
+}
+
+static NSString *FoldedPath(NSString *path)
+{
+  // The bundle may be materialized on a volume that does not distinguish names by case or Unicode normalization.
+  return [path stringByFoldingWithOptions:NSCaseInsensitiveSearch locale:nil].decomposedStringWithCanonicalMapping;
+}
+
+@implementation FBBundleManifestFile
+
+- (instancetype)initWithPath:(NSString *)path mode:(mode_t)mode digest:(NSString *)digest chunks:(NSArray<NSString *> *)chunks symlinkTarget:(NSString *)symlinkTarget directory:(BOOL)directory
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _path = path;
+  _mode = mode;
+  _digest = digest;
+  _chunks = chunks;
+  _symlinkTarget = symlinkTarget;
+  _directory = directory;
+
+  return self;
+}
+
+- (NSString *)description
+{
+  if (self.directory) {
+    return [NSString stringWithFormat:@"Directory %@", self.path];
+  }
+  if (self.symlinkTarget) {
+    return [NSString stringWithFormat:@"Symlink %@ -> %@", self.path, self.symlinkTarget];
+  }
+  return [NSString stringWithFormat:@"File %@ %@ (%lu chunks)", self.path, self.digest, (unsigned long) self.chunks.count];
+}
+
+@end
+
+@interface FBContentAddressedStore ()
+
+@property (nonatomic, strong, readonly) id<FBControlCoreLogger> logger;
+
+@end
+
+@implementation FBContentAddressedStore
+
+#pragma mark Initializers
+
++ (instancetype)storeWithBasePath:(NSURL *)basePath maximumSize:(unsigned long long)maximumSize logger:(id<FBControlCoreLogger>)logger error:(NSError **)error
+{
+  FBContentAddressedStore *store = [[self alloc] initWithBasePath:basePath maximumSize:maximumSize logger:logger];
+  if (![store prepareDirectories:error]) {
+    return nil;
+  }
+  return store;
+}
+
+- (instancetype)initWithBasePath:(NSURL *)basePath maximumSize:(unsigned long long)maximumSize logger:(id<FBControlCoreLogger>)logger
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _basePath = basePath;
+  _maximumSize = maximumSize;
+  _logger = logger;
+
+  return self;
+}
+
+#pragma mark Public Methods
+
+- (NSArray<NSString *> *)missingChunksForManifest:(NSArray<FBBundleManifestFile *> *)manifest
+{
+  NSMutableOrderedSet<NSString *> *missing = NSMutableOrderedSet.orderedSet;
+  NSUInteger present = 0;
+  for (FBBundleManifestFile *file in manifest) {
+    if (!file.digest) {
+      continue;
+    }
+    if ([self touchObjectWithDigest:file.digest inDirectory:FilesDirectory]) {
+      present += 1;
+      continue;
+    }
+    for (NSString *chunk in file.chunks) {
+      if (![self touchObjectWithDigest:chunk inDirectory:ChunksDirectory]) {
+        [missing addObject:chunk];
+      }
+    }
+  }
+  [self.logger logFormat:@"%lu files of manifest are already present, %lu chunks are missing", (unsigned long) present, (unsigned long) missing.count];
+  return missing.array;
+}
+
+- (BOOL)storeChunk:(NSData *)data digest:(NSString *)digest error:(NSError **)error
+{
+  if (!IsDigest(digest)) {
+    return [[FBIDBError
+      describeFormat:@"%@ is not a valid chunk digest", digest]
+      failBool:error];
+  }
+  unsigned char actual[CC_SHA256_DIGEST_LENGTH];
+  CC_SHA256(data.bytes, (CC_LONG) data.length, actual);
+  if (![HexDigest(actual) isEqualToString:digest]) {
+    return [[FBIDBError
+      describeFormat:@"Chunk of %lu bytes does not match the digest %@", (unsigned long) data.length, digest]
+      failBool:error];
+  }
+  NSURL *destination = [self objectURLForDigest:digest inDirectory:ChunksDirectory];
+  if ([NSFileManager.defaultManager fileExistsAtPath:destination.path]) {
+    return YES;
+  }
+  if (![NSFileManager.defaultManager createDirectoryAtURL:destination.URLByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:error]) {
+    return NO;
+  }
+  return [data writeToURL:destination options:NSDataWritingAtomic error:error];
+}
+
+- (BOOL)materializeManifest:(NSArray<FBBundleManifestFile *> *)manifest inDirectory:(NSURL *)directory error:(NSError **)error
+{
+  if (![self validateManifest:manifest error:error]) {
+    return NO;
+  }
+  NSFileManager *fileManager = NSFileManager.defaultManager;
+  NSMutableArray<FBBundleManifestFile *> *directories = NSMutableArray.array;
+  NSUInteger assembled = 0;
+  for (FBBundleManifestFile *file in manifest) {
+    NSURL *destination = [directory URLByAppendingPathComponent:file.path];
+    if (file.directory) {
+      if (![fileManager createDirectoryAtURL:destination withIntermediateDirectories:YES attributes:nil error:error]) {
+        return NO;
+      }
+      [directories addObject:file];
+      continue;
+    }
+    if (![fileManager createDirectoryAtURL:destination.URLByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:error]) {
+      return NO;
+    }
+    if (file.symlinkTarget) {
+      if (![fileManager createSymbolicLinkAtPath:destination.path withDestinationPath:file.symlinkTarget error:error]) {
+        return NO;
+      }
+      continue;
+    }
+    NSURL *object = [self objectURLForDigest:file.digest inDirectory:FilesDirectory];
+    if ([fileManager fileExistsAtPath:object.path]) {
+      [self touch:object];
+    } else {
+      if (![self assembleFile:file atURL:object error:error]) {
+        return NO;
+      }
+      assembled += 1;
+    }
+    if (![FBStorageUtils cloneItemAtURL:object toURL:destination error:error]) {
+      return NO;
+    }
+    if (chmod(destination.fileSystemRepresentation, file.mode & 07777) != 0) {
+      return [[FBIDBError
+        describeFormat:@"Failed to set the mode of %@: %s", destination, strerror(errno)]
+        failBool:error];
+    }
+  }
+  // The mode of a directory is applied last, as it may not be writable.
+  for (FBBundleManifestFile *file in directories.reverseObjectEnumerator) {
+    NSURL *destination = [directory URLByAppendingPathComponent:file.path];
+    chmod(destination.fileSystemRepresentation, file.mode & 07777);
+  }
+  [self.logger logFormat:@"Materialized %lu entries in %@, %lu files were assembled from chunks", (unsigned long) manifest.count, directory, (unsigned long) assembled];
+
+  NSError *trimError = nil;
+  if (![self trim:&trimError]) {
+    [self.logger logFormat:@"Failed to trim content store %@", trimError];
+  }
+  return YES;
+}
+
+- (BOOL)trim:(NSError **)error
+{
+  NSArray<NSURLResourceKey> *keys = @[NSURLIsRegularFileKey, NSURLContentModificationDateKey, NSURLTotalFileAllocatedSizeKey];
+  NSMutableArray<NSURL *> *objects = NSMutableArray.array;
+  NSMutableDictionary<NSURL *, NSDictionary<NSURLResourceKey, id> *> *attributes = NSMutableDictionary.dictionary;
+  unsigned long long totalSize = 0;
+  for (NSString *name in @[ChunksDirectory, FilesDirectory]) {
+    NSDirectoryEnumerator<NSURL *> *enumerator = [NSFileManager.defaultManager enumeratorAtURL:[self.basePath URLByAppendingPathComponent:name] includingPropertiesForKeys:keys options:0 errorHandler:nil];
+    for (NSURL *url in enumerator) {
+      NSDictionary<NSURLResourceKey, id> *values = [url resourceValuesForKeys:keys error:nil];
+      if (![values[NSURLIsRegularFileKey] boolValue]) {
+        continue;
+      }
+      [objects addObject:url];
+      attributes[url] = values;
+      totalSize += [values[NSURLTotalFileAllocatedSizeKey] unsignedLongLongValue];
+    }
+  }
+  if (totalSize <= self.maximumSize) {
+    return YES;
+  }
+  [objects sortUsingComparator:^ NSComparisonResult (NSURL *left, NSURL *right) {
+    return [attributes[left][NSURLContentModificationDateKey] compare:attributes[right][NSURLContentModificationDateKey]];
+  }];
+  NSDate *cutoff = [NSDate dateWithTimeIntervalSinceNow:-MinimumAgeForTrimming];
+  unsigned long long removedSize = 0;
+  for (NSURL *object in objects) {
+    if (totalSize - removedSize <= self.maximumSize) {
+      break;
+    }
+    NSDictionary<NSURLResourceKey, id> *values = attributes[object];
+    if ([values[NSURLContentModificationDateKey] compare:cutoff] != NSOrderedAscending) {
+      break;
+    }
+    if (![NSFileManager.defaultManager removeItemAtURL:object error:error]) {
+      return NO;
+    }
+    removedSize += [values[NSURLTotalFileAllocatedSizeKey] unsignedLongLongValue];
+  }
+  [self.logger logFormat:@"Trimmed %llu bytes from content store of %llu bytes", removedSize, totalSize];
+  return YES;
+}
+
+- (BOOL)clean:(NSError **)error
+{
+  if (![NSFileManager.defaultManager removeItemAtURL:self.basePath error:error]) {
+    return NO;
+  }
+  return [self prepareDirectories:error];
+}
+
+#pragma mark Private
+
+- (BOOL)prepareDirectories:(NSError **)error
+{
+  for (NSString *name in @[ChunksDirectory, FilesDirectory, StagingDirectory]) {
+    NSURL *directory = [self.basePath URLByAppendingPathComponent:name];
+    NSError *innerError = nil;
+    if (![NSFileManager.defaultManager createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:&innerError]) {
+      return [[[FBIDBError
+        describeFormat:@"Failed to create content store directory %@", directory]
+        causedBy:innerError]
+        failBool:error];
+    }
+  }
+  return YES;
+}
+
+- (BOOL)validateManifest:(NSArray<FBBundleManifestFile *> *)manifest error:(NSError **)error
+{
+  // Paths must stay inside the directory that is materialized into, including by way of a symlink in the manifest.
+  NSMutableSet<NSString *> *symlinks = NSMutableSet.set;
+  for (FBBundleManifestFile *file in manifest) {
+    if (file.symlinkTarget) {
+      [symlinks addObject:FoldedPath(file.path)];
+    }
+  }
+  for (FBBundleManifestFile *file in manifest) {
+    NSArray<NSString *> *components = file.path.pathComponents;
+    if (components.count == 0 || file.path.isAbsolutePath || [components containsObject:@".."] || [components containsObject:@"."]) {
+      return [[FBIDBError
+        describeFormat:@"Manifest path %@ is not a relative path within the bundle", file.path]
+        failBool:error];
+    }
+    for (NSUInteger length = 1; length < components.count; length++) {
+      NSString *parent = [NSString pathWithComponents:[components subarrayWithRange:NSMakeRange(0, length)]];
+      if ([symlinks containsObject:FoldedPath(parent)]) {
+        return [[FBIDBError
+          describeFormat:@"Manifest path %@ is within the symlink %@", file.path, parent]
+          failBool:error];
+      }
+    }
+    if (file.symlinkTarget) {
+      if (![self validateSymlinkTarget:file symlinks:symlinks error:error]) {
+        return NO;
+      }
+      continue;
+    }
+    if (file.directory) {
+      continue;
+    }
+    if (!IsDigest(file.digest)) {
+      return [[FBIDBError
+        describeFormat:@"Manifest file %@ has an invalid digest %@", file.path, file.digest]
+        failBool:error];
+    }
+    for (NSString *chunk in file.chunks) {
+      if (!IsDigest(chunk)) {
+        return [[FBIDBError
+          describeFormat:@"Manifest file %@ has an invalid chunk digest %@", file.path, chunk]
+          failBool:error];
+      }
+    }
+  }
+  return YES;
+}
+
+- (BOOL)validateSymlinkTarget:(FBBundleManifestFile *)file symlinks:(NSSet<NSString *> *)symlinks error:(NSError **)error
+{
+  // The target is resolved relative to the directory containing the link, and must not leave the bundle.
+  NSString *target = file.symlinkTarget;
+  if (target.length == 0 || target.isAbsolutePath) {
+    return [[FBIDBError
+      describeFormat:@"Manifest symlink %@ has target %@, which is not a relative path within the bundle", file.path, target]
+      failBool:error];
+  }
+  NSMutableArray<NSString *> *resolved = [file.path.pathComponents mutableCopy];
+  [resolved removeLastObject];
+  BOOL traversedSymlink = NO;
+  for (NSString *component in target.pathComponents) {
+    if ([component isEqualToString:@"."] || [component isEqualToString:@"/"]) {
+      continue;
+    }
+    if ([component isEqualToString:@".."]) {
+      // Once a symlink has been followed the location is no longer the lexical one, so moving up from it can't be checked.
+      if (resolved.count == 0 || traversedSymlink) {
+        return [[FBIDBError
+          describeFormat:@"Manifest symlink %@ has target %@, which resolves outside of the bundle", file.path, target]
+          failBool:error];
+      }
+      [resolved removeLastObject];
+      continue;
+    }
+    [resolved addObject:component];
+    if ([symlinks containsObject:FoldedPath([NSString pathWithComponents:resolved])]) {
+      traversedSymlink = YES;
+    }
+  }
+  return YES;
+}
+
+- (BOOL)assembleFile:(FBBundleManifestFile *)file atURL:(NSURL *)destination error:(NSError **)error
+{
+  // Assemble into a staging file, so that the object only ever appears once it is complete and verified.
+  NSURL *staging = [[self.basePath URLByAppendingPathComponent:StagingDirectory] URLByAppendingPathComponent:NSUUID.UUID.UUIDString];
+  int fileDescriptor = open(staging.fileSystemRepresentation, O_WRONLY | O_CREAT | O_EXCL, 0644);
+  if (fileDescriptor == -1) {
+    return [[FBIDBError
+      describeFormat:@"Failed to create staging file %@: %s", staging, strerror(errno)]
+      failBool:error];
+  }
+  CC_SHA256_CTX context;
+  CC_SHA256_Init(&context);
+  BOOL success = YES;
+  NSError *innerError = nil;
+  for (NSString *chunk in file.chunks) {
+    NSURL *chunkURL = [self objectURLForDigest:chunk inDirectory:ChunksDirectory];
+    NSData *data = [NSData dataWithContentsOfURL:chunkURL options:NSDataReadingMappedIfSafe error:&innerError];
+    if (!data) {
+      success = NO;
+      break;
+    }
+    CC_SHA256_Update(&context, data.bytes, (CC_LONG) data.length);
+    if (!WriteFully(fileDescriptor, data.bytes, data.length)) {
+      innerError = [[FBIDBError describeFormat:@"Failed to write to %@: %s", staging, strerror(errno)] build];
+      success = NO;
+      break;
+    }
+    [self touch:chunkURL];
+  }
+  close(fileDescriptor);
+  unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+  CC_SHA256_Final(digest, &context);
+  if (success && ![HexDigest(digest) isEqualToString:file.digest]) {
+    innerError = [[FBIDBError describeFormat:@"Assembled contents of %@ do not match the digest %@", file.path, file.digest] build];
+    success = NO;
+  }
+  if (success && ![NSFileManager.defaultManager createDirectoryAtURL:destination.URLByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:&innerError]) {
+    success = NO;
+  }
+  // Renaming is atomic, so a concurrent assembly of the same file will replace it with identical contents.
+  if (success && rename(staging.fileSystemRepresentation, destination.fileSystemRepresentation) != 0) {
+    innerError = [[FBIDBError describeFormat:@"Failed to move %@ to %@: %s", staging, destination, strerror(errno)] build];
+    success = NO;
+  }
+  if (!success) {
+    [NSFileManager.defaultManager removeItemAtURL:staging error:nil];
+    return [[[FBIDBError
+      describeFormat:@"Failed to assemble %@ from %lu chunks", file.path, (unsigned long) file.chunks.count]
+      causedBy:innerError]
+      failBool:error];
+  }
+  return YES;
+}
+
+- (NSURL *)objectURLForDigest:(NSString *)digest inDirectory:(NSString *)name
+{
+  // Objects are split by the leading byte of the digest, so that no single directory becomes very large.
+  return [[[self.basePath
+    URLByAppendingPathComponent:name]
+    URLByAppendingPathComponent:[digest substringToIndex:2]]
+    URLByAppendingPathComponent:digest];
+}
+
+- (BOOL)touchObjectWithDigest:(NSString *)digest inDirectory:(NSString *)name
+{
+  if (!IsDigest(digest)) {
+    return NO;
+  }
+  // An object that is reported as present must not be trimmed before the manifest is materialized, so it is touched as it is checked.
+  return utimes([self objectURLForDigest:digest inDirectory:name].fileSystemRepresentation, NULL) == 0;
+}
+
+- (void)touch:(NSURL *)url
+{
+  // The modification time orders objects for trimming.
+  utimes(url.fileSystemRepresentation, NULL);
+}
+
+@end
@@ -9,6 +9,8 @@
 #import <FBControlCore/FBControlCore.h>
 #import "FBXCTestDescriptor.h"
 
+@class FBContentAddressedStore;
+
 NS_ASSUME_NONNULL_BEGIN
 
 extern NSString *const IdbTestBundlesFolder;
@@ -16,6 +18,7 @@ extern NSString *const IdbApplicationsFolder;
 extern NSString *const IdbDylibsFolder;
 extern NSString *const IdbDsymsFolder;
 extern NSString *const IdbFrameworksFolder;
+extern NSString *const IdbContentStoreFolder;
 
 /**
  A wrapper around an installed artifact
@@ -110,6 +113,16 @@ extern NSString *const IdbFrameworksFolder;
  */
 - (BOOL)checkArchitecture:(FBBundleDescriptor *)bundle error:(NSError **)error;
 
+/**
+ Checks that a set of architectures is supported on the current target.
+ This allows a binary to be checked before the rest of its bundle is available.
+
+ @param architectures the architectures of the binary.
+ @param error Set if the targets architecture isn't in the set of architectures
+ @return YES if the binary can run on this target, NO otherwise
+ */
+- (BOOL)checkArchitectures:(NSSet<NSString *> *)architectures error:(NSError **)error;
+
 /**
  Persist the bundle to storage.
 
@@ -118,6 +131,25 @@ extern NSString *const IdbFrameworksFolder;
  */
 - (FBFuture<FBInstalledArtifact *> *)saveBundle:(FBBundleDescriptor *)bundle;
 
+/**
+ Creates an empty directory on the same volume as the storage, for a bundle to be extracted into.
+ A bundle in this directory is persisted with a rename, rather than a copy.
+ The directory should be removed once the bundle has been persisted, or has failed to be.
+
+ @param error an error out for any error that occurs.
+ @return the directory if successful, nil otherwise.
+ */
+- (nullable NSURL *)createIncomingDirectoryWithError:(NSError **)error;
+
+/**
+ Persist a bundle to storage by moving it, rather than copying it.
+ The bundle is no longer at its original path once this resolves.
+
+ @param bundle the bundle to persist, which should be within an incoming directory.
+ @return a future of the persisted bundle info.
+ */
+- (FBFuture<FBInstalledArtifact *> *)moveBundleIntoStorage:(FBBundleDescriptor *)bundle;
+
 #pragma mark Properties
 
 /**
@@ -228,6 +260,11 @@ extern NSString *const IdbFrameworksFolder;
  */
 @property (nonatomic, strong, readonly) FBBundleStorage *framework;
 
+/**
+ The store of bundle contents, from which bundles that are uploaded by manifest are rebuilt.
+ */
+@property (nonatomic, strong, readonly) FBContentAddressedStore *contentStore;
+
 /**
  The logger to use.
  */
@@ -7,6 +7,7 @@
 
 #import "FBIDBStorageManager.h"
 
+#import "FBContentAddressedStore.h"
 #import "FBIDBError.h"
 #import "FBStorageUtils.h"
 #import "FBXCTestDescriptor.h"
@@ -16,6 +17,10 @@ NSString *const IdbApplicationsFolder = @"idb-applications";
 NSString *const IdbDylibsFolder = @"idb-dylibs";
 NSString *const IdbDsymsFolder = @"idb-dsyms";
 NSString *const IdbFrameworksFolder = @"idb-frameworks";
+NSString *const IdbContentStoreFolder = @"idb-content-store";
+
+// The size above which the least recently used bundle contents are removed.
+static const unsigned long long ContentStoreMaximumSize = 4ull * 1024 * 1024 * 1024;
 
 @implementation FBInstalledArtifact
 
@@ -82,7 +87,7 @@ NSString *const IdbFrameworksFolder = @"idb-frameworks";
 {
   NSURL *destination = [self.basePath URLByAppendingPathComponent:url.lastPathComponent];
   [self.logger logFormat:@"Persisting %@ to %@", url.lastPathComponent, destination];
-  if (![NSFileManager.defaultManager copyItemAtURL:url toURL:destination error:error]) {
+  if (![FBStorageUtils cloneItemAtURL:url toURL:destination error:error]) {
     return nil;
   }
   [self.logger logFormat:@"Persisted %@", destination.lastPathComponent];
@@ -111,7 +116,11 @@ NSString *const IdbFrameworksFolder = @"idb-frameworks";
 
 - (BOOL)checkArchitecture:(FBBundleDescriptor *)bundle error:(NSError **)error
 {
-  NSSet<NSString *> *bundleArchs = bundle.binary.architectures;
+  return [self checkArchitectures:bundle.binary.architectures error:error];
+}
+
+- (BOOL)checkArchitectures:(NSSet<NSString *> *)bundleArchs error:(NSError **)error
+{
   NSString *targetArch = self.target.architecture;
 
   const BOOL containsExactArch = [bundleArchs containsObject:targetArch];
@@ -129,39 +138,27 @@ NSString *const IdbFrameworksFolder = @"idb-frameworks";
 
 - (FBFuture<FBInstalledArtifact *> *)saveBundle:(FBBundleDescriptor *)bundle
 {
-  // Check that the bundle matches the architecture of the target.
-  NSError *error = nil;
-  if (![self checkArchitecture:bundle error:&error]) {
-    return [FBFuture futureWithError:error];
-  }
-
-  // Where the bundle will be copied to.
-  NSURL *storageDirectory = [self.basePath URLByAppendingPathComponent:bundle.identifier];
-  if (![self prepareDirectoryWithURL:storageDirectory error:&error]) {
-    return [FBFuture futureWithError:error];
-  }
+  return [self persistBundle:bundle move:NO];
+}
 
-  // Copy over bundle
-  NSURL *sourceBundlePath = [NSURL fileURLWithPath:bundle.path];
-  NSURL *destinationBundlePath = [storageDirectory URLByAppendingPathComponent:sourceBundlePath.lastPathComponent];
-  [self.logger logFormat:@"Persisting %@ to %@", bundle.identifier, destinationBundlePath];
-  if (![NSFileManager.defaultManager copyItemAtURL:sourceBundlePath toURL:destinationBundlePath error:&error]) {
-    return [FBFuture futureWithError:error];
+- (nullable NSURL *)createIncomingDirectoryWithError:(NSError **)error
+{
+  // A sibling of the storage, so that it is on the same volume but isn't mistaken for a persisted bundle.
+  NSURL *incoming = [[self.basePath URLByDeletingLastPathComponent] URLByAppendingPathComponent:[self.basePath.lastPathComponent stringByAppendingString:@"-incoming"]];
+  NSURL *directory = [incoming URLByAppendingPathComponent:NSUUID.UUID.UUIDString];
+  NSError *innerError = nil;
+  if (![NSFileManager.defaultManager createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:&innerError]) {
+    return [[[FBIDBError
+      describeFormat:@"Failed to create incoming directory %@", directory]
+      causedBy:innerError]
+      fail:error];
   }
-  [self.logger logFormat:@"Persisted %@", bundle.identifier];
+  return directory;
+}
 
-  FBInstalledArtifact *artifact = [[FBInstalledArtifact alloc] initWithName:bundle.identifier uuid:bundle.binary.uuid];
-  if (!self.relocateLibraries || ![self.target requiresBundlesToBeSigned]) {
-    return [FBFuture futureWithResult:artifact];
-  }
-  bundle = [FBBundleDescriptor bundleFromPath:destinationBundlePath.path error:&error];
-  if (!bundle) {
-    return [FBFuture futureWithError:error];
-  }
-  FBCodesignProvider *provider = [FBCodesignProvider codeSignCommandWithAdHocIdentityWithLogger:self.logger];
-  return [[bundle
-    updatePathsForRelocationWithCodesign:provider logger:self.logger queue:self.queue]
-    mapReplace:artifact];
+- (FBFuture<FBInstalledArtifact *> *)moveBundleIntoStorage:(FBBundleDescriptor *)bundle
+{
+  return [self persistBundle:bundle move:YES];
 }
 
 #pragma mark Properties
@@ -208,6 +205,50 @@ NSString *const IdbFrameworksFolder = @"idb-frameworks";
 
 #pragma mark Private
 
+- (FBFuture<FBInstalledArtifact *> *)persistBundle:(FBBundleDescriptor *)bundle move:(BOOL)move
+{
+  // Check that the bundle matches the architecture of the target.
+  NSError *error = nil;
+  if (![self checkArchitecture:bundle error:&error]) {
+    return [FBFuture futureWithError:error];
+  }
+
+  // Where the bundle will be persisted to.
+  NSURL *storageDirectory = [self.basePath URLByAppendingPathComponent:bundle.identifier];
+  if (![self prepareDirectoryWithURL:storageDirectory error:&error]) {
+    return [FBFuture futureWithError:error];
+  }
+
+  // Move or copy over bundle, the copy is a clone where the filesystem supports it.
+  NSURL *sourceBundlePath = [NSURL fileURLWithPath:bundle.path];
+  NSURL *destinationBundlePath = [storageDirectory URLByAppendingPathComponent:sourceBundlePath.lastPathComponent];
+  [self.logger logFormat:@"Persisting %@ to %@", bundle.identifier, destinationBundlePath];
+  if (move) {
+    if (![NSFileManager.defaultManager moveItemAtURL:sourceBundlePath toURL:destinationBundlePath error:&error]) {
+      return [[[FBIDBError
+        describeFormat:@"Failed to move %@ into storage", sourceBundlePath]
+        causedBy:error]
+        failFuture];
+    }
+  } else if (![FBStorageUtils cloneItemAtURL:sourceBundlePath toURL:destinationBundlePath error:&error]) {
+    return [FBFuture futureWithError:error];
+  }
+  [self.logger logFormat:@"Persisted %@", bundle.identifier];
+
+  FBInstalledArtifact *artifact = [[FBInstalledArtifact alloc] initWithName:bundle.identifier uuid:bundle.binary.uuid];
+  if (!self.relocateLibraries || ![self.target requiresBundlesToBeSigned]) {
+    return [FBFuture futureWithResult:artifact];
+  }
+  bundle = [FBBundleDescriptor bundleFromPath:destinationBundlePath.path error:&error];
+  if (!bundle) {
+    return [FBFuture futureWithError:error];
+  }
+  FBCodesignProvider *provider = [FBCodesignProvider codeSignCommandWithAdHocIdentityWithLogger:self.logger];
+  return [[bundle
+    updatePathsForRelocationWithCodesign:provider logger:self.logger queue:self.queue]
+    mapReplace:artifact];
+}
+
 - (BOOL)prepareDirectoryWithURL:(NSURL *)url error:(NSError **)error
 {
   // Clear old test
@@ -594,10 +635,19 @@ static NSString *const XctestRunExtension = @"xctestrun";
   }
   FBBundleStorage *framework = [[FBBundleStorage alloc] initWithTarget:target basePath:basePath queue:queue logger:logger relocateLibraries:YES];
 
-  return [[self alloc] initWithXctest:xctest application:application dylib:dylib dsym:dsym framework:framework logger:logger];
+  basePath = [self prepareStoragePathWithName:IdbContentStoreFolder target:target error:error];
+  if (!basePath) {
+    return nil;
+  }
+  FBContentAddressedStore *contentStore = [FBContentAddressedStore storeWithBasePath:basePath maximumSize:ContentStoreMaximumSize logger:logger error:error];
+  if (!contentStore) {
+    return nil;
+  }
+
+  return [[self alloc] initWithXctest:xctest application:application dylib:dylib dsym:dsym framework:framework contentStore:contentStore logger:logger];
 }
 
-- (instancetype)initWithXctest:(FBXCTestBundleStorage *)xctest application:(FBBundleStorage *)application dylib:(FBFileStorage *)dylib dsym:(FBFileStorage *)dsym framework:(FBBundleStorage *)framework logger:(id<FBControlCoreLogger>)logger
+- (instancetype)initWithXctest:(FBXCTestBundleStorage *)xctest application:(FBBundleStorage *)application dylib:(FBFileStorage *)dylib dsym:(FBFileStorage *)dsym framework:(FBBundleStorage *)framework contentStore:(FBContentAddressedStore *)contentStore logger:(id<FBControlCoreLogger>)logger
 {
   self = [super init];
   if (!self) {
@@ -609,6 +659,7 @@ static NSString *const XctestRunExtension = @"xctestrun";
   _dylib = dylib;
   _dsym = dsym;
   _framework = framework;
+  _contentStore = contentStore;
   _logger = logger;
 
   return self;
@@ -618,7 +669,7 @@ static NSString *const XctestRunExtension = @"xctestrun";
 
 - (BOOL)clean:(NSError **)error
 {
-  return [self.xctest clean:error] && [self.application clean:error] && [self.dylib clean:error] && [self.dsym clean:error] && [self.framework clean:error];
+  return [self.xctest clean:error] && [self.application clean:error] && [self.dylib clean:error] && [self.dsym clean:error] && [self.framework clean:error] && [self.contentStore clean:error];
 }
 
 - (NSArray<NSString *> *)interpolateArgumentReplacements:(NSArray<NSString *> *)arguments
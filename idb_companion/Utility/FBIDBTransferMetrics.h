@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The stages that a call that transfers data spends its time in.
+ */
+typedef NSString *FBIDBTransferStage NS_STRING_ENUM;
+
+/**
+ Time blocked in reading a message from the client.
+ */
+extern FBIDBTransferStage const FBIDBTransferStageRead;
+
+/**
+ Time blocked in writing a message to the client.
+ */
+extern FBIDBTransferStage const FBIDBTransferStageWrite;
+
+/**
+ Time spent decompressing and extracting data that has been read.
+ */
+extern FBIDBTransferStage const FBIDBTransferStageExtract;
+
+/**
+ Time blocked waiting for a future to resolve.
+ */
+extern FBIDBTransferStage const FBIDBTransferStageBlock;
+
+/**
+ A histogram with power-of-two buckets.
+ The bucket at index i counts the values that are less than 2^i and not counted by a lower bucket, so the bucket at index 0 counts zeros.
+ */
+@interface FBIDBHistogram : NSObject <NSCopying>
+
+/**
+ Records a value.
+
+ @param value the value to record.
+ */
+- (void)recordValue:(uint64_t)value;
+
+/**
+ The number of values recorded.
+ */
+@property (nonatomic, assign, readonly) uint64_t count;
+
+/**
+ The sum of the values recorded.
+ */
+@property (nonatomic, assign, readonly) uint64_t sum;
+
+/**
+ The largest value recorded.
+ */
+@property (nonatomic, assign, readonly) uint64_t maximum;
+
+/**
+ The count of each bucket, up to the highest bucket with a value in it.
+ */
+@property (nonatomic, copy, readonly) NSArray<NSNumber *> *bucketCounts;
+
+@end
+
+/**
+ A snapshot of the metrics of all calls to a single method.
+ */
+@interface FBIDBCallMetrics : NSObject
+
+/**
+ The name of the method.
+ */
+@property (nonatomic, copy, readonly) NSString *name;
+
+/**
+ The number of calls that have finished.
+ */
+@property (nonatomic, assign, readonly) uint64_t calls;
+
+/**
+ The bytes read from clients, and the number of messages they were read in.
+ */
+@property (nonatomic, assign, readonly) uint64_t bytesIn;
+@property (nonatomic, assign, readonly) uint64_t chunksIn;
+
+/**
+ The bytes written to clients, and the number of messages they were written in.
+ */
+@property (nonatomic, assign, readonly) uint64_t bytesOut;
+@property (nonatomic, assign, readonly) uint64_t chunksOut;
+
+/**
+ The time of each operation within a stage, in microseconds.
+ */
+@property (nonatomic, copy, readonly) NSDictionary<FBIDBTransferStage, FBIDBHistogram *> *stageMicroseconds;
+
+/**
+ The time of each call, in microseconds.
+ */
+@property (nonatomic, copy, readonly) FBIDBHistogram *durationMicroseconds;
+
+/**
+ The bytes transferred per second by each call, in either direction.
+ */
+@property (nonatomic, copy, readonly) FBIDBHistogram *throughputBytesPerSecond;
+
+@end
+
+/**
+ Records the transfers of a single call.
+ Each operation is added to the metrics as it is recorded, so a long-lived call is visible before it finishes.
+ Recording is thread-safe, so operations may be recorded from the queues that a call uses.
+ */
+@interface FBIDBTransferRecording : NSObject
+
+/**
+ Records a message that was read from the client.
+
+ @param bytes the size of the message.
+ @param nanoseconds the time blocked in reading the message.
+ */
+- (void)recordReadOfBytes:(uint64_t)bytes nanoseconds:(uint64_t)nanoseconds;
+
+/**
+ Records a message that was written to the client.
+
+ @param bytes the size of the message.
+ @param nanoseconds the time blocked in writing the message.
+ */
+- (void)recordWriteOfBytes:(uint64_t)bytes nanoseconds:(uint64_t)nanoseconds;
+
+/**
+ Records time spent in a stage.
+
+ @param stage the stage.
+ @param nanoseconds the time spent in the stage.
+ */
+- (void)recordStage:(FBIDBTransferStage)stage nanoseconds:(uint64_t)nanoseconds;
+
+/**
+ Finishes the recording, adding the duration and throughput of the call to the metrics.
+ Subsequent calls have no effect.
+ */
+- (void)finish;
+
+@end
+
+/**
+ Aggregates the transfers of the calls that the companion serves, so that the stage that bounds a transfer can be found.
+ */
+@interface FBIDBTransferMetrics : NSObject
+
+/**
+ Starts recording a call.
+
+ @param name the name of the method that is called.
+ @return a recording to record the transfers of the call to.
+ */
+- (FBIDBTransferRecording *)recordingForCall:(NSString *)name;
+
+/**
+ A snapshot of the metrics of each method that has been called, ordered by name.
+ */
+@property (nonatomic, copy, readonly) NSArray<FBIDBCallMetrics *> *snapshot;
+
+/**
+ The current time, for timing the operations of a recording.
+ */
++ (uint64_t)now;
+
+@end
+
+NS_ASSUME_NONNULL_END
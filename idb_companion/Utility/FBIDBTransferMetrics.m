@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "FBIDBTransferMetrics.h"
+
+#import <time.h>
+
+FBIDBTransferStage const FBIDBTransferStageRead = @"read";
+FBIDBTransferStage const FBIDBTransferStageWrite = @"write";
+FBIDBTransferStage const FBIDBTransferStageExtract = @"extract";
+FBIDBTransferStage const FBIDBTransferStageBlock = @"block";
+
+static const NSUInteger HistogramBucketCount = 65;
+
+static uint64_t NanosecondsToMicroseconds(uint64_t nanoseconds)
+{
+  return nanoseconds / NSEC_PER_USEC;
+}
+
+@implementation FBIDBHistogram
+{
+  uint64_t _buckets[HistogramBucketCount];
+}
+
+- (void)recordValue:(uint64_t)value
+{
+  NSUInteger index = value == 0 ? 0 : (NSUInteger) (64 - __builtin_clzll(value));
+  _buckets[index] += 1;
+  _count += 1;
+  _sum += value;
+  _maximum = MAX(_maximum, value);
+}
+
+- (NSArray<NSNumber *> *)bucketCounts
+{
+  NSUInteger length = 0;
+  for (NSUInteger index = 0; index < HistogramBucketCount; index++) {
+    if (_buckets[index]) {
+      length = index + 1;
+    }
+  }
+  NSMutableArray<NSNumber *> *counts = [NSMutableArray arrayWithCapacity:length];
+  for (NSUInteger index = 0; index < length; index++) {
+    [counts addObject:@(_buckets[index])];
+  }
+  return counts;
+}
+
+#pragma mark NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone
+{
+  FBIDBHistogram *histogram = [FBIDBHistogram new];
+  memcpy(histogram->_buckets, _buckets, sizeof(_buckets));
+  histogram->_count = _count;
+  histogram->_sum = _sum;
+  histogram->_maximum = _maximum;
+  return histogram;
+}
+
+@end
+
+@interface FBIDBCallMetrics ()
+
+@property (nonatomic, assign, readwrite) uint64_t calls;
+@property (nonatomic, assign, readwrite) uint64_t bytesIn;
+@property (nonatomic, assign, readwrite) uint64_t chunksIn;
+@property (nonatomic, assign, readwrite) uint64_t bytesOut;
+@property (nonatomic, assign, readwrite) uint64_t chunksOut;
+@property (nonatomic, strong, readonly) NSMutableDictionary<FBIDBTransferStage, FBIDBHistogram *> *stages;
+
+@end
+
+@implementation FBIDBCallMetrics
+
+@synthesize durationMicroseconds = _durationMicroseconds;
+@synthesize throughputBytesPerSecond = _throughputBytesPerSecond;
+
+- (instancetype)initWithName:(NSString *)name
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _name = name;
+  _stages = NSMutableDictionary.dictionary;
+  _durationMicroseconds = [FBIDBHistogram new];
+  _throughputBytesPerSecond = [FBIDBHistogram new];
+
+  return self;
+}
+
+- (void)recordStage:(FBIDBTransferStage)stage microseconds:(uint64_t)microseconds
+{
+  FBIDBHistogram *histogram = self.stages[stage];
+  if (!histogram) {
+    histogram = [FBIDBHistogram new];
+    self.stages[stage] = histogram;
+  }
+  [histogram recordValue:microseconds];
+}
+
+- (NSDictionary<FBIDBTransferStage, FBIDBHistogram *> *)stageMicroseconds
+{
+  return [[NSDictionary alloc] initWithDictionary:self.stages copyItems:YES];
+}
+
+- (FBIDBCallMetrics *)snapshot
+{
+  FBIDBCallMetrics *metrics = [[FBIDBCallMetrics alloc] initWithName:self.name];
+  metrics.calls = self.calls;
+  metrics.bytesIn = self.bytesIn;
+  metrics.chunksIn = self.chunksIn;
+  metrics.bytesOut = self.bytesOut;
+  metrics.chunksOut = self.chunksOut;
+  [metrics.stages setDictionary:self.stageMicroseconds];
+  metrics->_durationMicroseconds = [self.durationMicroseconds copy];
+  metrics->_throughputBytesPerSecond = [self.throughputBytesPerSecond copy];
+  return metrics;
+}
+
+@end
+
+@interface FBIDBTransferMetrics ()
+
+@property (nonatomic, strong, readonly) NSMutableDictionary<NSString *, FBIDBCallMetrics *> *calls;
+
+@end
+
+@interface FBIDBTransferRecording ()
+
+@property (nonatomic, strong, readonly) FBIDBTransferMetrics *metrics;
+@property (nonatomic, strong, readonly) FBIDBCallMetrics *call;
+@property (nonatomic, assign, readonly) uint64_t start;
+@property (nonatomic, assign, readwrite) uint64_t bytes;
+@property (nonatomic, assign, readwrite) BOOL finished;
+
+@end
+
+@implementation FBIDBTransferRecording
+
+- (instancetype)initWithMetrics:(FBIDBTransferMetrics *)metrics call:(FBIDBCallMetrics *)call
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _metrics = metrics;
+  _call = call;
+  _start = FBIDBTransferMetrics.now;
+
+  return self;
+}
+
+- (void)recordReadOfBytes:(uint64_t)bytes nanoseconds:(uint64_t)nanoseconds
+{
+  @synchronized (self.metrics) {
+    self.bytes += bytes;
+    self.call.bytesIn += bytes;
+    self.call.chunksIn += 1;
+    [self.call recordStage:FBIDBTransferStageRead microseconds:NanosecondsToMicroseconds(nanoseconds)];
+  }
+}
+
+- (void)recordWriteOfBytes:(uint64_t)bytes nanoseconds:(uint64_t)nanoseconds
+{
+  @synchronized (self.metrics) {
+    self.bytes += bytes;
+    self.call.bytesOut += bytes;
+    self.call.chunksOut += 1;
+    [self.call recordStage:FBIDBTransferStageWrite microseconds:NanosecondsToMicroseconds(nanoseconds)];
+  }
+}
+
+- (void)recordStage:(FBIDBTransferStage)stage nanoseconds:(uint64_t)nanoseconds
+{
+  @synchronized (self.metrics) {
+    [self.call recordStage:stage microseconds:NanosecondsToMicroseconds(nanoseconds)];
+  }
+}
+
+- (void)finish
+{
+  uint64_t nanoseconds = FBIDBTransferMetrics.now - self.start;
+  @synchronized (self.metrics) {
+    if (self.finished) {
+      return;
+    }
+    self.finished = YES;
+    self.call.calls += 1;
+    [self.call.durationMicroseconds recordValue:NanosecondsToMicroseconds(nanoseconds)];
+    if (self.bytes > 0 && nanoseconds > 0) {
+      [self.call.throughputBytesPerSecond recordValue:(uint64_t) ((double) self.bytes * NSEC_PER_SEC / nanoseconds)];
+    }
+  }
+}
+
+@end
+
+@implementation FBIDBTransferMetrics
+
+- (instancetype)init
+{
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  _calls = NSMutableDictionary.dictionary;
+
+  return self;
+}
+
+#pragma mark Public
+
+- (FBIDBTransferRecording *)recordingForCall:(NSString *)name
+{
+  FBIDBCallMetrics *call = nil;
+  @synchronized (self) {
+    call = self.calls[name];
+    if (!call) {
+      call = [[FBIDBCallMetrics alloc] initWithName:name];
+      self.calls[name] = call;
+    }
+  }
+  return [[FBIDBTransferRecording alloc] initWithMetrics:self call:call];
+}
+
+- (NSArray<FBIDBCallMetrics *> *)snapshot
+{
+  NSMutableArray<FBIDBCallMetrics *> *snapshot = NSMutableArray.array;
+  @synchronized (self) {
+    for (NSString *name in [self.calls.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+      [snapshot addObject:[self.calls[name] snapshot]];
+    }
+  }
+  return snapshot;
+}
+
++ (uint64_t)now
+{
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+@end
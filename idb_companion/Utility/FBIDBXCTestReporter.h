@@ -48,6 +48,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, strong, readwrite) FBXCTestReporterConfiguration *configuration;
 
+/**
+ When YES, the result bundle and log directory are written as a series of chunked responses ahead of the final response.
+ Otherwise they are inlined in the final response, which requires each of them to be held in memory and to fit within a single message.
+ */
+@property (nonatomic, assign, readwrite) BOOL streamArtifacts;
+
 @end
 
 NS_ASSUME_NONNULL_END
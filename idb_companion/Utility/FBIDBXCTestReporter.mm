@@ -336,7 +336,24 @@
   // https://github.com/facebook/infer/blob/master/infer/lib/linter_rules/linters.al#L212
   __block idb::XctestRunResponse responseCaptured = response;
   NSMutableArray<FBFuture<NSNull *> *> *futures = [NSMutableArray array];
-  if (self.configuration.resultBundlePath) {
+  if (self.streamArtifacts) {
+    // The artifacts are streamed one after the other, each in bounded memory, before the final response is written.
+    FBFuture<NSNull *> *artifacts = FBFuture.empty;
+    NSString *resultBundlePath = self.configuration.resultBundlePath;
+    if (resultBundlePath) {
+      artifacts = [artifacts onQueue:self.queue fmap:^(id _) {
+        return [self writeArtifactAtPath:resultBundlePath kind:idb::XctestRunResponse_Artifact_Kind_RESULT_BUNDLE];
+      }];
+    }
+    NSString *logDirectoryPath = self.configuration.logDirectoryPath;
+    if (logDirectoryPath) {
+      artifacts = [artifacts onQueue:self.queue fmap:^(id _) {
+        return [self writeArtifactAtPath:logDirectoryPath kind:idb::XctestRunResponse_Artifact_Kind_LOG_DIRECTORY];
+      }];
+    }
+    [futures addObject:artifacts];
+  }
+  if (self.configuration.resultBundlePath && !self.streamArtifacts) {
     [futures addObject:[[self getResultsBundle] onQueue:self.queue chain:^FBFuture<NSNull *> *(FBFuture<NSData *> *future) {
       NSData *data = future.result;
       if (data) {
@@ -359,7 +376,7 @@
       return [FBFuture futureWithResult:NSNull.null];
     }]];
   }
-  if (self.configuration.logDirectoryPath) {
+  if (self.configuration.logDirectoryPath && !self.streamArtifacts) {
       [futures addObject:[[self getLogDirectoryData] onQueue:self.queue chain:^FBFuture<NSNull *> *(FBFuture<NSData *> *future) {
         NSData *data = future.result;
         if (data) {
@@ -448,6 +465,34 @@
     }];
 }
 
+- (FBFuture<NSNull *> *)writeArtifactAtPath:(NSString *)path kind:(idb::XctestRunResponse_Artifact_Kind)kind
+{
+  id<FBDataConsumer> consumer = [FBBlockDataConsumer synchronousDataConsumerWithBlock:^(NSData *data) {
+    idb::XctestRunResponse response;
+    response.set_status(idb::XctestRunResponse_Status_RUNNING);
+    idb::XctestRunResponse_Artifact *artifact = response.mutable_artifact();
+    artifact->set_kind(kind);
+    artifact->set_data(data.bytes, data.length);
+    [self writeResponseFinal:response];
+  }];
+  return [[FBArchiveOperations
+    writeGzippedTarForPath:path toConsumer:consumer queue:self.queue logger:self.logger]
+    onQueue:self.queue chain:^FBFuture<NSNull *> *(FBFuture<NSNull *> *future) {
+      NSError *error = future.error;
+      if (error) {
+        [self.logger.info logFormat:@"Failed to stream %@: %@", path, error.localizedDescription];
+        // Chunks may have been sent already, so the client must be told to discard them.
+        idb::XctestRunResponse response;
+        response.set_status(idb::XctestRunResponse_Status_RUNNING);
+        idb::XctestRunResponse_Artifact *artifact = response.mutable_artifact();
+        artifact->set_kind(kind);
+        artifact->set_error(error.localizedDescription.length > 0 ? error.localizedDescription.UTF8String : "Failed to archive artifact");
+        [self writeResponseFinal:response];
+      }
+      return FBFuture.empty;
+    }];
+}
+
 - (FBFuture<NSData *> *)getResultsBundle
 {
   return [FBArchiveOperations createGzippedTarDataForPath:self.configuration.resultBundlePath queue:self.queue logger:self.logger];
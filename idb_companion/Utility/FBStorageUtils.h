@@ -76,6 +76,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable FBBundleDescriptor *)bundleInDirectory:(NSURL *)directory error:(NSError **)error;
 
+#pragma mark Copying Files
+
+/**
+ Copies a file or directory hierarchy, cloning it where the filesystem supports it.
+ A clone shares storage with the source until either is modified, so this is constant-time on APFS.
+ Falls back to a regular copy where cloning is not supported, for instance across volumes.
+
+ @param source the file or directory to copy.
+ @param destination the path to copy to, which must not exist.
+ @param error an error out for any error that occurs.
+ @return YES if successful, NO otherwise.
+ */
++ (BOOL)cloneItemAtURL:(NSURL *)source toURL:(NSURL *)destination error:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -9,6 +9,8 @@
 
 #import <FBControlCore/FBControlCore.h>
 
+#import <sys/clonefile.h>
+
 #import "FBIDBError.h"
 
 @implementation FBStorageUtils
@@ -99,4 +101,20 @@
   return [FBBundleDescriptor bundleFromPath:uniqueFile.path error:error];
 }
 
+#pragma mark Copying Files
+
++ (BOOL)cloneItemAtURL:(NSURL *)source toURL:(NSURL *)destination error:(NSError **)error
+{
+  // clonefile(2) clones an entire directory hierarchy in one call.
+  if (clonefile(source.fileSystemRepresentation, destination.fileSystemRepresentation, CLONE_NOFOLLOW) == 0) {
+    return YES;
+  }
+  if (errno != ENOTSUP && errno != EXDEV) {
+    return [[FBIDBError
+      describeFormat:@"Failed to clone %@ to %@: %s", source, destination, strerror(errno)]
+      failBool:error];
+  }
+  return [NSFileManager.defaultManager copyItemAtURL:source toURL:destination error:error];
+}
+
 @end
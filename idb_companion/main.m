@@ -49,6 +49,8 @@ Usage: \n \
     --grpc-port PORT           Port to start the grpc companion server on (default: 10882).\n\
     --tls-cert-path PATH       If specified exposed GRPC server will be listening on a TLS enabled socket.\n\
     --grpc-domain-sock PATH    Unix Domain Socket path to start the companion server on, will superceed TCP binding via --grpc-port.\n\
+    --grpc-async-streams VALUE If VALUE is a true value, long-lived streams (log, video_stream) are served from a completion queue instead of occupying a server thread.\n\
+    --video-stream-max-queued-frames COUNT The number of video frames queued for a client that is slow to read them (default: 4).\n\
     --debug-port PORT          Port to connect debugger on (default: 10881).\n\
     --log-file-path PATH       Path to write a log file to e.g ./output.log (default: logs to stdErr).\n\
     --log-level info|debug     The log level to use, 'debug' for a higher level of debugging 'info' for a lower level of logging (default 'debug').\n\
@@ -193,15 +195,15 @@ static FBFuture<FBSimulator *> *SimulatorFuture(NSString *udid, NSUserDefaults *
 
 static FBFuture<NSNull *> *TargetOfflineFuture(id<FBiOSTarget> target, id<FBControlCoreLogger> logger)
 {
-  return [[FBFuture
+  // This lasts for the lifetime of the companion, so the polling backs off to avoid waking up ten times a second while idle.
+  return [FBFuture
     onQueue:target.workQueue resolveWhen:^ BOOL {
       if (target.state != FBiOSTargetStateBooted) {
         [logger.error logFormat:@"Target with udid %@ is no longer booted, it is in state %@", target.udid, FBiOSTargetStateStringFromState(target.state)];
         return YES;
       }
       return NO;
-    }]
-    mapReplace:NSNull.null];
+    } backoffFrom:0.1 to:1];
 }
 
 static FBFuture<FBFuture<NSNull *> *> *BootFuture(NSString *udid, NSUserDefaults *userDefaults, id<FBControlCoreLogger> logger, id<FBEventReporter> reporter)